@@ -0,0 +1,103 @@
+// Tests that aggregations which scan a collection with several threads return the same results as
+// the serial scan they replace.
+(function() {
+"use strict";
+
+const conn =
+    MongoRunner.runMongod({setParameter: {internalQueryParallelCollectionScanMinRecords: 0}});
+assert.neq(null, conn, "mongod was unable to start up");
+const db = conn.getDB("test");
+const coll = db.agg_parallel_collection_scan;
+
+const bulk = coll.initializeUnorderedBulkOp();
+for (let i = 0; i < 5000; i++) {
+    bulk.insert({_id: i, a: i % 13, b: i, s: "str" + (i % 5)});
+}
+assert.commandWorked(bulk.execute());
+
+const pipelines = [
+    [{$match: {b: {$gte: 100}}}],
+    [{$match: {a: {$ne: 3}}}, {$project: {a: 1, b: 1}}, {$addFields: {c: {$add: ["$a", "$b"]}}}],
+    [{$group: {_id: "$a", total: {$sum: "$b"}, n: {$sum: 1}, avg: {$avg: "$b"}}}],
+    [{$match: {b: {$lt: 4000}}}, {$group: {_id: "$s", lo: {$min: "$b"}, hi: {$max: "$b"}}}],
+    // $unwind can't run on the workers, so it consumes their merged output.
+    [{$match: {a: {$gt: 2}}}, {$project: {arr: ["$a", "$s"]}}, {$unwind: "$arr"}],
+];
+
+// The workers' output comes back in no particular order.
+function runSorted(pipeline) {
+    return coll.aggregate(pipeline).toArray().sort(bsonWoCompare);
+}
+
+for (let pipeline of pipelines) {
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryParallelCollectionScanThreads: 0}));
+    const serial = runSorted(pipeline);
+
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryParallelCollectionScanThreads: 4}));
+    const parallel = runSorted(pipeline);
+
+    assert.gt(serial.length, 0, tojson(pipeline));
+    assert.eq(serial, parallel, tojson(pipeline));
+}
+
+// Make sure the parallel scan was actually used.
+db.setLogLevel(1, "query");
+coll.aggregate([{$match: {b: {$gte: 0}}}]).itcount();
+checkLog.contains(conn, "Scanning " + coll.getFullName() + " with 4 threads");
+
+// Small batches fill the workers' queue long before they finish their ranges. Scanning with more
+// workers than the pool has threads makes two idle cursors enough to occupy every thread if the
+// workers waited for room in the queue instead of giving their threads back.
+assert.commandWorked(
+    db.adminCommand({setParameter: 1, internalDocumentSourceCursorBatchSizeBytes: 1000}));
+assert.commandWorked(
+    db.adminCommand({setParameter: 1, internalQueryParallelCollectionScanThreads: 64}));
+const idleCursors = [
+    coll.aggregate([], {cursor: {batchSize: 1}}),
+    coll.aggregate([{$project: {b: 1}}], {cursor: {batchSize: 1}}),
+];
+for (let cursor of idleCursors) {
+    assert(cursor.hasNext());
+}
+assert.eq(5000, coll.aggregate([{$match: {b: {$gte: 0}}}]).itcount());
+for (let cursor of idleCursors) {
+    assert.eq(5000, cursor.itcount());
+}
+
+// A $lookup over a parallel scan gives the same results as over a serial one. Its own pipeline
+// scans the foreign collection serially, whether it runs per document or builds a hash table.
+const foreign = db.agg_parallel_collection_scan_foreign;
+for (let i = 0; i < 20; i++) {
+    assert.commandWorked(foreign.insert({_id: i, a: i % 13}));
+}
+const lookupPipelines = [
+    [{$lookup: {from: foreign.getName(), localField: "a", foreignField: "a", as: "joined"}}],
+    [
+        {$match: {b: {$lt: 200}}},
+        {
+            $lookup: {
+                from: foreign.getName(),
+                let: {a: "$a"},
+                pipeline: [{$match: {$expr: {$eq: ["$a", "$$a"]}}}, {$project: {_id: 1}}],
+                as: "joined"
+            }
+        }
+    ],
+];
+for (let pipeline of lookupPipelines) {
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryParallelCollectionScanThreads: 0}));
+    const serial = runSorted(pipeline);
+
+    assert.commandWorked(
+        db.adminCommand({setParameter: 1, internalQueryParallelCollectionScanThreads: 4}));
+    const parallel = runSorted(pipeline);
+
+    assert.gt(serial.length, 0, tojson(pipeline));
+    assert.eq(serial, parallel, tojson(pipeline));
+}
+
+MongoRunner.stopMongod(conn);
+}());
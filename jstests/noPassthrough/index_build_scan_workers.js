@@ -0,0 +1,158 @@
+/**
+ * Builds indexes with several collection scan workers (indexBuildScanWorkers > 1) and checks that
+ * they come out the same as a single-threaded build would make them:
+ *  - keys sorted, and spilled, by each worker are merged into one ordered index;
+ *  - multikey paths found by different workers are combined;
+ *  - wildcard multikey metadata keys generated by several workers are inserted once;
+ *  - unique keys duplicated across workers fail the build;
+ *  - documents a secondary's workers skip on a key generation error are retried at commit.
+ *
+ * @tags: [
+ *     requires_replication,
+ * ]
+ */
+(function() {
+"use strict";
+
+load('jstests/libs/analyze_plan.js');
+load('jstests/noPassthrough/libs/index_build.js');
+
+const numWorkers = 4;
+const rst = new ReplSetTest({
+    nodes: [{}, {rsConfig: {priority: 0}}],
+    nodeOptions: {
+        setParameter: {indexBuildScanWorkers: numWorkers, maxIndexBuildMemoryUsageMegabytes: 100}
+    },
+});
+rst.startSet();
+rst.initiate();
+
+const primary = rst.getPrimary();
+const testDB = primary.getDB('test');
+const coll = testDB.getCollection('test');
+
+// Workers get documents in batches of at most 256, so these are spread over all of them.
+const numDocs = 20000;
+const pad = 'x'.repeat(1000);
+const bulk = coll.initializeUnorderedBulkOp();
+for (let i = 0; i < numDocs; ++i) {
+    bulk.insert({
+        _id: i,
+        s: pad + i,
+        // Only a few documents make 'a' multikey.
+        a: i % 1000 === 0 ? [i, -i] : i,
+        // 'b' is only an array in the first half of the collection and 'c' only in the second, so
+        // no single worker is likely to see both.
+        b: i < numDocs / 2 && i % 500 === 0 ? [i, -i] : i,
+        c: i >= numDocs / 2 && i % 500 === 0 ? [i, -i] : i,
+        w: {x: i % 3 === 0 ? [i] : i, y: {z: i}},
+        u: i,
+        // The first and last documents, which different workers process, share a value.
+        e: i === numDocs - 1 ? 0 : i,
+    });
+}
+assert.commandWorked(bulk.execute());
+
+// Build several indexes at once, which splits the memory limit between them. Each worker's share
+// for {s: 1} is then about 3MB, well under the 5MB of keys each worker generates for it, so every
+// worker spills.
+assert.commandWorked(coll.createIndexes([
+    {s: 1},
+    {s: -1, _id: 1},
+    {a: 1},
+    {b: 1, c: 1},
+    {'w.$**': 1},
+    {u: -1},
+    {a: 1, s: 1},
+    {e: -1},
+]));
+checkLog.contains(
+    primary, new RegExp('key generation done on ' + numWorkers + ' threads.*sorterSpills: [1-9]'));
+
+let res = assert.commandWorked(coll.validate({full: true}));
+assert(res.valid, tojson(res));
+
+// The merged index returns every document, in order.
+let count = 0;
+let previous = '';
+coll.find({}, {s: 1}).sort({s: 1}).hint({s: 1}).forEach(doc => {
+    assert.lte(previous, doc.s);
+    previous = doc.s;
+    ++count;
+});
+assert.eq(numDocs, count);
+
+// Each index is marked multikey on the paths that any worker found to be arrays.
+function assertMultiKeyPaths(query, hint, expected) {
+    const explain = coll.find(query).hint(hint).explain();
+    const ixscan = getPlanStage(explain.queryPlanner.winningPlan, 'IXSCAN');
+    assert.neq(null, ixscan, tojson(explain));
+    assert.eq(expected, ixscan.multiKeyPaths, tojson(ixscan));
+}
+assertMultiKeyPaths({a: 1000}, {a: 1}, {a: ['a']});
+assertMultiKeyPaths({b: 0, c: 0}, {b: 1, c: 1}, {b: ['b'], c: ['c']});
+assertMultiKeyPaths({a: 1000, s: pad + 1000}, {a: 1, s: 1}, {a: ['a'], s: []});
+assert.eq(19, coll.find({a: {$lt: 0}}).hint({a: 1}).itcount());
+assert.eq(19, coll.find({b: {$lt: 0}}).hint({b: 1, c: 1}).itcount());
+assert.eq(20, coll.find({c: {$lt: 0}}).hint({b: 1, c: 1}).itcount());
+
+// The wildcard index answers queries on both array and non-array paths.
+assert.eq(1, coll.find({'w.x': 3}).hint({'w.$**': 1}).itcount());
+assert.eq(numDocs, coll.find({'w.y.z': {$gte: 0}}).hint({'w.$**': 1}).itcount());
+
+// A unique index with no duplicates builds; one whose only duplicates went to different workers
+// does not.
+assert.commandWorked(coll.createIndex({u: 1}, {unique: true, name: 'u_unique'}));
+assert.commandFailedWithCode(coll.createIndex({e: 1}, {unique: true, name: 'e_unique'}),
+                             ErrorCodes.DuplicateKey);
+IndexBuildTest.assertIndexes(coll, 10, [
+    '_id_',
+    's_1',
+    's_-1__id_1',
+    'a_1',
+    'b_1_c_1',
+    'w.$**_1',
+    'u_-1',
+    'a_1_s_1',
+    'e_-1',
+    'u_unique',
+]);
+
+// On a secondary, the workers skip documents whose keys can't be generated, and the build retries
+// them when it commits. Let the secondary scan documents with parallel arrays while the primary
+// waits, and fix them before the build commits.
+if (IndexBuildTest.supportsTwoPhaseIndexBuild(primary)) {
+    const secondary = rst.getSecondary();
+    const badIds = [];
+    for (let i = 0; i < numDocs; i += 2500) {
+        badIds.push(i);
+    }
+    assert.commandWorked(
+        coll.update({_id: {$in: badIds}}, {$set: {p: [1, 2], q: [3, 4]}}, {multi: true}));
+    rst.awaitReplication();
+
+    assert.commandWorked(primary.adminCommand(
+        {configureFailPoint: 'hangAfterSettingUpIndexBuild', mode: 'alwaysOn'}));
+    assert.commandWorked(secondary.adminCommand(
+        {configureFailPoint: 'hangAfterIndexBuildDumpsInsertsFromBulk', mode: 'alwaysOn'}));
+    const createIdx = IndexBuildTest.startIndexBuild(primary, coll.getFullName(), {p: 1, q: 1});
+    checkLog.contains(secondary, 'Hanging after dumping inserts from bulk builder');
+
+    assert.commandWorked(coll.update({_id: {$in: badIds}}, {$set: {q: 3}}, {multi: true}));
+    assert.commandWorked(secondary.adminCommand(
+        {configureFailPoint: 'hangAfterIndexBuildDumpsInsertsFromBulk', mode: 'off'}));
+    assert.commandWorked(
+        primary.adminCommand({configureFailPoint: 'hangAfterSettingUpIndexBuild', mode: 'off'}));
+    createIdx();
+    rst.awaitReplication();
+
+    secondary.setSlaveOk();
+    const secondaryColl = secondary.getDB('test').getCollection('test');
+    IndexBuildTest.waitForIndexBuildToStop(secondary.getDB('test'));
+    assert.eq(badIds.length, secondaryColl.find({p: 1, q: 3}).hint({p: 1, q: 1}).itcount());
+    res = assert.commandWorked(secondaryColl.validate({full: true}));
+    assert(res.valid, tojson(res));
+}
+
+rst.stopSet();
+})();
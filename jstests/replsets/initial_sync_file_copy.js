@@ -0,0 +1,44 @@
+/**
+ * Tests that a new member started with 'initialSyncFileCopySource' seeds its empty dbpath with a
+ * copy of the source's data files instead of running a logical initial sync, and then replicates
+ * writes made during and after the copy.
+ * @tags: [ requires_wiredtiger, requires_persistence ]
+ */
+(function() {
+"use strict";
+
+const rst = new ReplSetTest({nodes: 1});
+rst.startSet();
+rst.initiate();
+
+const primary = rst.getPrimary();
+const primaryColl = primary.getDB("test").getCollection(jsTestName());
+assert.commandWorked(primaryColl.createIndex({a: 1}));
+const bulk = primaryColl.initializeUnorderedBulkOp();
+for (let i = 0; i < 1000; i++) {
+    bulk.insert({_id: i, a: i % 10});
+}
+assert.commandWorked(bulk.execute());
+
+jsTestLog("Adding a node that copies its data files from the primary");
+const secondary = rst.add({
+    rsConfig: {priority: 0},
+    setParameter: {initialSyncFileCopySource: primary.host, numInitialSyncAttempts: 1}
+});
+rst.reInitiate();
+rst.awaitSecondaryNodes();
+
+assert.commandWorked(primaryColl.insert({_id: 1000, a: 0}));
+rst.awaitReplication();
+
+const secondaryColl = secondary.getDB("test").getCollection(jsTestName());
+assert.eq(1001, secondaryColl.find().itcount());
+assert.eq(2, secondaryColl.getIndexes().length, tojson(secondaryColl.getIndexes()));
+
+const log = assert.commandWorked(secondary.adminCommand({getLog: "global"})).log;
+assert(log.some(line => line.includes("Opened backup")), "expected a file copy initial sync");
+assert(!log.some(line => line.includes("Starting initial sync")), "expected no logical initial sync");
+
+// The data hashes are checked by ReplSetTest when stopping the set.
+rst.stopSet();
+})();
@@ -0,0 +1,74 @@
+/**
+ * Tests that a secondary that writes the next batch's oplog entries while applying the current
+ * batch ('replPipelinedBatchApplication') ends up with the same data as its primary, including
+ * when it crashes while those entries are being written.
+ *
+ * @tags: [requires_persistence]
+ */
+(function() {
+"use strict";
+
+// The arbiter keeps the primary elected while the secondary restarts.
+const rst = new ReplSetTest({
+    nodes: [{}, {rsConfig: {priority: 0}}, {arbiter: true}],
+    nodeOptions: {setParameter: {replPipelinedBatchApplication: true, replBatchLimitOperations: 50}}
+});
+rst.startSet();
+rst.initiate();
+
+const primary = rst.getPrimary();
+let secondary = rst.getSecondary();
+const coll = primary.getDB("test").getCollection(jsTestName());
+
+function runRounds(firstRound, lastRound) {
+    for (let round = firstRound; round < lastRound; round++) {
+        const bulk = coll.initializeUnorderedBulkOp();
+        for (let i = 0; i < 500; i++) {
+            bulk.insert({_id: round * 500 + i, round: round});
+        }
+        assert.commandWorked(bulk.execute());
+        assert.commandWorked(coll.updateMany({round: round}, {$inc: {x: 1}}));
+        assert.commandWorked(coll.remove({_id: {$mod: [7, round % 7]}, round: round}));
+    }
+}
+
+function assertSecondaryCaughtUp() {
+    rst.awaitReplication();
+    assert.eq(coll.find().itcount(),
+              secondary.getDB("test").getCollection(jsTestName()).find().itcount());
+}
+
+runRounds(0, 20);
+assertSecondaryCaughtUp();
+
+// Each round is many batches of 50 operations, all fetched well before they can be applied, so
+// the secondary always has a next batch ready to write while it applies one.
+const applyMetrics =
+    assert.commandWorked(secondary.adminCommand({serverStatus: 1})).metrics.repl.apply;
+jsTestLog("Secondary apply metrics: " + tojson(applyMetrics));
+assert.gt(applyMetrics.pipelinedBatches, 0, tojson(applyMetrics));
+
+// Crash the secondary after it has written a pipelined batch's oplog entries, but while the oplog
+// truncate-after point is still set to the end of the batch being applied. Startup recovery must
+// remove the pipelined batch's entries, which were never applied, and replay the batch that was
+// being applied; the secondary then fetches the rest again.
+assert.commandWorked(secondary.adminCommand(
+    {configureFailPoint: "hangAfterWritingPipelinedBatchToOplog", mode: "alwaysOn"}));
+runRounds(20, 25);
+checkLog.contains(secondary, "hangAfterWritingPipelinedBatchToOplog fail point enabled");
+
+// Give the journal flusher time to make the oplog entries and the truncate-after point durable.
+sleep(1000);
+
+const secondaryId = rst.getNodeId(secondary);
+rst.stop(secondaryId, 9, {allowedExitCode: MongoRunner.EXIT_SIGKILL}, {forRestart: true});
+secondary = rst.start(secondaryId, {}, true /* restart */);
+checkLog.contains(secondary, "Removing unapplied oplog entries starting after");
+rst.awaitSecondaryNodes();
+
+runRounds(25, 30);
+assertSecondaryCaughtUp();
+
+// The data hashes are checked by ReplSetTest when stopping the set.
+rst.stopSet();
+})();
@@ -31,6 +31,7 @@
 
 #include <benchmark/benchmark.h>
 
+#include "mongo/bson/bson_validate.h"
 #include "mongo/bson/bsonobjbuilder.h"
 
 namespace mongo {
@@ -63,7 +64,101 @@ void BM_arrayLookup(benchmark::State& state) {
     state.SetItemsProcessed(totalLen);
 }
 
+/**
+ * Document shapes for the validation and field lookup benchmarks, roughly covering what arrives in
+ * insert and update commands.
+ */
+enum DocumentShape { kOrder, kWide, kNested, kLongStrings };
+
+BSONObj makeDocument(int64_t shape) {
+    BSONObjBuilder bob;
+    switch (shape) {
+        case kOrder: {
+            bob.append("_id", OID::gen());
+            bob.append("customerId", 1234567LL);
+            bob.append("status", "shipped");
+            bob.append("createdAt", Date_t::fromMillisSinceEpoch(1580000000000LL));
+            bob.append("total", 129.95);
+            bob.append("itemCount", 3);
+            bob.append("shippingAddress",
+                       BSON("street"
+                            << "123 Main Street"
+                            << "city"
+                            << "Springfield"
+                            << "postalCode"
+                            << "12345"));
+            bob.append("tags", BSON_ARRAY("gift"
+                                          << "express"
+                                          << "fragile"));
+            bob.append("notes", "Leave the package at the side door");
+            break;
+        }
+        case kWide:
+            for (int i = 0; i < 100; ++i) {
+                bob.append(str::stream() << "measurementField" << i, i);
+            }
+            break;
+        case kNested: {
+            BSONObj inner = BSON("value" << 1);
+            for (int i = 0; i < 20; ++i) {
+                inner = BSON("level" << i << "child" << inner);
+            }
+            bob.append("_id", 1);
+            bob.append("tree", inner);
+            break;
+        }
+        case kLongStrings:
+            bob.append("_id", 1);
+            for (int i = 0; i < 8; ++i) {
+                bob.append(str::stream() << "text" << i, std::string(512, 'a' + i));
+            }
+            break;
+    }
+    return bob.obj();
+}
+
+const char* shapeName(int64_t shape) {
+    static const char* kNames[] = {"order", "wide", "nested", "longStrings"};
+    return kNames[shape];
+}
+
+void BM_validate(benchmark::State& state) {
+    const BSONObj obj = makeDocument(state.range(0));
+    state.SetLabel(shapeName(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(validateBSON(obj.objdata(), obj.objsize(), BSONVersion::kLatest));
+    }
+    state.SetBytesProcessed(state.iterations() * obj.objsize());
+}
+
+/**
+ * Looks up the first, middle and last fields of a document, and one that isn't there.
+ */
+void BM_getField(benchmark::State& state) {
+    const BSONObj obj = makeDocument(state.range(0));
+    state.SetLabel(shapeName(state.range(0)));
+
+    std::vector<std::string> names;
+    std::vector<StringData> allNames;
+    for (auto&& elem : obj) {
+        allNames.push_back(elem.fieldNameStringData());
+    }
+    names.push_back(allNames.front().toString());
+    names.push_back(allNames[allNames.size() / 2].toString());
+    names.push_back(allNames.back().toString());
+    names.push_back("notAFieldInTheDocument");
+
+    for (auto _ : state) {
+        for (auto&& name : names) {
+            benchmark::DoNotOptimize(obj.getField(name));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * names.size());
+}
+
 BENCHMARK(BM_arrayBuilder)->Ranges({{{1}, {100'000}}});
 BENCHMARK(BM_arrayLookup)->Ranges({{{1}, {100'000}}});
+BENCHMARK(BM_validate)->DenseRange(kOrder, kLongStrings);
+BENCHMARK(BM_getField)->DenseRange(kOrder, kLongStrings);
 
 }  // namespace mongo
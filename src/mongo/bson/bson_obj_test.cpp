@@ -621,6 +621,27 @@ TEST(Looping, Cpp11Auto) {
     ASSERT_EQUALS(count, 1 + 2 + 3);
 }
 
+TEST(BSONObj, getField) {
+    const std::string longName(40, 'x');
+    auto obj = BSON("a" << 1 << "ab" << 2 << longName << 3 << "abc"
+                        << "str"
+                        << "" << 4 << "last" << BSONNULL);
+    ASSERT_EQUALS(obj.getField("a").numberInt(), 1);
+    ASSERT_EQUALS(obj.getField("ab").numberInt(), 2);
+    ASSERT_EQUALS(obj.getField(longName).numberInt(), 3);
+    ASSERT_EQUALS(obj.getField("abc").str(), "str");
+    ASSERT_EQUALS(obj.getField("").numberInt(), 4);
+    ASSERT_EQUALS(obj.getField("last").type(), BSONType::jstNULL);
+
+    // Prefixes and extensions of existing names must not match.
+    ASSERT_TRUE(obj.getField("abcd").eoo());
+    ASSERT_TRUE(obj.getField(std::string(39, 'x')).eoo());
+    ASSERT_TRUE(obj.getField(std::string(41, 'x')).eoo());
+    ASSERT_TRUE(obj.getField("las").eoo());
+
+    ASSERT_TRUE(BSONObj().getField("a").eoo());
+}
+
 TEST(BSONObj, getFields) {
     auto e = BSON("a" << 1 << "b" << 2 << "c" << 3 << "d" << 4 << "e" << 5 << "f" << 6);
     std::array<StringData, 3> fieldNames{"c", "d", "f"};
@@ -27,14 +27,15 @@
  *    it in the license file.
  */
 
+#include <boost/container/small_vector.hpp>
 #include <cstring>
 #include <limits>
-#include <vector>
 
 #include "mongo/base/data_view.h"
 #include "mongo/bson/bson_depth.h"
 #include "mongo/bson/bson_validate.h"
 #include "mongo/bson/oid.h"
+#include "mongo/bson/util/string_scan.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/platform/decimal128.h"
 
@@ -90,10 +91,10 @@ public:
      * reading, if it exists. Otherwise, it should be empty.
      */
     Status readCString(StringData elemName, StringData* out) {
-        const void* x = memchr(_buffer + _position, 0, _maxLength - _position);
+        const char* x = findNulByte(_buffer + _position, _buffer + _maxLength);
         if (!x)
             return makeError("no end of c-string", _idElem, elemName);
-        uint64_t len = static_cast<uint64_t>(static_cast<const char*>(x) - (_buffer + _position));
+        uint64_t len = static_cast<uint64_t>(x - (_buffer + _position));
 
         StringData data(_buffer + _position, len);
         _position += len + 1;
@@ -309,8 +310,8 @@ Status validateElementInfo(Buffer* buffer,
 }
 
 Status validateBSONIterative(Buffer* buffer) {
-    std::vector<ValidationObjectFrame> frames;
-    frames.reserve(16);
+    // Deeply nested documents are rare, so keep the common case off the heap.
+    boost::container::small_vector<ValidationObjectFrame, 16> frames;
     ValidationObjectFrame* curr = nullptr;
     ValidationState::State state = ValidationState::BeginObj;
 
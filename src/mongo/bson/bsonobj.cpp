@@ -37,6 +37,7 @@
 #include "mongo/bson/generator_extended_canonical_2_0_0.h"
 #include "mongo/bson/generator_extended_relaxed_2_0_0.h"
 #include "mongo/bson/generator_legacy_strict.h"
+#include "mongo/bson/util/string_scan.h"
 #include "mongo/db/json.h"
 #include "mongo/util/allocator.h"
 #include "mongo/util/hex.h"
@@ -553,15 +554,21 @@ void BSONObj::getFields(unsigned n, const char** fieldNames, BSONElement* fields
 }
 
 BSONElement BSONObj::getField(StringData name) const {
-    BSONObjIterator i(*this);
-    while (i.more()) {
-        BSONElement e = i.next();
-        // We know that e has a cached field length since BSONObjIterator::next internally
-        // called BSONElement::size on the BSONElement that it returned, so it is more
-        // efficient to re-use that information by obtaining the field name as a
-        // StringData, which will be pre-populated with the cached length.
-        if (name == e.fieldNameStringData())
+    // Walk the elements by hand rather than with a BSONObjIterator: measuring each field name with
+    // findNulByte() is cheaper than the strlen() call BSONElement's constructor makes, and the
+    // name length alone rules out most non-matching fields before any bytes are compared.
+    const char* pos = objdata() + sizeof(int32_t);
+    const char* const end = objdata() + objsize();
+    while (*pos != EOO) {
+        const char* nameEnd = findNulByte(pos + 1, end);
+        verify(nameEnd);
+        const int fieldNameSize = nameEnd - pos;  // Includes the NUL byte.
+        BSONElement e(pos, fieldNameSize, -1, BSONElement::CachedSizeTag());
+        if (static_cast<size_t>(fieldNameSize - 1) == name.size() &&
+            memcmp(pos + 1, name.rawData(), name.size()) == 0)
             return e;
+        pos += e.size();
+        verify(pos < end);
     }
     return BSONElement();
 }
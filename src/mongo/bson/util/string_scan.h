@@ -0,0 +1,77 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(_M_AMD64) || defined(__amd64__)
+#include <emmintrin.h>
+#endif
+
+#include "mongo/platform/bits.h"
+
+namespace mongo {
+
+/**
+ * Returns a pointer to the first NUL byte in [begin, end), or nullptr if there is none. This is
+ * memchr(begin, 0, end - begin), but inlined and tuned for BSON field names and other short
+ * strings, where the call into memchr tends to cost more than the scan itself.
+ *
+ * On x86_64 the range is scanned 16 bytes at a time with SSE2, which every x86_64 CPU supports,
+ * so no runtime dispatch is needed. Other platforms use memchr. Only bytes inside the
+ * range are read.
+ */
+inline const char* findNulByte(const char* begin, const char* end) {
+#if defined(_M_AMD64) || defined(__amd64__)
+    constexpr std::ptrdiff_t kWidth = sizeof(__m128i);
+    const __m128i zero = _mm_setzero_si128();
+    for (; end - begin >= kWidth; begin += kWidth) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(begin));
+        const uint32_t mask = _mm_movemask_epi8(_mm_cmpeq_epi8(chunk, zero));
+        if (mask) {
+            return begin + countTrailingZeros64(mask);
+        }
+    }
+    for (; begin < end; ++begin) {
+        if (*begin == '\0') {
+            return begin;
+        }
+    }
+    return nullptr;
+#else
+    if (begin >= end) {
+        return nullptr;
+    }
+    return static_cast<const char*>(memchr(begin, 0, end - begin));
+#endif
+}
+
+}  // namespace mongo
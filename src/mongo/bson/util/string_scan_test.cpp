@@ -0,0 +1,66 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <cstring>
+#include <vector>
+
+#include "mongo/bson/util/string_scan.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(FindNulByte, MatchesMemchr) {
+    // Cover ranges shorter than, equal to and spanning several vector widths, with the NUL at
+    // every position as well as missing.
+    std::vector<char> buf(80);
+    for (size_t len = 0; len < buf.size(); ++len) {
+        for (size_t nul = 0; nul <= len; ++nul) {
+            std::fill(buf.begin(), buf.end(), 'a');
+            if (nul < len) {
+                buf[nul] = '\0';
+            }
+            const char* begin = buf.data();
+            ASSERT_TRUE(findNulByte(begin, begin + len) == memchr(begin, 0, len));
+        }
+    }
+}
+
+TEST(FindNulByte, IgnoresBytesPastEnd) {
+    const char buf[] = "abcdefghijklmnopqrstuvwxyz";
+    ASSERT_TRUE(findNulByte(buf, buf + 5) == nullptr);
+    ASSERT_TRUE(findNulByte(buf, buf + 20) == nullptr);
+    ASSERT_EQ(findNulByte(buf, buf + sizeof(buf)), buf + sizeof(buf) - 1);
+    ASSERT_TRUE(findNulByte(buf, buf) == nullptr);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -46,6 +46,8 @@ namespace {
 const ServiceContext::Decoration<CollectionCatalog> getCatalog =
     ServiceContext::declareDecoration<CollectionCatalog>();
 
+AtomicWord<uint64_t> nextCatalogInstanceId{1};
+
 class FinishDropCollectionChange : public RecoveryUnit::Change {
 public:
     FinishDropCollectionChange(CollectionCatalog* catalog,
@@ -165,6 +167,8 @@ bool CollectionCatalog::iterator::_exhausted() {
     return _mapIter == _catalog->_orderedCollections.end() || _mapIter->first.first != _dbName;
 }
 
+CollectionCatalog::CollectionCatalog() : _instanceId(nextCatalogInstanceId.fetchAndAdd(1)) {}
+
 CollectionCatalog& CollectionCatalog::get(ServiceContext* svcCtx) {
     return getCatalog(svcCtx);
 }
@@ -197,6 +201,7 @@ void CollectionCatalog::setCollectionNamespace(OperationContext* opCtx,
 
     removeResource(oldRid, fromCollection.ns());
     addResource(newRid, toCollection.ns());
+    _invalidateLookupSnapshot(lock);
 
     opCtx->recoveryUnit()->onRollback([this, coll, fromCollection, toCollection] {
         stdx::lock_guard<Latch> lock(_catalogLock);
@@ -204,6 +209,7 @@ void CollectionCatalog::setCollectionNamespace(OperationContext* opCtx,
 
         _collections[fromCollection] = _collections[toCollection];
         _collections.erase(toCollection);
+        _invalidateLookupSnapshot(lock);
 
         ResourceId oldRid = ResourceId(RESOURCE_COLLECTION, fromCollection.ns());
         ResourceId newRid = ResourceId(RESOURCE_COLLECTION, toCollection.ns());
@@ -223,9 +229,11 @@ void CollectionCatalog::onCloseCatalog(OperationContext* opCtx) {
     invariant(opCtx->lockState()->isW());
     stdx::lock_guard<Latch> lock(_catalogLock);
     invariant(!_shadowCatalog);
-    _shadowCatalog.emplace();
+    auto shadowCatalog = std::make_shared<ShadowCatalogMap>();
     for (auto& entry : _catalog)
-        _shadowCatalog->insert({entry.first, entry.second->ns()});
+        shadowCatalog->insert({entry.first, entry.second->ns()});
+    _shadowCatalog = std::move(shadowCatalog);
+    _invalidateLookupSnapshot(lock);
 }
 
 void CollectionCatalog::onOpenCatalog(OperationContext* opCtx) {
@@ -233,6 +241,44 @@ void CollectionCatalog::onOpenCatalog(OperationContext* opCtx) {
     stdx::lock_guard<Latch> lock(_catalogLock);
     invariant(_shadowCatalog);
     _shadowCatalog.reset();
+    _invalidateLookupSnapshot(lock);
+}
+
+const CollectionCatalog::LookupSnapshot& CollectionCatalog::_getLookupSnapshot() const {
+    struct CachedSnapshot {
+        uint64_t catalogId = 0;
+        uint64_t version = 0;
+        std::shared_ptr<const LookupSnapshot> snapshot;
+    };
+    static thread_local CachedSnapshot cached;
+
+    if (cached.catalogId == _instanceId && cached.version == _lookupVersion.load()) {
+        return *cached.snapshot;
+    }
+
+    stdx::lock_guard<Latch> lock(_catalogLock);
+    if (!_lookupSnapshot) {
+        auto snapshot = std::make_shared<LookupSnapshot>();
+        snapshot->byUUID.reserve(_catalog.size());
+        snapshot->byNss.reserve(_catalog.size());
+        for (auto&& [uuid, coll] : _catalog) {
+            LookupSnapshot::Entry entry{coll.get(), coll->ns(), uuid};
+            snapshot->byNss.emplace(entry.nss, entry);
+            snapshot->byUUID.emplace(uuid, std::move(entry));
+        }
+        snapshot->shadowCatalog = _shadowCatalog;
+        _lookupSnapshot = std::move(snapshot);
+    }
+
+    cached.catalogId = _instanceId;
+    cached.version = _lookupVersion.load();
+    cached.snapshot = _lookupSnapshot;
+    return *cached.snapshot;
+}
+
+void CollectionCatalog::_invalidateLookupSnapshot(WithLock) {
+    _lookupSnapshot.reset();
+    _lookupVersion.fetchAndAdd(1);
 }
 
 Collection* CollectionCatalog::lookupCollectionByUUID(OperationContext* opCtx,
@@ -241,8 +287,9 @@ Collection* CollectionCatalog::lookupCollectionByUUID(OperationContext* opCtx,
         return coll;
     }
 
-    stdx::lock_guard<Latch> lock(_catalogLock);
-    return _lookupCollectionByUUID(lock, uuid);
+    const auto& snapshot = _getLookupSnapshot();
+    auto it = snapshot.byUUID.find(uuid);
+    return it == snapshot.byUUID.end() ? nullptr : it->second.collection;
 }
 
 Collection* CollectionCatalog::_lookupCollectionByUUID(WithLock, CollectionUUID uuid) const {
@@ -256,9 +303,9 @@ Collection* CollectionCatalog::lookupCollectionByNamespace(OperationContext* opC
         return coll;
     }
 
-    stdx::lock_guard<Latch> lock(_catalogLock);
-    auto it = _collections.find(nss);
-    return it == _collections.end() ? nullptr : it->second;
+    const auto& snapshot = _getLookupSnapshot();
+    auto it = snapshot.byNss.find(nss);
+    return it == snapshot.byNss.end() ? nullptr : it->second.collection;
 }
 
 boost::optional<NamespaceString> CollectionCatalog::lookupNSSByUUID(OperationContext* opCtx,
@@ -267,10 +314,10 @@ boost::optional<NamespaceString> CollectionCatalog::lookupNSSByUUID(OperationCon
         return coll->ns();
     }
 
-    stdx::lock_guard<Latch> lock(_catalogLock);
-    auto foundIt = _catalog.find(uuid);
-    if (foundIt != _catalog.end()) {
-        NamespaceString ns = foundIt->second->ns();
+    const auto& snapshot = _getLookupSnapshot();
+    auto foundIt = snapshot.byUUID.find(uuid);
+    if (foundIt != snapshot.byUUID.end()) {
+        const NamespaceString& ns = foundIt->second.nss;
         invariant(!ns.isEmpty());
         return ns;
     }
@@ -278,9 +325,9 @@ boost::optional<NamespaceString> CollectionCatalog::lookupNSSByUUID(OperationCon
     // Only in the case that the catalog is closed and a UUID is currently unknown, resolve it
     // using the pre-close state. This ensures that any tasks reloading the catalog can see their
     // own updates.
-    if (_shadowCatalog) {
-        auto shadowIt = _shadowCatalog->find(uuid);
-        if (shadowIt != _shadowCatalog->end())
+    if (snapshot.shadowCatalog) {
+        auto shadowIt = snapshot.shadowCatalog->find(uuid);
+        if (shadowIt != snapshot.shadowCatalog->end())
             return shadowIt->second;
     }
     return boost::none;
@@ -292,10 +339,10 @@ boost::optional<CollectionUUID> CollectionCatalog::lookupUUIDByNSS(
         return coll->uuid();
     }
 
-    stdx::lock_guard<Latch> lock(_catalogLock);
-    auto it = _collections.find(nss);
-    if (it != _collections.end()) {
-        return it->second->uuid();
+    const auto& snapshot = _getLookupSnapshot();
+    auto it = snapshot.byNss.find(nss);
+    if (it != snapshot.byNss.end()) {
+        return it->second.uuid;
     }
     return boost::none;
 }
@@ -407,6 +454,8 @@ void CollectionCatalog::registerCollection(CollectionUUID uuid, std::unique_ptr<
 
     auto collRid = ResourceId(RESOURCE_COLLECTION, ns.ns());
     addResource(collRid, ns.ns());
+
+    _invalidateLookupSnapshot(lock);
 }
 
 std::unique_ptr<Collection> CollectionCatalog::deregisterCollection(CollectionUUID uuid) {
@@ -435,6 +484,7 @@ std::unique_ptr<Collection> CollectionCatalog::deregisterCollection(CollectionUU
     // Removal from an ordered map will invalidate iterators and potentially references to the
     // references to the erased element.
     _generationNumber++;
+    _invalidateLookupSnapshot(lock);
 
     return coll;
 }
@@ -467,6 +517,7 @@ void CollectionCatalog::deregisterAllCollections() {
     _resourceInformation.clear();
 
     _generationNumber++;
+    _invalidateLookupSnapshot(lock);
 }
 
 CollectionCatalog::iterator CollectionCatalog::begin(StringData db) const {
@@ -97,7 +97,7 @@ public:
 
     static CollectionCatalog& get(ServiceContext* svcCtx);
     static CollectionCatalog& get(OperationContext* opCtx);
-    CollectionCatalog() = default;
+    CollectionCatalog();
 
     /**
      * This function is responsible for safely setting the namespace string inside 'coll' to the
@@ -139,6 +139,10 @@ public:
      * The required locks must be obtained prior to calling this function, or else the found
      * Collection pointer might no longer be valid when the call returns.
      *
+     * This and the other lookups by UUID or namespace below read a published snapshot of the
+     * catalog and do not take '_catalogLock' unless the catalog changed since the calling thread
+     * last looked.
+     *
      * Returns nullptr if the 'uuid' is not known.
      */
     Collection* lookupCollectionByUUID(OperationContext* opCtx, CollectionUUID uuid) const;
@@ -250,6 +254,38 @@ public:
 private:
     friend class CollectionCatalog::iterator;
 
+    using ShadowCatalogMap =
+        mongo::stdx::unordered_map<CollectionUUID, NamespaceString, CollectionUUID::Hash>;
+
+    /**
+     * An immutable copy of the UUID and namespace lookup maps which readers share without holding
+     * '_catalogLock'. It records the namespace and UUID of every collection, so that readers never
+     * dereference a Collection which may be concurrently renamed or destroyed.
+     */
+    struct LookupSnapshot {
+        struct Entry {
+            Collection* collection;
+            NamespaceString nss;
+            CollectionUUID uuid;
+        };
+
+        mongo::stdx::unordered_map<CollectionUUID, Entry, CollectionUUID::Hash> byUUID;
+        mongo::stdx::unordered_map<NamespaceString, Entry> byNss;
+        std::shared_ptr<const ShadowCatalogMap> shadowCatalog;
+    };
+
+    /**
+     * Returns the calling thread's copy of the current LookupSnapshot. The snapshot is only
+     * rebuilt, under '_catalogLock', by the first reader to notice that '_lookupVersion' moved.
+     * The reference stays valid until this thread next calls this function.
+     */
+    const LookupSnapshot& _getLookupSnapshot() const;
+
+    /**
+     * Must be called by every change to the lookup maps or the shadow catalog.
+     */
+    void _invalidateLookupSnapshot(WithLock);
+
     Collection* _lookupCollectionByUUID(WithLock, CollectionUUID uuid) const;
 
     const std::vector<CollectionUUID>& _getOrdering_inlock(const StringData& db,
@@ -260,9 +296,7 @@ private:
      * When present, indicates that the catalog is in closed state, and contains a map from UUID
      * to pre-close NSS. See also onCloseCatalog.
      */
-    boost::optional<
-        mongo::stdx::unordered_map<CollectionUUID, NamespaceString, CollectionUUID::Hash>>
-        _shadowCatalog;
+    std::shared_ptr<const ShadowCatalogMap> _shadowCatalog;
 
     using CollectionCatalogMap = mongo::stdx::
         unordered_map<CollectionUUID, std::unique_ptr<Collection>, CollectionUUID::Hash>;
@@ -277,6 +311,17 @@ private:
      */
     uint64_t _generationNumber;
 
+    // Distinguishes this catalog from any other in the per-thread snapshot caches.
+    const uint64_t _instanceId;
+
+    // Bumped under '_catalogLock' whenever '_lookupSnapshot' is invalidated. Readers compare it
+    // with the version of their cached snapshot, which is the only shared state they touch.
+    AtomicWord<uint64_t> _lookupVersion{0};
+
+    // The snapshot for the current '_lookupVersion', or null until some reader needs it. Protected
+    // by '_catalogLock'.
+    mutable std::shared_ptr<const LookupSnapshot> _lookupSnapshot;
+
     // Protects _resourceInformation.
     mutable Mutex _resourceLock = MONGO_MAKE_LATCH("CollectionCatalog::_resourceLock");
 
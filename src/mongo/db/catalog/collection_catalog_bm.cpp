@@ -0,0 +1,111 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/catalog/collection_catalog.h"
+#include "mongo/db/catalog/collection_mock.h"
+#include "mongo/db/operation_context_noop.h"
+
+namespace mongo {
+namespace {
+
+const int kMaxPerfThreads = 64;
+const int kNumCollections = 1000;
+
+/**
+ * Registers kNumCollections collections in a catalog shared by every benchmark and thread, so that
+ * all lookups contend on the same catalog.
+ */
+class CatalogLookupTest : public benchmark::Fixture {
+public:
+    struct Catalog {
+        Catalog() {
+            for (int i = 0; i < kNumCollections; ++i) {
+                NamespaceString nss("test", "coll" + std::to_string(i));
+                auto uuid = CollectionUUID::gen();
+                std::unique_ptr<Collection> coll = std::make_unique<CollectionMock>(nss);
+                catalog.registerCollection(uuid, &coll);
+                namespaces.push_back(nss);
+                uuids.push_back(uuid);
+            }
+        }
+
+        CollectionCatalog catalog;
+        std::vector<NamespaceString> namespaces;
+        std::vector<CollectionUUID> uuids;
+    };
+
+    static Catalog& getCatalog() {
+        static Catalog catalog;
+        return catalog;
+    }
+};
+
+BENCHMARK_DEFINE_F(CatalogLookupTest, BM_LookupCollectionByUUID)(benchmark::State& state) {
+    auto& c = getCatalog();
+    OperationContextNoop opCtx;
+    size_t i = state.thread_index;
+
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(
+            c.catalog.lookupCollectionByUUID(&opCtx, c.uuids[i++ % kNumCollections]));
+    }
+}
+
+BENCHMARK_DEFINE_F(CatalogLookupTest, BM_LookupCollectionByNamespace)(benchmark::State& state) {
+    auto& c = getCatalog();
+    OperationContextNoop opCtx;
+    size_t i = state.thread_index;
+
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(
+            c.catalog.lookupCollectionByNamespace(&opCtx, c.namespaces[i++ % kNumCollections]));
+    }
+}
+
+BENCHMARK_DEFINE_F(CatalogLookupTest, BM_LookupNSSByUUID)(benchmark::State& state) {
+    auto& c = getCatalog();
+    OperationContextNoop opCtx;
+    size_t i = state.thread_index;
+
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(c.catalog.lookupNSSByUUID(&opCtx, c.uuids[i++ % kNumCollections]));
+    }
+}
+
+BENCHMARK_REGISTER_F(CatalogLookupTest, BM_LookupCollectionByUUID)->ThreadRange(1, kMaxPerfThreads);
+BENCHMARK_REGISTER_F(CatalogLookupTest, BM_LookupCollectionByNamespace)
+    ->ThreadRange(1, kMaxPerfThreads);
+BENCHMARK_REGISTER_F(CatalogLookupTest, BM_LookupNSSByUUID)->ThreadRange(1, kMaxPerfThreads);
+
+}  // namespace
+}  // namespace mongo
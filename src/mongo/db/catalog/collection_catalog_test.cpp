@@ -38,6 +38,7 @@
 #include "mongo/db/operation_context_noop.h"
 #include "mongo/db/service_context_d_test_fixture.h"
 #include "mongo/db/storage/durable_catalog.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/death_test.h"
 #include "mongo/unittest/unittest.h"
 
@@ -525,6 +526,39 @@ TEST_F(CollectionCatalogTest, RenameCollection) {
     ASSERT_EQUALS(catalog.lookupCollectionByUUID(&opCtx, uuid), collection);
 }
 
+TEST_F(CollectionCatalogTest, LookupsOnOtherThreadsObserveRename) {
+    auto uuid = CollectionUUID::gen();
+    NamespaceString oldNss(nss.db(), "oldcol");
+    std::unique_ptr<Collection> collUnique = std::make_unique<CollectionMock>(oldNss);
+    auto collection = collUnique.get();
+    catalog.registerCollection(uuid, &collUnique);
+
+    auto lookUpOnOtherThread = [&](auto lookup) {
+        stdx::thread thread([&] {
+            OperationContextNoop otherOpCtx;
+            lookup(&otherOpCtx);
+        });
+        thread.join();
+    };
+
+    // Leave a cached snapshot behind on this thread too.
+    ASSERT_EQUALS(*catalog.lookupNSSByUUID(&opCtx, uuid), oldNss);
+    lookUpOnOtherThread([&](OperationContext* otherOpCtx) {
+        ASSERT_EQUALS(*catalog.lookupNSSByUUID(otherOpCtx, uuid), oldNss);
+    });
+
+    NamespaceString newNss(nss.db(), "newcol");
+    catalog.setCollectionNamespace(&opCtx, collection, oldNss, newNss);
+
+    ASSERT_EQUALS(*catalog.lookupNSSByUUID(&opCtx, uuid), newNss);
+    lookUpOnOtherThread([&](OperationContext* otherOpCtx) {
+        ASSERT_EQUALS(*catalog.lookupNSSByUUID(otherOpCtx, uuid), newNss);
+        ASSERT_EQUALS(*catalog.lookupUUIDByNSS(otherOpCtx, newNss), uuid);
+        ASSERT_EQUALS(catalog.lookupCollectionByNamespace(otherOpCtx, newNss), collection);
+        ASSERT(catalog.lookupCollectionByNamespace(otherOpCtx, oldNss) == nullptr);
+    });
+}
+
 TEST_F(CollectionCatalogTest, LookupNSSByUUIDForClosedCatalogReturnsOldNSSIfDropped) {
     catalog.onCloseCatalog(&opCtx);
     catalog.deregisterCollection(colUUID);
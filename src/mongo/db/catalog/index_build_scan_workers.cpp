@@ -0,0 +1,185 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kIndex
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/catalog/index_build_scan_workers.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/str.h"
+#include "mongo/util/timer.h"
+
+namespace mongo {
+namespace {
+
+// Documents go to the workers in batches so that the queue's mutex is not taken per document.
+constexpr size_t kMaxBatchDocs = 256;
+constexpr size_t kMaxBatchBytes = 1024 * 1024;
+
+// How many full batches may wait for each worker before add() blocks. This bounds the memory the
+// queue uses to a few megabytes per worker.
+constexpr size_t kQueuedBatchesPerWorker = 2;
+
+}  // namespace
+
+IndexBuildScanWorkers::IndexBuildScanWorkers(size_t numWorkers, ProcessFn process)
+    : _process(std::move(process)), _workers(numWorkers) {
+    invariant(numWorkers > 0);
+    for (size_t i = 0; i < numWorkers; ++i) {
+        _workers[i].thread = stdx::thread([this, i] {
+            setThreadName(str::stream() << "IndexBuildScanWorker-" << i);
+            _run(i);
+        });
+    }
+}
+
+IndexBuildScanWorkers::~IndexBuildScanWorkers() {
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stopped = true;
+        _queue.clear();
+    }
+    _workAvailable.notify_all();
+    for (auto&& worker : _workers) {
+        if (worker.thread.joinable()) {
+            worker.thread.join();
+        }
+    }
+}
+
+Status IndexBuildScanWorkers::add(OperationContext* opCtx,
+                                  const BSONObj& doc,
+                                  const RecordId& loc) {
+    _batch.emplace_back(doc.getOwned(), loc);
+    _batchBytes += doc.objsize();
+    if (_batch.size() < kMaxBatchDocs && _batchBytes < kMaxBatchBytes) {
+        return Status::OK();
+    }
+
+    try {
+        stdx::unique_lock<Latch> lk(_mutex);
+        opCtx->waitForConditionOrInterrupt(_spaceAvailable, lk, [&] {
+            return !_status.isOK() || _queue.size() < kQueuedBatchesPerWorker * _workers.size();
+        });
+        if (!_status.isOK()) {
+            return _status;
+        }
+        _pushBatch(lk);
+    } catch (...) {
+        return exceptionToStatus();
+    }
+    return Status::OK();
+}
+
+Status IndexBuildScanWorkers::finish() {
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (!_batch.empty() && _status.isOK()) {
+            _pushBatch(lk);
+        }
+        _finishing = true;
+    }
+    _workAvailable.notify_all();
+    for (auto&& worker : _workers) {
+        worker.thread.join();
+    }
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _status;
+}
+
+void IndexBuildScanWorkers::appendStats(BSONObjBuilder* builder,
+                                        const AppendWorkerStatsFn& appendWorkerStats) const {
+    BSONArrayBuilder workers(builder->subarrayStart("workers"));
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        BSONObjBuilder stats(workers.subobjStart());
+        stats.append("docs", _workers[i].docs.load());
+        stats.append("busyMillis", _workers[i].busyMicros.load() / 1000);
+        if (appendWorkerStats) {
+            appendWorkerStats(i, &stats);
+        }
+    }
+}
+
+void IndexBuildScanWorkers::_pushBatch(WithLock) {
+    _queue.push_back(std::move(_batch));
+    _batch.clear();
+    _batchBytes = 0;
+    _workAvailable.notify_one();
+}
+
+void IndexBuildScanWorkers::_run(size_t workerNum) {
+    auto& worker = _workers[workerNum];
+
+    stdx::unique_lock<Latch> lk(_mutex);
+    while (true) {
+        _workAvailable.wait(lk, [&] { return _stopped || _finishing || !_queue.empty(); });
+        if (_stopped || _queue.empty()) {
+            return;
+        }
+
+        auto batch = std::move(_queue.front());
+        _queue.pop_front();
+        _spaceAvailable.notify_one();
+        lk.unlock();
+
+        Timer timer;
+        Status status = Status::OK();
+        for (auto&& [doc, loc] : batch) {
+            try {
+                status = _process(workerNum, doc, loc);
+            } catch (...) {
+                status = exceptionToStatus();
+            }
+            if (!status.isOK()) {
+                break;
+            }
+            worker.docs.fetchAndAdd(1);
+        }
+        worker.busyMicros.fetchAndAdd(timer.micros());
+
+        lk.lock();
+        if (!status.isOK()) {
+            if (_status.isOK()) {
+                _status = status;
+            }
+            _stopped = true;
+            _queue.clear();
+            _workAvailable.notify_all();
+            _spaceAvailable.notify_all();
+            return;
+        }
+    }
+}
+
+}  // namespace mongo
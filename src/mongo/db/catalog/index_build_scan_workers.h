@@ -0,0 +1,137 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/bson/bsonobj.h"
+#include "mongo/db/record_id.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/with_lock.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+class OperationContext;
+
+/**
+ * Spreads the key generation and sorting for an index build's collection scan over several
+ * threads. The scanning thread hands each document to add(), which groups them into batches that
+ * go to whichever worker is free next. A worker calls the supplied function on each document in
+ * its batches, passing its own worker number so that the function can use per-worker state (e.g.
+ * a Sorter) without synchronization.
+ *
+ * The first error a worker returns stops all workers and is returned by the next call to add() or
+ * finish().
+ */
+class IndexBuildScanWorkers {
+    IndexBuildScanWorkers(const IndexBuildScanWorkers&) = delete;
+    IndexBuildScanWorkers& operator=(const IndexBuildScanWorkers&) = delete;
+
+public:
+    using ProcessFn = std::function<Status(size_t worker, const BSONObj& doc, const RecordId& loc)>;
+    using AppendWorkerStatsFn = std::function<void(size_t worker, BSONObjBuilder* builder)>;
+
+    /**
+     * Starts 'numWorkers' threads.
+     */
+    IndexBuildScanWorkers(size_t numWorkers, ProcessFn process);
+
+    /**
+     * Stops the workers without waiting for them to process what they have not got to yet.
+     */
+    ~IndexBuildScanWorkers();
+
+    /**
+     * Queues a copy of 'doc' to be processed. Blocks, interruptibly, while the workers are far
+     * enough behind.
+     */
+    Status add(OperationContext* opCtx, const BSONObj& doc, const RecordId& loc);
+
+    /**
+     * Waits for the workers to process everything added so far and stops them. This does not take
+     * long, as add() keeps only a few batches per worker queued.
+     */
+    Status finish();
+
+    size_t numWorkers() const {
+        return _workers.size();
+    }
+
+    /**
+     * Appends a "workers" array with the number of documents each worker has processed and the
+     * time it has spent processing them. If given, 'appendWorkerStats' adds what the caller knows
+     * about each worker, such as the state its ProcessFn keeps. May be called while the workers
+     * are running.
+     */
+    void appendStats(BSONObjBuilder* builder,
+                     const AppendWorkerStatsFn& appendWorkerStats = nullptr) const;
+
+private:
+    using Batch = std::vector<std::pair<BSONObj, RecordId>>;
+
+    struct Worker {
+        stdx::thread thread;
+        AtomicWord<long long> docs;
+        AtomicWord<long long> busyMicros;
+    };
+
+    void _run(size_t worker);
+
+    /**
+     * Queues '_batch'. Must hold '_mutex'.
+     */
+    void _pushBatch(WithLock);
+
+    const ProcessFn _process;
+
+    // The batch add() is filling, and how many bytes of documents it holds.
+    Batch _batch;
+    size_t _batchBytes = 0;
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("IndexBuildScanWorkers::_mutex");
+    stdx::condition_variable _workAvailable;
+    stdx::condition_variable _spaceAvailable;
+    std::deque<Batch> _queue;
+    bool _finishing = false;  // No more batches are coming.
+    bool _stopped = false;    // Workers should exit without emptying the queue.
+    Status _status = Status::OK();
+
+    std::vector<Worker> _workers;
+};
+
+}  // namespace mongo
@@ -0,0 +1,125 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/catalog/index_build_scan_workers.h"
+
+#include <set>
+
+#include "mongo/db/jsobj.h"
+#include "mongo/db/service_context_test_fixture.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+class IndexBuildScanWorkersTest : public ServiceContextTest {
+protected:
+    ServiceContext::UniqueOperationContext _opCtx = makeOperationContext();
+};
+
+TEST_F(IndexBuildScanWorkersTest, EveryDocumentIsProcessedOnce) {
+    const int kNumDocs = 10000;
+
+    auto mutex = MONGO_MAKE_LATCH();
+    std::set<long long> seen;
+    IndexBuildScanWorkers workers(4, [&](size_t worker, const BSONObj& doc, const RecordId& loc) {
+        ASSERT_LT(worker, 4U);
+        ASSERT_EQ(doc["_id"].numberLong(), loc.repr());
+        stdx::lock_guard<Latch> lk(mutex);
+        ASSERT_TRUE(seen.insert(loc.repr()).second);
+        return Status::OK();
+    });
+
+    for (int i = 0; i < kNumDocs; ++i) {
+        ASSERT_OK(workers.add(_opCtx.get(), BSON("_id" << i), RecordId(i)));
+    }
+    ASSERT_OK(workers.finish());
+    ASSERT_EQ(seen.size(), static_cast<size_t>(kNumDocs));
+
+    BSONObjBuilder builder;
+    workers.appendStats(&builder, [](size_t worker, BSONObjBuilder* workerBuilder) {
+        workerBuilder->append("worker", static_cast<long long>(worker));
+    });
+    long long docs = 0;
+    long long workerNum = 0;
+    for (auto&& worker : builder.obj()["workers"].Array()) {
+        docs += worker["docs"].numberLong();
+        ASSERT_EQ(worker["worker"].numberLong(), workerNum++);
+    }
+    ASSERT_EQ(docs, kNumDocs);
+    ASSERT_EQ(workerNum, 4);
+}
+
+TEST_F(IndexBuildScanWorkersTest, FirstErrorIsReturned) {
+    IndexBuildScanWorkers workers(2, [](size_t, const BSONObj& doc, const RecordId&) {
+        if (doc["_id"].numberInt() == 500) {
+            return Status(ErrorCodes::CannotIndexParallelArrays, "bad document");
+        }
+        return Status::OK();
+    });
+
+    Status status = Status::OK();
+    for (int i = 0; i < 10000 && status.isOK(); ++i) {
+        status = workers.add(_opCtx.get(), BSON("_id" << i), RecordId(i));
+    }
+    if (status.isOK()) {
+        status = workers.finish();
+    }
+    ASSERT_EQ(status, ErrorCodes::CannotIndexParallelArrays);
+}
+
+TEST_F(IndexBuildScanWorkersTest, InterruptedWhileWaitingForWorkers) {
+    auto mutex = MONGO_MAKE_LATCH();
+    stdx::condition_variable cv;
+    bool release = false;
+    IndexBuildScanWorkers workers(1, [&](size_t, const BSONObj&, const RecordId&) {
+        stdx::unique_lock<Latch> lk(mutex);
+        cv.wait(lk, [&] { return release; });
+        return Status::OK();
+    });
+
+    _opCtx->markKilled(ErrorCodes::Interrupted);
+    Status status = Status::OK();
+    for (int i = 0; i < 10000 && status.isOK(); ++i) {
+        status = workers.add(_opCtx.get(), BSON("_id" << i), RecordId(i));
+    }
+    ASSERT_EQ(status, ErrorCodes::Interrupted);
+
+    {
+        stdx::lock_guard<Latch> lk(mutex);
+        release = true;
+    }
+    cv.notify_all();
+}
+
+}  // namespace
+}  // namespace mongo
@@ -38,11 +38,13 @@
 #include "mongo/base/error_codes.h"
 #include "mongo/db/audit.h"
 #include "mongo/db/catalog/collection.h"
+#include "mongo/db/catalog/index_build_scan_workers.h"
 #include "mongo/db/catalog/index_timestamp_helper.h"
 #include "mongo/db/catalog/multi_index_block_gen.h"
 #include "mongo/db/catalog/uncommitted_collections.h"
 #include "mongo/db/client.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/index/index_build_interceptor.h"
 #include "mongo/db/index/multikey_paths.h"
 #include "mongo/db/multi_key_path_tracker.h"
 #include "mongo/db/op_observer.h"
@@ -262,6 +264,12 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlock::init(OperationContext* opCtx,
                 indexSpecs.size();
         }
 
+        // Hybrid builds and non-hybrid foreground builds use the bulk builder, which can generate
+        // and sort keys on several threads while this one scans the collection.
+        const bool useBulk =
+            _method == IndexBuildMethod::kHybrid || _method == IndexBuildMethod::kForeground;
+        _numScanWorkers = useBulk ? static_cast<size_t>(indexBuildScanWorkers.load()) : 1;
+
         for (size_t i = 0; i < indexSpecs.size(); i++) {
             BSONObj info = indexSpecs[i];
             StatusWith<BSONObj> statusWithInfo =
@@ -298,13 +306,11 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlock::init(OperationContext* opCtx,
             if (!status.isOK())
                 return status;
 
-            // Hybrid builds and non-hybrid foreground builds use the bulk builder.
-            const bool useBulk =
-                _method == IndexBuildMethod::kHybrid || _method == IndexBuildMethod::kForeground;
             if (useBulk) {
                 // Bulk build process requires foreground building as it assumes nothing is changing
                 // under it.
-                index.bulk = index.real->initiateBulk(eachIndexBuildMaxMemoryUsageBytes);
+                index.bulk =
+                    index.real->initiateBulk(eachIndexBuildMaxMemoryUsageBytes, _numScanWorkers);
             }
 
             const IndexDescriptor* descriptor = index.block->getEntry()->descriptor();
@@ -326,6 +332,8 @@ StatusWith<std::vector<BSONObj>> MultiIndexBlock::init(OperationContext* opCtx,
             if (index.bulk)
                 log() << "build may temporarily use up to "
                       << eachIndexBuildMaxMemoryUsageBytes / 1024 / 1024 << " megabytes of RAM";
+            if (_numScanWorkers > 1)
+                log() << "index build: generating keys on " << _numScanWorkers << " threads";
 
             index.filterExpression = index.block->getEntry()->getFilterExpression();
 
@@ -417,6 +425,24 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
                 "Failed index build because of failpoint 'hangAndThenFailIndexBuild'"};
     }
 
+    // With several scan workers, this thread only reads the collection, which keeps the reads
+    // sequential, and hands the documents to the workers to generate and sort their keys. The
+    // documents whose key generation errors the workers suppress are recorded once the scan is
+    // done.
+    std::vector<std::vector<std::pair<size_t, RecordId>>> skippedByWorker(_numScanWorkers);
+    std::unique_ptr<IndexBuildScanWorkers> workers;
+    if (_numScanWorkers > 1) {
+        workers = std::make_unique<IndexBuildScanWorkers>(
+            _numScanWorkers,
+            [this, &skippedByWorker](size_t worker, const BSONObj& doc, const RecordId& loc) {
+                return _insertFromWorker(worker, doc, loc, &skippedByWorker[worker]);
+            });
+    }
+    Timer workerStatsTimer;
+    const auto appendSorterStats = [this](size_t worker, BSONObjBuilder* builder) {
+        _appendScanWorkerSorterStats(worker, builder);
+    };
+
     Timer t;
 
     unsigned long long n = 0;
@@ -469,20 +495,28 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
 
             failPointHangDuringBuild(&hangBeforeIndexBuildOf, "before", objToIndex.value());
 
-            WriteUnitOfWork wunit(opCtx);
-            Status ret = insert(opCtx, objToIndex.value(), loc);
-            if (_method == IndexBuildMethod::kBackground)
-                exec->saveState();
-            if (!ret.isOK()) {
-                // Fail the index build hard.
-                return ret;
-            }
-            wunit.commit();
-            if (_method == IndexBuildMethod::kBackground) {
-                try {
-                    exec->restoreState();  // Handles any WCEs internally.
-                } catch (...) {
-                    return exceptionToStatus();
+            if (workers) {
+                Status ret = workers->add(opCtx, objToIndex.value(), loc);
+                if (!ret.isOK()) {
+                    // Fail the index build hard.
+                    return ret;
+                }
+            } else {
+                WriteUnitOfWork wunit(opCtx);
+                Status ret = insert(opCtx, objToIndex.value(), loc);
+                if (_method == IndexBuildMethod::kBackground)
+                    exec->saveState();
+                if (!ret.isOK()) {
+                    // Fail the index build hard.
+                    return ret;
+                }
+                wunit.commit();
+                if (_method == IndexBuildMethod::kBackground) {
+                    try {
+                        exec->restoreState();  // Handles any WCEs internally.
+                    } catch (...) {
+                        return exceptionToStatus();
+                    }
                 }
             }
 
@@ -492,6 +526,14 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
             progress->hit();
             n++;
             retries = 0;
+
+            if (workers && workerStatsTimer.millis() >= 1000) {
+                BSONObjBuilder workerStats;
+                workers->appendStats(&workerStats, appendSorterStats);
+                stdx::unique_lock<Client> lk(*opCtx->getClient());
+                CurOp::get(opCtx)->setProgressDetail_inlock(workerStats.obj());
+                workerStatsTimer.reset();
+            }
         } catch (const WriteConflictException&) {
             // Only background builds write inside transactions, and therefore should only ever
             // generate WCEs.
@@ -517,6 +559,33 @@ Status MultiIndexBlock::insertAllDocumentsInCollection(OperationContext* opCtx,
         return exec->getMemberObjectStatus(objToIndex.value());
     }
 
+    if (workers) {
+        Status ret = workers->finish();
+        if (!ret.isOK())
+            return ret;
+
+        BSONObjBuilder workerStats;
+        workers->appendStats(&workerStats, appendSorterStats);
+        log() << "index build: key generation done on " << workers->numWorkers()
+              << " threads: " << workerStats.obj();
+
+        for (const auto& skipped : skippedByWorker) {
+            for (const auto& [indexNo, skippedLoc] : skipped) {
+                auto interceptor = _indexes[indexNo].block->getEntry()->indexBuildInterceptor();
+                try {
+                    writeConflictRetry(
+                        opCtx, "recording skipped record", collection->ns().ns(), [&] {
+                            WriteUnitOfWork wunit(opCtx);
+                            interceptor->getSkippedRecordTracker()->record(opCtx, skippedLoc);
+                            wunit.commit();
+                        });
+                } catch (...) {
+                    return exceptionToStatus();
+                }
+            }
+        }
+    }
+
     if (MONGO_unlikely(leaveIndexBuildUnfinishedForShutdown.shouldFail())) {
         log() << "Index build interrupted due to 'leaveIndexBuildUnfinishedForShutdown' failpoint. "
                  "Mimicking shutdown error code.";
@@ -587,6 +656,50 @@ Status MultiIndexBlock::insert(OperationContext* opCtx, const BSONObj& doc, cons
     return Status::OK();
 }
 
+Status MultiIndexBlock::_insertFromWorker(size_t worker,
+                                          const BSONObj& doc,
+                                          const RecordId& loc,
+                                          std::vector<std::pair<size_t, RecordId>>* skipped) {
+    std::vector<RecordId> skippedLocs;
+    for (size_t i = 0; i < _indexes.size(); i++) {
+        if (_indexes[i].filterExpression && !_indexes[i].filterExpression->matchesBSON(doc)) {
+            continue;
+        }
+
+        // The worker's Sorter performs file I/O that may result in an exception.
+        Status idxStatus = Status::OK();
+        try {
+            idxStatus = _indexes[i].bulk->insertFromWorker(
+                worker, doc, loc, _indexes[i].options, &skippedLocs);
+        } catch (...) {
+            return exceptionToStatus();
+        }
+
+        if (!idxStatus.isOK())
+            return idxStatus;
+
+        for (const auto& skippedLoc : skippedLocs) {
+            skipped->emplace_back(i, skippedLoc);
+        }
+        skippedLocs.clear();
+    }
+    return Status::OK();
+}
+
+void MultiIndexBlock::_appendScanWorkerSorterStats(size_t worker, BSONObjBuilder* builder) const {
+    long long memUsedBytes = 0;
+    long long numSpills = 0;
+    for (const auto& index : _indexes) {
+        if (index.bulk) {
+            const auto stats = index.bulk->getWorkerSorterStats(worker);
+            memUsedBytes += stats.memUsedBytes;
+            numSpills += stats.numSpills;
+        }
+    }
+    builder->append("sorterMemUsedBytes", memUsedBytes);
+    builder->append("sorterSpills", numSpills);
+}
+
 Status MultiIndexBlock::dumpInsertsFromBulk(OperationContext* opCtx) {
     return dumpInsertsFromBulk(opCtx, nullptr);
 }
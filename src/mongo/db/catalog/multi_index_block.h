@@ -338,6 +338,22 @@ private:
         InsertDeleteOptions options;
     };
 
+    /**
+     * Like insert(), but on behalf of collection scan worker 'worker'. Appends the index number
+     * and location of each document whose key generation error was suppressed to 'skipped',
+     * instead of recording it in the index's skipped record tracker.
+     */
+    Status _insertFromWorker(size_t worker,
+                             const BSONObj& doc,
+                             const RecordId& loc,
+                             std::vector<std::pair<size_t, RecordId>>* skipped);
+
+    /**
+     * Appends the memory held by collection scan worker 'worker's Sorters, summed over the indexes
+     * being built, and how many times they have spilled to disk.
+     */
+    void _appendScanWorkerSorterStats(size_t worker, BSONObjBuilder* builder) const;
+
     /**
      * Returns the current state.
      */
@@ -362,6 +378,10 @@ private:
 
     IndexBuildMethod _method = IndexBuildMethod::kHybrid;
 
+    // Number of threads that generate keys for the documents the collection scan returns. Set
+    // during init(); only builds that use the bulk builder have more than one.
+    size_t _numScanWorkers = 1;
+
     bool _ignoreUnique = false;
 
     bool _needToCleanup = true;
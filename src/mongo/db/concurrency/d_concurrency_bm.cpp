@@ -42,6 +42,9 @@ namespace {
 
 const int kMaxPerfThreads = 16;  // max number of threads to use for lock perf
 
+// Max number of threads to use for intent lock perf, which is meant to scale with cores.
+const int kMaxIntentLockPerfThreads = 128;
+
 
 class DConcurrencyTest : public benchmark::Fixture {
 public:
@@ -64,6 +67,7 @@ protected:
     std::vector<std::pair<ServiceContext::UniqueClient, ServiceContext::UniqueOperationContext>>
         clients;
     std::array<LockerImpl, kMaxPerfThreads> locker;
+    std::unique_ptr<LockManager> lockManager;
 };
 
 BENCHMARK_DEFINE_F(DConcurrencyTest, BM_StdMutex)(benchmark::State& state) {
@@ -128,6 +132,34 @@ BENCHMARK_DEFINE_F(DConcurrencyTest, BM_CollectionIntentExclusiveLock)(benchmark
     }
 }
 
+/**
+ * Acquires and releases a collection lock in MODE_IX directly through a LockManager. When given
+ * non-zero arguments, the LockManager uses that many buckets and partitions, so {128, 32} shows
+ * the fixed sizing used before the lock manager scaled with the number of cores.
+ */
+BENCHMARK_DEFINE_F(DConcurrencyTest, BM_LockManagerIntentExclusive)(benchmark::State& state) {
+    if (state.thread_index == 0) {
+        lockManager = state.range(0)
+            ? std::make_unique<LockManager>(state.range(0), state.range(1))
+            : std::make_unique<LockManager>();
+    }
+
+    const ResourceId resId(RESOURCE_COLLECTION, std::string("test.coll"));
+    LockerImpl threadLocker;
+    TrackingLockGrantNotification notify;
+
+    for (auto keepRunning : state) {
+        LockRequest request;
+        request.initNew(&threadLocker, &notify);
+        invariant(lockManager->lock(resId, &request, MODE_IX) == LOCK_OK);
+        lockManager->unlock(&request);
+    }
+
+    if (state.thread_index == 0) {
+        lockManager.reset();
+    }
+}
+
 BENCHMARK_DEFINE_F(DConcurrencyTest, BM_MMAPv1CollectionSharedLock)(benchmark::State& state) {
     std::unique_ptr<ForceSupportsDocLocking> supportDocLocking;
 
@@ -174,7 +206,11 @@ BENCHMARK_REGISTER_F(DConcurrencyTest, BM_ResourceMutexExclusive)->ThreadRange(1
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionIntentSharedLock)
     ->ThreadRange(1, kMaxPerfThreads);
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_CollectionIntentExclusiveLock)
-    ->ThreadRange(1, kMaxPerfThreads);
+    ->ThreadRange(1, kMaxIntentLockPerfThreads);
+BENCHMARK_REGISTER_F(DConcurrencyTest, BM_LockManagerIntentExclusive)
+    ->Args({128, 32})
+    ->Args({0, 0})
+    ->ThreadRange(1, kMaxIntentLockPerfThreads);
 
 BENCHMARK_REGISTER_F(DConcurrencyTest, BM_MMAPv1CollectionSharedLock)
     ->ThreadRange(1, kMaxPerfThreads);
@@ -41,6 +41,7 @@
 #include "mongo/db/catalog/collection_catalog.h"
 #include "mongo/db/concurrency/d_concurrency.h"
 #include "mongo/db/concurrency/locker.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
 #include "mongo/util/log.h"
 #include "mongo/util/str.h"
@@ -393,12 +394,36 @@ void LockHead::migratePartitionedLockHeads() {
 // LockManager
 //
 
+namespace {
+
+unsigned roundUpToPowerOfTwo(unsigned value) {
+    unsigned result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
 // Have more buckets than CPUs to reduce contention on lock and caches
-const unsigned LockManager::_numLockBuckets(128);
+unsigned numLockBucketsForCores(unsigned long numCores) {
+    return roundUpToPowerOfTwo(std::min(std::max(numCores * 4, 128UL), 4096UL));
+}
 
-// Balance scalability of intent locks against potential added cost of conflicting locks.
+// Balance scalability of intent locks against potential added cost of conflicting locks, which
+// have to visit every partition holding their resource. Give each core a partition of its own.
 // The exact value doesn't appear very important, but should be power of two
-const unsigned LockManager::_numPartitions = 32;
+unsigned numPartitionsForCores(unsigned long numCores) {
+    return roundUpToPowerOfTwo(std::min(std::max(numCores, 32UL), 256UL));
+}
+
+}  // namespace
+
+unsigned long getNumCoresForLocking() {
+    // The global LockManager is constructed during static initialization, when ProcessInfo cannot
+    // yet safely collect the system description. hardware_concurrency() returns 0 when the count
+    // is unknown, in which case a single core is assumed.
+    return std::max(stdx::thread::hardware_concurrency(), 1U);
+}
 
 // static
 std::map<LockerId, BSONObj> LockManager::getLockToClientMap(ServiceContext* serviceContext) {
@@ -426,7 +451,13 @@ std::map<LockerId, BSONObj> LockManager::getLockToClientMap(ServiceContext* serv
     return lockToClientMap;
 }
 
-LockManager::LockManager() {
+LockManager::LockManager()
+    : LockManager(numLockBucketsForCores(getNumCoresForLocking()),
+                  numPartitionsForCores(getNumCoresForLocking())) {}
+
+LockManager::LockManager(unsigned numLockBuckets, unsigned numPartitions)
+    : _numLockBuckets(numLockBuckets), _numPartitions(numPartitions) {
+    invariant(_numLockBuckets > 0 && _numPartitions > 0);
     _lockBuckets = new LockBucket[_numLockBuckets];
     _partitions = new Partition[_numPartitions];
 }
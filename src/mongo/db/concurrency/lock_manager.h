@@ -42,6 +42,7 @@
 #include "mongo/platform/compiler.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/new.h"
 #include "mongo/stdx/unordered_map.h"
 #include "mongo/util/concurrency/mutex.h"
 
@@ -64,7 +65,17 @@ public:
      */
     static std::map<LockerId, BSONObj> getLockToClientMap(ServiceContext* serviceContext);
 
+    /**
+     * Sizes the lock buckets and intent lock partitions to the number of cores available to this
+     * process.
+     */
     LockManager();
+
+    /**
+     * Uses exactly 'numLockBuckets' buckets and 'numPartitions' partitions. Used for testing.
+     */
+    LockManager(unsigned numLockBuckets, unsigned numPartitions);
+
     ~LockManager();
 
     /**
@@ -147,7 +158,9 @@ private:
 
     // These types describe the locks hash table
 
-    struct LockBucket {
+    // Buckets and partitions are aligned to cache lines so that neighbouring entries in their
+    // arrays do not falsely share their mutexes.
+    struct alignas(stdx::hardware_destructive_interference_size) LockBucket {
         SimpleMutex mutex;
         typedef stdx::unordered_map<ResourceId, LockHead*> Map;
         Map data;
@@ -157,7 +170,7 @@ private:
     // Each locker maps to a partition that is used for resources acquired in intent modes
     // modes and potentially other modes that don't conflict with themselves. This avoids
     // contention on the regular LockHead in the lock manager.
-    struct Partition {
+    struct alignas(stdx::hardware_destructive_interference_size) Partition {
         PartitionedLockHead* find(ResourceId resId);
         PartitionedLockHead* findOrInsert(ResourceId resId);
         typedef stdx::unordered_map<ResourceId, PartitionedLockHead*> Map;
@@ -219,10 +232,17 @@ private:
      */
     void _cleanupUnusedLocksInBucket(LockBucket* bucket);
 
-    static const unsigned _numLockBuckets;
+    const unsigned _numLockBuckets;
     LockBucket* _lockBuckets;
 
-    static const unsigned _numPartitions;
+    const unsigned _numPartitions;
     Partition* _partitions;
 };
+
+/**
+ * Returns the number of cores on this machine, which the lock manager and the lock statistics size
+ * their partitions by. Safe to call during static initialization.
+ */
+unsigned long getNumCoresForLocking();
+
 }  // namespace mongo
@@ -100,6 +100,33 @@ TEST(LockManager, Grant) {
     ASSERT(request.recursiveCount == 0);
 }
 
+TEST(LockManager, ConflictingRequestMigratesIntentLocksFromEveryPartition) {
+    // Few buckets and partitions, so that lockers and resources have to share them.
+    LockManager lockMgr(2, 4);
+    const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
+    const ResourceId otherResId(RESOURCE_COLLECTION, std::string("TestDB.other"));
+
+    LockerImpl lockers[6];
+    TrackingLockGrantNotification notify;
+    LockRequest requests[6];
+    for (int i = 0; i < 6; i++) {
+        requests[i].initNew(&lockers[i], &notify);
+        ASSERT(LOCK_OK == lockMgr.lock(i % 2 ? resId : otherResId, &requests[i], MODE_IX));
+    }
+
+    LockerImpl conflictingLocker;
+    LockRequest conflictingRequest;
+    conflictingRequest.initNew(&conflictingLocker, &notify);
+    ASSERT(LOCK_WAITING == lockMgr.lock(resId, &conflictingRequest, MODE_S));
+
+    for (int i = 0; i < 6; i++) {
+        lockMgr.unlock(&requests[i]);
+    }
+    ASSERT(notify.numNotifies == 1);
+    ASSERT(conflictingRequest.status == LockRequest::STATUS_GRANTED);
+    lockMgr.unlock(&conflictingRequest);
+}
+
 TEST(LockManager, GrantMultipleNoConflict) {
     LockManager lockMgr;
     const ResourceId resId(RESOURCE_COLLECTION, std::string("TestDB.collection"));
@@ -35,6 +35,10 @@
 
 #include <vector>
 
+#if defined(__linux__)
+#include <sched.h>
+#endif
+
 #include "mongo/db/concurrency/flow_control_ticketholder.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/service_context.h"
@@ -60,18 +64,21 @@ namespace {
  * Tracks global (across all clients) lock acquisition statistics, partitioned into multiple
  * buckets to minimize concurrent access conflicts.
  *
- * Each client has a LockerId that monotonically increases across all client instances. The
- * LockerId % 8 is used to index into one of 8 LockStats instances. These LockStats objects must be
- * atomically accessed, so maintaining 8 that are indexed by LockerId reduces client conflicts and
- * improves concurrent write access. A reader, to collect global lock statics for reporting, will
- * sum the results of all 8 disjoint 'buckets' of stats.
+ * There is one LockStats instance per core available to the process, and each update goes to the
+ * instance of the CPU it runs on. Updates remain atomic, since a thread may migrate between
+ * picking a partition and updating it, but a partition's cache lines are normally only written by
+ * a single core. Where the current CPU cannot be determined, the LockerId picks the partition
+ * instead. A reader, to collect global lock statics for reporting, will sum the results of all
+ * the disjoint 'buckets' of stats.
  */
 class PartitionedInstanceWideLockStats {
     PartitionedInstanceWideLockStats(const PartitionedInstanceWideLockStats&) = delete;
     PartitionedInstanceWideLockStats& operator=(const PartitionedInstanceWideLockStats&) = delete;
 
 public:
-    PartitionedInstanceWideLockStats() {}
+    PartitionedInstanceWideLockStats()
+        : _numPartitions(std::max<size_t>(getNumCoresForLocking(), kMinPartitions)),
+          _partitions(new AlignedLockStats[_numPartitions]) {}
 
     void recordAcquisition(LockerId id, ResourceId resId, LockMode mode) {
         _get(id).recordAcquisition(resId, mode);
@@ -86,13 +93,13 @@ public:
     }
 
     void report(SingleThreadedLockStats* outStats) const {
-        for (int i = 0; i < NumPartitions; i++) {
+        for (size_t i = 0; i < _numPartitions; i++) {
             outStats->append(_partitions[i].stats);
         }
     }
 
     void reset() {
-        for (int i = 0; i < NumPartitions; i++) {
+        for (size_t i = 0; i < _numPartitions; i++) {
             _partitions[i].stats.reset();
         }
     }
@@ -104,15 +111,22 @@ private:
         AtomicLockStats stats;
     };
 
-    enum { NumPartitions = 8 };
+    static constexpr size_t kMinPartitions = 8;
 
 
     AtomicLockStats& _get(LockerId id) {
-        return _partitions[id % NumPartitions].stats;
+#if defined(__linux__)
+        int cpu = sched_getcpu();
+        if (cpu >= 0) {
+            return _partitions[cpu % _numPartitions].stats;
+        }
+#endif
+        return _partitions[id % _numPartitions].stats;
     }
 
 
-    AlignedLockStats _partitions[NumPartitions];
+    const size_t _numPartitions;
+    std::unique_ptr<AlignedLockStats[]> _partitions;
 };
 
 
@@ -337,10 +351,22 @@ bool LockerImpl::_acquireTicket(OperationContext* opCtx, LockMode mode, Date_t d
         // If the ticket wait is interrupted, restore the state of the client.
         auto restoreStateOnErrorGuard = makeGuard([&] { _clientState.store(kInactive); });
 
+        const auto priority = [&] {
+            if (auto priority = getTicketPriority())
+                return *priority;
+            const auto client = opCtx ? opCtx->getClient() : nullptr;
+            if (!client || !client->isFromUserConnection())
+                return TicketHolder::Priority::kInternal;
+            if (client->session() &&
+                (client->session()->getTags() & transport::Session::kInternalClient))
+                return TicketHolder::Priority::kInternal;
+            return TicketHolder::Priority::kUser;
+        }();
+
         OperationContext* interruptible = _uninterruptibleLocksRequested ? nullptr : opCtx;
         if (deadline == Date_t::max()) {
-            holder->waitForTicket(interruptible);
-        } else if (!holder->waitForTicketUntil(interruptible, deadline)) {
+            holder->waitForTicket(interruptible, priority);
+        } else if (!holder->waitForTicketUntil(interruptible, deadline, priority)) {
             return false;
         }
         restoreStateOnErrorGuard.dismiss();
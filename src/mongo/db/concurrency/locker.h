@@ -37,6 +37,7 @@
 #include "mongo/db/concurrency/lock_stats.h"
 #include "mongo/db/operation_context.h"
 #include "mongo/stdx/thread.h"
+#include "mongo/util/concurrency/ticketholder.h"
 
 namespace mongo {
 
@@ -492,6 +493,18 @@ public:
         return _shouldAcquireTicket;
     }
 
+    /**
+     * Overrides the priority class with which this locker queues for a global lock ticket. When
+     * unset, operations from user connections queue as users and everything else as internal.
+     */
+    void setTicketPriority(TicketHolder::Priority priority) {
+        _ticketPriority = priority;
+    }
+
+    boost::optional<TicketHolder::Priority> getTicketPriority() const {
+        return _ticketPriority;
+    }
+
     /**
      * Acquire a flow control admission ticket into the system. Flow control is used as a
      * backpressure mechanism to limit replication majority point lag.
@@ -540,6 +553,7 @@ protected:
 private:
     bool _shouldConflictWithSecondaryBatchApplication = true;
     bool _shouldAcquireTicket = true;
+    boost::optional<TicketHolder::Priority> _ticketPriority;
     std::string _debugInfo;  // Extra info about this locker for debugging purpose
 };
 
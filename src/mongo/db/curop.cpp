@@ -391,6 +391,7 @@ ProgressMeter& CurOp::setProgress_inlock(StringData message,
     setMessage_inlock(message);
     _progressMeter.reset(progressMeterTotal, secondsBetween);
     _progressMeter.setName(message);
+    _progressDetail = BSONObj();
     return _progressMeter;
 }
 
@@ -620,6 +621,7 @@ void CurOp::reportState(OperationContext* opCtx, BSONObjBuilder* builder, bool t
             BSONObjBuilder sub(builder->subobjStart("progress"));
             sub.appendNumber("done", (long long)_progressMeter.done());
             sub.appendNumber("total", (long long)_progressMeter.total());
+            sub.appendElements(_progressDetail);
             sub.done();
         } else {
             builder->append("msg", _message);
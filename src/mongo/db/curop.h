@@ -579,6 +579,15 @@ public:
     ProgressMeter& setProgress_inlock(StringData name,
                                       unsigned long long progressMeterTotal = 0,
                                       int secondsBetween = 3);
+
+    /**
+     * Sets extra fields reported alongside "done" and "total" in this CurOp's "progress" while
+     * its progress meter is active. Cleared by setProgress_inlock().
+     */
+    void setProgressDetail_inlock(BSONObj detail) {
+        _progressDetail = detail.getOwned();
+    }
+
     /**
      * Gets the message for this CurOp.
      */
@@ -671,6 +680,7 @@ private:
     OpDebug _debug;
     std::string _message;
     ProgressMeter _progressMeter;
+    BSONObj _progressDetail;
     int _numYields{0};
     // A GenericCursor containing information about the active cursor for a getMore operation.
     boost::optional<GenericCursor> _genericCursor;
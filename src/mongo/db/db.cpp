@@ -105,7 +105,9 @@
 #include "mongo/db/read_write_concern_defaults_cache_lookup_mongod.h"
 #include "mongo/db/repair_database_and_check_version.h"
 #include "mongo/db/repl/drop_pending_collection_reaper.h"
+#include "mongo/db/repl/file_copy_initial_syncer.h"
 #include "mongo/db/repl/oplog.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/repl_settings.h"
 #include "mongo/db/repl/replication_consistency_markers_impl.h"
 #include "mongo/db/repl/replication_coordinator.h"
@@ -340,6 +342,20 @@ ExitCode _initAndListen(int listenPort) {
                      std::make_unique<FlowControl>(
                          serviceContext, repl::ReplicationCoordinator::get(serviceContext)));
 
+    // A new member may seed its dbpath with a copy of another member's data files, which must be
+    // in place before the storage engine opens the dbpath.
+    if (!repl::initialSyncFileCopySource.empty()) {
+        uassert(ErrorCodes::InvalidOptions,
+                "initialSyncFileCopySource requires --replSet",
+                replSettings.usingReplSets());
+        uassert(ErrorCodes::InvalidOptions,
+                "initialSyncFileCopySource requires the wiredTiger storage engine",
+                storageGlobalParams.engine == "wiredTiger" && !storageGlobalParams.repair);
+        repl::FileCopyInitialSyncer fileCopyInitialSyncer(
+            HostAndPort(repl::initialSyncFileCopySource), storageGlobalParams.dbpath);
+        uassertStatusOK(fileCopyInitialSyncer.run(repl::numInitialSyncAttempts.load()));
+    }
+
     initializeStorageEngine(serviceContext, StorageEngineInitFlags::kNone);
 
 #ifdef MONGO_CONFIG_WIREDTIGER_ENABLED
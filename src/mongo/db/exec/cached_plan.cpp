@@ -49,7 +49,9 @@
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/stage_builder.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
+#include "mongo/util/timer.h"
 #include "mongo/util/transitional_tools_do_not_use/vector_spooling.h"
 
 namespace mongo {
@@ -77,6 +79,8 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     // execution work that happens here, so this is needed for the time accounting to
     // make sense.
     ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+    Timer executionTimer;
+    ON_BLOCK_EXIT([&] { _executionTime += Microseconds(executionTimer.micros()); });
 
     // During plan selection, the list of indices we are using to plan must remain stable, so the
     // query will die during yield recovery if any index has been dropped. However, once plan
@@ -115,12 +119,14 @@ Status CachedPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
                 // Once a plan returns enough results, stop working. Update cache with stats
                 // from this run and return.
                 updatePlanCache();
+                _shouldRecordRuntimeStats = true;
                 return Status::OK();
             }
         } else if (PlanStage::IS_EOF == state) {
             // Cached plan hit EOF quickly enough. No need to replan. Update cache with stats
             // from this run and return.
             updatePlanCache();
+            _shouldRecordRuntimeStats = true;
             return Status::OK();
         } else if (PlanStage::NEED_YIELD == state) {
             invariant(id == WorkingSet::INVALID_ID);
@@ -262,7 +268,14 @@ Status CachedPlanStage::replan(PlanYieldPolicy* yieldPolicy, bool shouldCache, s
 }
 
 bool CachedPlanStage::isEOF() {
-    return _results.empty() && child()->isEOF();
+    if (!_results.empty() || !child()->isEOF()) {
+        return false;
+    }
+
+    // A plan which hit EOF during the trial period never reports it from work(), and callers may
+    // find out that the execution is over from isEOF() alone, so record it here too.
+    recordRuntimeStats();
+    return true;
 }
 
 PlanStage::StageState CachedPlanStage::doWork(WorkingSetID* out) {
@@ -278,7 +291,34 @@ PlanStage::StageState CachedPlanStage::doWork(WorkingSetID* out) {
     }
 
     // Nothing left in trial period buffer.
-    return child()->work(out);
+    Timer executionTimer;
+    const auto state = child()->work(out);
+    _executionTime += Microseconds(executionTimer.micros());
+    if (PlanStage::IS_EOF == state) {
+        recordRuntimeStats();
+    }
+    return state;
+}
+
+PlanStage::StageState CachedPlanStage::doWorkBatch(WorkingSet* ws,
+                                                   size_t maxResults,
+                                                   std::vector<WorkingSetID>* batch,
+                                                   WorkingSetID* out) {
+    if (isEOF()) {
+        return PlanStage::IS_EOF;
+    }
+
+    if (!_results.empty()) {
+        return PlanStage::doWorkBatch(ws, maxResults, batch, out);
+    }
+
+    Timer executionTimer;
+    const auto state = child()->workBatch(ws, maxResults, batch, out);
+    _executionTime += Microseconds(executionTimer.micros());
+    if (PlanStage::IS_EOF == state) {
+        recordRuntimeStats();
+    }
+    return state;
 }
 
 std::unique_ptr<PlanStageStats> CachedPlanStage::getStats() {
@@ -311,4 +351,20 @@ void CachedPlanStage::updatePlanCache() {
     }
 }
 
+void CachedPlanStage::recordRuntimeStats() {
+    if (!_shouldRecordRuntimeStats) {
+        return;
+    }
+    _shouldRecordRuntimeStats = false;
+
+    const CommonStats* stats = child()->getCommonStats();
+    PlanCache* cache = CollectionQueryInfo::get(collection()).getPlanCache();
+    Status status =
+        cache->recordExecution(*_canonicalQuery, stats->works, stats->advanced, _executionTime);
+    if (!status.isOK()) {
+        LOG(5) << _canonicalQuery->ns()
+               << ": Failed to record runtime statistics in plan cache: " << redact(status);
+    }
+}
+
 }  // namespace mongo
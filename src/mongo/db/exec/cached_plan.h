@@ -39,6 +39,7 @@
 #include "mongo/db/query/query_planner_params.h"
 #include "mongo/db/query/query_solution.h"
 #include "mongo/db/record_id.h"
+#include "mongo/util/duration.h"
 
 namespace mongo {
 
@@ -68,6 +69,10 @@ public:
 
     StageState doWork(WorkingSetID* out) final;
 
+    bool producesNativeBatches() const final {
+        return child()->producesNativeBatches();
+    }
+
     StageType stageType() const final {
         return STAGE_CACHED_PLAN;
     }
@@ -88,6 +93,12 @@ public:
      */
     Status pickBestPlan(PlanYieldPolicy* yieldPolicy);
 
+protected:
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxResults,
+                           std::vector<WorkingSetID>* batch,
+                           WorkingSetID* out) final;
+
 private:
     /**
      * Passes stats from the trial period run of the cached plan to the plan cache.
@@ -97,6 +108,14 @@ private:
      */
     void updatePlanCache();
 
+    /**
+     * Passes the works, results and execution time of the whole run of the cached plan to the plan
+     * cache, which may evict the entry if the plan has become much more expensive than it was
+     * when it was cached. Only has an effect the first time a plan which was not replanned is
+     * found to be at EOF.
+     */
+    void recordRuntimeStats();
+
     /**
      * Uses the QueryPlanner and the MultiPlanStage to re-generate candidate plans for this
      * query and select a new winner.
@@ -136,6 +155,14 @@ private:
     // Any results produced during trial period execution are kept here.
     std::queue<WorkingSetID> _results;
 
+    // True if the trial period accepted the cached plan, so that its complete executions should
+    // be reported to the plan cache.
+    bool _shouldRecordRuntimeStats = false;
+
+    // Time spent in pickBestPlan(), doWork() and doWorkBatch(). Unlike 'executionTimeMillis' in
+    // the common stats, this is precise enough to describe fast queries.
+    Microseconds _executionTime{0};
+
     // Stats
     CachedPlanStats _specificStats;
 };
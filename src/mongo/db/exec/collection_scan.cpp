@@ -85,6 +85,14 @@ CollectionScan::CollectionScan(OperationContext* opCtx,
         invariant(params.direction == CollectionScanParams::FORWARD);
     }
 
+    if (params.minRecord || params.maxRecord) {
+        // Range-restricted scans are used to split a collection between several scanners, which
+        // only makes sense for forward scans over a fixed set of records.
+        invariant(params.direction == CollectionScanParams::FORWARD);
+        invariant(!params.tailable);
+        invariant(!params.resumeAfterRecordId);
+    }
+
     // Set early stop condition.
     if (params.maxTs) {
         _endConditionBSON = BSON("$gte"_sd << *(params.maxTs));
@@ -122,6 +130,9 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
             }
 
             _cursor = collection()->getCursor(getOpCtx(), forward);
+            if (!_projectedFields.empty()) {
+                _cursor->setProjectedFields(_projectedFields);
+            }
 
             if (!_lastSeenId.isNull()) {
                 invariant(_params.tailable);
@@ -163,6 +174,12 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
                 }
             }
 
+            if (_params.minRecord) {
+                // If the cursor can't seek, records before 'minRecord' are skipped one at a time
+                // below instead.
+                _cursor->positionAt(*_params.minRecord);
+            }
+
             return PlanStage::NEED_TIME;
         }
 
@@ -203,7 +220,16 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
         return PlanStage::IS_EOF;
     }
 
+    if (_params.maxRecord && record->id > *_params.maxRecord) {
+        _commonStats.isEOF = true;
+        return PlanStage::IS_EOF;
+    }
+
     _lastSeenId = record->id;
+    if (_params.minRecord && record->id < *_params.minRecord) {
+        return PlanStage::NEED_TIME;
+    }
+
     if (_params.shouldTrackLatestOplogTimestamp) {
         auto status = setLatestOplogEntryTimestamp(*record);
         if (!status.isOK()) {
@@ -222,6 +248,86 @@ PlanStage::StageState CollectionScan::doWork(WorkingSetID* out) {
     return returnIfMatches(member, id, out);
 }
 
+void CollectionScan::setProjectedFields(StringSet fields) {
+    invariant(!_cursor);
+    if (_params.minTs || _params.maxTs || _params.shouldTrackLatestOplogTimestamp) {
+        return;
+    }
+    _projectedFields = std::move(fields);
+}
+
+bool CollectionScan::producesNativeBatches() const {
+    // Tailable, resumable and oplog scans keep per-record bookkeeping which only doWork() does.
+    return !_params.tailable && !_params.resumeAfterRecordId && !_params.minTs && !_params.maxTs &&
+        !_params.shouldTrackLatestOplogTimestamp;
+}
+
+PlanStage::StageState CollectionScan::doWorkBatch(WorkingSet* ws,
+                                                  size_t maxResults,
+                                                  std::vector<WorkingSetID>* batch,
+                                                  WorkingSetID* out) {
+    if (!_cursor || !producesNativeBatches()) {
+        return PlanStage::doWorkBatch(ws, maxResults, batch, out);
+    }
+
+    if (_commonStats.isEOF) {
+        return PlanStage::IS_EOF;
+    }
+
+    const auto snapshotId = getOpCtx()->recoveryUnit()->getSnapshotId();
+    size_t needTimes = 0;
+    for (size_t unit = 0; unit < maxResults; ++unit) {
+        boost::optional<Record> record;
+        try {
+            record = _cursor->next();
+        } catch (const WriteConflictException&) {
+            recordAbsorbedNeedTimes(needTimes);
+            *out = WorkingSet::INVALID_ID;
+            return PlanStage::NEED_YIELD;
+        }
+
+        if (!record || (_params.maxRecord && record->id > *_params.maxRecord)) {
+            recordAbsorbedNeedTimes(needTimes);
+            _commonStats.isEOF = true;
+            return PlanStage::IS_EOF;
+        }
+
+        _lastSeenId = record->id;
+        if (_params.minRecord && record->id < *_params.minRecord) {
+            ++needTimes;
+            continue;
+        }
+
+        ++_specificStats.docsTested;
+
+        // Test the filter against the cursor's copy of the record, so that only matching
+        // documents pay for a WorkingSetMember and an owned copy.
+        BSONObj obj = record->data.releaseToBson();
+        if (_filter && !_filter->matchesBSON(obj)) {
+            ++needTimes;
+            continue;
+        }
+
+        if (_params.stopApplyingFilterAfterFirstMatch) {
+            _filter = nullptr;
+        }
+
+        WorkingSetID id = _workingSet->allocate();
+        WorkingSetMember* member = _workingSet->get(id);
+        member->recordId = record->id;
+        member->resetDocument(snapshotId, obj.getOwned());
+        _workingSet->transitionToRecordIdAndObj(id);
+        batch->push_back(id);
+    }
+
+    if (batch->empty()) {
+        recordAbsorbedNeedTimes(needTimes - 1);
+        return PlanStage::NEED_TIME;
+    }
+    recordAbsorbedNeedTimes(needTimes);
+    return PlanStage::ADVANCED;
+}
+
 Status CollectionScan::setLatestOplogEntryTimestamp(const Record& record) {
     auto tsElem = record.data.toBson()[repl::OpTime::kTimestampFieldName];
     if (tsElem.type() != BSONType::bsonTimestamp) {
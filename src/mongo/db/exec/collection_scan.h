@@ -35,6 +35,7 @@
 #include "mongo/db/exec/requires_collection_stage.h"
 #include "mongo/db/matcher/expression_leaf.h"
 #include "mongo/db/record_id.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -62,6 +63,15 @@ public:
     StageState doWork(WorkingSetID* out) final;
     bool isEOF() final;
 
+    bool producesNativeBatches() const final;
+
+    /**
+     * Asks the storage engine for only these top-level fields of each record, rather than the
+     * whole document. Whoever sets this must only consume those fields, and must include every
+     * field read by this stage's filter. Ignored by oplog scans, which read 'ts' themselves.
+     */
+    void setProjectedFields(StringSet fields);
+
     void doDetachFromOperationContext() final;
     void doReattachToOperationContext() final;
 
@@ -82,6 +92,11 @@ public:
     const SpecificStats* getSpecificStats() const final;
 
 protected:
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxResults,
+                           std::vector<WorkingSetID>* batch,
+                           WorkingSetID* out) final;
+
     void doSaveStateRequiresCollection() final;
 
     void doRestoreStateRequiresCollection() final;
@@ -113,6 +128,9 @@ private:
 
     std::unique_ptr<SeekableRecordCursor> _cursor;
 
+    // If not empty, the only top-level fields requested from '_cursor'.
+    StringSet _projectedFields;
+
     CollectionScanParams _params;
 
     RecordId _lastSeenId;  // Null if nothing has been returned from _cursor yet.
@@ -0,0 +1,138 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/db/catalog/catalog_test_fixture.h"
+#include "mongo/db/catalog/collection_options.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/limit.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/expression_parser.h"
+#include "mongo/db/pipeline/expression_context.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kNss("test.collection_scan_bm");
+const int kNumDocs = 100 * 1000;
+
+/**
+ * Creates a collection of 'kNumDocs' small documents whose field 'a' cycles through 0..99, so
+ * that {a: {$lt: N}} selects N percent of them.
+ */
+class CollectionScanBenchmarkFixture : public CatalogTestFixture {
+public:
+    CollectionScanBenchmarkFixture() {
+        setUp();
+
+        auto opCtx = operationContext();
+        invariant(storageInterface()->createCollection(opCtx, kNss, CollectionOptions()));
+
+        const std::string padding(64, 'x');
+        std::vector<InsertStatement> docs;
+        for (int i = 0; i < kNumDocs; ++i) {
+            docs.emplace_back(BSON("_id" << i << "a" << i % 100 << "padding" << padding));
+        }
+        invariant(storageInterface()->insertDocuments(opCtx, kNss, docs));
+    }
+
+    ~CollectionScanBenchmarkFixture() {
+        tearDown();
+    }
+
+private:
+    void _doTest() final {}
+};
+
+/**
+ * Scans the collection through a PlanExecutor with the filter {a: {$lt: state.range(0)}}, under
+ * a LIMIT when state.range(2) is non-zero, asking the plan for batches of state.range(1) units of
+ * work (zero for one result at a time).
+ */
+void BM_CollectionScanWithFilter(benchmark::State& state) {
+    CollectionScanBenchmarkFixture fixture;
+    auto opCtx = fixture.operationContext();
+
+    const int originalBatchSize = internalQueryExecBatchSize.load();
+    internalQueryExecBatchSize.store(state.range(1));
+
+    const boost::intrusive_ptr<ExpressionContext> expCtx(new ExpressionContext(opCtx, nullptr));
+    auto filter = uassertStatusOK(
+        MatchExpressionParser::parse(BSON("a" << BSON("$lt" << state.range(0))), expCtx));
+
+    int64_t numResults = 0;
+    for (auto _ : state) {
+        AutoGetCollectionForRead autoColl(opCtx, kNss);
+
+        auto ws = std::make_unique<WorkingSet>();
+        CollectionScanParams params;
+        std::unique_ptr<PlanStage> root = std::make_unique<CollectionScan>(
+            opCtx, autoColl.getCollection(), params, ws.get(), filter.get());
+        if (state.range(2)) {
+            root = std::make_unique<LimitStage>(opCtx, state.range(2), ws.get(), std::move(root));
+        }
+
+        auto exec = uassertStatusOK(PlanExecutor::make(opCtx,
+                                                       std::move(ws),
+                                                       std::move(root),
+                                                       autoColl.getCollection(),
+                                                       PlanExecutor::NO_YIELD));
+        BSONObj obj;
+        while (exec->getNext(&obj, nullptr) == PlanExecutor::ADVANCED) {
+            benchmark::DoNotOptimize(obj);
+            ++numResults;
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * kNumDocs);
+    state.counters["resultsPerScan"] =
+        benchmark::Counter(static_cast<double>(numResults) / state.iterations());
+    internalQueryExecBatchSize.store(originalBatchSize);
+}
+
+BENCHMARK(BM_CollectionScanWithFilter)
+    ->ArgNames({"percentMatching", "batchSize", "limit"})
+    ->Args({1, 0, 0})
+    ->Args({1, 64, 0})
+    ->Args({10, 0, 0})
+    ->Args({10, 64, 0})
+    ->Args({100, 0, 0})
+    ->Args({100, 64, 0})
+    ->Args({100, 0, 1000})
+    ->Args({100, 64, 1000})
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace mongo
@@ -61,6 +61,13 @@ struct CollectionScanParams {
     // This field cannot be used in conjunction with 'minTs' or 'maxTs'.
     boost::optional<RecordId> resumeAfterRecordId;
 
+    // If present, the collection scan only returns records whose RecordId lies within
+    // ['minRecord', 'maxRecord'], seeking straight to 'minRecord' when the storage engine allows
+    // it. Must only be set on forward, non-tailable scans. These fields cannot be used in
+    // conjunction with 'resumeAfterRecordId'.
+    boost::optional<RecordId> minRecord;
+    boost::optional<RecordId> maxRecord;
+
     Direction direction = FORWARD;
 
     // Do we want the scan to be 'tailable'?  Only meaningful if the collection is capped.
@@ -170,6 +170,24 @@ Position DocumentStorage::findField(StringData requested, LookupPolicy policy) c
     return Position();
 }
 
+Value DocumentStorage::getField(StringData requested) const {
+    if (auto pos = findFieldInCache(requested); pos.found()) {
+        return getField(pos).val;
+    }
+
+    for (auto&& bsonElement : _bson) {
+        if (requested == bsonElement.fieldNameStringData()) {
+            if (readInPlace(bsonElement.type())) {
+                return Value(bsonElement);
+            }
+            return getField(const_cast<DocumentStorage*>(this)->constructInCache(bsonElement)).val;
+        }
+    }
+
+    // if we got here, there's no such field
+    return Value();
+}
+
 Position DocumentStorage::constructInCache(const BSONElement& elem) {
     auto savedModified = _modified;
     auto pos = getNextPosition();
@@ -570,18 +588,23 @@ static Value getNestedFieldHelper(const Document& doc,
                                   vector<Position>* positions,
                                   size_t level) {
     const auto fieldName = fieldNames.getFieldName(level);
-    const Position pos = doc.positionOf(fieldName);
 
-    if (!pos.found())
-        return Value();
+    Value val;
+    if (positions) {
+        const Position pos = doc.positionOf(fieldName);
+        if (!pos.found())
+            return Value();
 
-    if (positions)
         positions->push_back(pos);
+        val = doc.getField(pos);
+    } else {
+        // Without positions to report there is no need to bring the field into cache.
+        val = doc.getField(fieldName);
+    }
 
     if (level == fieldNames.getPathLength() - 1)
-        return doc.getField(pos);
+        return val;
 
-    Value val = doc.getField(pos);
     if (val.getType() != Object)
         return Value();
 
@@ -615,9 +638,9 @@ size_t Document::getApproximateSize() const {
 void Document::hash_combine(size_t& seed,
                             const StringData::ComparatorInterface* stringComparator) const {
     for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
-        StringData name = it->nameSD();
+        StringData name = it.fieldName();
         boost::hash_range(seed, name.rawData(), name.rawData() + name.size());
-        it->val.hash_combine(seed, stringComparator);
+        it.value().hash_combine(seed, stringComparator);
     }
 }
 
@@ -644,23 +667,25 @@ int Document::compare(const Document& rL,
         if (rIt.atEnd())
             return 1;  // right document is shorter
 
-        const ValueElement& rField = rIt.get();
-        const ValueElement& lField = lIt.get();
+        const StringData rName = rIt.fieldName();
+        const StringData lName = lIt.fieldName();
+        const Value rVal = rIt.value();
+        const Value lVal = lIt.value();
 
         // For compatibility with BSONObj::woCompare() consider the canonical type of values
         // before considerting their names.
-        if (lField.val.getType() != rField.val.getType()) {
-            const int rCType = canonicalizeBSONType(rField.val.getType());
-            const int lCType = canonicalizeBSONType(lField.val.getType());
+        if (lVal.getType() != rVal.getType()) {
+            const int rCType = canonicalizeBSONType(rVal.getType());
+            const int lCType = canonicalizeBSONType(lVal.getType());
             if (lCType != rCType)
                 return lCType < rCType ? -1 : 1;
         }
 
-        const int nameCmp = lField.nameSD().compare(rField.nameSD());
+        const int nameCmp = lName.compare(rName);
         if (nameCmp)
             return nameCmp;  // field names are unequal
 
-        const int valueCmp = Value::compare(lField.val, rField.val, stringComparator);
+        const int valueCmp = Value::compare(lVal, rVal, stringComparator);
         if (valueCmp)
             return valueCmp;  // fields are unequal
 
@@ -677,7 +702,7 @@ string Document::toString() const {
     const char* prefix = "{";
 
     for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
-        out << prefix << it->nameSD() << ": " << it->val.toString();
+        out << prefix << it.fieldName() << ": " << it.value().toString();
         prefix = ", ";
     }
     out << '}';
@@ -690,8 +715,8 @@ void Document::serializeForSorter(BufBuilder& buf) const {
     buf.appendNum(numElems);
 
     for (DocumentStorageIterator it = storage().iterator(); !it.atEnd(); it.advance()) {
-        buf.appendStr(it->nameSD(), /*NUL byte*/ true);
-        it->val.serializeForSorter(buf);
+        buf.appendStr(it.fieldName(), /*NUL byte*/ true);
+        it.value().serializeForSorter(buf);
     }
 
     metadata().serializeForSorter(buf);
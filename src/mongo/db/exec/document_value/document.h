@@ -723,7 +723,10 @@ public:
     Document::FieldPair next() {
         verify(more());
 
-        Document::FieldPair fp(_it->nameSD(), _it->val);
+        // Take the name first: while the field is only in the bson it is stable across cache
+        // growth.
+        auto name = _it.fieldName();
+        Document::FieldPair fp(name, _it.value());
         _it.advance();
         return fp;
     }
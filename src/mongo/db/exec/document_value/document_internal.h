@@ -203,6 +203,12 @@ public:
         return get();
     }
 
+    /**
+     * Get the value the iterator currently points to. Unlike get() this does not bring fields from
+     * the underlying bson into cache when they can be read in place.
+     */
+    Value value();
+
     const ValueElement* cachedValue() const {
         return _it;
     }
@@ -330,12 +336,12 @@ public:
         verify(pos.found());
         return *(_firstElement->plusBytes(pos.index));
     }
-    Value getField(StringData name) const {
-        Position pos = findField(name, LookupPolicy::kCacheAndBSON);
-        if (!pos.found())
-            return Value();
-        return getField(pos).val;
-    }
+    /**
+     * Returns the value of the named field, or a missing Value. Fields that are still only in the
+     * underlying BSON are read from it without being brought into cache unless they are
+     * containers (see readInPlace()).
+     */
+    Value getField(StringData name) const;
 
     // MutableDocument uses these
     ValueElement& getField(Position pos) {
@@ -462,6 +468,16 @@ public:
 
     Position constructInCache(const BSONElement& elem);
 
+    /**
+     * Whether a field of this type is read straight out of the underlying BSON rather than
+     * constructed in cache. Building a Value from a scalar is cheap, so giving it a ValueElement
+     * would only cost memory. Objects and arrays are copied into the Value, so they are cached to
+     * avoid doing that on every access.
+     */
+    static bool readInPlace(BSONType type) {
+        return type != Object && type != Array;
+    }
+
     auto isModified() const {
         return _modified;
     }
@@ -564,4 +580,11 @@ private:
 
     friend class DocumentStorageIterator;
 };
+
+inline Value DocumentStorageIterator::value() {
+    if (!_it && DocumentStorage::readInPlace((*_bsonIt).type())) {
+        return Value(*_bsonIt);
+    }
+    return get().val;
+}
 }  // namespace mongo
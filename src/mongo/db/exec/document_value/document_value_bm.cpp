@@ -0,0 +1,134 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/pipeline/field_path.h"
+
+namespace mongo {
+namespace {
+
+/**
+ * Builds a document resembling a typical small collection document: an _id, a handful of scalar
+ * fields and one embedded sub-document.
+ */
+BSONObj makeSmallDocument(int i, int numScalarFields) {
+    BSONObjBuilder bob;
+    bob.append("_id", i);
+    for (int f = 0; f < numScalarFields; ++f) {
+        bob.append(str::stream() << "field" << f, i * f);
+    }
+    bob.append("status", i % 2 ? "active" : "inactive");
+    bob.append("sub", BSON("x" << i << "y" << "some string"));
+    return bob.obj();
+}
+
+void BM_DocumentGetField(benchmark::State& state) {
+    const auto numFields = static_cast<int>(state.range(0));
+    const auto bson = makeSmallDocument(1, numFields);
+
+    std::vector<std::string> names;
+    for (int f = 0; f < numFields; ++f) {
+        names.push_back(str::stream() << "field" << f);
+    }
+
+    for (auto _ : state) {
+        // A fresh Document each time, as a pipeline sees each input document once.
+        Document doc(bson);
+        for (auto&& name : names) {
+            benchmark::DoNotOptimize(doc[name]);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * numFields);
+}
+
+void BM_DocumentGetNestedField(benchmark::State& state) {
+    const auto bson = makeSmallDocument(1, 8);
+    const FieldPath path("sub.x");
+
+    for (auto _ : state) {
+        Document doc(bson);
+        benchmark::DoNotOptimize(doc.getNestedField(path));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_DocumentIterateFields(benchmark::State& state) {
+    const auto bson = makeSmallDocument(1, static_cast<int>(state.range(0)));
+
+    for (auto _ : state) {
+        Document doc(bson);
+        for (FieldIterator it(doc); it.more();) {
+            benchmark::DoNotOptimize(it.next());
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * bson.nFields());
+}
+
+/**
+ * Holds many documents in memory after reading a group key and an accumulator argument from each,
+ * the way $group does, and reports the approximate memory charged per document. This is the
+ * figure $group and $sort compare against their memory limits before spilling.
+ */
+void BM_DocumentMemoryPerDocument(benchmark::State& state) {
+    const auto numDocs = static_cast<int>(state.range(0));
+    std::vector<BSONObj> inputs;
+    for (int i = 0; i < numDocs; ++i) {
+        inputs.push_back(makeSmallDocument(i, 8));
+    }
+
+    size_t totalBytes = 0;
+    for (auto _ : state) {
+        std::vector<Document> docs;
+        docs.reserve(numDocs);
+        totalBytes = 0;
+        for (auto&& bson : inputs) {
+            Document doc(bson);
+            benchmark::DoNotOptimize(doc["status"]);
+            benchmark::DoNotOptimize(doc["field3"]);
+            totalBytes += doc.getApproximateSize();
+            docs.push_back(std::move(doc));
+        }
+    }
+
+    state.SetItemsProcessed(state.iterations() * numDocs);
+    state.counters["bytesPerDocument"] = static_cast<double>(totalBytes) / numDocs;
+}
+
+BENCHMARK(BM_DocumentGetField)->Arg(4)->Arg(16)->Arg(64);
+BENCHMARK(BM_DocumentGetNestedField);
+BENCHMARK(BM_DocumentIterateFields)->Arg(4)->Arg(16)->Arg(64);
+BENCHMARK(BM_DocumentMemoryPerDocument)->Arg(1000)->Arg(100000);
+
+}  // namespace
+}  // namespace mongo
@@ -133,6 +133,41 @@ TEST(DocumentConstruction, FromBsonReset) {
     ASSERT_BSONOBJ_EQ(bson, toBson(newDocument));
 }
 
+TEST(DocumentGetField, ScalarFieldsAreReadFromBsonWithoutCaching) {
+    Document document = fromBson(BSON("a" << 1 << "b"
+                                          << "a string too long to be stored inline"
+                                          << "c" << BSON("d" << 2)));
+    const auto sizeBeforeReads = document.getApproximateSize();
+
+    ASSERT_VALUE_EQ(document["a"], Value(1));
+    ASSERT_VALUE_EQ(document["b"], Value("a string too long to be stored inline"_sd));
+    ASSERT_TRUE(document["missing"].missing());
+    ASSERT_VALUE_EQ(document.getNestedField(FieldPath("a")), Value(1));
+    for (FieldIterator it(document); it.more();) {
+        it.next();
+    }
+    ASSERT_EQ(document.getApproximateSize(), sizeBeforeReads);
+
+    // Sub-documents are still brought into cache so they aren't rebuilt on every access.
+    ASSERT_VALUE_EQ(document["c"], Value(BSON("d" << 2)));
+    ASSERT_GT(document.getApproximateSize(), sizeBeforeReads);
+}
+
+TEST(DocumentGetField, ModifyingFieldReadInPlaceTakesEffect) {
+    Document document = fromBson(BSON("a" << 1 << "b" << 2));
+    ASSERT_VALUE_EQ(document["a"], Value(1));
+
+    MutableDocument md(document);
+    md["a"] = Value(3);
+    md.remove("b");
+    Document modified = md.freeze();
+
+    ASSERT_VALUE_EQ(modified["a"], Value(3));
+    ASSERT_TRUE(modified["b"].missing());
+    ASSERT_BSONOBJ_EQ(toBson(modified), BSON("a" << 3));
+    ASSERT_VALUE_EQ(document["a"], Value(1));
+}
+
 /**
  * Appends to 'builder' an object nested 'depth' levels deep.
  */
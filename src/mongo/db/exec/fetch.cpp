@@ -101,7 +101,7 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
 
             try {
                 if (!_cursor)
-                    _cursor = collection()->getCursor(getOpCtx());
+                    makeCursor();
 
                 if (!WorkingSetCommon::fetch(getOpCtx(), _ws, id, _cursor, collection()->ns())) {
                     _ws->free(id);
@@ -131,6 +131,18 @@ PlanStage::StageState FetchStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+void FetchStage::setProjectedFields(StringSet fields) {
+    invariant(!_cursor);
+    _projectedFields = std::move(fields);
+}
+
+void FetchStage::makeCursor() {
+    _cursor = collection()->getCursor(getOpCtx());
+    if (!_projectedFields.empty()) {
+        _cursor->setProjectedFields(_projectedFields);
+    }
+}
+
 void FetchStage::doSaveStateRequiresCollection() {
     if (_cursor) {
         _cursor->saveUnpositioned();
@@ -35,6 +35,7 @@
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression.h"
 #include "mongo/db/record_id.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -61,6 +62,14 @@ public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
 
+    /**
+     * Asks the storage engine for only these top-level fields of each fetched record, rather than
+     * the whole document. Whoever sets this must only consume those fields, and must include every
+     * field read by this stage's filter and by the key patterns of the indexes below it, which
+     * are needed to check index keys against a document fetched after a yield.
+     */
+    void setProjectedFields(StringSet fields);
+
     void doDetachFromOperationContext() final;
     void doReattachToOperationContext() final;
 
@@ -80,6 +89,8 @@ protected:
     void doRestoreStateRequiresCollection() final;
 
 private:
+    void makeCursor();
+
     /**
      * If the member (with id memberID) passes our filter, set *out to memberID and return that
      * ADVANCED.  Otherwise, free memberID and return NEED_TIME.
@@ -89,6 +100,9 @@ private:
     // Used to fetch Records from _collection.
     std::unique_ptr<SeekableRecordCursor> _cursor;
 
+    // If not empty, the only top-level fields requested from '_cursor'.
+    StringSet _projectedFields;
+
     // _ws is not owned by us.
     WorkingSet* _ws;
 
@@ -82,6 +82,21 @@ PlanStage::StageState LimitStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState LimitStage::doWorkBatch(WorkingSet* ws,
+                                              size_t maxResults,
+                                              std::vector<WorkingSetID>* batch,
+                                              WorkingSetID* out) {
+    if (0 == _numToReturn) {
+        return PlanStage::IS_EOF;
+    }
+
+    // Never ask for more than we may return, so that nothing is read past the limit.
+    const size_t toReturn = std::min(maxResults, static_cast<size_t>(_numToReturn));
+    StageState status = child()->workBatch(ws, toReturn, batch, out);
+    _numToReturn -= batch->size();
+    return status;
+}
+
 unique_ptr<PlanStageStats> LimitStage::getStats() {
     _commonStats.isEOF = isEOF();
     unique_ptr<PlanStageStats> ret = std::make_unique<PlanStageStats>(_commonStats, STAGE_LIMIT);
@@ -42,13 +42,21 @@
 #include "mongo/db/catalog/database.h"
 #include "mongo/db/client.h"
 #include "mongo/db/concurrency/write_conflict_exception.h"
+#include "mongo/db/db_raii.h"
 #include "mongo/db/exec/scoped_timer.h"
 #include "mongo/db/exec/working_set_common.h"
 #include "mongo/db/query/collection_query_info.h"
 #include "mongo/db/query/explain.h"
 #include "mongo/db/query/plan_cache.h"
 #include "mongo/db/query/plan_ranker.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/query/query_planner_common.h"
+#include "mongo/db/query/stage_builder.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/util/concurrency/thread_pool.h"
 #include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
@@ -61,6 +69,153 @@ using std::vector;
 // static
 const char* MultiPlanStage::kStageType = "MULTI_PLAN";
 
+namespace {
+
+/**
+ * Returns the process-wide pool that runs parallel trial periods. The pool is shared by every
+ * query, which bounds the number of trial threads regardless of how many queries plan at once.
+ * Tasks bring their own Client, so the pool is never torn down.
+ */
+ThreadPool* getParallelTrialPool() {
+    static ThreadPool* pool = [] {
+        ThreadPool::Options options;
+        options.poolName = "MultiPlanTrial";
+        options.minThreads = 0;
+        options.maxThreads = std::max(ProcessInfo::getNumAvailableCores(), 2UL);
+        auto pool = new ThreadPool(std::move(options));
+        pool->startup();
+        return pool;
+    }();
+    return pool;
+}
+
+/**
+ * Returns false if the plan rooted at 'node' contains a stage which cannot be built and worked on
+ * a thread other than the one that owns the query, either because the stage evaluates
+ * expressions against the query's shared ExpressionContext or because it depends on state that
+ * is only set up for the owning operation. The projection and sort stages are built from the
+ * query's ExpressionContext, whose OperationContext is the owning one, so they are excluded too.
+ */
+bool isParallelTrialSafe(const QuerySolutionNode* node) {
+    switch (node->getType()) {
+        case STAGE_AND_HASH:
+        case STAGE_AND_SORTED:
+        case STAGE_COLLSCAN:
+        case STAGE_ENSURE_SORTED:
+        case STAGE_FETCH:
+        case STAGE_IXSCAN:
+        case STAGE_LIMIT:
+        case STAGE_OR:
+        case STAGE_SKIP:
+        case STAGE_SORT_MERGE:
+            break;
+        default:
+            return false;
+    }
+
+    return std::all_of(node->children.begin(), node->children.end(), [](auto&& child) {
+        return isParallelTrialSafe(child);
+    });
+}
+
+/**
+ * State shared between a MultiPlanStage and the workers running its parallel trial period. Each
+ * per-candidate vector is indexed like MultiPlanStage::_candidates, and each entry is written by
+ * the single worker responsible for that candidate.
+ */
+struct ParallelTrialState {
+    Mutex mutex = MONGO_MAKE_LATCH("ParallelTrialState::mutex");
+    stdx::condition_variable workersDone;
+    size_t activeWorkers = 0;
+
+    // The first error raised by any worker.
+    Status status = Status::OK();
+
+    // Set as soon as any candidate returns enough results or hits EOF, ending the trial for all.
+    AtomicWord<bool> trialOver{false};
+
+    std::vector<std::unique_ptr<PlanStageStats>> stats;
+    std::vector<size_t> numResults;
+    std::vector<char> failed;
+};
+
+/**
+ * Builds and works the candidates listed in 'candidateIdxs' round-robin, in the same way
+ * MultiPlanStage::workAllPlans() does, until the trial is over. Results are counted and discarded.
+ */
+void workTrialCandidates(OperationContext* opCtx,
+                         OperationContext* parentOpCtx,
+                         const Collection* collection,
+                         const CanonicalQuery& cq,
+                         const std::vector<const QuerySolution*>& solutions,
+                         const std::vector<size_t>& candidateIdxs,
+                         size_t numWorks,
+                         size_t numResults,
+                         ParallelTrialState* state) {
+    struct TrialCandidate {
+        size_t idx;
+        std::unique_ptr<WorkingSet> ws;
+        std::unique_ptr<PlanStage> root;
+        bool done = false;
+    };
+
+    std::vector<TrialCandidate> candidates;
+    for (auto idx : candidateIdxs) {
+        auto ws = std::make_unique<WorkingSet>();
+        auto root = StageBuilder::build(opCtx, collection, cq, *solutions[idx], ws.get());
+        candidates.push_back({idx, std::move(ws), std::move(root)});
+    }
+
+    for (size_t ix = 0; ix < numWorks; ++ix) {
+        size_t numDone = 0;
+        for (auto&& candidate : candidates) {
+            if (candidate.done) {
+                ++numDone;
+                continue;
+            }
+
+            WorkingSetID id = WorkingSet::INVALID_ID;
+            PlanStage::StageState workState = candidate.root->work(&id);
+
+            if (PlanStage::ADVANCED == workState) {
+                candidate.ws->free(id);
+                if (++state->numResults[candidate.idx] >= numResults) {
+                    state->trialOver.store(true);
+                }
+            } else if (PlanStage::IS_EOF == workState) {
+                candidate.done = true;
+                state->trialOver.store(true);
+            } else if (PlanStage::NEED_YIELD == workState) {
+                // Workers never yield, so a write conflict abandons the parallel trial.
+                throw WriteConflictException();
+            } else if (PlanStage::NEED_TIME != workState) {
+                invariant(PlanStage::FAILURE == workState);
+                candidate.done = true;
+                state->failed[candidate.idx] = true;
+            }
+        }
+
+        // Every candidate gets at least one full round before the trial can end, so none of them
+        // is ranked without having done any work.
+        if (numDone == candidates.size() || state->trialOver.load()) {
+            break;
+        }
+
+        opCtx->checkForInterrupt();
+        stdx::lock_guard<Client> lk(*parentOpCtx->getClient());
+        uassert(parentOpCtx->getKillStatus(),
+                "operation was interrupted during a parallel plan trial",
+                !parentOpCtx->isKillPending());
+    }
+
+    // The stats must be gathered while the trees and the worker's snapshot are still alive.
+    for (auto&& candidate : candidates) {
+        state->stats[candidate.idx] = candidate.root->getStats();
+    }
+}
+
+}  // namespace
+
 MultiPlanStage::MultiPlanStage(OperationContext* opCtx,
                                const Collection* collection,
                                CanonicalQuery* cq,
@@ -145,6 +300,24 @@ PlanStage::StageState MultiPlanStage::doWork(WorkingSetID* out) {
     return state;
 }
 
+bool MultiPlanStage::producesNativeBatches() const {
+    // While there is a backup plan, every result must be inspected to decide whether to drop it.
+    return bestPlanChosen() && !_failure && !hasBackupPlan() &&
+        _candidates[_bestPlanIdx].root->producesNativeBatches();
+}
+
+PlanStage::StageState MultiPlanStage::doWorkBatch(WorkingSet* ws,
+                                                  size_t maxResults,
+                                                  std::vector<WorkingSetID>* batch,
+                                                  WorkingSetID* out) {
+    CandidatePlan& bestPlan = _candidates[_bestPlanIdx];
+    if (_failure || hasBackupPlan() || !bestPlan.results.empty()) {
+        return PlanStage::doWorkBatch(ws, maxResults, batch, out);
+    }
+
+    return bestPlan.root->workBatch(bestPlan.ws, maxResults, batch, out);
+}
+
 Status MultiPlanStage::tryYield(PlanYieldPolicy* yieldPolicy) {
     // These are the conditions which can cause us to yield:
     //   1) The yield policy's timer elapsed, or
@@ -206,29 +379,40 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     size_t numWorks = getTrialPeriodWorks(getOpCtx(), collection());
     size_t numResults = getTrialPeriodNumToReturn(*_query);
 
-    try {
-        // Work the plans, stopping when a plan hits EOF or returns some fixed number of results.
-        for (size_t ix = 0; ix < numWorks; ++ix) {
-            bool moreToDo = workAllPlans(numResults, yieldPolicy);
-            if (!moreToDo) {
-                break;
+    boost::optional<std::vector<std::unique_ptr<PlanStageStats>>> parallelTrialStats;
+    if (canRunParallelTrial()) {
+        parallelTrialStats = runParallelTrial(numWorks, numResults);
+        _specificStats.ranParallelTrial = parallelTrialStats.has_value();
+    }
+
+    if (!parallelTrialStats) {
+        try {
+            // Work the plans, stopping when a plan hits EOF or returns some fixed number of
+            // results.
+            for (size_t ix = 0; ix < numWorks; ++ix) {
+                bool moreToDo = workAllPlans(numResults, yieldPolicy);
+                if (!moreToDo) {
+                    break;
+                }
             }
+        } catch (DBException& e) {
+            e.addContext("exception thrown while multiplanner was selecting best plan");
+            throw;
         }
-    } catch (DBException& e) {
-        e.addContext("exception thrown while multiplanner was selecting best plan");
-        throw;
-    }
 
-    if (_failure) {
-        invariant(WorkingSet::INVALID_ID != _statusMemberId);
-        WorkingSetMember* member = _candidates[0].ws->get(_statusMemberId);
-        return WorkingSetCommon::getMemberStatus(*member).withContext(
-            "multiplanner encountered a failure while selecting best plan");
+        if (_failure) {
+            invariant(WorkingSet::INVALID_ID != _statusMemberId);
+            WorkingSetMember* member = _candidates[0].ws->get(_statusMemberId);
+            return WorkingSetCommon::getMemberStatus(*member).withContext(
+                "multiplanner encountered a failure while selecting best plan");
+        }
     }
 
     // After picking best plan, ranking will own plan stats from
     // candidate solutions (winner and losers).
-    auto statusWithRanking = PlanRanker::pickBestPlan(_candidates);
+    auto statusWithRanking = parallelTrialStats
+        ? PlanRanker::pickBestPlan(_candidates, std::move(*parallelTrialStats))
+        : PlanRanker::pickBestPlan(_candidates);
     if (!statusWithRanking.isOK()) {
         return statusWithRanking.getStatus();
     }
@@ -247,14 +431,19 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
     std::vector<size_t> failedCandidates = ranking->failedCandidates;
 
     CandidatePlan& bestCandidate = _candidates[_bestPlanIdx];
-    const auto& alreadyProduced = bestCandidate.results;
     const auto& bestSolution = bestCandidate.solution;
 
+    // A winner chosen by a parallel trial restarts from scratch, but whether it produced anything
+    // during the trial still decides whether it is worth caching or backing up.
+    const size_t numProducedDuringTrial = _parallelTrialResults.empty()
+        ? bestCandidate.results.size()
+        : _parallelTrialResults[_bestPlanIdx];
+
     LOG(5) << "Winning solution:\n" << redact(bestSolution->toString());
     LOG(2) << "Winning plan: " << Explain::getPlanSummary(bestCandidate.root);
 
     _backupPlanIdx = kNoSuchPlan;
-    if (bestSolution->hasBlockingStage && (0 == alreadyProduced.size())) {
+    if (bestSolution->hasBlockingStage && (0 == numProducedDuringTrial)) {
         LOG(5) << "Winner has blocking stage, looking for backup plan...";
         for (auto&& ix : candidateOrder) {
             if (!_candidates[ix].solution->hasBlockingStage) {
@@ -294,7 +483,7 @@ Status MultiPlanStage::pickBestPlan(PlanYieldPolicy* yieldPolicy) {
                    << Explain::getPlanSummary(_candidates[runnerUpIdx].root);
         }
 
-        if (alreadyProduced.empty()) {
+        if (0 == numProducedDuringTrial) {
             // We're using the "sometimes cache" mode, and the winning plan produced no results
             // during the plan ranking trial period. We will not write a plan cache entry.
             canCache = false;
@@ -419,6 +608,135 @@ bool MultiPlanStage::workAllPlans(size_t numResults, PlanYieldPolicy* yieldPolic
     return !doneWorking;
 }
 
+bool MultiPlanStage::canRunParallelTrial() const {
+    if (internalQueryPlanEvaluationParallelism.load() < 2 || _candidates.size() < 2) {
+        return false;
+    }
+
+    // Explain reports the stats of the candidate trees owned by this stage, so they must be the
+    // ones that do the trial work.
+    if (_query->getQueryRequest().isExplain() || _query->getExpCtx()->explain) {
+        return false;
+    }
+
+    // Workers take their own locks and snapshots, which cannot observe a transaction's writes.
+    if (getOpCtx()->inMultiDocumentTransaction()) {
+        return false;
+    }
+
+    // The workers share the CanonicalQuery, so it must not evaluate anything which keeps state in
+    // the query's ExpressionContext, JS scope or collator.
+    const MatchExpression* root = _query->root();
+    if (_query->getCollator() || QueryPlannerCommon::hasNode(root, MatchExpression::EXPRESSION) ||
+        QueryPlannerCommon::hasNode(root, MatchExpression::WHERE) ||
+        QueryPlannerCommon::hasNode(root, MatchExpression::TEXT) ||
+        QueryPlannerCommon::hasNode(root, MatchExpression::GEO_NEAR)) {
+        return false;
+    }
+
+    return std::all_of(_candidates.begin(), _candidates.end(), [](auto&& candidate) {
+        return candidate.solution->root && isParallelTrialSafe(candidate.solution->root.get());
+    });
+}
+
+boost::optional<std::vector<std::unique_ptr<PlanStageStats>>> MultiPlanStage::runParallelTrial(
+    size_t numWorks, size_t numResults) {
+    OperationContext* opCtx = getOpCtx();
+    const size_t numWorkers = std::min(
+        static_cast<size_t>(internalQueryPlanEvaluationParallelism.load()), _candidates.size());
+
+    std::vector<const QuerySolution*> solutions;
+    for (auto&& candidate : _candidates) {
+        solutions.push_back(candidate.solution.get());
+    }
+
+    ParallelTrialState state;
+    state.stats.resize(_candidates.size());
+    state.numResults.resize(_candidates.size(), 0);
+    state.failed.resize(_candidates.size(), false);
+    state.activeWorkers = numWorkers;
+
+    const auto dbName = collection()->ns().db().toString();
+    const auto uuid = collection()->uuid();
+    const auto readTimestamp = opCtx->recoveryUnit()->getPointInTimeReadTimestamp();
+
+    for (size_t worker = 0; worker < numWorkers; ++worker) {
+        std::vector<size_t> candidateIdxs;
+        for (size_t ix = worker; ix < _candidates.size(); ix += numWorkers) {
+            candidateIdxs.push_back(ix);
+        }
+
+        getParallelTrialPool()->schedule([&, candidateIdxs](auto status) {
+            if (status.isOK()) {
+                try {
+                    ThreadClient tc("MultiPlanTrial", opCtx->getServiceContext());
+                    auto workerOpCtx = cc().makeOperationContext();
+                    workerOpCtx->setDeadlineByDate(opCtx->getDeadline(), opCtx->getTimeoutError());
+                    if (readTimestamp) {
+                        workerOpCtx->recoveryUnit()->setTimestampReadSource(
+                            RecoveryUnit::ReadSource::kProvided, readTimestamp);
+                    }
+
+                    // The owning operation already holds the collection lock and waits for this
+                    // worker, so if the lock cannot be granted at once (e.g. behind a queued
+                    // exclusive request) waiting for it could deadlock.
+                    AutoGetCollectionForRead autoColl(workerOpCtx.get(),
+                                                      NamespaceStringOrUUID(dbName, uuid),
+                                                      AutoGetCollection::ViewMode::kViewsForbidden,
+                                                      Date_t::now());
+                    uassert(ErrorCodes::QueryPlanKilled,
+                            "collection changed during a parallel plan trial",
+                            autoColl.getCollection());
+                    workTrialCandidates(workerOpCtx.get(),
+                                        opCtx,
+                                        autoColl.getCollection(),
+                                        *_query,
+                                        solutions,
+                                        candidateIdxs,
+                                        numWorks,
+                                        numResults,
+                                        &state);
+                } catch (const DBException& ex) {
+                    status = ex.toStatus();
+                }
+            }
+
+            stdx::lock_guard<Latch> lk(state.mutex);
+            if (!status.isOK() && state.status.isOK()) {
+                state.status = status;
+                state.trialOver.store(true);
+            }
+            if (--state.activeWorkers == 0) {
+                state.workersDone.notify_all();
+            }
+        });
+    }
+
+    {
+        // The workers watch for this operation being killed, so the wait always ends.
+        stdx::unique_lock<Latch> lk(state.mutex);
+        state.workersDone.wait(lk, [&] { return state.activeWorkers == 0; });
+    }
+
+    opCtx->checkForInterrupt();
+
+    if (!state.status.isOK()) {
+        LOG(2) << "Parallel plan trial abandoned, working candidates serially: " << state.status;
+        return boost::none;
+    }
+
+    // Leave it to the serial trial to report why every candidate failed.
+    if (std::all_of(state.failed.begin(), state.failed.end(), [](char failed) { return failed; })) {
+        return boost::none;
+    }
+
+    for (size_t ix = 0; ix < _candidates.size(); ++ix) {
+        _candidates[ix].failed = state.failed[ix];
+    }
+    _parallelTrialResults = std::move(state.numResults);
+    return std::move(state.stats);
+}
+
 bool MultiPlanStage::hasBackupPlan() const {
     return kNoSuchPlan != _backupPlanIdx;
 }
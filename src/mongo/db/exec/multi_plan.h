@@ -85,6 +85,8 @@ public:
 
     StageState doWork(WorkingSetID* out) final;
 
+    bool producesNativeBatches() const final;
+
     StageType stageType() const final {
         return STAGE_MULTI_PLAN;
     }
@@ -155,6 +157,11 @@ public:
     static const char* kStageType;
 
 protected:
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxResults,
+                           std::vector<WorkingSetID>* batch,
+                           WorkingSetID* out) final;
+
     void doSaveStateRequiresCollection() final {}
 
     void doRestoreStateRequiresCollection() final {}
@@ -182,6 +189,28 @@ private:
      */
     Status tryYield(PlanYieldPolicy* yieldPolicy);
 
+    /**
+     * Returns true if the trial period may run the candidate plans concurrently on the plan
+     * evaluation worker pool instead of working them round-robin on this thread.
+     */
+    bool canRunParallelTrial() const;
+
+    /**
+     * Runs the trial period on up to 'internalQueryPlanEvaluationParallelism' worker threads. Each
+     * worker rebuilds its share of the candidates from their QuerySolutions, with a WorkingSet per
+     * candidate, under its own OperationContext and storage snapshot. The trial ends once every
+     * candidate has run 'numWorks' times, or as soon as any candidate has returned 'numResults'
+     * results or hit EOF. Returns one stats tree per candidate, in the order of '_candidates', and
+     * records in '_parallelTrialResults' how many results each candidate produced.
+     *
+     * The candidate trees owned by this stage are not worked, so the winner starts over from the
+     * beginning once chosen. Returns boost::none if the trial could not be completed on the worker
+     * pool, e.g. because a worker could not lock the collection without waiting; the caller should
+     * then run the ordinary trial period.
+     */
+    boost::optional<std::vector<std::unique_ptr<PlanStageStats>>> runParallelTrial(
+        size_t numWorks, size_t numResults);
+
     static const int kNoSuchPlan = -1;
 
     // Describes the cases in which we should write an entry for the winning plan to the plan cache.
@@ -225,6 +254,10 @@ private:
     // returned by ::work()
     WorkingSetID _statusMemberId;
 
+    // The number of results each candidate returned during a parallel trial period. Empty unless
+    // the plans were ranked by runParallelTrial().
+    std::vector<size_t> _parallelTrialResults;
+
     // Stats
     MultiPlanStats _specificStats;
 };
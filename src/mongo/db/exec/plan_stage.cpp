@@ -42,21 +42,91 @@ namespace mongo {
 PlanStage::StageState PlanStage::work(WorkingSetID* out) {
     invariant(_opCtx);
     ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
-    ++_commonStats.works;
 
     StageState workResult = doWork(out);
+    recordWorkResult(workResult);
+    return workResult;
+}
+
+PlanStage::StageState PlanStage::workBatch(WorkingSet* ws,
+                                           size_t maxResults,
+                                           std::vector<WorkingSetID>* batch,
+                                           WorkingSetID* out) {
+    invariant(_opCtx);
+    invariant(batch->empty());
+    invariant(maxResults > 0);
+    ScopedTimer timer(getClock(), &_commonStats.executionTimeMillis);
+
+    if (_pendingBatchState) {
+        StageState pendingState = *_pendingBatchState;
+        _pendingBatchState = boost::none;
+        *out = _pendingBatchId;
+        _pendingBatchId = WorkingSet::INVALID_ID;
+        recordWorkResult(pendingState);
+        return pendingState;
+    }
+
+    StageState batchResult = doWorkBatch(ws, maxResults, batch, out);
+    invariant(batch->size() <= maxResults);
+
+    if (batch->empty()) {
+        invariant(StageState::ADVANCED != batchResult);
+        recordWorkResult(batchResult);
+        return batchResult;
+    }
+
+    for (size_t i = 0; i < batch->size(); ++i) {
+        recordWorkResult(StageState::ADVANCED);
+    }
 
-    if (StageState::ADVANCED == workResult) {
+    if (StageState::ADVANCED != batchResult && StageState::NEED_TIME != batchResult) {
+        _pendingBatchState = batchResult;
+        _pendingBatchId = *out;
+    }
+
+    return StageState::ADVANCED;
+}
+
+PlanStage::StageState PlanStage::doWorkBatch(WorkingSet* ws,
+                                             size_t maxResults,
+                                             std::vector<WorkingSetID>* batch,
+                                             WorkingSetID* out) {
+    // Bound the units of work rather than the results, so that a selective stage still hands
+    // control back to its caller, which may need to yield, at a regular interval.
+    size_t needTimes = 0;
+    for (size_t unit = 0; unit < maxResults; ++unit) {
+        StageState state = doWork(out);
+        if (StageState::ADVANCED == state) {
+            ws->get(*out)->makeObjOwnedIfNeeded();
+            batch->push_back(*out);
+        } else if (StageState::NEED_TIME == state) {
+            ++needTimes;
+        } else {
+            recordAbsorbedNeedTimes(needTimes);
+            return state;
+        }
+    }
+
+    if (batch->empty()) {
+        recordAbsorbedNeedTimes(needTimes - 1);
+        return StageState::NEED_TIME;
+    }
+    recordAbsorbedNeedTimes(needTimes);
+    return StageState::ADVANCED;
+}
+
+void PlanStage::recordWorkResult(StageState state) {
+    ++_commonStats.works;
+
+    if (StageState::ADVANCED == state) {
         ++_commonStats.advanced;
-    } else if (StageState::NEED_TIME == workResult) {
+    } else if (StageState::NEED_TIME == state) {
         ++_commonStats.needTime;
-    } else if (StageState::NEED_YIELD == workResult) {
+    } else if (StageState::NEED_YIELD == state) {
         ++_commonStats.needYield;
-    } else if (StageState::FAILURE == workResult) {
+    } else if (StageState::FAILURE == state) {
         _commonStats.failed = true;
     }
-
-    return workResult;
 }
 
 void PlanStage::saveState() {
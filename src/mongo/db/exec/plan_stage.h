@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <memory>
 #include <vector>
 
@@ -193,6 +194,32 @@ public:
      */
     StageState work(WorkingSetID* out);
 
+    /**
+     * Batch-at-a-time variant of work(). Asks the stage for up to 'maxResults' units of output
+     * at once and appends their ids to 'batch', which must be empty on entry.
+     *
+     * Returns ADVANCED if and only if at least one result was appended to 'batch'. Otherwise
+     * returns another value of StageState with the same meaning, and the same contract for
+     * 'out', as work(). A batch which ends early on IS_EOF, NEED_YIELD or FAILURE is returned as
+     * ADVANCED, and that state is instead returned by the following call.
+     *
+     * Every member in a returned batch owns its document, since the storage cursor that produced
+     * it has usually moved on by the time the caller looks at it. 'ws' must be the WorkingSet
+     * shared by this stage tree.
+     */
+    StageState workBatch(WorkingSet* ws,
+                         size_t maxResults,
+                         std::vector<WorkingSetID>* batch,
+                         WorkingSetID* out);
+
+    /**
+     * Returns true if this stage, and every stage below it, produces batches natively rather
+     * than by repeating work(). Only then is it worth asking this subtree for batches.
+     */
+    virtual bool producesNativeBatches() const {
+        return false;
+    }
+
     /**
      * Returns true if no more work can be done on the query / out of results.
      */
@@ -341,6 +368,28 @@ protected:
      */
     virtual StageState doWork(WorkingSetID* out) = 0;
 
+    /**
+     * Produces one batch.  See comment at workBatch() above.  The default implementation loops
+     * over doWork().
+     *
+     * Implementations may return IS_EOF, NEED_YIELD or FAILURE after appending results to
+     * 'batch'; workBatch() holds that state back until the next call.  They are responsible for
+     * recording in '_commonStats' each NEED_TIME they absorb (see recordAbsorbedNeedTimes()), but
+     * not the results they return or the state they end on.
+     */
+    virtual StageState doWorkBatch(WorkingSet* ws,
+                                   size_t maxResults,
+                                   std::vector<WorkingSetID>* batch,
+                                   WorkingSetID* out);
+
+    /**
+     * Records 'count' units of work which produced NEED_TIME inside a batch and were not returned.
+     */
+    void recordAbsorbedNeedTimes(size_t count) {
+        _commonStats.works += count;
+        _commonStats.needTime += count;
+    }
+
     /**
      * Saves any stage-specific state required to resume where it was if the underlying data
      * changes.
@@ -385,7 +434,17 @@ protected:
     CommonStats _commonStats;
 
 private:
+    /**
+     * Updates '_commonStats' for a unit of work which returned 'state'.
+     */
+    void recordWorkResult(StageState state);
+
     OperationContext* _opCtx;
+
+    // The state which ended the last batch early, and the id that goes with it. Returned by the
+    // next call to workBatch().
+    boost::optional<StageState> _pendingBatchState;
+    WorkingSetID _pendingBatchId = WorkingSet::INVALID_ID;
 };
 
 }  // namespace mongo
@@ -567,6 +567,10 @@ struct MultiPlanStats : public SpecificStats {
     uint64_t estimateObjectSizeInBytes() const {
         return sizeof(*this);
     }
+
+    // True if the candidates were ranked by a trial run on worker threads rather than by working
+    // them on the owning thread.
+    bool ranParallelTrial = false;
 };
 
 struct OrStats : public SpecificStats {
@@ -86,6 +86,31 @@ PlanStage::StageState SkipStage::doWork(WorkingSetID* out) {
     return status;
 }
 
+PlanStage::StageState SkipStage::doWorkBatch(WorkingSet* ws,
+                                             size_t maxResults,
+                                             std::vector<WorkingSetID>* batch,
+                                             WorkingSetID* out) {
+    StageState status = child()->workBatch(ws, maxResults, batch, out);
+    if (PlanStage::ADVANCED != status || 0 == _toSkip) {
+        return status;
+    }
+
+    // Drop the front of the batch while we're still skipping results.
+    const size_t toDrop = std::min(batch->size(), static_cast<size_t>(_toSkip));
+    for (size_t i = 0; i < toDrop; ++i) {
+        _ws->free((*batch)[i]);
+    }
+    batch->erase(batch->begin(), batch->begin() + toDrop);
+    _toSkip -= toDrop;
+
+    if (batch->empty()) {
+        recordAbsorbedNeedTimes(toDrop - 1);
+        return PlanStage::NEED_TIME;
+    }
+    recordAbsorbedNeedTimes(toDrop);
+    return PlanStage::ADVANCED;
+}
+
 unique_ptr<PlanStageStats> SkipStage::getStats() {
     _commonStats.isEOF = isEOF();
     _specificStats.skip = _toSkip;
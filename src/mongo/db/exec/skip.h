@@ -53,6 +53,10 @@ public:
     bool isEOF() final;
     StageState doWork(WorkingSetID* out) final;
 
+    bool producesNativeBatches() const final {
+        return child()->producesNativeBatches();
+    }
+
     StageType stageType() const final {
         return STAGE_SKIP;
     }
@@ -63,6 +67,12 @@ public:
 
     static const char* kStageType;
 
+protected:
+    StageState doWorkBatch(WorkingSet* ws,
+                           size_t maxResults,
+                           std::vector<WorkingSetID>* batch,
+                           WorkingSetID* out) final;
+
 private:
     WorkingSet* _ws;
 
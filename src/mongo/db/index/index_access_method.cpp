@@ -33,6 +33,7 @@
 
 #include "mongo/db/index/btree_access_method.h"
 
+#include <algorithm>
 #include <utility>
 #include <vector>
 
@@ -52,6 +53,7 @@
 #include "mongo/db/repl/timestamp_block.h"
 #include "mongo/db/storage/durable_catalog.h"
 #include "mongo/db/storage/storage_options.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/util/log.h"
 #include "mongo/util/progress_meter.h"
 #include "mongo/util/scopeguard.h"
@@ -446,13 +448,20 @@ class AbstractIndexAccessMethod::BulkBuilderImpl : public IndexAccessMethod::Bul
 public:
     BulkBuilderImpl(IndexCatalogEntry* indexCatalogEntry,
                     const IndexDescriptor* descriptor,
-                    size_t maxMemoryUsageBytes);
+                    size_t maxMemoryUsageBytes,
+                    size_t numWorkers);
 
     Status insert(OperationContext* opCtx,
                   const BSONObj& obj,
                   const RecordId& loc,
                   const InsertDeleteOptions& options) final;
 
+    Status insertFromWorker(size_t worker,
+                            const BSONObj& obj,
+                            const RecordId& loc,
+                            const InsertDeleteOptions& options,
+                            std::vector<RecordId>* skipped) final;
+
     const MultikeyPaths& getMultikeyPaths() const final;
 
     bool isMultikey() const final;
@@ -465,117 +474,233 @@ public:
 
     int64_t getKeysInserted() const final;
 
+    SorterStats getWorkerSorterStats(size_t worker) const final;
+
 private:
-    std::unique_ptr<Sorter> _sorter;
-    IndexCatalogEntry* _indexCatalogEntry;
-    int64_t _keysInserted = 0;
+    // The state each collection scan worker builds up on its own. Without parallel workers, there
+    // is just one.
+    struct Worker {
+        std::unique_ptr<Sorter> sorter;
+        int64_t keysInserted = 0;
+
+        // Copies of the sorter's stats that getWorkerSorterStats() can read while the worker runs.
+        AtomicWord<long long> sorterMemUsed;
+        AtomicWord<long long> sorterSpills;
+
+        // Set to true if any document added by this worker causes the index to become multikey.
+        bool isMultiKey = false;
+
+        // Holds the path components that cause this index to be multikey. Remains empty if this
+        // index doesn't support path-level multikey tracking.
+        MultikeyPaths indexMultikeyPaths;
+
+        // Caches the set of all multikey metadata keys generated by this worker. These are
+        // inserted into the sorter after all normal data keys have been added, just before the
+        // bulk build is committed.
+        KeyStringSet multikeyMetadataKeys;
+    };
 
-    // Set to true if any document added to the BulkBuilder causes the index to become multikey.
-    bool _isMultiKey = false;
+    Status _insert(Worker* worker,
+                   const BSONObj& obj,
+                   const RecordId& loc,
+                   const InsertDeleteOptions& options,
+                   const OnSuppressedErrorFn& onSuppressedError);
 
-    // Holds the path components that cause this index to be multikey. The '_indexMultikeyPaths'
-    // vector remains empty if this index doesn't support path-level multikey tracking.
-    MultikeyPaths _indexMultikeyPaths;
+    const SortOptions _sortOptions;
+    std::vector<Worker> _workers;
+    IndexCatalogEntry* _indexCatalogEntry;
 
-    // Caches the set of all multikey metadata keys generated during the bulk build process.
-    // These are inserted into the sorter after all normal data keys have been added, just
-    // before the bulk build is committed.
-    KeyStringSet _multikeyMetadataKeys;
+    // The union of the workers' multikey paths, computed by getMultikeyPaths() when there are
+    // several workers.
+    mutable MultikeyPaths _mergedMultikeyPaths;
 };
 
 std::unique_ptr<IndexAccessMethod::BulkBuilder> AbstractIndexAccessMethod::initiateBulk(
-    size_t maxMemoryUsageBytes) {
-    return std::make_unique<BulkBuilderImpl>(_indexCatalogEntry, _descriptor, maxMemoryUsageBytes);
+    size_t maxMemoryUsageBytes, size_t numWorkers) {
+    return std::make_unique<BulkBuilderImpl>(
+        _indexCatalogEntry, _descriptor, maxMemoryUsageBytes, numWorkers);
 }
 
 AbstractIndexAccessMethod::BulkBuilderImpl::BulkBuilderImpl(IndexCatalogEntry* index,
                                                             const IndexDescriptor* descriptor,
-                                                            size_t maxMemoryUsageBytes)
-    : _sorter(Sorter::make(
-          SortOptions()
-              .TempDir(storageGlobalParams.dbpath + "/_tmp")
-              .ExtSortAllowed()
-              .MaxMemoryUsageBytes(maxMemoryUsageBytes),
-          BtreeExternalSortComparison(),
-          std::pair<KeyString::Value::SorterDeserializeSettings,
-                    mongo::NullValue::SorterDeserializeSettings>(
-              {index->accessMethod()->getSortedDataInterface()->getKeyStringVersion()}, {}))),
-      _indexCatalogEntry(index) {}
+                                                            size_t maxMemoryUsageBytes,
+                                                            size_t numWorkers)
+    : _sortOptions(SortOptions()
+                       .TempDir(storageGlobalParams.dbpath + "/_tmp")
+                       .ExtSortAllowed()
+                       .MaxMemoryUsageBytes(maxMemoryUsageBytes / numWorkers)),
+      _workers(numWorkers),
+      _indexCatalogEntry(index) {
+    invariant(numWorkers > 0);
+    for (auto&& worker : _workers) {
+        worker.sorter.reset(Sorter::make(
+            _sortOptions,
+            BtreeExternalSortComparison(),
+            std::pair<KeyString::Value::SorterDeserializeSettings,
+                      mongo::NullValue::SorterDeserializeSettings>(
+                {index->accessMethod()->getSortedDataInterface()->getKeyStringVersion()}, {})));
+    }
+}
 
 Status AbstractIndexAccessMethod::BulkBuilderImpl::insert(OperationContext* opCtx,
                                                           const BSONObj& obj,
                                                           const RecordId& loc,
                                                           const InsertDeleteOptions& options) {
+    return _insert(
+        &_workers[0],
+        obj,
+        loc,
+        options,
+        [&](Status status, const BSONObj&, boost::optional<RecordId>) {
+            // If a key generation error was suppressed, record the document as "skipped" so the
+            // index builder can retry at a point when data is consistent.
+            auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
+            if (interceptor && interceptor->getSkippedRecordTracker()) {
+                LOG(1) << "Recording suppressed key generation error to retry later: " << status
+                       << " on " << loc << ": " << redact(obj);
+                interceptor->getSkippedRecordTracker()->record(opCtx, loc);
+            }
+        });
+}
+
+Status AbstractIndexAccessMethod::BulkBuilderImpl::insertFromWorker(
+    size_t worker,
+    const BSONObj& obj,
+    const RecordId& loc,
+    const InsertDeleteOptions& options,
+    std::vector<RecordId>* skipped) {
+    invariant(worker < _workers.size());
+    return _insert(&_workers[worker],
+                   obj,
+                   loc,
+                   options,
+                   [&](Status status, const BSONObj&, boost::optional<RecordId>) {
+                       auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
+                       if (interceptor && interceptor->getSkippedRecordTracker()) {
+                           LOG(1) << "Suppressed key generation error to retry later: " << status
+                                  << " on " << loc << ": " << redact(obj);
+                           skipped->push_back(loc);
+                       }
+                   });
+}
+
+Status AbstractIndexAccessMethod::BulkBuilderImpl::_insert(
+    Worker* worker,
+    const BSONObj& obj,
+    const RecordId& loc,
+    const InsertDeleteOptions& options,
+    const OnSuppressedErrorFn& onSuppressedError) {
     KeyStringSet keys;
     MultikeyPaths multikeyPaths;
 
     try {
-        _indexCatalogEntry->accessMethod()->getKeys(
-            obj,
-            options.getKeysMode,
-            GetKeysContext::kReadOrAddKeys,
-            &keys,
-            &_multikeyMetadataKeys,
-            &multikeyPaths,
-            loc,
-            [&](Status status, const BSONObj&, boost::optional<RecordId>) {
-                // If a key generation error was suppressed, record the document as "skipped" so the
-                // index builder can retry at a point when data is consistent.
-                auto interceptor = _indexCatalogEntry->indexBuildInterceptor();
-                if (interceptor && interceptor->getSkippedRecordTracker()) {
-                    LOG(1) << "Recording suppressed key generation error to retry later: " << status
-                           << " on " << loc << ": " << redact(obj);
-                    interceptor->getSkippedRecordTracker()->record(opCtx, loc);
-                }
-            });
+        _indexCatalogEntry->accessMethod()->getKeys(obj,
+                                                    options.getKeysMode,
+                                                    GetKeysContext::kReadOrAddKeys,
+                                                    &keys,
+                                                    &worker->multikeyMetadataKeys,
+                                                    &multikeyPaths,
+                                                    loc,
+                                                    onSuppressedError);
     } catch (...) {
         return exceptionToStatus();
     }
 
     if (!multikeyPaths.empty()) {
-        if (_indexMultikeyPaths.empty()) {
-            _indexMultikeyPaths = multikeyPaths;
+        if (worker->indexMultikeyPaths.empty()) {
+            worker->indexMultikeyPaths = multikeyPaths;
         } else {
-            invariant(_indexMultikeyPaths.size() == multikeyPaths.size());
+            invariant(worker->indexMultikeyPaths.size() == multikeyPaths.size());
             for (size_t i = 0; i < multikeyPaths.size(); ++i) {
-                _indexMultikeyPaths[i].insert(multikeyPaths[i].begin(), multikeyPaths[i].end());
+                worker->indexMultikeyPaths[i].insert(multikeyPaths[i].begin(),
+                                                     multikeyPaths[i].end());
             }
         }
     }
 
     for (const auto& keyString : keys) {
-        _sorter->add(keyString, mongo::NullValue());
-        ++_keysInserted;
+        worker->sorter->add(keyString, mongo::NullValue());
+        ++worker->keysInserted;
     }
+    worker->sorterMemUsed.store(worker->sorter->memUsed());
+    worker->sorterSpills.store(worker->sorter->numSpills());
 
-    _isMultiKey = _isMultiKey ||
+    worker->isMultiKey = worker->isMultiKey ||
         _indexCatalogEntry->accessMethod()->shouldMarkIndexAsMultikey(
             keys.size(),
-            {_multikeyMetadataKeys.begin(), _multikeyMetadataKeys.end()},
+            {worker->multikeyMetadataKeys.begin(), worker->multikeyMetadataKeys.end()},
             multikeyPaths);
 
     return Status::OK();
 }
 
 const MultikeyPaths& AbstractIndexAccessMethod::BulkBuilderImpl::getMultikeyPaths() const {
-    return _indexMultikeyPaths;
+    if (_workers.size() == 1) {
+        return _workers[0].indexMultikeyPaths;
+    }
+
+    _mergedMultikeyPaths.clear();
+    for (auto&& worker : _workers) {
+        const auto& paths = worker.indexMultikeyPaths;
+        if (paths.empty()) {
+            continue;
+        }
+        if (_mergedMultikeyPaths.empty()) {
+            _mergedMultikeyPaths = paths;
+            continue;
+        }
+        invariant(_mergedMultikeyPaths.size() == paths.size());
+        for (size_t i = 0; i < paths.size(); ++i) {
+            _mergedMultikeyPaths[i].insert(paths[i].begin(), paths[i].end());
+        }
+    }
+    return _mergedMultikeyPaths;
 }
 
 bool AbstractIndexAccessMethod::BulkBuilderImpl::isMultikey() const {
-    return _isMultiKey;
+    return std::any_of(
+        _workers.begin(), _workers.end(), [](auto&& worker) { return worker.isMultiKey; });
 }
 
 IndexAccessMethod::BulkBuilder::Sorter::Iterator*
 AbstractIndexAccessMethod::BulkBuilderImpl::done() {
-    for (const auto& keyString : _multikeyMetadataKeys) {
-        _sorter->add(keyString, mongo::NullValue());
-        ++_keysInserted;
+    // Workers may have generated the same metadata keys, which must only be inserted once.
+    auto& metadataKeys = _workers[0].multikeyMetadataKeys;
+    for (size_t i = 1; i < _workers.size(); ++i) {
+        metadataKeys.insert(_workers[i].multikeyMetadataKeys.begin(),
+                            _workers[i].multikeyMetadataKeys.end());
     }
-    return _sorter->done();
+    for (const auto& keyString : metadataKeys) {
+        _workers[0].sorter->add(keyString, mongo::NullValue());
+        ++_workers[0].keysInserted;
+    }
+
+    if (_workers.size() == 1) {
+        return _workers[0].sorter->done();
+    }
+
+    // Each worker's keys are sorted, and possibly spilled, independently. A k-way merge of them
+    // feeds the index's bulk builder in order. The merge owns no spill file of its own; each
+    // worker's iterator cleans up its own.
+    std::vector<std::shared_ptr<Sorter::Iterator>> iters;
+    for (auto&& worker : _workers) {
+        iters.emplace_back(worker.sorter->done());
+    }
+    return Sorter::Iterator::merge(iters, "", _sortOptions, BtreeExternalSortComparison());
 }
 
 int64_t AbstractIndexAccessMethod::BulkBuilderImpl::getKeysInserted() const {
-    return _keysInserted;
+    int64_t keysInserted = 0;
+    for (auto&& worker : _workers) {
+        keysInserted += worker.keysInserted;
+    }
+    return keysInserted;
+}
+
+IndexAccessMethod::BulkBuilder::SorterStats
+AbstractIndexAccessMethod::BulkBuilderImpl::getWorkerSorterStats(size_t worker) const {
+    invariant(worker < _workers.size());
+    return {_workers[worker].sorterMemUsed.load(), _workers[worker].sorterSpills.load()};
 }
 
 Status AbstractIndexAccessMethod::commitBulk(OperationContext* opCtx,
@@ -210,13 +210,27 @@ public:
                               const RecordId& loc,
                               const InsertDeleteOptions& options) = 0;
 
+        /**
+         * Inserts on behalf of collection scan worker 'worker', which must be less than the
+         * 'numWorkers' the BulkBuilder was started with. Each worker generates keys into its own
+         * Sorter, so different workers may call this concurrently. No OperationContext is needed:
+         * where insert() would record a document whose key generation error was suppressed, this
+         * appends it to 'skipped' for the caller to record.
+         */
+        virtual Status insertFromWorker(size_t worker,
+                                        const BSONObj& obj,
+                                        const RecordId& loc,
+                                        const InsertDeleteOptions& options,
+                                        std::vector<RecordId>* skipped) = 0;
+
         virtual const MultikeyPaths& getMultikeyPaths() const = 0;
 
         virtual bool isMultikey() const = 0;
 
         /**
          * Inserts all multikey metadata keys cached during the BulkBuilder's lifetime into the
-         * underlying Sorter, finalizes it, and returns an iterator over the sorted dataset.
+         * underlying Sorter, finalizes it, and returns an iterator over the sorted dataset. With
+         * several workers, the iterator merges the workers' Sorters.
          */
         virtual Sorter::Iterator* done() = 0;
 
@@ -224,6 +238,18 @@ public:
          * Returns number of keys inserted using this BulkBuilder.
          */
         virtual int64_t getKeysInserted() const = 0;
+
+        struct SorterStats {
+            long long memUsedBytes = 0;
+            long long numSpills = 0;
+        };
+
+        /**
+         * Returns how much memory the Sorter of collection scan worker 'worker' holds and how many
+         * times it has spilled to disk, as of the worker's last insert. Unlike the rest of the
+         * BulkBuilder, this may be called while the workers are inserting.
+         */
+        virtual SorterStats getWorkerSorterStats(size_t worker) const = 0;
     };
 
     /**
@@ -235,8 +261,11 @@ public:
      *
      * maxMemoryUsageBytes: amount of memory consumed before the external sorter starts spilling to
      *                      disk
+     * numWorkers: number of collection scan workers that will call insertFromWorker. Each gets its
+     *             own Sorter and an equal share of maxMemoryUsageBytes.
      */
-    virtual std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes) = 0;
+    virtual std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes,
+                                                      size_t numWorkers) = 0;
 
     /**
      * Call this when you are ready to finish your bulk work.
@@ -504,7 +533,8 @@ public:
 
     void setIndexIsMultikey(OperationContext* opCtx, MultikeyPaths paths) final;
 
-    std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes) final;
+    std::unique_ptr<BulkBuilder> initiateBulk(size_t maxMemoryUsageBytes,
+                                              size_t numWorkers) final;
 
     Status commitBulk(OperationContext* opCtx,
                       BulkBuilder* bulk,
@@ -48,6 +48,7 @@
 #include "mongo/util/decorable.h"
 #include "mongo/util/interruptible.h"
 #include "mongo/util/lockable_adapter.h"
+#include "mongo/util/shared_buffer.h"
 #include "mongo/util/time_support.h"
 #include "mongo/util/timer.h"
 
@@ -423,6 +424,21 @@ public:
         return _exhaust;
     }
 
+    /**
+     * Gives this operation a buffer to build its reply in. Each batch of an exhaust stream is
+     * handed the buffer the previous batch was sent from.
+     */
+    void setReplyBuffer(SharedBuffer buffer) {
+        _replyBuffer = std::move(buffer);
+    }
+
+    /**
+     * Returns the buffer passed to setReplyBuffer, if any, and forgets it.
+     */
+    SharedBuffer releaseReplyBuffer() {
+        return std::move(_replyBuffer);
+    }
+
 private:
     StatusWith<stdx::cv_status> waitForConditionOrInterruptNoAssertUntil(
         stdx::condition_variable& cv, BasicLockableAdapter m, Date_t deadline) noexcept override;
@@ -560,6 +576,9 @@ private:
 
     // Whether this operation is an exhaust command.
     bool _exhaust = false;
+
+    // A buffer to build this operation's reply in, if the caller had one to spare.
+    SharedBuffer _replyBuffer;
 };
 
 namespace repl {
@@ -32,6 +32,8 @@
 #include <boost/filesystem/operations.hpp>
 #include <memory>
 
+#include "mongo/base/counter.h"
+#include "mongo/db/commands/server_status_metric.h"
 #include "mongo/db/exec/document_value/document.h"
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/db/exec/document_value/value_comparator.h"
@@ -61,6 +63,40 @@ std::string nextFileName() {
     return "extsort-doc-group." + std::to_string(documentSourceGroupFileCounter.fetchAndAdd(1));
 }
 
+Counter64 partitionedSpillsCounter;
+ServerStatusMetricField<Counter64> displayPartitionedSpills("query.group.partitionedSpills",
+                                                           &partitionedSpillsCounter);
+Counter64 spilledPartitionRunsCounter;
+ServerStatusMetricField<Counter64> displaySpilledPartitionRuns("query.group.spilledPartitionRuns",
+                                                               &spilledPartitionRunsCounter);
+Counter64 spilledGroupsCounter;
+ServerStatusMetricField<Counter64> displaySpilledGroups("query.group.spilledGroups",
+                                                       &spilledGroupsCounter);
+Counter64 spilledBytesCounter;
+ServerStatusMetricField<Counter64> displaySpilledBytes("query.group.spilledBytes",
+                                                      &spilledBytesCounter);
+Counter64 repartitionsCounter;
+ServerStatusMetricField<Counter64> displayRepartitions("query.group.repartitions",
+                                                      &repartitionsCounter);
+Counter64 sortedRunPartitionsCounter;
+ServerStatusMetricField<Counter64> displaySortedRunPartitions("query.group.sortedRunPartitions",
+                                                              &sortedRunPartitionsCounter);
+
+/**
+ * Chooses the partition of a group key with hash 'hash' among 'numPartitions' partitions at
+ * 'depth'. The hash is salted with the depth and run through the MurmurHash3 finalizer so that the
+ * keys of a partition are spread over all of its children when it is split again.
+ */
+size_t partitionForHash(size_t hash, size_t depth, size_t numPartitions) {
+    uint64_t h = static_cast<uint64_t>(hash) + depth * 0x9e3779b97f4a7c15ULL;
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h % numPartitions;
+}
+
 }  // namespace
 
 using boost::intrusive_ptr;
@@ -144,7 +180,9 @@ DocumentSource::GetNextResult DocumentSourceGroup::doGetNext() {
         accum->reset();  // Prep accumulators for a new group.
     }
 
-    if (_spilled) {
+    if (_partitioned) {
+        return getNextPartitioned();
+    } else if (_spilled) {
         return getNextSpilled();
     } else {
         return getNextStandard();
@@ -161,7 +199,7 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
     while (pExpCtx->getValueComparator().evaluate(_currentId == _firstPartOfNextGroup.first)) {
         // Inside of this loop, _firstPartOfNextGroup is the current data being processed.
         // At loop exit, it is the first value to be processed in the next group.
-        switch (numAccumulators) {  // mirrors switch in spill()
+        switch (numAccumulators) {  // mirrors serializeForSpill()
             case 1:                 // Single accumulators serialize as a single Value.
                 _currentAccumulators[0]->process(_firstPartOfNextGroup.second, true);
             case 0:  // No accumulators so no Values.
@@ -175,7 +213,12 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
         }
 
         if (!_sorterIterator->more()) {
-            dispose();
+            if (_partitioned) {
+                // Only this partition was merged from sorted runs; the others are still pending.
+                _sorterIterator.reset();
+            } else {
+                dispose();
+            }
             break;
         }
 
@@ -185,6 +228,28 @@ DocumentSource::GetNextResult DocumentSourceGroup::getNextSpilled() {
     return makeDocument(_currentId, _currentAccumulators, pExpCtx->needsMerge);
 }
 
+DocumentSource::GetNextResult DocumentSourceGroup::getNextPartitioned() {
+    // We have spilled to hash partitions. Output the groups of one partition at a time, loading the
+    // next one once the groups of the current partition are exhausted.
+    while (!_sorterIterator && groupsIterator == _groups->end()) {
+        if (_pendingPartitions.empty()) {
+            dispose();
+            return GetNextResult::makeEOF();
+        }
+        loadNextSpilledPartition();
+    }
+
+    if (_sorterIterator) {
+        // The partition did not fit in memory even at the maximum depth, so was spilled as sorted
+        // runs.
+        return getNextSpilled();
+    }
+
+    Document out = makeDocument(groupsIterator->first, groupsIterator->second, pExpCtx->needsMerge);
+    ++groupsIterator;
+    return std::move(out);
+}
+
 DocumentSource::GetNextResult DocumentSourceGroup::getNextStandard() {
     // Not spilled, and not streaming.
     if (_groups->empty())
@@ -202,6 +267,8 @@ void DocumentSourceGroup::doDispose() {
     // Free our resources.
     _groups = pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>();
     _sorterIterator.reset();
+    _spilledPartitions.clear();
+    _pendingPartitions.clear();
 
     // Make us look done.
     groupsIterator = _groups->end();
@@ -252,6 +319,19 @@ Value DocumentSourceGroup::serialize(boost::optional<ExplainOptions::Verbosity>
         insides["$doingMerge"] = Value(true);
     }
 
+    if (explain && *explain >= ExplainOptions::Verbosity::kExecStats && !_partitionStats.empty()) {
+        vector<Value> partitions;
+        for (auto&& stats : _partitionStats) {
+            partitions.push_back(Value(Document{{"depth", static_cast<long long>(stats.depth)},
+                                                {"runs", static_cast<long long>(stats.runs)},
+                                                {"groups", static_cast<long long>(stats.groups)},
+                                                {"bytes", static_cast<long long>(stats.bytes)},
+                                                {"sortedRuns",
+                                                 static_cast<long long>(stats.sortedRuns)}}));
+        }
+        insides["spilledPartitions"] = Value(std::move(partitions));
+    }
+
     return Value(DOC(getSourceName() << insides.freeze()));
 }
 
@@ -332,7 +412,8 @@ DocumentSourceGroup::DocumentSourceGroup(const intrusive_ptr<ExpressionContext>&
       _initialized(false),
       _groups(pExpCtx->getValueComparator().makeUnorderedValueMap<Accumulators>()),
       _spilled(false),
-      _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongos) {
+      _allowDiskUse(pExpCtx->allowDiskUse && !pExpCtx->inMongos),
+      _numSpillPartitions(internalDocumentSourceGroupSpillPartitions.load()) {
     if (!pExpCtx->inMongos && (pExpCtx->allowDiskUse || kDebugBuild)) {
         // We spill to disk in debug mode, regardless of allowDiskUse, to stress the system.
         _fileName = pExpCtx->tempDir + "/" + nextFileName();
@@ -343,6 +424,10 @@ DocumentSourceGroup::~DocumentSourceGroup() {
     if (_ownsFileDeletion) {
         DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName));
     }
+    // Partition files are removed as they are output, so only those of an unfinished $group remain.
+    for (size_t i = 0; i < _partitionStats.size(); ++i) {
+        DESTRUCTOR_GUARD(boost::filesystem::remove(_fileName + ".partition." + std::to_string(i)));
+    }
 }
 
 void DocumentSourceGroup::addAccumulator(AccumulationStatement accumulationStatement) {
@@ -472,7 +557,11 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
                     "Exceeded memory limit for $group, but didn't allow external sort."
                     " Pass allowDiskUse:true to opt in.",
                     _allowDiskUse);
-            _sortedFiles.push_back(spill());
+            if (_numSpillPartitions > 0) {
+                spillToPartitions(0, &_spilledPartitions);
+            } else {
+                _sortedFiles.push_back(spill());
+            }
             _memoryUsageBytes = 0;
         }
 
@@ -519,9 +608,15 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
             if (!inserted &&                 // is a dup
                 !pExpCtx->inMongos &&        // can't spill to disk in mongos
                 !_allowDiskUse &&            // don't change behavior when testing external sort
-                _sortedFiles.size() < 20) {  // don't open too many FDs
+                _sortedFiles.size() < 20 &&  // don't open too many FDs
+                _numPartitionedSpills < 20) {
 
-                _sortedFiles.push_back(spill());
+                if (_numSpillPartitions > 0) {
+                    spillToPartitions(0, &_spilledPartitions);
+                    _memoryUsageBytes = 0;
+                } else {
+                    _sortedFiles.push_back(spill());
+                }
             }
         }
     }
@@ -535,7 +630,21 @@ DocumentSource::GetNextResult DocumentSourceGroup::initialize() {
         }
         case DocumentSource::GetNextResult::ReturnStatus::kEOF: {
             // Do any final steps necessary to prepare to output results.
-            if (!_sortedFiles.empty()) {
+            if (!_spilledPartitions.empty()) {
+                _partitioned = true;
+
+                // Flush the remaining groups so that each partition holds every partial result for
+                // its share of the key space.
+                spillToPartitions(0, &_spilledPartitions);
+                _memoryUsageBytes = 0;
+                for (auto&& partition : _spilledPartitions) {
+                    if (!partition.runs.empty()) {
+                        _pendingPartitions.push_back(std::move(partition));
+                    }
+                }
+                _spilledPartitions.clear();
+                groupsIterator = _groups->end();
+            } else if (!_sortedFiles.empty()) {
                 _spilled = true;
                 if (!_groups->empty()) {
                     _sortedFiles.push_back(spill());
@@ -589,36 +698,211 @@ shared_ptr<Sorter<Value, Value>::Iterator> DocumentSourceGroup::spill() {
 
     SortedFileWriter<Value, Value> writer(
         SortOptions().TempDir(pExpCtx->tempDir), _fileName, _nextSortedFileWriterOffset);
-    switch (_accumulatedFields.size()) {  // same as ptrs[i]->second.size() for all i.
-        case 0:                           // no values, essentially a distinct
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first, Value());
-            }
-            break;
+    for (size_t i = 0; i < ptrs.size(); i++) {
+        writer.addAlreadySorted(ptrs[i]->first, serializeForSpill(ptrs[i]->second));
+    }
+
+    _groups->clear();
+
+    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
+    _nextSortedFileWriterOffset = writer.getFileEndOffset();
+    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+}
+
+Value DocumentSourceGroup::serializeForSpill(const Accumulators& accums) const {
+    switch (accums.size()) {
+        case 0:  // no values, essentially a distinct
+            return Value();
 
         case 1:  // just one value, use optimized serialization as single Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                writer.addAlreadySorted(ptrs[i]->first,
-                                        ptrs[i]->second[0]->getValue(/*toBeMerged=*/true));
+            return accums[0]->getValue(/*toBeMerged=*/true);
+
+        default: {  // multiple values, serialize as array-typed Value
+            vector<Value> states;
+            states.reserve(accums.size());
+            for (auto&& accum : accums) {
+                states.push_back(accum->getValue(/*toBeMerged=*/true));
             }
-            break;
+            return Value(std::move(states));
+        }
+    }
+}
+
+void DocumentSourceGroup::spillToPartitions(size_t depth,
+                                            std::vector<SpilledPartition>* partitions) {
+    _usedDisk = true;
+    ++_numPartitionedSpills;
+    partitionedSpillsCounter.increment();
+
+    if (partitions->empty()) {
+        partitions->reserve(_numSpillPartitions);
+        for (size_t i = 0; i < _numSpillPartitions; ++i) {
+            const size_t statsIndex = _partitionStats.size();
+            partitions->push_back(
+                {statsIndex, _fileName + ".partition." + std::to_string(statsIndex)});
+            _partitionStats.push_back({depth});
+        }
+    }
 
-        default:  // multiple values, serialize as array-typed Value
-            for (size_t i = 0; i < ptrs.size(); i++) {
-                vector<Value> accums;
-                for (size_t j = 0; j < ptrs[i]->second.size(); j++) {
-                    accums.push_back(ptrs[i]->second[j]->getValue(/*toBeMerged=*/true));
+    // Bucket the groups first so that each partition's run is written by a single writer.
+    vector<vector<const GroupsMap::value_type*>> buckets(partitions->size());
+    const auto& comparator = pExpCtx->getValueComparator();
+    for (auto&& group : *_groups) {
+        buckets[partitionForHash(comparator.hash(group.first), depth, buckets.size())].push_back(
+            &group);
+    }
+
+    for (size_t i = 0; i < buckets.size(); ++i) {
+        if (buckets[i].empty()) {
+            // Don't write empty runs, which the Sorter cannot read back.
+            continue;
+        }
+
+        // The Sorter's file format is used for storage only: the runs of a partition are read
+        // back one after the other rather than merged, so their groups need not be sorted.
+        auto& partition = (*partitions)[i];
+        SortedFileWriter<Value, Value> writer(SortOptions().TempDir(pExpCtx->tempDir),
+                                              partition.fileName,
+                                              partition.nextWriterOffset);
+        for (auto&& group : buckets[i]) {
+            writer.addAlreadySorted(group->first, serializeForSpill(group->second));
+        }
+        partition.runs.emplace_back(writer.done());
+
+        const auto bytesWritten =
+            static_cast<size_t>(writer.getFileEndOffset() - partition.nextWriterOffset);
+        partition.nextWriterOffset = writer.getFileEndOffset();
+
+        auto& stats = _partitionStats[partition.statsIndex];
+        ++stats.runs;
+        stats.groups += buckets[i].size();
+        stats.bytes += bytesWritten;
+
+        spilledPartitionRunsCounter.increment();
+        spilledGroupsCounter.increment(buckets[i].size());
+        spilledBytesCounter.increment(bytesWritten);
+    }
+
+    _groups->clear();
+}
+
+void DocumentSourceGroup::loadNextSpilledPartition() {
+    invariant(!_pendingPartitions.empty());
+    auto partition = std::move(_pendingPartitions.front());
+    _pendingPartitions.pop_front();
+
+    _groups->clear();
+    _memoryUsageBytes = 0;
+
+    const size_t childDepth = _partitionStats[partition.statsIndex].depth + 1;
+    std::vector<SpilledPartition> children;
+    for (auto&& run : partition.runs) {
+        run->openSource();
+        while (run->more()) {
+            if (_memoryUsageBytes > _maxMemoryUsageBytes) {
+                if (childDepth <= kMaxSpillPartitionDepth) {
+                    if (children.empty()) {
+                        repartitionsCounter.increment();
+                    }
+                    spillToPartitions(childDepth, &children);
+                } else {
+                    // Splitting again is unlikely to separate these keys, so spill sorted runs and
+                    // merge them, as when hash partitioning is disabled.
+                    if (_sortedFiles.empty()) {
+                        sortedRunPartitionsCounter.increment();
+                    }
+                    _sortedFiles.push_back(spill());
+                    ++_partitionStats[partition.statsIndex].sortedRuns;
                 }
-                writer.addAlreadySorted(ptrs[i]->first, Value(std::move(accums)));
+                _memoryUsageBytes = 0;
             }
-            break;
+
+            auto spilledGroup = run->next();
+            mergeSpilledGroup(spilledGroup.first, spilledGroup.second);
+        }
+        run->closeSource();
     }
+    partition.runs.clear();
+    boost::filesystem::remove(partition.fileName);
 
-    _groups->clear();
+    if (!_sortedFiles.empty()) {
+        if (!_groups->empty()) {
+            _sortedFiles.push_back(spill());
+            ++_partitionStats[partition.statsIndex].sortedRuns;
+        }
+        _memoryUsageBytes = 0;
+
+        // The merge removes '_fileName' once it is done, so the next partition that needs sorted
+        // runs starts a new file.
+        _sorterIterator.reset(
+            Sorter<Value, Value>::Iterator::merge(_sortedFiles,
+                                                  _fileName,
+                                                  SortOptions(),
+                                                  SorterComparator(pExpCtx->getValueComparator())));
+        _sortedFiles.clear();
+        _nextSortedFileWriterOffset = 0;
+
+        if (_currentAccumulators.empty()) {
+            _currentAccumulators.reserve(_accumulatedFields.size());
+            for (auto&& accumulatedField : _accumulatedFields) {
+                _currentAccumulators.push_back(accumulatedField.makeAccumulator());
+            }
+        }
 
-    Sorter<Value, Value>::Iterator* iteratorPtr = writer.done();
-    _nextSortedFileWriterOffset = writer.getFileEndOffset();
-    return shared_ptr<Sorter<Value, Value>::Iterator>(iteratorPtr);
+        verify(_sorterIterator->more());  // we put data in, we should get something out.
+        _firstPartOfNextGroup = _sorterIterator->next();
+        groupsIterator = _groups->end();
+        return;
+    }
+
+    if (!children.empty()) {
+        // This partition did not fit in memory. Flush what is left, then process its children
+        // before any other pending partition so that the partition files in use stay bounded.
+        spillToPartitions(childDepth, &children);
+        _memoryUsageBytes = 0;
+        for (auto it = children.rbegin(); it != children.rend(); ++it) {
+            if (!it->runs.empty()) {
+                _pendingPartitions.push_front(std::move(*it));
+            }
+        }
+    }
+
+    groupsIterator = _groups->begin();
+}
+
+void DocumentSourceGroup::mergeSpilledGroup(const Value& id, const Value& state) {
+    const size_t numAccumulators = _accumulatedFields.size();
+
+    const size_t oldSize = _groups->size();
+    Accumulators& group = (*_groups)[id];
+    if (_groups->size() != oldSize) {
+        _memoryUsageBytes += id.getApproximateSize();
+        group.reserve(numAccumulators);
+        for (auto&& accumulatedField : _accumulatedFields) {
+            group.push_back(accumulatedField.makeAccumulator());
+        }
+    } else {
+        for (auto&& accum : group) {
+            _memoryUsageBytes -= accum->memUsageForSorter();
+        }
+    }
+
+    switch (numAccumulators) {  // mirrors serializeForSpill()
+        case 1:
+            group[0]->process(state, true);
+        case 0:
+            break;
+        default: {
+            const vector<Value>& accumulatorStates = state.getArray();
+            for (size_t i = 0; i < numAccumulators; i++) {
+                group[i]->process(accumulatorStates[i], true);
+            }
+        }
+    }
+
+    for (auto&& accum : group) {
+        _memoryUsageBytes += accum->memUsageForSorter();
+    }
 }
 
 Value DocumentSourceGroup::computeId(const Document& root) {
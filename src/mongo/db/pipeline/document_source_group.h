@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <deque>
 #include <memory>
 #include <utility>
 
@@ -93,6 +94,25 @@ public:
 
     static constexpr StringData kStageName = "$group"_sd;
 
+    /**
+     * A partition which spills past this depth is no longer split when it exceeds the memory limit,
+     * since its keys are then likely to collide on every salted hash. Its groups are spilled as
+     * sorted runs instead, which are merged to output the partition.
+     */
+    static constexpr size_t kMaxSpillPartitionDepth = 8;
+
+    /**
+     * Statistics for one hash partition of the group key space written to disk, reported by
+     * explain.
+     */
+    struct SpilledPartitionStats {
+        size_t depth = 0;   // 0 for partitions of the input, n for partitions re-split n times.
+        size_t runs = 0;    // Number of spills which wrote to this partition.
+        size_t groups = 0;  // Number of (group key, partial accumulator state) pairs written.
+        size_t bytes = 0;   // Number of bytes written to this partition's file.
+        size_t sortedRuns = 0;  // Number of sorted runs spilled to output it past the max depth.
+    };
+
     boost::intrusive_ptr<DocumentSource> optimize() final;
     DepsTracker::State getDependencies(DepsTracker* deps) const final;
     Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
@@ -160,6 +180,13 @@ public:
      */
     bool usedDisk() final;
 
+    /**
+     * Returns the statistics of every hash partition this $group spilled to, in creation order.
+     */
+    const std::vector<SpilledPartitionStats>& getSpilledPartitionStats() const {
+        return _partitionStats;
+    }
+
     boost::optional<DistributedPlanLogic> distributedPlanLogic() final;
     bool canRunInParallelBeforeWriteStage(
         const std::set<std::string>& nameOfShardKeyFieldsUponEntryToStage) const final;
@@ -192,6 +219,7 @@ private:
      * initialize() to have been called already.
      */
     GetNextResult getNextSpilled();
+    GetNextResult getNextPartitioned();
     GetNextResult getNextStandard();
 
     /**
@@ -213,6 +241,47 @@ private:
      */
     std::shared_ptr<Sorter<Value, Value>::Iterator> spill();
 
+    /**
+     * One hash partition of the group key space. Each run holds the groups which were in memory
+     * when a spill happened and hashed to this partition, so the runs are written and read back in
+     * input order and need not be sorted.
+     */
+    struct SpilledPartition {
+        size_t statsIndex;  // Index into '_partitionStats', also used to name the file.
+        std::string fileName;
+        std::streampos nextWriterOffset = 0;
+        std::vector<std::shared_ptr<Sorter<Value, Value>::Iterator>> runs;
+    };
+
+    /**
+     * Alternative to spill() which writes each group in memory to the partition in 'partitions'
+     * chosen by hashing its key, salted with 'depth' so that a partition which is split again
+     * spreads its keys over all of its children. Creates '_numSpillPartitions' partitions if
+     * 'partitions' is empty. Clears '_groups' but leaves '_memoryUsageBytes' to the caller.
+     */
+    void spillToPartitions(size_t depth, std::vector<SpilledPartition>* partitions);
+
+    /**
+     * Pops the front of '_pendingPartitions' and aggregates its runs into '_groups'. If the
+     * partition does not fit in memory it is split into child partitions, which are pushed onto the
+     * front of '_pendingPartitions' and processed next, leaving '_groups' empty. Past
+     * kMaxSpillPartitionDepth it is instead spilled as sorted runs, and '_sorterIterator' is set up
+     * to merge them.
+     */
+    void loadNextSpilledPartition();
+
+    /**
+     * Merges a (group key, partial accumulator state) pair read back from a spilled partition into
+     * '_groups', keeping '_memoryUsageBytes' up to date.
+     */
+    void mergeSpilledGroup(const Value& id, const Value& state);
+
+    /**
+     * Returns the partial accumulator states of 'accums' in the format written by spill(): missing
+     * if there are no accumulators, a single Value if there is one, and an array otherwise.
+     */
+    Value serializeForSpill(const Accumulators& accums) const;
+
     Document makeDocument(const Value& id, const Accumulators& accums, bool mergeableOutput);
 
     /**
@@ -260,10 +329,21 @@ private:
     // Only used when '_spilled' is false.
     GroupsMap::iterator groupsIterator;
 
-    // Only used when '_spilled' is true.
+    // Only used when '_spilled' is true, or to output a partition spilled as sorted runs.
     std::unique_ptr<Sorter<Value, Value>::Iterator> _sorterIterator;
     const bool _allowDiskUse;
 
+    // Number of hash partitions to spill to, or 0 to spill sorted runs to '_sortedFiles' instead.
+    const size_t _numSpillPartitions;
+
+    // Partitions of the input written while exhausting 'pSource'. Once the input is exhausted, the
+    // non-empty ones move to '_pendingPartitions', which are output one at a time.
+    std::vector<SpilledPartition> _spilledPartitions;
+    std::deque<SpilledPartition> _pendingPartitions;
+    bool _partitioned = false;
+    size_t _numPartitionedSpills = 0;
+    std::vector<SpilledPartitionStats> _partitionStats;
+
     std::pair<Value, Value> _firstPartOfNextGroup;
 };
 
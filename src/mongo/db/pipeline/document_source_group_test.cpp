@@ -49,11 +49,13 @@
 #include "mongo/db/pipeline/document_source_mock.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_test_service_context.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/stdx/unordered_set.h"
 #include "mongo/unittest/temp_dir.h"
 #include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 
@@ -147,6 +149,133 @@ TEST_F(DocumentSourceGroupTest, ShouldBeAbleToPauseLoadingWhileSpilled) {
     ASSERT_EQ(idSet.count(2), 1UL);
 }
 
+/**
+ * Groups 200 documents {_id: i, n: i} on _id % 50 summing 'n' with a memory limit small enough to
+ * spill after nearly every document, and checks that each of the 50 groups has the right sum.
+ */
+intrusive_ptr<DocumentSourceGroup> groupModFiftyAndCheckSums(
+    const intrusive_ptr<ExpressionContext>& expCtx) {
+    auto&& parser = AccumulationStatement::getParser("$sum");
+    auto accumulatorArg = BSON(""
+                               << "$n");
+    auto [expression, factory] =
+        parser(expCtx, accumulatorArg.firstElement(), expCtx->variablesParseState);
+    AccumulationStatement sumStatement{"total", expression, factory};
+    auto groupByExpression = Expression::parseObject(
+        expCtx, fromjson("{$mod: ['$_id', 50]}"), expCtx->variablesParseState);
+    auto group = DocumentSourceGroup::create(
+        expCtx, groupByExpression, {sumStatement}, /*maxMemoryUsageBytes=*/100);
+
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < 200; ++i) {
+        inputs.emplace_back(Document{{"_id", i}, {"n", i}});
+    }
+    auto mock = DocumentSourceMock::createForTest(std::move(inputs));
+    group->setSource(mock.get());
+
+    // Key k sums k, k + 50, k + 100 and k + 150.
+    map<int, int> totals;
+    for (auto result = group->getNext(); result.isAdvanced(); result = group->getNext()) {
+        auto doc = result.releaseDocument();
+        ASSERT_EQ(totals.count(doc["_id"].coerceToInt()), 0UL);
+        totals[doc["_id"].coerceToInt()] = doc["total"].coerceToInt();
+    }
+    ASSERT_EQ(totals.size(), 50UL);
+    for (auto&& [key, total] : totals) {
+        ASSERT_EQ(total, 4 * key + 300);
+    }
+    ASSERT_TRUE(group->usedDisk());
+    return group;
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldAggregateAllGroupsAfterSpillingToHashPartitions) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    auto group = groupModFiftyAndCheckSums(expCtx);
+
+    // Every partition of the input spilled more than once, and since each holds several groups
+    // that do not fit in 100 bytes, they were split again.
+    const auto& stats = group->getSpilledPartitionStats();
+    ASSERT_GT(stats.size(), static_cast<size_t>(internalDocumentSourceGroupSpillPartitions.load()));
+    ASSERT_TRUE(std::any_of(
+        stats.begin(), stats.end(), [](const auto& partition) { return partition.depth > 0; }));
+
+    size_t groupsSpilledFromInput = 0;
+    for (auto&& partition : stats) {
+        ASSERT_LTE(partition.depth, DocumentSourceGroup::kMaxSpillPartitionDepth);
+        if (partition.depth == 0) {
+            groupsSpilledFromInput += partition.groups;
+            ASSERT_GT(partition.bytes, 0UL);
+        }
+    }
+    ASSERT_GTE(groupsSpilledFromInput, 50UL);
+
+    auto explained = group->serialize(ExplainOptions::Verbosity::kExecStats);
+    ASSERT_EQ(explained["$group"]["spilledPartitions"].getArray().size(), stats.size());
+    ASSERT_TRUE(group->serialize(ExplainOptions::Verbosity::kQueryPlanner)["$group"]
+                                ["spilledPartitions"]
+                                    .missing());
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSpillSortedRunsPastMaxPartitionDepth) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    // Every document has the same key and a single group exceeds the memory limit, so the one
+    // non-empty partition is split until it reaches the maximum depth without ever fitting.
+    auto&& parser = AccumulationStatement::getParser("$sum");
+    auto accumulatorArg = BSON(""
+                               << "$n");
+    auto [expression, factory] =
+        parser(expCtx, accumulatorArg.firstElement(), expCtx->variablesParseState);
+    AccumulationStatement sumStatement{"total", expression, factory};
+    auto group = DocumentSourceGroup::create(expCtx,
+                                             ExpressionConstant::create(expCtx, Value(1)),
+                                             {sumStatement},
+                                             /*maxMemoryUsageBytes=*/1);
+
+    deque<DocumentSource::GetNextResult> inputs;
+    for (int i = 0; i < 100; ++i) {
+        inputs.emplace_back(Document{{"_id", i}, {"n", i}});
+    }
+    auto mock = DocumentSourceMock::createForTest(std::move(inputs));
+    group->setSource(mock.get());
+
+    auto result = group->getNext();
+    ASSERT_TRUE(result.isAdvanced());
+    ASSERT_DOCUMENT_EQ(result.releaseDocument(), (Document{{"_id", 1}, {"total", 4950}}));
+    ASSERT_TRUE(group->getNext().isEOF());
+
+    size_t sortedRuns = 0;
+    for (auto&& partition : group->getSpilledPartitionStats()) {
+        ASSERT_LTE(partition.depth, DocumentSourceGroup::kMaxSpillPartitionDepth);
+        if (partition.sortedRuns > 0) {
+            ASSERT_EQ(partition.depth, DocumentSourceGroup::kMaxSpillPartitionDepth);
+        }
+        sortedRuns += partition.sortedRuns;
+    }
+    ASSERT_GT(sortedRuns, 1UL);
+}
+
+TEST_F(DocumentSourceGroupTest, ShouldSpillSortedRunsIfHashPartitioningIsDisabled) {
+    auto expCtx = getExpCtx();
+    TempDir tempDir("DocumentSourceGroupTest");
+    expCtx->tempDir = tempDir.path();
+    expCtx->allowDiskUse = true;
+
+    const auto originalPartitions = internalDocumentSourceGroupSpillPartitions.load();
+    ON_BLOCK_EXIT([&] { internalDocumentSourceGroupSpillPartitions.store(originalPartitions); });
+    internalDocumentSourceGroupSpillPartitions.store(0);
+
+    auto group = groupModFiftyAndCheckSums(expCtx);
+    ASSERT_TRUE(group->getSpilledPartitionStats().empty());
+}
+
 TEST_F(DocumentSourceGroupTest, ShouldErrorIfNotAllowedToSpillToDiskAndResultSetIsTooLarge) {
     auto expCtx = getExpCtx();
     const size_t maxMemoryUsageBytes = 1000;
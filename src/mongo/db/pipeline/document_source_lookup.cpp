@@ -38,7 +38,9 @@
 #include "mongo/db/exec/document_value/value.h"
 #include "mongo/db/jsobj.h"
 #include "mongo/db/matcher/expression_algo.h"
+#include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/pipeline/document_path_support.h"
+#include "mongo/db/pipeline/document_source_queue.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/expression_context.h"
 #include "mongo/db/query/query_knobs_gen.h"
@@ -273,7 +275,9 @@ DocumentSource::GetNextResult DocumentSourceLookUp::doGetNext() {
     // '_unwindSrc' would be non-null, and we would not have made it here.
     invariant(!_matchSrc);
 
-    if (!wasConstructedWithPipelineSyntax()) {
+    initializeJoinStrategy();
+
+    if (!wasConstructedWithPipelineSyntax() && !isUsingHashJoin()) {
         auto matchStage =
             makeMatchStageFromInput(inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
         // We've already allocated space for the trailing $match stage in '_resolvedPipeline'.
@@ -315,6 +319,10 @@ std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     // Resolve the 'let' variables to values per the given input document.
     resolveLetVariables(inputDoc, &_fromExpCtx->variables);
 
+    if (isUsingHashJoin() && _hashTable->isServing()) {
+        return buildPipelineFromHashTable(inputDoc);
+    }
+
     // If we don't have a cache, build and return the pipeline immediately.
     if (!_cache || _cache->isAbandoned()) {
         MongoProcessInterface::MakePipelineOptions pipelineOpts;
@@ -366,6 +374,112 @@ std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipeline(
     return pipeline;
 }
 
+DocumentSourceLookUp::JoinStrategy DocumentSourceLookUp::chooseJoinStrategy() const {
+    if (wasConstructedWithPipelineSyntax() || pExpCtx->inMongos ||
+        !internalQueryEnableLookupHashJoin.load()) {
+        return JoinStrategy::kNestedLoop;
+    }
+
+    if (pExpCtx->mongoProcessInterface->isSharded(pExpCtx->opCtx, _resolvedNs)) {
+        return JoinStrategy::kNestedLoop;
+    }
+
+    // '_resolvedPipeline' consists of any view pipeline followed by the placeholder for the join
+    // $match. A view may reshape the documents, so indexes on the underlying collection cannot be
+    // assumed to serve 'foreignField'.
+    if (_resolvedPipeline.size() > 1) {
+        return JoinStrategy::kHashJoin;
+    }
+
+    const auto foreignField = _foreignField->fullPath();
+    for (auto&& indexSpec : pExpCtx->mongoProcessInterface->getIndexSpecs(
+             pExpCtx->opCtx, _resolvedNs, false /* includeBuildUUIDs */)) {
+        // A partial index cannot be used to answer an arbitrary equality on its leading field.
+        if (indexSpec.hasField("partialFilterExpression")) {
+            continue;
+        }
+
+        auto leadingKey = indexSpec.getObjectField("key").firstElement();
+        if (!leadingKey || leadingKey.fieldNameStringData() != foreignField) {
+            continue;
+        }
+
+        // Ascending, descending and hashed indexes all support equality lookups.
+        const bool isHashed =
+            leadingKey.type() == BSONType::String && leadingKey.valueStringData() == "hashed"_sd;
+        if (leadingKey.isNumber() || isHashed) {
+            return JoinStrategy::kNestedLoop;
+        }
+    }
+    return JoinStrategy::kHashJoin;
+}
+
+void DocumentSourceLookUp::initializeJoinStrategy() {
+    if (_joinStrategy) {
+        return;
+    }
+
+    _joinStrategy = chooseJoinStrategy();
+    if (!isUsingHashJoin()) {
+        return;
+    }
+
+    _hashTable.emplace(_fromExpCtx->getValueComparator(),
+                       *_foreignField,
+                       internalQueryLookupHashJoinMaxMemoryBytes.load());
+
+    // The build side is the foreign collection, filtered by any $match absorbed on the 'as' field.
+    // The join predicate itself is applied by probing the table.
+    _resolvedPipeline.back() = BSON("$match" << _additionalFilter.value_or(BSONObj()));
+    auto pipeline = buildPipeline(Document());
+
+    while (auto result = pipeline->getNext()) {
+        if (_hashTable->add(std::move(*result)) == LookupHashTable::TableStatus::kAbandoned) {
+            break;
+        }
+    }
+    _usedDisk = _usedDisk || pipeline->usedDisk();
+
+    if (_hashTable->isAbandoned()) {
+        _joinStrategy = JoinStrategy::kNestedLoop;
+        return;
+    }
+    _hashTable->freeze();
+}
+
+std::unique_ptr<Pipeline, PipelineDeleter> DocumentSourceLookUp::buildPipelineFromHashTable(
+    const Document& inputDoc) {
+    invariant(_hashTable && _hashTable->isServing());
+
+    std::vector<Value> joinValues;
+    document_path_support::visitAllValuesAtPath(
+        inputDoc, *_localField, [&](const Value& nextValue) { joinValues.push_back(nextValue); });
+    if (joinValues.empty()) {
+        // Missing values are treated as null.
+        joinValues.emplace_back(BSONNULL);
+    }
+
+    auto probeResult = _hashTable->probe(joinValues);
+
+    // The table only returns a superset of the matching documents for null or array join values,
+    // in which case we filter the candidates using the same predicate as a nested-loop join.
+    std::unique_ptr<MatchExpression> joinPredicate;
+    if (!probeResult.exact) {
+        auto matchStage = makeMatchStageFromInput(
+            inputDoc, *_localField, _foreignField->fullPath(), BSONObj());
+        joinPredicate = uassertStatusOK(
+            MatchExpressionParser::parse(matchStage.firstElement().embeddedObject(), _fromExpCtx));
+    }
+
+    auto queue = DocumentSourceQueue::create(_fromExpCtx);
+    for (auto&& doc : probeResult.docs) {
+        if (!joinPredicate || joinPredicate->matchesBSON(doc.toBson())) {
+            queue->emplace_back(std::move(doc));
+        }
+    }
+    return uassertStatusOK(Pipeline::create({queue}, _fromExpCtx));
+}
+
 DocumentSource::GetModPathsReturn DocumentSourceLookUp::getModifiedPaths() const {
     std::set<std::string> modifiedPaths{_as.fullPath()};
     if (_unwindSrc) {
@@ -507,6 +621,7 @@ void DocumentSourceLookUp::doDispose() {
         _pipeline->dispose(pExpCtx->opCtx);
         _pipeline.reset();
     }
+    _hashTable.reset();
 }
 
 BSONObj DocumentSourceLookUp::makeMatchStageFromInput(const Document& input,
@@ -607,7 +722,9 @@ DocumentSource::GetNextResult DocumentSourceLookUp::unwindResult() {
 
         _input = nextInput.releaseDocument();
 
-        if (!wasConstructedWithPipelineSyntax()) {
+        initializeJoinStrategy();
+
+        if (!wasConstructedWithPipelineSyntax() && !isUsingHashJoin()) {
             BSONObj filter = _additionalFilter.value_or(BSONObj());
             auto matchStage =
                 makeMatchStageFromInput(*_input, *_localField, _foreignField->fullPath(), filter);
@@ -742,6 +859,24 @@ void DocumentSourceLookUp::serializeToArray(
             output[getSourceName()]["matching"] = Value(*_additionalFilter);
         }
 
+        // The join strategy is chosen when the stage first executes, so it can only be reported
+        // at verbosities which run the query.
+        if (*explain >= ExplainOptions::Verbosity::kExecStats && _joinStrategy) {
+            output[getSourceName()]["joinStrategy"] =
+                Value(isUsingHashJoin() ? "hashJoin"_sd : "nestedLoopJoin"_sd);
+            if (_hashTable) {
+                output[getSourceName()]["hashJoin"] = Value(
+                    DOC("abandoned" << _hashTable->isAbandoned() << "buildSideDocs"
+                                    << static_cast<long long>(_hashTable->numDocs())
+                                    << "buildSideKeys"
+                                    << static_cast<long long>(_hashTable->numKeys())
+                                    << "memoryUsageBytes"
+                                    << static_cast<long long>(_hashTable->sizeBytes())
+                                    << "maxMemoryUsageBytes"
+                                    << static_cast<long long>(_hashTable->maxSizeBytes())));
+            }
+        }
+
         array.push_back(Value(output.freeze()));
     } else {
         array.push_back(Value(output.freeze()));
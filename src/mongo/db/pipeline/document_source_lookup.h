@@ -38,6 +38,7 @@
 #include "mongo/db/pipeline/document_source_unwind.h"
 #include "mongo/db/pipeline/expression.h"
 #include "mongo/db/pipeline/lite_parsed_pipeline.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
 #include "mongo/db/pipeline/lookup_set_cache.h"
 
 namespace mongo {
@@ -51,6 +52,14 @@ public:
     static constexpr size_t kMaxSubPipelineDepth = 20;
     static constexpr StringData kStageName = "$lookup"_sd;
 
+    /**
+     * The ways in which a $lookup with localField/foreignField syntax can be executed. A
+     * nested-loop join queries the foreign collection once per input document, whereas a hash join
+     * scans the foreign collection once into a LookupHashTable and probes it for each input
+     * document.
+     */
+    enum class JoinStrategy { kNestedLoop, kHashJoin };
+
     struct LetVariable {
         LetVariable(std::string name, boost::intrusive_ptr<Expression> expression, Variables::Id id)
             : name(std::move(name)), expression(std::move(expression)), id(id) {}
@@ -191,6 +200,13 @@ public:
         return buildPipeline(inputDoc);
     }
 
+    /**
+     * Returns the join strategy in use, or boost::none if this stage has not yet been executed.
+     */
+    boost::optional<JoinStrategy> getJoinStrategy() const {
+        return _joinStrategy;
+    }
+
 protected:
     GetNextResult doGetNext() final;
     void doDispose() final;
@@ -264,6 +280,30 @@ private:
      */
     std::unique_ptr<Pipeline, PipelineDeleter> buildPipeline(const Document& inputDoc);
 
+    /**
+     * Returns the strategy which should be used to execute this $lookup. A hash join is only chosen
+     * for localField/foreignField syntax when the foreign collection has no index which could be
+     * used to look up values of 'foreignField'.
+     */
+    JoinStrategy chooseJoinStrategy() const;
+
+    /**
+     * Chooses the join strategy on the first call. If a hash join is chosen, scans the foreign
+     * collection to build '_hashTable', falling back to a nested-loop join if the table exceeds
+     * its memory limit.
+     */
+    void initializeJoinStrategy();
+
+    /**
+     * Returns a pipeline which produces the foreign documents matching 'inputDoc' by probing the
+     * hash table. May only be called once the hash table has been built.
+     */
+    std::unique_ptr<Pipeline, PipelineDeleter> buildPipelineFromHashTable(const Document& inputDoc);
+
+    bool isUsingHashJoin() const {
+        return _joinStrategy == JoinStrategy::kHashJoin;
+    }
+
     /**
      * Reinitialize the cache with a new max size. May only be called if this DSLookup was created
      * with pipeline syntax, the cache has not been frozen or abandoned, and no data has been added
@@ -297,6 +337,12 @@ private:
     // from a cursor source.
     boost::optional<SequentialDocumentCache> _cache;
 
+    // Chosen on the first call to getNext(). When this is 'kHashJoin', '_hashTable' holds every
+    // document from the foreign collection that passes '_additionalFilter'. The table is retained
+    // if it is abandoned, so that explain can report why the hash join was not used.
+    boost::optional<JoinStrategy> _joinStrategy;
+    boost::optional<LookupHashTable> _hashTable;
+
     // The ExpressionContext used when performing aggregation pipelines against the '_resolvedNs'
     // namespace.
     boost::intrusive_ptr<ExpressionContext> _fromExpCtx;
@@ -48,6 +48,7 @@
 #include "mongo/db/repl/replication_coordinator_mock.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/server_options.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace {
@@ -480,7 +481,8 @@ TEST(MakeMatchStageFromInput, ArrayValueWithRegexUsesOrQuery) {
  * A mock MongoProcessInterface which allows mocking a foreign pipeline. If
  * 'removeLeadingQueryStages' is true then any $match, $sort or $project fields at the start of the
  * pipeline will be removed, simulating the pipeline changes which occur when
- * PipelineD::prepareCursorSource absorbs stages into the PlanExecutor.
+ * PipelineD::prepareCursorSource absorbs stages into the PlanExecutor. The foreign collection is
+ * reported to have only the default _id index.
  */
 class MockMongoInterface final : public StubMongoProcessInterface {
 public:
@@ -493,6 +495,13 @@ public:
         return false;
     }
 
+    std::list<BSONObj> getIndexSpecs(OperationContext* opCtx,
+                                     const NamespaceString& ns,
+                                     bool includeBuildUUIDs) final {
+        return {BSON("v" << 2 << "key" << BSON("_id" << 1) << "name"
+                         << "_id_")};
+    }
+
     std::unique_ptr<Pipeline, PipelineDeleter> makePipeline(
         const std::vector<BSONObj>& rawPipeline,
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
@@ -1115,5 +1124,192 @@ TEST_F(DocumentSourceLookUpTest, ShouldNotCacheIfCorrelatedStageIsAbsorbedIntoPl
     ASSERT_VALUE_EQ(Value(subPipeline->writeExplainOps(kExplain)), Value(BSONArray(expectedPipe)));
 }
 
+/**
+ * Creates a $lookup from the local field 'fk' to the foreign field 'ref', which the
+ * MockMongoInterface reports as unindexed.
+ */
+intrusive_ptr<DocumentSourceLookUp> makeUnindexedLookup(
+    const intrusive_ptr<ExpressionContext>& expCtx,
+    deque<DocumentSource::GetNextResult> mockForeignContents) {
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    expCtx->mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(std::move(mockForeignContents));
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "fk"_sd},
+                                         {"foreignField", "ref"_sd},
+                                         {"as", "joined"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    return static_cast<DocumentSourceLookUp*>(parsed.get());
+}
+
+TEST_F(DocumentSourceLookUpTest, ShouldUseNestedLoopJoinWhenForeignFieldIsIndexed) {
+    auto expCtx = getExpCtx();
+    NamespaceString fromNs("test", "foreign");
+    expCtx->setResolvedNamespaces(StringMap<ExpressionContext::ResolvedNamespace>{
+        {fromNs.coll().toString(), {fromNs, std::vector<BSONObj>()}}});
+    expCtx->mongoProcessInterface =
+        std::make_shared<MockMongoInterface>(deque<DocumentSource::GetNextResult>{});
+
+    auto lookupSpec = Document{{"$lookup",
+                                Document{{"from", fromNs.coll()},
+                                         {"localField", "fk"_sd},
+                                         {"foreignField", "_id"_sd},
+                                         {"as", "joined"_sd}}}}
+                          .toBson();
+    auto parsed = DocumentSourceLookUp::createFromBson(lookupSpec.firstElement(), expCtx);
+    auto lookup = static_cast<DocumentSourceLookUp*>(parsed.get());
+
+    auto mockLocalSource = DocumentSourceMock::createForTest({Document{{"fk", 0}}});
+    lookup->setSource(mockLocalSource.get());
+
+    ASSERT_TRUE(lookup->getNext().isAdvanced());
+    ASSERT(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kNestedLoop);
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldMatchScalarArrayAndMissingValues) {
+    auto expCtx = getExpCtx();
+    const Document foreignScalarOne{{"_id", 0}, {"ref", 1}};
+    const Document foreignScalarTwo{{"_id", 1}, {"ref", 2}};
+    const Document foreignArray{{"_id", 2}, {"ref", vector<Value>{Value(1), Value(3)}}};
+    const Document foreignMissing{{"_id", 3}};
+    auto lookup = makeUnindexedLookup(expCtx,
+                                      {Document(foreignScalarOne),
+                                       Document(foreignScalarTwo),
+                                       Document(foreignArray),
+                                       Document(foreignMissing)});
+
+    auto mockLocalSource =
+        DocumentSourceMock::createForTest({Document{{"fk", 1}},
+                                           Document{{"fk", vector<Value>{Value(2), Value(3)}}},
+                                           Document{{"fk", 4}},
+                                           Document{{"_id", "noFk"_sd}}});
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kHashJoin);
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"fk", 1},
+                  {"joined", vector<Value>{Value(foreignScalarOne), Value(foreignArray)}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"fk", vector<Value>{Value(2), Value(3)}},
+                  {"joined", vector<Value>{Value(foreignScalarTwo), Value(foreignArray)}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(), (Document{{"fk", 4}, {"joined", vector<Value>{}}}));
+
+    // A missing local field joins with foreign documents where the foreign field is missing.
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"_id", "noFk"_sd}, {"joined", vector<Value>{Value(foreignMissing)}}}));
+
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldPropagatePausesWhileUnwinding) {
+    auto expCtx = getExpCtx();
+    auto lookup = makeUnindexedLookup(
+        expCtx, {Document{{"_id", 0}, {"ref", 0}}, Document{{"_id", 1}, {"ref", 0}}});
+
+    const bool preserveNullAndEmptyArrays = false;
+    const boost::optional<std::string> includeArrayIndex = boost::none;
+    lookup->setUnwindStage(DocumentSourceUnwind::create(
+        expCtx, "joined", preserveNullAndEmptyArrays, includeArrayIndex));
+
+    auto mockLocalSource =
+        DocumentSourceMock::createForTest({Document{{"fk", 0}},
+                                           DocumentSource::GetNextResult::makePauseExecution(),
+                                           Document{{"fk", 1}}});
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"fk", 0}, {"joined", Document{{"_id", 0}, {"ref", 0}}}}));
+
+    next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT_DOCUMENT_EQ(next.releaseDocument(),
+                       (Document{{"fk", 0}, {"joined", Document{{"_id", 1}, {"ref", 0}}}}));
+
+    ASSERT_TRUE(lookup->getNext().isPaused());
+
+    // The second local document has no match, so it is dropped by the unwind.
+    ASSERT_TRUE(lookup->getNext().isEOF());
+    ASSERT(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kHashJoin);
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldFallBackToNestedLoopWhenOverMemoryLimit) {
+    const auto originalMaxMemory = internalQueryLookupHashJoinMaxMemoryBytes.load();
+    ON_BLOCK_EXIT(
+        [&] { internalQueryLookupHashJoinMaxMemoryBytes.store(originalMaxMemory); });
+    internalQueryLookupHashJoinMaxMemoryBytes.store(1);
+
+    auto expCtx = getExpCtx();
+    auto lookup = makeUnindexedLookup(
+        expCtx, {Document{{"_id", 0}, {"ref", 0}}, Document{{"_id", 1}, {"ref", 1}}});
+
+    auto mockLocalSource = DocumentSourceMock::createForTest({Document{{"fk", 1}}});
+    lookup->setSource(mockLocalSource.get());
+
+    auto next = lookup->getNext();
+    ASSERT_TRUE(next.isAdvanced());
+    ASSERT(lookup->getJoinStrategy() == DocumentSourceLookUp::JoinStrategy::kNestedLoop);
+    ASSERT_DOCUMENT_EQ(
+        next.releaseDocument(),
+        (Document{{"fk", 1}, {"joined", vector<Value>{Value(Document{{"_id", 1}, {"ref", 1}})}}}));
+
+    vector<Value> explainOutput;
+    lookup->serializeToArray(explainOutput, ExplainOptions::Verbosity::kExecStats);
+    ASSERT_EQ(explainOutput.size(), 1U);
+    auto lookupExplain = explainOutput[0]["$lookup"];
+    ASSERT_VALUE_EQ(lookupExplain["joinStrategy"], Value("nestedLoopJoin"_sd));
+    ASSERT_VALUE_EQ(lookupExplain["hashJoin"]["abandoned"], Value(true));
+    lookup->dispose();
+}
+
+TEST_F(DocumentSourceLookUpTest, HashJoinShouldReportBuildSideInExplain) {
+    auto expCtx = getExpCtx();
+    auto lookup = makeUnindexedLookup(expCtx,
+                                      {Document{{"_id", 0}, {"ref", 0}},
+                                       Document{{"_id", 1}, {"ref", 0}},
+                                       Document{{"_id", 2}, {"ref", 1}}});
+
+    auto mockLocalSource = DocumentSourceMock::createForTest({Document{{"fk", 0}}});
+    lookup->setSource(mockLocalSource.get());
+    ASSERT_TRUE(lookup->getNext().isAdvanced());
+
+    // The join strategy is only reported once the query has been run.
+    vector<Value> queryPlannerOutput;
+    lookup->serializeToArray(queryPlannerOutput, kExplain);
+    ASSERT_TRUE(queryPlannerOutput[0]["$lookup"]["joinStrategy"].missing());
+
+    vector<Value> explainOutput;
+    lookup->serializeToArray(explainOutput, ExplainOptions::Verbosity::kExecStats);
+    auto lookupExplain = explainOutput[0]["$lookup"];
+    ASSERT_VALUE_EQ(lookupExplain["joinStrategy"], Value("hashJoin"_sd));
+    ASSERT_VALUE_EQ(lookupExplain["hashJoin"]["abandoned"], Value(false));
+    ASSERT_VALUE_EQ(lookupExplain["hashJoin"]["buildSideDocs"], Value(3LL));
+    ASSERT_VALUE_EQ(lookupExplain["hashJoin"]["buildSideKeys"], Value(2LL));
+    ASSERT_GT(lookupExplain["hashJoin"]["memoryUsageBytes"].getLong(), 0LL);
+    lookup->dispose();
+}
+
 }  // namespace
 }  // namespace mongo
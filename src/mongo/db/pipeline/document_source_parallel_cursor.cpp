@@ -0,0 +1,578 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kQuery
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_parallel_cursor.h"
+
+#include <algorithm>
+
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/working_set.h"
+#include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/pipeline/document_source_cursor.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/document_source_match.h"
+#include "mongo/db/pipeline/document_source_single_document_transformation.h"
+#include "mongo/db/query/canonical_query.h"
+#include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/db/query/query_request.h"
+#include "mongo/db/service_context.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/producer_consumer_queue.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/string_map.h"
+
+namespace mongo {
+
+namespace {
+
+/**
+ * Returns the process-wide pool that runs the workers of every parallel collection scan, which
+ * bounds the number of scanning threads regardless of how many aggregations scan at once. Tasks
+ * bring their own Client, so the pool is never torn down.
+ */
+ThreadPool* getParallelScanPool() {
+    static ThreadPool* pool = [] {
+        ThreadPool::Options options;
+        options.poolName = "ParallelCollScan";
+        options.minThreads = 0;
+        options.maxThreads = std::max(ProcessInfo::getNumAvailableCores(), 2UL);
+        auto pool = new ThreadPool(std::move(options));
+        pool->startup();
+        return pool;
+    }();
+    return pool;
+}
+
+/**
+ * Returns true if each worker may run 'group' over its share of the collection, leaving the
+ * merging half of the $group to combine the partial results. Accumulators whose result depends on
+ * the order of their input are excluded.
+ */
+bool canGroupInParallel(const DocumentSourceGroup& group) {
+    static const StringDataSet kOrderInsensitiveAccumulators{
+        "$sum", "$avg", "$min", "$max", "$addToSet", "$stdDevPop", "$stdDevSamp"};
+
+    if (group.doingMerge()) {
+        return false;
+    }
+    for (auto&& accumulatedField : group.getAccumulatedFields()) {
+        if (!kOrderInsensitiveAccumulators.count(accumulatedField.makeAccumulator()->getOpName())) {
+            return false;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+/**
+ * A worker scanning one range. Its Client, OperationContext and pipeline outlive the pool task
+ * which created them, so that a worker which found the queue full can give up its thread and
+ * carry on from where it stopped once the consumer makes room.
+ */
+struct DocumentSourceParallelCursor::Worker {
+    boost::intrusive_ptr<ExpressionContext> expCtx;
+
+    // Declared in this order so that the pipeline goes first and the Client last.
+    ServiceContext::UniqueClient client;
+    ServiceContext::UniqueOperationContext opCtx;
+    std::unique_ptr<Pipeline, PipelineDeleter> pipeline;
+
+    // Documents which the pipeline has produced but the queue has not yet accepted.
+    std::deque<Document> batch;
+    size_t batchBytes = 0;
+    bool eof = false;
+
+    // Guarded by SharedState::mutex.
+    bool started = false;
+};
+
+/**
+ * State shared between the stage and its workers. The scan parameters are copied in so that a
+ * worker task never needs the stage itself, which may be gone by the time the task gets a thread.
+ */
+struct DocumentSourceParallelCursor::SharedState {
+    SharedState(const DocumentSourceParallelCursor& stage, ServiceContext* serviceContext)
+        : serviceContext(serviceContext),
+          nss(stage._nss),
+          uuid(stage._uuid),
+          query(stage._query),
+          prefix(stage._prefix),
+          ranges(stage._ranges),
+          readTimestamp(stage._readTimestamp),
+          // Each worker may have one batch queued, so the queue is full when they all have.
+          maxQueuedBatches(ranges.size()),
+          workers(ranges.size()),
+          activeWorkers(ranges.size()),
+          queue([maxQueuedBatches = maxQueuedBatches] {
+              MultiProducerSingleConsumerQueue<std::deque<Document>>::Options options;
+              options.maxQueueDepth = maxQueuedBatches;
+              return options;
+          }()) {}
+
+    // Captured on the thread driving the stage, whose OperationContext the workers never touch.
+    ServiceContext* const serviceContext;
+    const NamespaceString nss;
+    const UUID uuid;
+    const BSONObj query;
+    const std::vector<BSONObj> prefix;
+    const std::vector<ScanRange> ranges;
+    const boost::optional<Timestamp> readTimestamp;
+    const size_t maxQueuedBatches;
+
+    // Only the task currently running a worker touches it, outside of its 'started' flag.
+    std::vector<Worker> workers;
+
+    Mutex mutex = MONGO_MAKE_LATCH("DocumentSourceParallelCursor::SharedState::mutex");
+
+    // The first error hit by any worker.
+    Status status = Status::OK();
+
+    // The OperationContexts of the workers which have started and not yet finished, so that they
+    // can be killed when the stage is disposed of.
+    std::vector<OperationContext*> workerOpCtxs;
+    bool killed = false;
+
+    // Number of workers which have not yet finished. The last one to finish closes the queue.
+    size_t activeWorkers;
+
+    // Number of workers which have started and not yet released their Client, which the stage
+    // waits for when it stops them.
+    size_t liveWorkers = 0;
+    stdx::condition_variable workersDone;
+
+    // Workers which found the queue full, in the order they gave up their threads. The consumer
+    // resumes one each time it takes a batch off the queue.
+    std::deque<size_t> parkedWorkers;
+
+    MultiProducerSingleConsumerQueue<std::deque<Document>> queue;
+};
+
+std::vector<DocumentSourceParallelCursor::ScanRange>
+DocumentSourceParallelCursor::splitRecordIdRange(OperationContext* opCtx,
+                                                 const Collection* collection,
+                                                 size_t numRanges) {
+    auto first = collection->getCursor(opCtx, true)->next();
+    auto last = collection->getCursor(opCtx, false)->next();
+    if (!first || !last || numRanges < 2) {
+        return {ScanRange{}};
+    }
+
+    const int64_t lo = first->id.repr();
+    const int64_t hi = last->id.repr();
+    const uint64_t span = static_cast<uint64_t>(hi) - static_cast<uint64_t>(lo);
+    const uint64_t width = span / numRanges;
+    if (width == 0) {
+        return {ScanRange{}};
+    }
+
+    // The first and last ranges are left open so that records inserted outside of [lo, hi] while
+    // the scan is running are seen as they would be by a single COLLSCAN.
+    std::vector<ScanRange> ranges;
+    boost::optional<RecordId> min;
+    for (size_t i = 0; i + 1 < numRanges; ++i) {
+        RecordId max(lo + static_cast<int64_t>(width * (i + 1)) - 1);
+        ranges.push_back({min, max});
+        min = RecordId(max.repr() + 1);
+    }
+    ranges.push_back({min, boost::none});
+    return ranges;
+}
+
+std::vector<BSONObj> DocumentSourceParallelCursor::extractPrefix(
+    Pipeline::SourceContainer* sources, bool* prefixNeedsMerge) {
+    std::vector<Value> serialized;
+    *prefixNeedsMerge = false;
+    while (!sources->empty()) {
+        auto stage = sources->front();
+        if (auto match = dynamic_cast<DocumentSourceMatch*>(stage.get())) {
+            if (match->isTextQuery()) {
+                break;
+            }
+        } else if (auto group = dynamic_cast<DocumentSourceGroup*>(stage.get())) {
+            if (!canGroupInParallel(*group)) {
+                break;
+            }
+            auto mergingStage = group->distributedPlanLogic()->mergingStage;
+            group->serializeToArray(serialized);
+            sources->pop_front();
+            sources->push_front(std::move(mergingStage));
+            *prefixNeedsMerge = true;
+            break;
+        } else if (!dynamic_cast<DocumentSourceSingleDocumentTransformation*>(stage.get())) {
+            break;
+        }
+        stage->serializeToArray(serialized);
+        sources->pop_front();
+    }
+
+    std::vector<BSONObj> prefix;
+    for (auto&& value : serialized) {
+        prefix.push_back(value.getDocument().toBson());
+    }
+    return prefix;
+}
+
+boost::intrusive_ptr<DocumentSourceParallelCursor> DocumentSourceParallelCursor::create(
+    const Collection* collection,
+    BSONObj query,
+    std::vector<BSONObj> prefix,
+    bool prefixNeedsMerge,
+    std::vector<ScanRange> ranges,
+    const boost::intrusive_ptr<ExpressionContext>& expCtx) {
+    return new DocumentSourceParallelCursor(collection,
+                                            std::move(query),
+                                            std::move(prefix),
+                                            prefixNeedsMerge,
+                                            std::move(ranges),
+                                            expCtx);
+}
+
+DocumentSourceParallelCursor::DocumentSourceParallelCursor(
+    const Collection* collection,
+    BSONObj query,
+    std::vector<BSONObj> prefix,
+    bool prefixNeedsMerge,
+    std::vector<ScanRange> ranges,
+    const boost::intrusive_ptr<ExpressionContext>& expCtx)
+    : DocumentSource(kStageName, expCtx),
+      _nss(collection->ns()),
+      _uuid(collection->uuid()),
+      _query(query.getOwned()),
+      _prefix(std::move(prefix)),
+      _prefixNeedsMerge(prefixNeedsMerge),
+      _ranges(std::move(ranges)),
+      _readTimestamp(expCtx->opCtx->recoveryUnit()->getPointInTimeReadTimestamp()) {
+    invariant(!_ranges.empty());
+}
+
+DocumentSourceParallelCursor::~DocumentSourceParallelCursor() {
+    stopWorkers();
+}
+
+const char* DocumentSourceParallelCursor::getSourceName() const {
+    return kStageName.rawData();
+}
+
+Value DocumentSourceParallelCursor::serialize(
+    boost::optional<ExplainOptions::Verbosity> explain) const {
+    std::vector<Value> prefix;
+    for (auto&& stage : _prefix) {
+        prefix.emplace_back(stage);
+    }
+    return Value(DOC(getSourceName() << DOC("query" << _query << "pipeline" << prefix
+                                                    << "numWorkers"
+                                                    << static_cast<long long>(_ranges.size()))));
+}
+
+DocumentSource::GetNextResult DocumentSourceParallelCursor::doGetNext() {
+    if (_currentBatch.empty()) {
+        loadBatch();
+    }
+
+    if (_currentBatch.empty()) {
+        return GetNextResult::makeEOF();
+    }
+
+    Document out = std::move(_currentBatch.front());
+    _currentBatch.pop_front();
+    return std::move(out);
+}
+
+void DocumentSourceParallelCursor::loadBatch() {
+    if (_exhausted) {
+        return;
+    }
+
+    if (!_state) {
+        startWorkers();
+    }
+
+    while (_currentBatch.empty()) {
+        {
+            stdx::lock_guard<Latch> lk(_state->mutex);
+            uassertStatusOK(_state->status);
+        }
+
+        try {
+            _currentBatch = _state->queue.pop(pExpCtx->opCtx);
+        } catch (const ExceptionFor<ErrorCodes::ProducerConsumerQueueConsumed>&) {
+            // Every worker has finished. Report the error which made one of them stop early, if
+            // there was one.
+            stdx::lock_guard<Latch> lk(_state->mutex);
+            uassertStatusOK(_state->status);
+            _exhausted = true;
+            return;
+        }
+        resumeParkedWorker();
+    }
+}
+
+void DocumentSourceParallelCursor::resumeParkedWorker() {
+    size_t workerNum;
+    {
+        stdx::lock_guard<Latch> lk(_state->mutex);
+        if (_state->parkedWorkers.empty()) {
+            return;
+        }
+        workerNum = _state->parkedWorkers.front();
+        _state->parkedWorkers.pop_front();
+    }
+    scheduleWorker(_state, workerNum);
+}
+
+void DocumentSourceParallelCursor::startWorkers() {
+    invariant(!_state);
+    LOG(1) << "Scanning " << _nss << " with " << _ranges.size() << " threads";
+    _state = std::make_shared<SharedState>(*this, pExpCtx->opCtx->getServiceContext());
+
+    for (size_t i = 0; i < _ranges.size(); ++i) {
+        auto& worker = _state->workers[i];
+        worker.expCtx = pExpCtx->copyWith(_nss, _uuid);
+        worker.expCtx->opCtx = nullptr;
+        worker.expCtx->needsMerge = _prefixNeedsMerge;
+        scheduleWorker(_state, i);
+    }
+}
+
+void DocumentSourceParallelCursor::scheduleWorker(std::shared_ptr<SharedState> state,
+                                                  size_t workerNum) {
+    getParallelScanPool()->schedule([state = std::move(state), workerNum](auto status) {
+        runWorker(state, workerNum, std::move(status));
+    });
+}
+
+void DocumentSourceParallelCursor::runWorker(std::shared_ptr<SharedState> state,
+                                             size_t workerNum,
+                                             Status status) {
+    auto& worker = state->workers[workerNum];
+    bool killed;
+    {
+        stdx::lock_guard<Latch> lk(state->mutex);
+        killed = state->killed;
+        if (!worker.started) {
+            if (killed) {
+                // The stage was disposed of before a thread became free to scan this range.
+                return;
+            }
+            worker.started = true;
+            ++state->liveWorkers;
+        }
+    }
+
+    if (!worker.client) {
+        worker.client = state->serviceContext->makeClient(str::stream() << "parallelCollScan-"
+                                                                        << workerNum);
+    }
+
+    bool finished = true;
+    {
+        AlternativeClientRegion acr(worker.client);
+        if (status.isOK() && !killed) {
+            try {
+                if (!worker.opCtx) {
+                    worker.opCtx = cc().makeOperationContext();
+                    worker.expCtx->opCtx = worker.opCtx.get();
+                    stdx::lock_guard<Latch> lk(state->mutex);
+                    state->workerOpCtxs.push_back(worker.opCtx.get());
+                    if (state->killed) {
+                        stdx::lock_guard<Client> clientLock(cc());
+                        state->serviceContext->killOperation(clientLock, worker.opCtx.get());
+                    }
+                }
+                finished = produce(state.get(), &worker, state->ranges[workerNum]);
+            } catch (const ExceptionFor<ErrorCodes::ProducerConsumerQueueEndClosed>&) {
+                // The consumer has gone away, so nobody needs the rest of the range.
+            } catch (const DBException& ex) {
+                status = ex.toStatus();
+            }
+        }
+
+        if (finished) {
+            // Disposing of the pipeline needs the worker's Client to be the current one.
+            worker.pipeline.reset();
+            if (worker.opCtx) {
+                stdx::lock_guard<Latch> lk(state->mutex);
+                auto& opCtxs = state->workerOpCtxs;
+                opCtxs.erase(std::find(opCtxs.begin(), opCtxs.end(), worker.opCtx.get()));
+            }
+            worker.opCtx.reset();
+        } else {
+            // Like a cursor waiting for its next getMore, a parked worker holds no snapshot.
+            worker.opCtx->recoveryUnit()->abandonSnapshot();
+        }
+    }
+    if (finished) {
+        worker.client.reset();
+    }
+
+    bool reschedule = false;
+    {
+        stdx::lock_guard<Latch> lk(state->mutex);
+        if (finished) {
+            if (!status.isOK() && state->status.isOK() && !state->killed) {
+                state->status = status.withContext(str::stream() << "parallel collection scan of "
+                                                                 << state->nss.ns() << " failed");
+            }
+            if (--state->activeWorkers == 0 || !state->status.isOK()) {
+                state->queue.closeProducerEnd();
+            }
+            if (--state->liveWorkers == 0) {
+                state->workersDone.notify_all();
+            }
+        } else if (state->killed ||
+                   state->queue.getStats().queueDepth < state->maxQueuedBatches) {
+            // Either the stage was disposed of, and this worker must come back to release its
+            // Client, or the consumer made room before the worker could park, in which case it
+            // would not know to resume it.
+            reschedule = true;
+        } else {
+            state->parkedWorkers.push_back(workerNum);
+        }
+    }
+    if (reschedule) {
+        scheduleWorker(std::move(state), workerNum);
+    }
+}
+
+bool DocumentSourceParallelCursor::produce(SharedState* state,
+                                           Worker* worker,
+                                           const ScanRange& range) {
+    OperationContext* opCtx = worker->opCtx.get();
+    if (!worker->pipeline) {
+        if (state->readTimestamp) {
+            opCtx->recoveryUnit()->setTimestampReadSource(RecoveryUnit::ReadSource::kProvided,
+                                                          state->readTimestamp);
+        }
+
+        auto pipeline = uassertStatusOK(Pipeline::parse(state->prefix, worker->expCtx));
+        AutoGetCollectionForRead autoColl(
+            opCtx, NamespaceStringOrUUID(state->nss.db().toString(), state->uuid));
+        Collection* collection = autoColl.getCollection();
+
+        auto qr = std::make_unique<QueryRequest>(collection->ns());
+        qr->setFilter(state->query);
+        auto cq = uassertStatusOK(
+            CanonicalQuery::canonicalize(opCtx,
+                                         std::move(qr),
+                                         worker->expCtx,
+                                         ExtensionsCallbackReal(opCtx, &state->nss),
+                                         Pipeline::kAllowedMatcherFeatures));
+
+        CollectionScanParams params;
+        params.minRecord = range.min;
+        params.maxRecord = range.max;
+        auto ws = std::make_unique<WorkingSet>();
+        auto root =
+            std::make_unique<CollectionScan>(opCtx, collection, params, ws.get(), cq->root());
+        auto exec = uassertStatusOK(PlanExecutor::make(std::move(cq),
+                                                       std::move(ws),
+                                                       std::move(root),
+                                                       collection,
+                                                       PlanExecutor::YIELD_AUTO));
+
+        // The DocumentSourceCursor takes and releases the collection lock for each batch it reads,
+        // so the worker holds no locks while it is parked.
+        pipeline->addInitialSource(
+            DocumentSourceCursor::create(collection, std::move(exec), worker->expCtx));
+        worker->pipeline = std::move(pipeline);
+    }
+
+    // Never wait for room in the queue, since that would hold a pool thread for as long as the
+    // consumer stays idle.
+    const auto maxBatchBytes =
+        static_cast<size_t>(internalDocumentSourceCursorBatchSizeBytes.load());
+    while (!worker->eof || !worker->batch.empty()) {
+        if (worker->eof || worker->batchBytes > maxBatchBytes) {
+            if (!state->queue.tryPush(std::move(worker->batch))) {
+                return false;
+            }
+            worker->batch = {};
+            worker->batchBytes = 0;
+        } else if (auto next = worker->pipeline->getNext()) {
+            worker->batchBytes += next->getApproximateSize();
+            worker->batch.push_back(std::move(*next));
+        } else {
+            worker->eof = true;
+        }
+    }
+    return true;
+}
+
+void DocumentSourceParallelCursor::doDispose() {
+    stopWorkers();
+}
+
+void DocumentSourceParallelCursor::stopWorkers() {
+    if (!_state) {
+        return;
+    }
+
+    std::deque<size_t> parkedWorkers;
+    {
+        stdx::lock_guard<Latch> lk(_state->mutex);
+        _state->killed = true;
+        for (auto&& opCtx : _state->workerOpCtxs) {
+            stdx::lock_guard<Client> clientLock(*opCtx->getClient());
+            opCtx->getServiceContext()->killOperation(clientLock, opCtx);
+        }
+        parkedWorkers = std::exchange(_state->parkedWorkers, {});
+    }
+    _state->queue.closeConsumerEnd();
+
+    // A parked worker's pipeline can only be disposed of under its own Client, so each one gets a
+    // thread once more to release it.
+    for (auto workerNum : parkedWorkers) {
+        scheduleWorker(_state, workerNum);
+    }
+
+    {
+        // Workers which have not got a thread yet return as soon as they do, without touching
+        // the collection, so only those already started are waited for. Being killed, they stop
+        // at their next interrupt check.
+        stdx::unique_lock<Latch> lk(_state->mutex);
+        _state->workersDone.wait(lk, [&] { return _state->liveWorkers == 0; });
+    }
+    _currentBatch.clear();
+    _exhausted = true;
+}
+
+}  // namespace mongo
@@ -0,0 +1,200 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/db/pipeline/document_source.h"
+#include "mongo/db/pipeline/pipeline.h"
+#include "mongo/db/record_id.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+
+class Collection;
+
+/**
+ * Scans a collection with several threads at once. The collection's RecordId range is split into
+ * disjoint ranges, and each worker thread runs a COLLSCAN over one range under its own Client and
+ * OperationContext. Each worker feeds its documents through its own copy of a pipeline prefix made
+ * of streaming stages ($match, $project and friends) and optionally a $group which emits partial
+ * results. The stages that follow this one see the union of the workers' output in no particular
+ * order, so when the prefix ends with a $group this stage must be followed by the merging half of
+ * that $group.
+ *
+ * The workers are started by the first call to getNext() and are killed and waited for on
+ * dispose. They run on a thread pool shared by every parallel scan in the process, so at most one
+ * range per core is scanned at once; the other ranges wait for a free thread. A worker never waits
+ * for the consumer: when the queue of batches is full it parks, giving its thread back to the
+ * pool, and the consumer resumes it once it takes a batch off the queue. An idle cursor therefore
+ * holds no threads.
+ */
+class DocumentSourceParallelCursor final : public DocumentSource {
+public:
+    static constexpr StringData kStageName = "$parallelCursor"_sd;
+
+    /**
+     * An inclusive range of RecordIds scanned by one worker. A missing bound leaves that end of the
+     * range open.
+     */
+    struct ScanRange {
+        boost::optional<RecordId> min;
+        boost::optional<RecordId> max;
+    };
+
+    /**
+     * Splits the RecordIds of 'collection' into at most 'numRanges' disjoint ranges of equal
+     * width which together cover the whole collection, including records inserted after the split
+     * at either end. Returns a single unbounded range if the collection is too small to split.
+     */
+    static std::vector<ScanRange> splitRecordIdRange(OperationContext* opCtx,
+                                                     const Collection* collection,
+                                                     size_t numRanges);
+
+    /**
+     * Removes the leading stages of 'sources' which every worker can run on its own share of the
+     * collection, and returns them serialized. A $group whose accumulators do not depend on the
+     * order of their input ends the prefix and is replaced in 'sources' by its merging half, in
+     * which case 'prefixNeedsMerge' is set to true.
+     */
+    static std::vector<BSONObj> extractPrefix(Pipeline::SourceContainer* sources,
+                                              bool* prefixNeedsMerge);
+
+    /**
+     * Creates a parallel cursor over 'collection' which applies 'query' to every scanned document
+     * and then runs each worker's documents through the serialized stages in 'prefix'. If
+     * 'prefixNeedsMerge' is true, the prefix ends in a blocking stage whose output is partial and
+     * must be merged downstream.
+     */
+    static boost::intrusive_ptr<DocumentSourceParallelCursor> create(
+        const Collection* collection,
+        BSONObj query,
+        std::vector<BSONObj> prefix,
+        bool prefixNeedsMerge,
+        std::vector<ScanRange> ranges,
+        const boost::intrusive_ptr<ExpressionContext>& expCtx);
+
+    ~DocumentSourceParallelCursor();
+
+    const char* getSourceName() const final;
+
+    Value serialize(boost::optional<ExplainOptions::Verbosity> explain = boost::none) const final;
+
+    StageConstraints constraints(Pipeline::SplitState pipeState) const final {
+        StageConstraints constraints(StreamType::kStreaming,
+                                     PositionRequirement::kFirst,
+                                     HostTypeRequirement::kAnyShard,
+                                     DiskUseRequirement::kNoDiskUse,
+                                     FacetRequirement::kNotAllowed,
+                                     TransactionRequirement::kNotAllowed,
+                                     LookupRequirement::kNotAllowed);
+
+        constraints.requiresInputDocSource = false;
+        return constraints;
+    }
+
+    boost::optional<DistributedPlanLogic> distributedPlanLogic() final {
+        return boost::none;
+    }
+
+protected:
+    GetNextResult doGetNext() final;
+
+    /**
+     * Stops the workers, if they were started, and waits for them to exit.
+     */
+    void doDispose() final;
+
+private:
+    struct Worker;
+    struct SharedState;
+
+    DocumentSourceParallelCursor(const Collection* collection,
+                                 BSONObj query,
+                                 std::vector<BSONObj> prefix,
+                                 bool prefixNeedsMerge,
+                                 std::vector<ScanRange> ranges,
+                                 const boost::intrusive_ptr<ExpressionContext>& expCtx);
+
+    /**
+     * Schedules a task on the shared pool which starts or resumes worker 'workerNum'.
+     */
+    static void scheduleWorker(std::shared_ptr<SharedState> state, size_t workerNum);
+
+    /**
+     * Body of each worker task. Scans range 'workerNum' and pushes the prefix's output into the
+     * queue in 'state' until the range is exhausted, the queue is full, the consumer goes away or
+     * an error occurs. A worker which found the queue full parks with its scan open; otherwise it
+     * releases everything it holds. Only touches 'state', which outlives the stage if need be,
+     * since a task that gets a thread after the stage was disposed of does nothing but clean up.
+     */
+    static void runWorker(std::shared_ptr<SharedState> state, size_t workerNum, Status status);
+
+    /**
+     * Scans 'range' on behalf of 'worker', starting its pipeline on the first call and carrying on
+     * from where the previous call stopped on later ones. Returns true once the whole range has
+     * been queued, or false if the queue was full. Throws on error.
+     */
+    static bool produce(SharedState* state, Worker* worker, const ScanRange& range);
+
+    void startWorkers();
+
+    /**
+     * Refills '_currentBatch' from the queue, blocking until a worker produces a batch or all of
+     * them are done. Throws the first error any worker hit.
+     */
+    void loadBatch();
+
+    /**
+     * Schedules the worker which has been parked longest, if any, now that the queue has room.
+     */
+    void resumeParkedWorker();
+
+    void stopWorkers();
+
+    const NamespaceString _nss;
+    const UUID _uuid;
+    const BSONObj _query;
+    const std::vector<BSONObj> _prefix;
+    const bool _prefixNeedsMerge;
+    const std::vector<ScanRange> _ranges;
+
+    // Point-in-time read timestamp of the operation which created this stage, if it had one. The
+    // workers read at the same timestamp so that they all see one snapshot of the collection.
+    const boost::optional<Timestamp> _readTimestamp;
+
+    std::shared_ptr<SharedState> _state;
+    std::deque<Document> _currentBatch;
+    bool _exhausted = false;
+};
+
+}  // namespace mongo
@@ -0,0 +1,269 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/document_source_parallel_cursor.h"
+
+#include <algorithm>
+
+#include "mongo/db/catalog/catalog_test_fixture.h"
+#include "mongo/db/catalog/collection.h"
+#include "mongo/db/client.h"
+#include "mongo/db/db_raii.h"
+#include "mongo/db/exec/document_value/document_value_test_util.h"
+#include "mongo/db/pipeline/aggregation_request.h"
+#include "mongo/db/pipeline/document_source_group.h"
+#include "mongo/db/pipeline/expression_context_for_test.h"
+#include "mongo/db/query/query_knobs_gen.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/scopeguard.h"
+
+namespace mongo {
+namespace {
+
+const NamespaceString kNss("test.parallelCursor");
+constexpr int kNumDocs = 1000;
+
+class DocumentSourceParallelCursorTest : public CatalogTestFixture {
+protected:
+    void setUp() override {
+        CatalogTestFixture::setUp();
+        ASSERT_OK(storageInterface()->createCollection(operationContext(), kNss, {}));
+
+        std::vector<InsertStatement> docs;
+        for (int i = 0; i < kNumDocs; ++i) {
+            docs.emplace_back(BSON("_id" << i << "a" << i % 7 << "b" << i));
+        }
+        ASSERT_OK(storageInterface()->insertDocuments(operationContext(), kNss, docs));
+    }
+
+    boost::intrusive_ptr<ExpressionContext> makeExpCtx(OperationContext* opCtx) {
+        return make_intrusive<ExpressionContextForTest>(opCtx, AggregationRequest(kNss, {}));
+    }
+
+    /**
+     * Creates a $parallelCursor which splits the collection into at most 'numRanges' ranges.
+     */
+    boost::intrusive_ptr<DocumentSourceParallelCursor> makeParallelCursor(
+        const boost::intrusive_ptr<ExpressionContext>& expCtx,
+        std::vector<BSONObj> prefix,
+        bool prefixNeedsMerge,
+        size_t numRanges,
+        BSONObj query = BSONObj()) {
+        AutoGetCollectionForRead autoColl(expCtx->opCtx, kNss);
+        auto ranges = DocumentSourceParallelCursor::splitRecordIdRange(
+            expCtx->opCtx, autoColl.getCollection(), numRanges);
+        ASSERT_EQ(ranges.size(), numRanges);
+        return DocumentSourceParallelCursor::create(autoColl.getCollection(),
+                                                    query,
+                                                    std::move(prefix),
+                                                    prefixNeedsMerge,
+                                                    std::move(ranges),
+                                                    expCtx);
+    }
+
+    /**
+     * Returns everything 'source' produces, sorted by _id since the workers' output is unordered.
+     */
+    std::vector<Document> drainSortedById(DocumentSource* source) {
+        std::vector<Document> results;
+        for (auto next = source->getNext(); next.isAdvanced(); next = source->getNext()) {
+            results.push_back(next.releaseDocument());
+        }
+        std::sort(results.begin(), results.end(), [](const Document& lhs, const Document& rhs) {
+            return Value::compare(lhs["_id"], rhs["_id"], nullptr) < 0;
+        });
+        return results;
+    }
+
+    std::unique_ptr<Pipeline, PipelineDeleter> parsePipeline(
+        const std::vector<BSONObj>& stages, const boost::intrusive_ptr<ExpressionContext>& expCtx) {
+        return uassertStatusOK(Pipeline::parse(stages, expCtx));
+    }
+};
+
+TEST_F(DocumentSourceParallelCursorTest, ExtractPrefixStopsAtFirstStageWorkersCannotRun) {
+    auto expCtx = makeExpCtx(operationContext());
+    auto pipeline = parsePipeline({fromjson("{$match: {a: {$gt: 1}}}"),
+                                   fromjson("{$project: {a: 1}}"),
+                                   fromjson("{$sort: {a: 1}}"),
+                                   fromjson("{$match: {a: 3}}")},
+                                  expCtx);
+
+    bool prefixNeedsMerge = true;
+    auto prefix =
+        DocumentSourceParallelCursor::extractPrefix(&pipeline->getSources(), &prefixNeedsMerge);
+    ASSERT_FALSE(prefixNeedsMerge);
+    ASSERT_EQ(prefix.size(), 2U);
+    ASSERT_EQ(prefix[0].firstElementFieldNameStringData(), "$match"_sd);
+    ASSERT_EQ(prefix[1].firstElementFieldNameStringData(), "$project"_sd);
+    ASSERT_EQ(pipeline->getSources().size(), 2U);
+    ASSERT_EQ(pipeline->peekFront()->getSourceName(), "$sort"_sd);
+}
+
+TEST_F(DocumentSourceParallelCursorTest, ExtractPrefixSplitsOrderInsensitiveGroup) {
+    auto expCtx = makeExpCtx(operationContext());
+    auto pipeline =
+        parsePipeline({fromjson("{$match: {a: {$gt: 1}}}"),
+                       fromjson("{$group: {_id: '$a', total: {$sum: '$b'}, top: {$max: '$b'}}}"),
+                       fromjson("{$sort: {_id: 1}}")},
+                      expCtx);
+
+    bool prefixNeedsMerge = false;
+    auto prefix =
+        DocumentSourceParallelCursor::extractPrefix(&pipeline->getSources(), &prefixNeedsMerge);
+    ASSERT_TRUE(prefixNeedsMerge);
+    ASSERT_EQ(prefix.size(), 2U);
+    ASSERT_EQ(prefix[1].firstElementFieldNameStringData(), "$group"_sd);
+
+    // The $group is replaced by its merging half, and nothing after it is taken.
+    ASSERT_EQ(pipeline->getSources().size(), 2U);
+    auto mergingGroup = dynamic_cast<DocumentSourceGroup*>(pipeline->peekFront());
+    ASSERT(mergingGroup);
+    ASSERT_TRUE(mergingGroup->doingMerge());
+}
+
+TEST_F(DocumentSourceParallelCursorTest, ExtractPrefixLeavesOrderSensitiveGroup) {
+    auto expCtx = makeExpCtx(operationContext());
+    auto pipeline = parsePipeline(
+        {fromjson("{$project: {a: 1}}"), fromjson("{$group: {_id: '$a', f: {$first: '$b'}}}")},
+        expCtx);
+
+    bool prefixNeedsMerge = true;
+    auto prefix =
+        DocumentSourceParallelCursor::extractPrefix(&pipeline->getSources(), &prefixNeedsMerge);
+    ASSERT_FALSE(prefixNeedsMerge);
+    ASSERT_EQ(prefix.size(), 1U);
+    ASSERT_EQ(pipeline->getSources().size(), 1U);
+    ASSERT_FALSE(static_cast<DocumentSourceGroup*>(pipeline->peekFront())->doingMerge());
+}
+
+TEST_F(DocumentSourceParallelCursorTest, ParallelScanMatchesSerialScan) {
+    auto expCtx = makeExpCtx(operationContext());
+    const std::vector<BSONObj> prefix{fromjson("{$match: {a: {$ne: 3}}}"),
+                                      fromjson("{$project: {b: 1}}")};
+    const auto query = fromjson("{b: {$gte: 100}}");
+
+    // A single unbounded range is scanned exactly like the COLLSCAN it replaces.
+    auto serial = makeParallelCursor(expCtx, prefix, false, 1, query);
+    auto parallel = makeParallelCursor(expCtx, prefix, false, 4, query);
+
+    auto serialResults = drainSortedById(serial.get());
+    auto parallelResults = drainSortedById(parallel.get());
+    serial->dispose();
+    parallel->dispose();
+
+    ASSERT_EQ(serialResults.size(), size_t(kNumDocs - 100 - (kNumDocs - 100) / 7));
+    ASSERT_EQ(parallelResults.size(), serialResults.size());
+    for (size_t i = 0; i < serialResults.size(); ++i) {
+        ASSERT_DOCUMENT_EQ(parallelResults[i], serialResults[i]);
+    }
+}
+
+TEST_F(DocumentSourceParallelCursorTest, MergingGroupCombinesPartialResults) {
+    auto expCtx = makeExpCtx(operationContext());
+    auto pipeline = parsePipeline(
+        {fromjson("{$group: {_id: '$a', total: {$sum: '$b'}, n: {$sum: 1}, lo: {$min: '$b'}}}")},
+        expCtx);
+    bool prefixNeedsMerge = false;
+    auto prefix =
+        DocumentSourceParallelCursor::extractPrefix(&pipeline->getSources(), &prefixNeedsMerge);
+    ASSERT_TRUE(prefixNeedsMerge);
+
+    auto parallel = makeParallelCursor(expCtx, std::move(prefix), prefixNeedsMerge, 4);
+    auto mergingGroup = pipeline->peekFront();
+    mergingGroup->setSource(parallel.get());
+    auto results = drainSortedById(mergingGroup);
+    mergingGroup->dispose();
+
+    ASSERT_EQ(results.size(), 7U);
+    for (int a = 0; a < 7; ++a) {
+        long long total = 0;
+        int n = 0;
+        for (int b = a; b < kNumDocs; b += 7) {
+            total += b;
+            ++n;
+        }
+        ASSERT_DOCUMENT_EQ(results[a],
+                           Document(BSON("_id" << a << "total" << total << "n" << n << "lo" << a)));
+    }
+}
+
+TEST_F(DocumentSourceParallelCursorTest, IdleConsumersLeavePoolThreadsFree) {
+    // Small batches fill the queue long before the workers finish their ranges, and with more
+    // workers than the pool has threads, two idle cursors would occupy every thread if their
+    // workers waited for room in the queue.
+    const auto batchSizeBytes = internalDocumentSourceCursorBatchSizeBytes.load();
+    internalDocumentSourceCursorBatchSizeBytes.store(200);
+    ON_BLOCK_EXIT([&] { internalDocumentSourceCursorBatchSizeBytes.store(batchSizeBytes); });
+
+    auto expCtx = makeExpCtx(operationContext());
+    std::vector<boost::intrusive_ptr<DocumentSourceParallelCursor>> idleCursors = {
+        makeParallelCursor(expCtx, {}, false, 64), makeParallelCursor(expCtx, {}, false, 64)};
+    for (auto&& cursor : idleCursors) {
+        ASSERT_TRUE(cursor->getNext().isAdvanced());
+    }
+
+    auto busy = makeParallelCursor(expCtx, {}, false, 4);
+    ASSERT_EQ(drainSortedById(busy.get()).size(), static_cast<size_t>(kNumDocs));
+
+    // The idle cursors' parked workers resume where they stopped.
+    for (auto&& cursor : idleCursors) {
+        ASSERT_EQ(drainSortedById(cursor.get()).size(), static_cast<size_t>(kNumDocs - 1));
+    }
+}
+
+TEST_F(DocumentSourceParallelCursorTest, KilledConsumerStopsWorkers) {
+    {
+        auto client = getServiceContext()->makeClient("parallelCursorConsumer");
+        AlternativeClientRegion acr(client);
+        auto opCtx = cc().makeOperationContext();
+        auto parallel = makeParallelCursor(makeExpCtx(opCtx.get()), {}, false, 4);
+
+        opCtx->markKilled(ErrorCodes::Interrupted);
+        ASSERT_THROWS_CODE(parallel->getNext(), DBException, ErrorCodes::Interrupted);
+
+        // Disposing of the stage waits for the workers that started, and those that did not
+        // will not touch the collection.
+        parallel->dispose();
+        ASSERT_TRUE(parallel->getNext().isEOF());
+    }
+
+    // No worker is left holding a lock on the collection.
+    AutoGetCollection autoColl(operationContext(),
+                               kNss,
+                               MODE_X,
+                               AutoGetCollection::ViewMode::kViewsForbidden,
+                               Date_t::now());
+    ASSERT(autoColl.getCollection());
+}
+
+}  // namespace
+}  // namespace mongo
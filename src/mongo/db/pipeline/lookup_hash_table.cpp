@@ -0,0 +1,162 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/pipeline/lookup_hash_table.h"
+
+#include <algorithm>
+#include <numeric>
+
+#include "mongo/db/pipeline/document_path_support.h"
+
+namespace mongo {
+
+LookupHashTable::LookupHashTable(const ValueComparator& comparator,
+                                 FieldPath joinField,
+                                 size_t maxSizeBytes)
+    : _joinField(std::move(joinField)),
+      _maxSizeBytes(maxSizeBytes),
+      _table(comparator.makeUnorderedValueMap<std::vector<DocIndex>>()) {}
+
+LookupHashTable::TableStatus LookupHashTable::add(Document doc) {
+    invariant(_status == TableStatus::kBuilding);
+
+    const DocIndex index = _docs.size();
+    size_t addedBytes = doc.getApproximateSize();
+
+    document_path_support::visitAllValuesAtPath(doc, _joinField, [&](const Value& value) {
+        // Null and undefined values are tracked by '_nullCandidates' rather than by the table.
+        if (value.nullish()) {
+            return;
+        }
+
+        auto it = _table.find(value);
+        if (it == _table.end()) {
+            it = _table.emplace(value, std::vector<DocIndex>{}).first;
+            addedBytes += value.getApproximateSize();
+        }
+
+        // The same value may appear more than once at the join path, e.g. {a: [1, 1]}.
+        auto& indexes = it->second;
+        if (indexes.empty() || indexes.back() != index) {
+            indexes.push_back(index);
+            addedBytes += sizeof(DocIndex);
+        }
+    });
+
+    if (mayMatchNull(doc)) {
+        _nullCandidates.push_back(index);
+        addedBytes += sizeof(DocIndex);
+    }
+
+    _sizeBytes += addedBytes;
+    if (_sizeBytes > _maxSizeBytes) {
+        abandon();
+        return _status;
+    }
+
+    _docs.push_back(std::move(doc));
+    return _status;
+}
+
+void LookupHashTable::freeze() {
+    invariant(_status == TableStatus::kBuilding);
+
+    _status = TableStatus::kServing;
+    _docs.shrink_to_fit();
+    _nullCandidates.shrink_to_fit();
+}
+
+void LookupHashTable::abandon() {
+    _status = TableStatus::kAbandoned;
+
+    _docs.clear();
+    _docs.shrink_to_fit();
+    _table.clear();
+    _nullCandidates.clear();
+    _nullCandidates.shrink_to_fit();
+}
+
+LookupHashTable::ProbeResult LookupHashTable::probe(const std::vector<Value>& joinValues) const {
+    invariant(_status == TableStatus::kServing);
+
+    ProbeResult result;
+    std::vector<DocIndex> indexes;
+    for (auto&& value : joinValues) {
+        if (value.nullish()) {
+            result.exact = false;
+            indexes.insert(indexes.end(), _nullCandidates.begin(), _nullCandidates.end());
+        } else if (value.isArray()) {
+            // An equality predicate on an array also matches a field whose entire value is that
+            // array. Only array elements are indexed, so every document is a candidate.
+            result.exact = false;
+            indexes.resize(_docs.size());
+            std::iota(indexes.begin(), indexes.end(), DocIndex{0});
+            break;
+        } else if (auto it = _table.find(value); it != _table.end()) {
+            indexes.insert(indexes.end(), it->second.begin(), it->second.end());
+        }
+    }
+
+    // Each posting list is already sorted, but probing with several values may interleave or
+    // duplicate them. Restore scan order so that the output matches a nested-loop join.
+    if (joinValues.size() > 1) {
+        std::sort(indexes.begin(), indexes.end());
+        indexes.erase(std::unique(indexes.begin(), indexes.end()), indexes.end());
+    }
+
+    result.docs.reserve(indexes.size());
+    for (auto index : indexes) {
+        result.docs.push_back(_docs[index]);
+    }
+    return result;
+}
+
+bool LookupHashTable::mayMatchNull(const Document& doc) const {
+    Value current = doc[_joinField.getFieldName(0)];
+    for (size_t i = 1; i < _joinField.getPathLength(); ++i) {
+        if (current.getType() != BSONType::Object) {
+            // A missing or scalar value means that the rest of the path does not exist, which
+            // matches null. An array may contain elements which lack the rest of the path.
+            return true;
+        }
+        current = current.getDocument()[_joinField.getFieldName(i)];
+    }
+
+    if (current.isArray()) {
+        const auto& elems = current.getArray();
+        return std::any_of(
+            elems.begin(), elems.end(), [](const Value& elem) { return elem.nullish(); });
+    }
+    return current.nullish();
+}
+
+}  // namespace mongo
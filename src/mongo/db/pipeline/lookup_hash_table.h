@@ -0,0 +1,159 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <vector>
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/value.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/pipeline/field_path.h"
+
+namespace mongo {
+
+/**
+ * The build side of a hash join for an equality $lookup. Documents from the foreign collection are
+ * added in scan order and indexed by every value found at the join field, so that a local document
+ * can be joined by probing the table rather than re-querying the foreign collection.
+ *
+ * Like SequentialDocumentCache, the table is in one of three states: building, serving or
+ * abandoned. The table abandons itself if its approximate memory footprint exceeds the maximum
+ * size it was constructed with, at which point the caller is expected to fall back to a
+ * nested-loop join.
+ */
+class LookupHashTable {
+    LookupHashTable(const LookupHashTable&) = delete;
+    LookupHashTable& operator=(const LookupHashTable&) = delete;
+
+public:
+    enum class TableStatus { kBuilding, kServing, kAbandoned };
+
+    /**
+     * The result of probing the table with the join values of a single local document. 'docs' are
+     * returned in the order in which they were added to the table. If 'exact' is false, 'docs' is
+     * a superset of the matching documents and the caller must apply the join predicate to each of
+     * them. This happens when probing with null or with an array value, since the query semantics
+     * for such values cannot be expressed as a hash lookup.
+     */
+    struct ProbeResult {
+        std::vector<Document> docs;
+        bool exact = true;
+    };
+
+    LookupHashTable(const ValueComparator& comparator, FieldPath joinField, size_t maxSizeBytes);
+
+    /**
+     * Adds 'doc' to the table. May only be called while the table is in 'kBuilding' mode. Returns
+     * the status of the table after the insertion, which is 'kAbandoned' if adding 'doc' caused the
+     * table to exceed its maximum size.
+     */
+    TableStatus add(Document doc);
+
+    /**
+     * Moves the table into 'kServing' (read-only) mode. May only be called while building.
+     */
+    void freeze();
+
+    /**
+     * Marks the table as 'kAbandoned' and frees any memory allocated while building.
+     */
+    void abandon();
+
+    /**
+     * Returns the documents whose join field may be equal to any of 'joinValues'. May only be
+     * called while the table is in 'kServing' mode.
+     */
+    ProbeResult probe(const std::vector<Value>& joinValues) const;
+
+    TableStatus status() const {
+        return _status;
+    }
+
+    bool isBuilding() const {
+        return _status == TableStatus::kBuilding;
+    }
+
+    bool isServing() const {
+        return _status == TableStatus::kServing;
+    }
+
+    bool isAbandoned() const {
+        return _status == TableStatus::kAbandoned;
+    }
+
+    size_t numDocs() const {
+        return _docs.size();
+    }
+
+    size_t numKeys() const {
+        return _table.size();
+    }
+
+    /**
+     * Returns the approximate memory footprint of the table. Once abandoned, this is the size that
+     * the table had reached when it exceeded its limit.
+     */
+    size_t sizeBytes() const {
+        return _sizeBytes;
+    }
+
+    size_t maxSizeBytes() const {
+        return _maxSizeBytes;
+    }
+
+private:
+    using DocIndex = std::size_t;
+
+    /**
+     * Returns true if a predicate {<joinField>: {$eq: null}} could match 'doc'. This errs on the
+     * side of returning true, since all candidates for a null probe are re-checked by the caller.
+     */
+    bool mayMatchNull(const Document& doc) const;
+
+    TableStatus _status = TableStatus::kBuilding;
+
+    FieldPath _joinField;
+    size_t _maxSizeBytes;
+    size_t _sizeBytes = 0;
+
+    // All documents on the build side, in the order in which they were added.
+    std::vector<Document> _docs;
+
+    // Maps each value found at '_joinField' to the indexes into '_docs' of the documents holding
+    // that value. The index lists are in ascending order and free of duplicates.
+    ValueUnorderedMap<std::vector<DocIndex>> _table;
+
+    // Indexes of the documents which may match a null join value.
+    std::vector<DocIndex> _nullCandidates;
+};
+
+}  // namespace mongo
@@ -0,0 +1,152 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+
+#include "mongo/platform/basic.h"
+
+#include <vector>
+
+#include "mongo/db/exec/document_value/document.h"
+#include "mongo/db/exec/document_value/document_value_test_util.h"
+#include "mongo/db/exec/document_value/value_comparator.h"
+#include "mongo/db/pipeline/lookup_hash_table.h"
+#include "mongo/db/query/collation/collator_interface_mock.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+const ValueComparator defaultComparator{nullptr};
+const size_t kDefaultMaxSizeBytes = 100 * 1024 * 1024;
+
+std::vector<int> idsOf(const std::vector<Document>& docs) {
+    std::vector<int> ids;
+    for (auto&& doc : docs) {
+        ids.push_back(doc["_id"].getInt());
+    }
+    return ids;
+}
+
+TEST(LookupHashTableTest, ProbeReturnsDocumentsWithEqualScalarValue) {
+    LookupHashTable table(defaultComparator, FieldPath("a"), kDefaultMaxSizeBytes);
+    table.add(Document{{"_id", 0}, {"a", 1}});
+    table.add(Document{{"_id", 1}, {"a", 2}});
+    table.add(Document{{"_id", 2}, {"a", 1.0}});
+    table.freeze();
+
+    auto result = table.probe({Value(1)});
+    ASSERT_TRUE(result.exact);
+    ASSERT(idsOf(result.docs) == std::vector<int>({0, 2}));
+
+    result = table.probe({Value(3)});
+    ASSERT_TRUE(result.exact);
+    ASSERT_TRUE(result.docs.empty());
+
+    ASSERT_EQ(table.numDocs(), 3U);
+    ASSERT_EQ(table.numKeys(), 2U);
+}
+
+TEST(LookupHashTableTest, ArrayElementsAndNestedPathsAreIndexed) {
+    LookupHashTable table(defaultComparator, FieldPath("a.b"), kDefaultMaxSizeBytes);
+    const Document repeatedValue{{"b", std::vector<Value>{Value(1), Value(1)}}};
+    table.add(Document{{"_id", 0}, {"a", Document{{"b", 1}}}});
+    table.add(Document{
+        {"_id", 1}, {"a", std::vector<Value>{Value(Document{{"b", 2}}), Value(repeatedValue)}}});
+    table.freeze();
+
+    auto result = table.probe({Value(1)});
+    ASSERT_TRUE(result.exact);
+    ASSERT(idsOf(result.docs) == std::vector<int>({0, 1}));
+
+    result = table.probe({Value(2)});
+    ASSERT(idsOf(result.docs) == std::vector<int>({1}));
+}
+
+TEST(LookupHashTableTest, ProbingWithSeveralValuesPreservesInsertionOrderWithoutDuplicates) {
+    LookupHashTable table(defaultComparator, FieldPath("a"), kDefaultMaxSizeBytes);
+    table.add(Document{{"_id", 0}, {"a", 2}});
+    table.add(Document{{"_id", 1}, {"a", std::vector<Value>{Value(1), Value(2)}}});
+    table.add(Document{{"_id", 2}, {"a", 1}});
+    table.freeze();
+
+    auto result = table.probe({Value(1), Value(2)});
+    ASSERT_TRUE(result.exact);
+    ASSERT(idsOf(result.docs) == std::vector<int>({0, 1, 2}));
+}
+
+TEST(LookupHashTableTest, NullProbeReturnsInexactCandidates) {
+    LookupHashTable table(defaultComparator, FieldPath("a.b"), kDefaultMaxSizeBytes);
+    table.add(Document{{"_id", 0}, {"a", Document{{"b", 1}}}});
+    table.add(Document{{"_id", 1}});
+    table.add(Document{{"_id", 2}, {"a", Document{{"b", BSONNULL}}}});
+    table.add(Document{{"_id", 3}, {"a", std::vector<Value>{Value(Document{{"b", 1}})}}});
+    table.freeze();
+
+    // Document 3 is a candidate because an array along the path may contain elements without 'b'.
+    auto result = table.probe({Value(BSONNULL)});
+    ASSERT_FALSE(result.exact);
+    ASSERT(idsOf(result.docs) == std::vector<int>({1, 2, 3}));
+}
+
+TEST(LookupHashTableTest, ArrayProbeReturnsAllDocumentsAsCandidates) {
+    LookupHashTable table(defaultComparator, FieldPath("a"), kDefaultMaxSizeBytes);
+    table.add(Document{{"_id", 0}, {"a", 1}});
+    table.add(Document{{"_id", 1}, {"a", std::vector<Value>{Value(1), Value(2)}}});
+    table.freeze();
+
+    auto result = table.probe({Value(std::vector<Value>{Value(1), Value(2)})});
+    ASSERT_FALSE(result.exact);
+    ASSERT(idsOf(result.docs) == std::vector<int>({0, 1}));
+}
+
+TEST(LookupHashTableTest, ProbeRespectsCollation) {
+    CollatorInterfaceMock collator(CollatorInterfaceMock::MockType::kAlwaysEqual);
+    ValueComparator comparator(&collator);
+    LookupHashTable table(comparator, FieldPath("a"), kDefaultMaxSizeBytes);
+    table.add(Document{{"_id", 0}, {"a", "foo"_sd}});
+    table.add(Document{{"_id", 1}, {"a", "bar"_sd}});
+    table.freeze();
+
+    auto result = table.probe({Value("baz"_sd)});
+    ASSERT(idsOf(result.docs) == std::vector<int>({0, 1}));
+}
+
+TEST(LookupHashTableTest, TableIsAbandonedWhenMaxSizeIsExceeded) {
+    Document doc{{"_id", 0}, {"a", 1}};
+    LookupHashTable table(defaultComparator, FieldPath("a"), doc.getApproximateSize());
+
+    ASSERT(table.add(doc) == LookupHashTable::TableStatus::kAbandoned);
+    ASSERT_TRUE(table.isAbandoned());
+    ASSERT_EQ(table.numDocs(), 0U);
+    ASSERT_EQ(table.numKeys(), 0U);
+    ASSERT_GT(table.sizeBytes(), table.maxSizeBytes());
+}
+
+}  // namespace
+}  // namespace mongo
@@ -63,6 +63,7 @@
 #include "mongo/db/pipeline/document_source_geo_near_cursor.h"
 #include "mongo/db/pipeline/document_source_group.h"
 #include "mongo/db/pipeline/document_source_match.h"
+#include "mongo/db/pipeline/document_source_parallel_cursor.h"
 #include "mongo/db/pipeline/document_source_sample.h"
 #include "mongo/db/pipeline/document_source_sample_from_random_cursor.h"
 #include "mongo/db/pipeline/document_source_single_document_transformation.h"
@@ -71,6 +72,7 @@
 #include "mongo/db/query/collation/collator_interface.h"
 #include "mongo/db/query/get_executor.h"
 #include "mongo/db/query/plan_summary_stats.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/query/query_planner.h"
 #include "mongo/db/query/sort_pattern.h"
 #include "mongo/db/s/collection_sharding_state.h"
@@ -478,6 +480,46 @@ auto buildProjectionForPushdown(const DepsTracker& deps, Pipeline* pipeline) {
     // happen. This covers cases 2 and 3.
     return deps.toProjectionWithoutMetadata();
 }
+
+/**
+ * Returns true if 'exec' only scans 'collection' from start to end, optionally projecting the
+ * documents it returns, so that a $parallelCursor can produce the same documents.
+ */
+bool canScanInParallel(const boost::intrusive_ptr<ExpressionContext>& expCtx,
+                       const Collection* collection,
+                       PlanExecutor* exec) {
+    const int numThreads = internalQueryParallelCollectionScanThreads.load();
+    if (numThreads < 2 || !collection || expCtx->explain ||
+        expCtx->tailableMode != TailableModeEnum::kNormal ||
+        expCtx->opCtx->inMultiDocumentTransaction()) {
+        return false;
+    }
+
+    // A $lookup runs its sub-pipeline, or builds its hash table, once per outer document or
+    // batch, so scanning there in parallel would fill the pool with short-lived scans which
+    // compete with the outer one.
+    if (expCtx->subPipelineDepth > 0) {
+        return false;
+    }
+
+    // Capped collections and the oplog promise their readers insertion order, which the workers
+    // can't preserve.
+    if (collection->isCapped() || collection->ns().isOplog()) {
+        return false;
+    }
+
+    PlanStage* root = exec->getRootStage();
+    if (root->stageType() == STAGE_PROJECTION_DEFAULT ||
+        root->stageType() == STAGE_PROJECTION_SIMPLE) {
+        root = root->getChildren()[0].get();
+    }
+    if (root->stageType() != STAGE_COLLSCAN) {
+        return false;
+    }
+
+    return collection->getRecordStore()->numRecords(expCtx->opCtx) >=
+        internalQueryParallelCollectionScanMinRecords.load();
+}
 }  // namespace
 
 std::pair<PipelineD::AttachExecutorCallback, std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>>
@@ -533,6 +575,7 @@ PipelineD::buildInnerQueryExecutorGeneric(Collection* collection,
 
     // Create the PlanExecutor.
     bool shouldProduceEmptyDocs = false;
+    BSONObj projection;
     auto exec = uassertStatusOK(prepareExecutor(expCtx,
                                                 collection,
                                                 nss,
@@ -544,17 +587,46 @@ PipelineD::buildInnerQueryExecutorGeneric(Collection* collection,
                                                 limit,
                                                 aggRequest,
                                                 Pipeline::kAllowedMatcherFeatures,
-                                                &shouldProduceEmptyDocs));
+                                                &shouldProduceEmptyDocs,
+                                                &projection));
 
 
     // If this is a change stream pipeline, make sure that we tell DSCursor to track the oplog time.
     const bool trackOplogTS =
         (pipeline->peekFront() && pipeline->peekFront()->constraints().isChangeStreamStage());
 
-    auto attachExecutorCallback = [shouldProduceEmptyDocs, trackOplogTS](
+    auto attachExecutorCallback = [shouldProduceEmptyDocs, trackOplogTS, queryObj, projection](
                                       Collection* collection,
                                       std::unique_ptr<PlanExecutor, PlanExecutor::Deleter> exec,
                                       Pipeline* pipeline) {
+        auto expCtx = pipeline->getContext();
+        if (!trackOplogTS && canScanInParallel(expCtx, collection, exec.get())) {
+            auto ranges = DocumentSourceParallelCursor::splitRecordIdRange(
+                expCtx->opCtx,
+                collection,
+                static_cast<size_t>(internalQueryParallelCollectionScanThreads.load()));
+            if (ranges.size() > 1) {
+                // The workers run their own scans, so the executor built for a single scan is not
+                // needed. Its projection may have absorbed a $project from the pipeline, so the
+                // workers apply it ahead of the stages they take from the pipeline.
+                exec.reset();
+                bool prefixNeedsMerge;
+                auto prefix = DocumentSourceParallelCursor::extractPrefix(&pipeline->_sources,
+                                                                          &prefixNeedsMerge);
+                if (!projection.isEmpty()) {
+                    prefix.insert(prefix.begin(), BSON("$project" << projection));
+                }
+                pipeline->addInitialSource(
+                    DocumentSourceParallelCursor::create(collection,
+                                                         queryObj,
+                                                         std::move(prefix),
+                                                         prefixNeedsMerge,
+                                                         std::move(ranges),
+                                                         expCtx));
+                return;
+            }
+        }
+
         auto cursor = DocumentSourceCursor::create(
             collection, std::move(exec), pipeline->getContext(), trackOplogTS);
         addCursorSource(pipeline, std::move(cursor), shouldProduceEmptyDocs);
@@ -589,6 +661,7 @@ PipelineD::buildInnerQueryExecutorGeoNear(Collection* collection,
     BSONObj fullQuery = geoNearStage->asNearQuery(nearFieldName);
 
     bool shouldProduceEmptyDocs = false;
+    BSONObj projection;
     auto exec = uassertStatusOK(
         prepareExecutor(expCtx,
                         collection,
@@ -601,7 +674,8 @@ PipelineD::buildInnerQueryExecutorGeoNear(Collection* collection,
                         boost::none, /* limit */
                         aggRequest,
                         Pipeline::kGeoNearMatcherFeatures,
-                        &shouldProduceEmptyDocs));
+                        &shouldProduceEmptyDocs,
+                        &projection));
 
     auto attachExecutorCallback = [shouldProduceEmptyDocs,
                                    distanceField = geoNearStage->getDistanceField(),
@@ -636,7 +710,8 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
     boost::optional<long long> limit,
     const AggregationRequest* aggRequest,
     const MatchExpressionParser::AllowedFeatureSet& matcherFeatures,
-    bool* hasNoRequirements) {
+    bool* hasNoRequirements,
+    BSONObj* projection) {
     invariant(hasNoRequirements);
 
     size_t plannerOpts = QueryPlannerParams::DEFAULT;
@@ -687,6 +762,7 @@ StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> PipelineD::prep
         // layer. If a projection cannot be pushed down, an empty BSONObj will be returned.
         projObj = buildProjectionForPushdown(deps, pipeline);
     }
+    *projection = projObj;
 
     if (rewrittenGroupStage) {
         // See if the query system can handle the $group and $sort stage using a DISTINCT_SCAN
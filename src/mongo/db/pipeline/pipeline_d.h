@@ -175,7 +175,9 @@ private:
      * (SERVER-9507).
      *
      * Sets the 'hasNoRequirements' out-parameter based on whether the dependency set is both finite
-     * and empty. In this case, the query has count semantics.
+     * and empty. In this case, the query has count semantics. Sets the 'projection' out-parameter
+     * to the projection pushed down into the PlanStage layer, or to an empty object if there is
+     * none.
      */
     static StatusWith<std::unique_ptr<PlanExecutor, PlanExecutor::Deleter>> prepareExecutor(
         const boost::intrusive_ptr<ExpressionContext>& expCtx,
@@ -189,7 +191,8 @@ private:
         boost::optional<long long> limit,
         const AggregationRequest* aggRequest,
         const MatchExpressionParser::AllowedFeatureSet& matcherFeatures,
-        bool* hasNoRequirements);
+        bool* hasNoRequirements,
+        BSONObj* projection);
 
     /**
      * Adds 'cursor' to the front of 'pipeline'. If 'shouldProduceEmptyDocs' is true, then we inform
@@ -1074,6 +1074,20 @@ void Explain::planCacheEntryToBSON(const PlanCacheEntry& entry, BSONObjBuilder*
     scoresBuilder.doneFast();
 
     out->append("indexFilterSet", entry.plannerData[0]->indexFilterApplied);
+
+    const auto& runtimeStats = entry.runtimeStats;
+    BSONObjBuilder runtimeBob(out->subobjStart("runtimeStats"));
+    runtimeBob.appendNumber("executions", runtimeStats.executions);
+    runtimeBob.appendNumber("totalWorks", runtimeStats.totalWorks);
+    runtimeBob.appendNumber("totalReturned", runtimeStats.totalReturned);
+    runtimeBob.append("trialWorksPerResult", entry.trialWorksPerResult());
+    runtimeBob.append("recentWorksPerResult", runtimeStats.recentWorksPerResult);
+    for (auto percentile : {50, 95, 99}) {
+        runtimeBob.appendNumber(
+            str::stream() << "latencyP" << percentile << "Micros",
+            durationCount<Microseconds>(runtimeStats.latencyPercentile(percentile)));
+    }
+    runtimeBob.doneFast();
 }
 
 }  // namespace mongo
@@ -287,7 +287,7 @@ std::unique_ptr<PlanCacheEntry> PlanCacheEntry::clone() const {
     }
 
     auto decisionPtr = std::unique_ptr<PlanRankingDecision>(decision->clone());
-    return std::unique_ptr<PlanCacheEntry>(new PlanCacheEntry(std::move(solutionCacheData),
+    auto entry = std::unique_ptr<PlanCacheEntry>(new PlanCacheEntry(std::move(solutionCacheData),
                                                               query,
                                                               sort,
                                                               projection,
@@ -299,6 +299,13 @@ std::unique_ptr<PlanCacheEntry> PlanCacheEntry::clone() const {
                                                               feedback,
                                                               isActive,
                                                               works));
+    entry->runtimeStats = runtimeStats;
+    return entry;
+}
+
+double PlanCacheEntry::trialWorksPerResult() const {
+    const auto& trialStats = decision->stats[0]->common;
+    return static_cast<double>(trialStats.works + 1) / (trialStats.advanced + 1);
 }
 
 uint64_t PlanCacheEntry::_estimateObjectSizeInBytes() const {
@@ -325,6 +332,54 @@ std::string PlanCacheEntry::toString() const {
                          << ";timeOfCreation: " << timeOfCreation.toString() << ")";
 }
 
+//
+// PlanCacheEntryRuntimeStats
+//
+
+void PlanCacheEntryRuntimeStats::record(size_t works,
+                                        size_t nReturned,
+                                        Microseconds latency,
+                                        int windowSize) {
+    // Count one extra work cycle and result, as trialWorksPerResult() does, so that executions
+    // which return nothing still have a finite cost.
+    const double worksPerResult = static_cast<double>(works + 1) / (nReturned + 1);
+    if (executions == 0) {
+        recentWorksPerResult = worksPerResult;
+    } else {
+        const double alpha = 2.0 / (windowSize + 1);
+        recentWorksPerResult = alpha * worksPerResult + (1 - alpha) * recentWorksPerResult;
+    }
+
+    ++executions;
+    totalWorks += works;
+    totalReturned += nReturned;
+
+    size_t bucket = 0;
+    for (auto micros = durationCount<Microseconds>(latency);
+         micros > 1 && bucket + 1 < kNumLatencyBuckets;
+         micros = (micros + 1) / 2) {
+        ++bucket;
+    }
+    ++latencyHistogram[bucket];
+}
+
+Microseconds PlanCacheEntryRuntimeStats::latencyPercentile(double percentile) const {
+    if (executions == 0) {
+        return Microseconds(0);
+    }
+
+    const long long rank =
+        std::max(1LL, static_cast<long long>(std::ceil(executions * percentile / 100)));
+    long long seen = 0;
+    for (size_t bucket = 0; bucket < kNumLatencyBuckets; ++bucket) {
+        seen += latencyHistogram[bucket];
+        if (seen >= rank) {
+            return Microseconds(1LL << bucket);
+        }
+    }
+    MONGO_UNREACHABLE;
+}
+
 std::string CachedSolution::toString() const {
     return str::stream() << "key: " << key << '\n';
 }
@@ -658,6 +713,41 @@ Status PlanCache::feedback(const CanonicalQuery& cq, double score) {
     return Status::OK();
 }
 
+Status PlanCache::recordExecution(const CanonicalQuery& cq,
+                                  size_t works,
+                                  size_t nReturned,
+                                  Microseconds latency) {
+    PlanCacheKey ck = computeKey(cq);
+
+    stdx::lock_guard<Latch> cacheLock(_cacheMutex);
+    PlanCacheEntry* entry;
+    Status cacheStatus = _cache.get(ck, &entry);
+    if (!cacheStatus.isOK()) {
+        return cacheStatus;
+    }
+    invariant(entry);
+
+    const int minExecutions = internalQueryCacheRuntimeDriftMinExecutions.load();
+    auto& stats = entry->runtimeStats;
+    stats.record(works, nReturned, latency, minExecutions);
+
+    const double driftRatio = internalQueryCacheRuntimeDriftRatio.load();
+    if (driftRatio == 0 || stats.executions < minExecutions) {
+        return Status::OK();
+    }
+
+    const double expected = entry->trialWorksPerResult();
+    if (stats.recentWorksPerResult > driftRatio * expected) {
+        LOG(1) << "Evicting cache entry for query " << redact(cq.toStringShort())
+               << " with queryHash " << unsignedIntToFixedLengthHex(entry->queryHash)
+               << ": recent executions of the cached plan averaged "
+               << stats.recentWorksPerResult << " works per result, but its trial period took "
+               << expected << " works per result";
+        _cache.remove(ck);
+    }
+    return Status::OK();
+}
+
 Status PlanCache::remove(const CanonicalQuery& canonicalQuery) {
     stdx::lock_guard<Latch> cacheLock(_cacheMutex);
     return _cache.remove(computeKey(canonicalQuery));
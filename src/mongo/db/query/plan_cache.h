@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <array>
 #include <boost/optional/optional.hpp>
 #include <set>
 
@@ -41,6 +42,7 @@
 #include "mongo/platform/atomic_word.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/util/container_size_helper.h"
+#include "mongo/util/duration.h"
 
 namespace mongo {
 
@@ -266,6 +268,39 @@ struct SolutionCacheData {
 
 class PlanCacheEntry;
 
+/**
+ * Statistics about the executions of a cached plan which ran to completion after being taken from
+ * the cache. Used to notice when a plan has become much more expensive than it was when it won
+ * the race that put it in the cache.
+ */
+struct PlanCacheEntryRuntimeStats {
+    // Execution latencies are counted in buckets whose upper bounds are successive powers of two
+    // microseconds. The last bucket also counts every longer execution.
+    static constexpr size_t kNumLatencyBuckets = 32;
+
+    /**
+     * Records an execution which performed 'works' work cycles, returned 'nReturned' results and
+     * took 'latency'. The recent works per result are averaged over roughly the last
+     * 'windowSize' executions.
+     */
+    void record(size_t works, size_t nReturned, Microseconds latency, int windowSize);
+
+    /**
+     * Returns an upper bound on the latency of 'percentile' percent of the recorded executions,
+     * or zero if there are none.
+     */
+    Microseconds latencyPercentile(double percentile) const;
+
+    long long executions = 0;
+    long long totalWorks = 0;
+    long long totalReturned = 0;
+
+    // Exponentially weighted moving average of the works per result of recent executions.
+    double recentWorksPerResult = 0;
+
+    std::array<long long, kNumLatencyBuckets> latencyHistogram{};
+};
+
 /**
  * Information returned from a get(...) query.
  */
@@ -378,6 +413,15 @@ public:
     // cause this value to be increased.
     size_t works = 0;
 
+    // Statistics from complete executions of the cached plan.
+    PlanCacheEntryRuntimeStats runtimeStats;
+
+    /**
+     * Returns the works per result the winning plan performed during the trial period which put
+     * it in the cache. Observed runtime costs are compared against this value.
+     */
+    double trialWorksPerResult() const;
+
     /**
      * Tracks the approximate cumulative size of the plan cache entries across all the collections.
      */
@@ -531,6 +575,23 @@ public:
      */
     Status feedback(const CanonicalQuery& cq, double score);
 
+    /**
+     * The CachedPlanStage calls recordExecution(...) when a plan taken from the cache runs to
+     * completion, passing the number of work cycles it performed over the whole execution, the
+     * number of results it returned and how long it spent executing.
+     *
+     * If the recent executions of the plan have cost more than
+     * 'internalQueryCacheRuntimeDriftRatio' times the works per result seen during the plan's
+     * trial period, the entry is evicted so that the next query of this shape races the
+     * candidate plans again.
+     *
+     * Returns an error Status if the entry corresponding to 'cq' isn't in the cache anymore.
+     */
+    Status recordExecution(const CanonicalQuery& cq,
+                           size_t works,
+                           size_t nReturned,
+                           Microseconds latency);
+
     /**
      * Remove the entry corresponding to 'ck' from the cache.  Returns Status::OK() if the plan
      * was present and removed and an error status otherwise.
@@ -823,6 +823,56 @@ TEST(PlanCacheTest, DeactivateCacheEntry) {
     ASSERT_EQ(entry->works, 20U);
 }
 
+TEST(PlanCacheTest, RecordExecutionTracksRuntimeStats) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U, 9), Date_t{}));
+
+    ASSERT_OK(planCache.recordExecution(*cq, 9, 0, Microseconds(3)));
+    ASSERT_OK(planCache.recordExecution(*cq, 19, 1, Microseconds(100)));
+
+    auto entry = assertGet(planCache.getEntry(*cq));
+    const auto& stats = entry->runtimeStats;
+    ASSERT_EQ(stats.executions, 2);
+    ASSERT_EQ(stats.totalWorks, 28);
+    ASSERT_EQ(stats.totalReturned, 1);
+    ASSERT_EQ(entry->trialWorksPerResult(), 10.0);
+    ASSERT_EQ(stats.latencyPercentile(50), Microseconds(4));
+    ASSERT_EQ(stats.latencyPercentile(99), Microseconds(128));
+}
+
+TEST(PlanCacheTest, RecordExecutionEvictsEntryWhoseCostDrifts) {
+    PlanCache planCache;
+    unique_ptr<CanonicalQuery> cq(canonicalize("{a: 1}"));
+    auto qs = getQuerySolutionForCaching();
+    std::vector<QuerySolution*> solns = {qs.get()};
+
+    QueryTestServiceContext serviceContext;
+    ASSERT_OK(planCache.set(*cq, solns, createDecision(1U, 9), Date_t{}));
+
+    const int minExecutions = internalQueryCacheRuntimeDriftMinExecutions.load();
+    const size_t driftedWorks =
+        static_cast<size_t>(internalQueryCacheRuntimeDriftRatio.load() * 10) * 2;
+
+    // Executions which cost as much as the trial period leave the entry alone, however many there
+    // are.
+    for (int i = 0; i < 2 * minExecutions; ++i) {
+        ASSERT_OK(planCache.recordExecution(*cq, 9, 0, Microseconds(1)));
+    }
+    ASSERT_EQ(planCache.size(), 1U);
+
+    // Once recent executions cost much more, the entry is evicted.
+    for (int i = 0; i < 2 * minExecutions && planCache.size() > 0; ++i) {
+        ASSERT_OK(planCache.recordExecution(*cq, driftedWorks, 0, Microseconds(1)));
+    }
+    ASSERT_EQ(planCache.size(), 0U);
+    ASSERT_NOT_OK(planCache.recordExecution(*cq, 9, 0, Microseconds(1)));
+}
+
 TEST(PlanCacheTest, GetMatchingStatsMatchesAndSerializesCorrectly) {
     PlanCache planCache;
 
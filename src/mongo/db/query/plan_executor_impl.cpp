@@ -54,6 +54,7 @@
 #include "mongo/db/query/find_common.h"
 #include "mongo/db/query/mock_yield_policies.h"
 #include "mongo/db/query/plan_yield_policy.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/repl/replication_coordinator.h"
 #include "mongo/db/service_context.h"
 #include "mongo/util/fail_point.h"
@@ -331,6 +332,7 @@ const boost::intrusive_ptr<ExpressionContext>& PlanExecutorImpl::getExpCtx() con
 void PlanExecutorImpl::saveState() {
     invariant(_currentState == kUsable || _currentState == kSaved);
 
+    _saveBatchedResults();
     if (!isMarkedAsKilled()) {
         _root->saveState();
     }
@@ -531,6 +533,22 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
         return PlanExecutor::ADVANCED;
     }
 
+    while (!_savedBatch.empty()) {
+        SavedResult result = std::move(_savedBatch.front());
+        _savedBatch.pop();
+        if ((objOut && !result.doc) || (dlOut && !result.recordId)) {
+            // This result didn't have the data the caller wanted, try the next one.
+            continue;
+        }
+        if (objOut) {
+            *objOut = std::move(*result.doc);
+        }
+        if (dlOut) {
+            *dlOut = *result.recordId;
+        }
+        return PlanExecutor::ADVANCED;
+    }
+
     // Incremented on every writeConflict, reset to 0 on any successful call to _root->work.
     size_t writeConflictsInARow = 0;
 
@@ -547,8 +565,10 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
         //   1) The yield policy's timer elapsed, or
         //   2) some stage requested a yield, or
         //   3) we need to yield and retry due to a WriteConflictException.
-        // In all cases, the actual yielding happens here.
-        if (_yieldPolicy->shouldYieldOrInterrupt()) {
+        // In all cases, the actual yielding happens here. We only check for one when we are
+        // about to work the plan again, so that a yield never has to save a partly returned batch.
+        const bool haveBatchedResults = _batchPos < _batch.size();
+        if (!haveBatchedResults && _yieldPolicy->shouldYieldOrInterrupt()) {
             auto yieldStatus = _yieldPolicy->yieldOrInterrupt();
             if (!yieldStatus.isOK()) {
                 if (objOut) {
@@ -560,51 +580,27 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
         }
 
         WorkingSetID id = WorkingSet::INVALID_ID;
-        PlanStage::StageState code = _root->work(&id);
+        PlanStage::StageState code;
+        if (haveBatchedResults) {
+            id = _batch[_batchPos++];
+            code = PlanStage::ADVANCED;
+        } else if (const auto batchSize = internalQueryExecBatchSize.load();
+                   batchSize > 0 && _root->producesNativeBatches()) {
+            _batch.clear();
+            _batchPos = 0;
+            code = _root->workBatch(_workingSet.get(), batchSize, &_batch, &id);
+            if (PlanStage::ADVANCED == code) {
+                id = _batch[_batchPos++];
+            }
+        } else {
+            code = _root->work(&id);
+        }
 
         if (code != PlanStage::NEED_YIELD)
             writeConflictsInARow = 0;
 
         if (PlanStage::ADVANCED == code) {
-            WorkingSetMember* member = _workingSet->get(id);
-            bool hasRequestedData = true;
-
-            if (nullptr != objOut) {
-                if (WorkingSetMember::RID_AND_IDX == member->getState()) {
-                    if (1 != member->keyData.size()) {
-                        _workingSet->free(id);
-                        hasRequestedData = false;
-                    } else {
-                        // TODO: currently snapshot ids are only associated with documents, and
-                        // not with index keys.
-                        *objOut = Snapshotted<Document>(SnapshotId(),
-                                                        Document{member->keyData[0].keyData});
-                    }
-                } else if (member->hasObj()) {
-                    std::swap(*objOut, member->doc);
-                } else {
-                    _workingSet->free(id);
-                    hasRequestedData = false;
-                }
-            }
-
-            if (nullptr != dlOut) {
-                if (member->hasRecordId()) {
-                    *dlOut = member->recordId;
-                } else {
-                    _workingSet->free(id);
-                    hasRequestedData = false;
-                }
-            }
-
-            if (hasRequestedData) {
-                // transfer the metadata from the WSM to Document.
-                if (objOut && member->metadata()) {
-                    MutableDocument md(std::move(objOut->value()));
-                    md.setMetadata(member->releaseMetadata());
-                    objOut->setValue(md.freeze());
-                }
-                _workingSet->free(id);
+            if (_extractResult(id, objOut, dlOut)) {
                 return PlanExecutor::ADVANCED;
             }
             // This result didn't have the data the caller wanted, try again.
@@ -662,9 +658,69 @@ PlanExecutor::ExecState PlanExecutorImpl::_getNextImpl(Snapshotted<Document>* ob
     }
 }
 
+bool PlanExecutorImpl::_extractResult(WorkingSetID id,
+                                      Snapshotted<Document>* objOut,
+                                      RecordId* dlOut) {
+    WorkingSetMember* member = _workingSet->get(id);
+    ON_BLOCK_EXIT([&] { _workingSet->free(id); });
+
+    if (nullptr != objOut) {
+        if (WorkingSetMember::RID_AND_IDX == member->getState()) {
+            if (1 != member->keyData.size()) {
+                return false;
+            }
+            // TODO: currently snapshot ids are only associated with documents, and
+            // not with index keys.
+            *objOut = Snapshotted<Document>(SnapshotId(), Document{member->keyData[0].keyData});
+        } else if (member->hasObj()) {
+            std::swap(*objOut, member->doc);
+        } else {
+            return false;
+        }
+    }
+
+    if (nullptr != dlOut) {
+        if (!member->hasRecordId()) {
+            return false;
+        }
+        *dlOut = member->recordId;
+    }
+
+    // transfer the metadata from the WSM to Document.
+    if (objOut && member->metadata()) {
+        MutableDocument md(std::move(objOut->value()));
+        md.setMetadata(member->releaseMetadata());
+        objOut->setValue(md.freeze());
+    }
+    return true;
+}
+
+void PlanExecutorImpl::_saveBatchedResults() {
+    // Documents in a batch are owned, so the results can be taken out of the working set as they
+    // are. The stages below us have already moved past them and won't produce them again.
+    for (; _batchPos < _batch.size(); ++_batchPos) {
+        const WorkingSetID id = _batch[_batchPos];
+        SavedResult result;
+        if (_workingSet->get(id)->hasRecordId()) {
+            result.recordId = _workingSet->get(id)->recordId;
+        }
+        Snapshotted<Document> doc;
+        if (_extractResult(id, &doc, nullptr)) {
+            result.doc = std::move(doc);
+        }
+        if (result.doc || result.recordId) {
+            _savedBatch.push(std::move(result));
+        }
+    }
+    _batch.clear();
+    _batchPos = 0;
+}
+
 bool PlanExecutorImpl::isEOF() {
     invariant(_currentState == kUsable);
-    return isMarkedAsKilled() || (_stash.empty() && _root->isEOF());
+    return isMarkedAsKilled() ||
+        (_stash.empty() && _savedBatch.empty() && _batchPos == _batch.size() &&
+         _root->isEOF());
 }
 
 void PlanExecutorImpl::markAsKilled(Status killStatus) {
@@ -31,7 +31,9 @@
 
 #include <boost/optional.hpp>
 #include <queue>
+#include <vector>
 
+#include "mongo/db/exec/working_set.h"
 #include "mongo/db/query/plan_executor.h"
 
 namespace mongo {
@@ -155,6 +157,19 @@ private:
      */
     ExecState _getNextImpl(Snapshotted<Document>* objOut, RecordId* dlOut);
 
+    /**
+     * Hands the result in working set member 'id' to the caller through 'objOut' and 'dlOut',
+     * either of which may be null, and frees the member. Returns false if the member lacks the
+     * data the caller asked for.
+     */
+    bool _extractResult(WorkingSetID id, Snapshotted<Document>* objOut, RecordId* dlOut);
+
+    /**
+     * Moves the results of the last batch which have not been returned yet out of the working set
+     * and into '_savedBatch', so that no WorkingSetID outlives a call to saveState().
+     */
+    void _saveBatchedResults();
+
     // The OperationContext that we're executing within. This can be updated if necessary by using
     // detachFromOperationContext() and reattachToOperationContext().
     OperationContext* _opCtx;
@@ -189,6 +204,19 @@ private:
     // stages.
     std::queue<Document> _stash;
 
+    // Results of the last call to PlanStage::workBatch() on '_root' which have not been returned
+    // yet, starting at '_batchPos'. These are consumed before the plan is worked again.
+    std::vector<WorkingSetID> _batch;
+    size_t _batchPos = 0;
+
+    // What was left of '_batch' when the plan was last saved. These are returned before '_batch'
+    // is refilled.
+    struct SavedResult {
+        boost::optional<Snapshotted<Document>> doc;
+        boost::optional<RecordId> recordId;
+    };
+    std::queue<SavedResult> _savedBatch;
+
     // The output document that is used by getNext BSON API. This allows us to avoid constantly
     // allocating and freeing DocumentStorage.
     Document _docOutput;
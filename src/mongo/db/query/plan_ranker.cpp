@@ -68,12 +68,6 @@ using std::vector;
 StatusWith<std::unique_ptr<PlanRankingDecision>> PlanRanker::pickBestPlan(
     const vector<CandidatePlan>& candidates) {
     invariant(!candidates.empty());
-    // A plan that hits EOF is automatically scored above
-    // its peers. If multiple plans hit EOF during the same
-    // set of round-robin calls to work(), then all such plans
-    // receive the bonus.
-    double eofBonus = 1.0;
-
     // Each plan will have a stat tree.
     std::vector<std::unique_ptr<PlanStageStats>> statTrees;
 
@@ -85,6 +79,21 @@ StatusWith<std::unique_ptr<PlanRankingDecision>> PlanRanker::pickBestPlan(
         statTrees.push_back(candidates[i].root->getStats());
     }
 
+    return pickBestPlan(candidates, std::move(statTrees));
+}
+
+// static
+StatusWith<std::unique_ptr<PlanRankingDecision>> PlanRanker::pickBestPlan(
+    const vector<CandidatePlan>& candidates,
+    std::vector<std::unique_ptr<PlanStageStats>> statTrees) {
+    invariant(!candidates.empty());
+    invariant(statTrees.size() == candidates.size());
+    // A plan that hits EOF is automatically scored above
+    // its peers. If multiple plans hit EOF during the same
+    // set of round-robin calls to work(), then all such plans
+    // receive the bonus.
+    double eofBonus = 1.0;
+
     // Holds (score, candidateInndex).
     // Used to derive scores and candidate ordering.
     vector<std::pair<double, size_t>> scoresAndCandidateindices;
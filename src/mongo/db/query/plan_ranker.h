@@ -60,6 +60,15 @@ public:
     static StatusWith<std::unique_ptr<PlanRankingDecision>> pickBestPlan(
         const std::vector<CandidatePlan>& candidates);
 
+    /**
+     * As above, but ranks 'candidates' using the already collected 'statTrees' rather than the
+     * stats of each candidate's root stage. 'statTrees' must have one entry per candidate, in the
+     * same order. Used when the trial period ran the candidates outside of their own trees.
+     */
+    static StatusWith<std::unique_ptr<PlanRankingDecision>> pickBestPlan(
+        const std::vector<CandidatePlan>& candidates,
+        std::vector<std::unique_ptr<PlanStageStats>> statTrees);
+
     /**
      * Assign the stats tree a 'goodness' score. The higher the score, the better
      * the plan. The exact value isn't meaningful except for imposing a ranking.
@@ -60,12 +60,93 @@
 #include "mongo/db/exec/text.h"
 #include "mongo/db/index/fts_access_method.h"
 #include "mongo/db/matcher/extensions_callback_real.h"
+#include "mongo/db/pipeline/dependencies.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/s/collection_sharding_state.h"
 #include "mongo/db/storage/oplog_hack.h"
 #include "mongo/util/log.h"
 
 namespace mongo {
 
+namespace {
+
+/**
+ * Adds the top-level field of each path in 'deps' to 'fields'. Returns false if 'deps' needs the
+ * whole document.
+ */
+bool addTopLevelFields(const DepsTracker& deps, StringSet* fields) {
+    if (deps.needWholeDocument) {
+        return false;
+    }
+    for (auto&& path : deps.fields) {
+        fields->insert(FieldRef(path).getPart(0).toString());
+    }
+    return true;
+}
+
+/**
+ * Adds to 'fields' the top-level fields of every index key pattern below 'node'. Returns false if
+ * an index which can't be checked against a partial document is involved.
+ */
+bool addIndexKeyFields(const QuerySolutionNode* node, StringSet* fields) {
+    if (STAGE_IXSCAN == node->getType()) {
+        const auto& index = static_cast<const IndexScanNode*>(node)->index;
+        if (index.type != INDEX_BTREE) {
+            return false;
+        }
+        for (auto&& elem : index.keyPattern) {
+            fields->insert(FieldRef(elem.fieldNameStringData()).getPart(0).toString());
+        }
+    }
+    for (auto&& child : node->children) {
+        if (!addIndexKeyFields(child, fields)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * When 'childStage' is a COLLSCAN or FETCH directly below the inclusion projection of 'cq', asks
+ * it to read only the fields which the projection and the child's own filter depend on, so that
+ * wide documents are never materialized in full.
+ */
+void pushProjectedFieldsToStorage(const CanonicalQuery& cq,
+                                  const QuerySolutionNode* child,
+                                  PlanStage* childStage) {
+    const auto childType = child->getType();
+    if (!internalQueryPushProjectedFieldsToStorage.load() ||
+        (STAGE_COLLSCAN != childType && STAGE_FETCH != childType)) {
+        return;
+    }
+
+    const auto* proj = cq.getProj();
+    if (!proj || !proj->isInclusionOnly()) {
+        return;
+    }
+
+    DepsTracker deps;
+    for (auto&& path : proj->getRequiredFields()) {
+        deps.fields.insert(path);
+    }
+    if (child->filter) {
+        child->filter->addDependencies(&deps);
+    }
+
+    StringSet fields{"_id"};
+    if (!addTopLevelFields(deps, &fields)) {
+        return;
+    }
+
+    if (STAGE_COLLSCAN == childType) {
+        static_cast<CollectionScan*>(childStage)->setProjectedFields(std::move(fields));
+    } else if (addIndexKeyFields(child, &fields)) {
+        static_cast<FetchStage*>(childStage)->setProjectedFields(std::move(fields));
+    }
+}
+
+}  // namespace
+
 // Returns a non-null pointer to the root of a plan tree, or a non-OK status if the PlanStage tree
 // could not be constructed.
 std::unique_ptr<PlanStage> buildStages(OperationContext* opCtx,
@@ -150,6 +231,7 @@ std::unique_ptr<PlanStage> buildStages(OperationContext* opCtx,
         case STAGE_PROJECTION_DEFAULT: {
             auto pn = static_cast<const ProjectionNodeDefault*>(root);
             auto childStage = buildStages(opCtx, collection, cq, qsol, pn->children[0], ws);
+            pushProjectedFieldsToStorage(cq, pn->children[0], childStage.get());
             return std::make_unique<ProjectionStageDefault>(cq.getExpCtx(),
                                                             cq.getQueryRequest().getProj(),
                                                             cq.getProj(),
@@ -169,6 +251,7 @@ std::unique_ptr<PlanStage> buildStages(OperationContext* opCtx,
         case STAGE_PROJECTION_SIMPLE: {
             auto pn = static_cast<const ProjectionNodeSimple*>(root);
             auto childStage = buildStages(opCtx, collection, cq, qsol, pn->children[0], ws);
+            pushProjectedFieldsToStorage(cq, pn->children[0], childStage.get());
             return std::make_unique<ProjectionStageSimple>(cq.getExpCtx(),
                                                            cq.getQueryRequest().getProj(),
                                                            cq.getProj(),
@@ -31,6 +31,8 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
+
 #include "mongo/base/string_data.h"
 #include "mongo/db/commands/list_collections_filter.h"
 #include "mongo/db/repl/collection_bulk_loader.h"
@@ -38,11 +40,21 @@
 #include "mongo/db/repl/database_cloner_gen.h"
 #include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/wire_version.h"
+#include "mongo/rpc/get_status_from_command_result.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/util/assert_util.h"
+#include "mongo/util/concurrency/thread_name.h"
 #include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace repl {
+namespace {
+
+// Range queries stop fetching while this many bytes of documents are waiting to be inserted.
+constexpr size_t kMaxBufferedBytesForRangeQueries = 64 * 1024 * 1024;
+
+}  // namespace
 
 // Failpoint which causes initial sync to hang when it has cloned 'numDocsToClone' documents to
 // collection 'namespace'.
@@ -67,6 +79,7 @@ CollectionCloner::CollectionCloner(const NamespaceString& sourceNss,
       _countStage("count", this, &CollectionCloner::countStage),
       _listIndexesStage("listIndexes", this, &CollectionCloner::listIndexesStage),
       _createCollectionStage("createCollection", this, &CollectionCloner::createCollectionStage),
+      _partitionStage("partition", this, &CollectionCloner::partitionStage),
       _queryStage("query", this, &CollectionCloner::queryStage),
       _progressMeter(1U,  // total will be replaced with count command result.
                      kProgressMeterSecondsBetween,
@@ -87,6 +100,14 @@ CollectionCloner::CollectionCloner(const NamespaceString& sourceNss,
           _dbWorkTaskRunner.schedule(std::move(task));
           return executor::TaskExecutor::CallbackHandle();
       }),
+      _createClientFn([this] {
+          auto client = std::make_unique<DBClientConnection>();
+          uassertStatusOK(client->connect(getSource(), StringData()));
+          uassertStatusOK(replAuthenticate(client.get())
+                              .withContext(str::stream()
+                                           << "Failed to authenticate to " << getSource()));
+          return client;
+      }),
       _dbWorkTaskRunner(dbPool) {
     invariant(sourceNss.isValid());
     invariant(collectionOptions.uuid);
@@ -98,7 +119,8 @@ CollectionCloner::CollectionCloner(const NamespaceString& sourceNss,
 }
 
 BaseCloner::ClonerStages CollectionCloner::getStages() {
-    return {&_countStage, &_listIndexesStage, &_createCollectionStage, &_queryStage};
+    return {
+        &_countStage, &_listIndexesStage, &_createCollectionStage, &_partitionStage, &_queryStage};
 }
 
 
@@ -182,10 +204,78 @@ BaseCloner::AfterStageBehavior CollectionCloner::createCollectionStage() {
     return kContinueNormally;
 }
 
+BaseCloner::AfterStageBehavior CollectionCloner::partitionStage() {
+    // Ranges are bounds on the _id index, so there must be one and, without a collation, its keys
+    // compare like the _id values themselves.  Like the single query, range queries are only
+    // resumed after errors on sync sources that support it.  Capped collections must be inserted
+    // in their natural order.
+    const long long parallelism = collectionClonerParallelism.load();
+    if (parallelism <= 1 || !_resumeSupported || _collectionOptions.capped ||
+        _idIndexSpec.isEmpty() || !_collectionOptions.collation.isEmpty()) {
+        return kContinueNormally;
+    }
+
+    const auto dbName = _sourceNss.db().toString();
+    BSONObj collStats;
+    if (!getClient()->runCommand(dbName, BSON("collStats" << _sourceNss.coll()), collStats)) {
+        log() << "Copying " << _sourceNss << " with a single query because collStats failed: "
+              << getStatusFromCommandResult(collStats);
+        return kContinueNormally;
+    }
+    const long long size = collStats["size"].safeNumberLong();
+    const long long numRanges =
+        std::min(parallelism, size / collectionClonerMinBytesPerStream.load());
+    if (numRanges <= 1) {
+        return kContinueNormally;
+    }
+
+    // splitVector splits at half of maxChunkSizeBytes.
+    BSONObj splitVector;
+    if (!getClient()->runCommand(dbName,
+                                 BSON("splitVector" << _sourceNss.ns() << "keyPattern"
+                                                    << BSON("_id" << 1) << "maxChunkSizeBytes"
+                                                    << 2 * (size / numRanges) << "maxSplitPoints"
+                                                    << numRanges - 1),
+                                 splitVector)) {
+        log() << "Copying " << _sourceNss << " with a single query because splitVector failed: "
+              << getStatusFromCommandResult(splitVector);
+        return kContinueNormally;
+    }
+
+    std::vector<Stats::StreamStats> streams;
+    BSONObj min;
+    for (auto&& splitKey : splitVector["splitKeys"].Array()) {
+        streams.emplace_back();
+        streams.back().min = min;
+        streams.back().max = splitKey.Obj().getOwned();
+        min = streams.back().max;
+    }
+    if (streams.empty()) {
+        return kContinueNormally;
+    }
+    streams.emplace_back();
+    streams.back().min = min;
+
+    log() << "Copying " << _sourceNss << " (" << size << " bytes) with " << streams.size()
+          << " concurrent queries over _id ranges";
+    stdx::lock_guard<Latch> lk(_mutex);
+    _stats.streams = std::move(streams);
+    return kContinueNormally;
+}
+
 BaseCloner::AfterStageBehavior CollectionCloner::queryStage() {
     // Attempt to clean up cursor from the last retry (if applicable).
     killOldQueryCursor();
-    runQuery();
+    bool useRangeQueries;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        useRangeQueries = !_stats.streams.empty();
+    }
+    if (useRangeQueries) {
+        runRangeQueries();
+    } else {
+        runQuery();
+    }
     waitForDatabaseWorkToComplete();
     // We want to free the _collLoader regardless of whether the commit succeeds.
     std::unique_ptr<CollectionBulkLoader> loader = std::move(_collLoader);
@@ -261,18 +351,205 @@ void CollectionCloner::runQuery() {
     }
 }
 
-void CollectionCloner::handleNextBatch(DBClientCursorBatchIterator& iter) {
+void CollectionCloner::runRangeQueries() {
+    std::vector<size_t> unfinished;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _stopRangeQueries = false;
+        _rangeCursorIds.assign(_stats.streams.size(), -1);
+        _rangeClients.assign(_stats.streams.size(), nullptr);
+        for (size_t i = 0; i < _stats.streams.size(); ++i) {
+            if (!_stats.streams[i].done) {
+                unfinished.push_back(i);
+            }
+        }
+        _activeRangeQueries = unfinished.size();
+    }
+
+    Status firstError = Status::OK();  // Guarded by _mutex.
+    std::vector<stdx::thread> threads;
+    for (auto streamIndex : unfinished) {
+        threads.emplace_back([this, streamIndex, &firstError] {
+            setThreadName(str::stream() << "CollectionClonerRange-" << streamIndex);
+            try {
+                auto client = _createClientFn();
+                {
+                    stdx::lock_guard<Latch> lk(_mutex);
+                    if (_stopRangeQueries) {
+                        client->shutdownAndDisallowReconnect();
+                    }
+                    _rangeClients[streamIndex] = client.get();
+                }
+                ON_BLOCK_EXIT([&] {
+                    stdx::lock_guard<Latch> lk(_mutex);
+                    _rangeClients[streamIndex] = nullptr;
+                });
+                runRangeQuery(streamIndex, client.get());
+            } catch (...) {
+                auto status = exceptionToStatus();
+                stdx::lock_guard<Latch> lk(_mutex);
+                if (!_stopRangeQueries) {
+                    LOG(1) << "Query over _id range " << streamIndex << " of " << _sourceNss
+                           << " failed: " << status;
+                    firstError = status;
+                    _stopRangeQueries = true;
+                    _documentsInserted.notify_all();
+                }
+            }
+
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (--_activeRangeQueries == 0) {
+                _rangeQueryFinished.notify_all();
+            }
+        });
+    }
+
+    {
+        // A range query blocked on the network would not notice that initial sync is shutting
+        // down, or that another range failed, until its connection is closed. InitialSyncer only
+        // shuts down the main connection, so the range connections are shut down from here.
+        stdx::unique_lock<Latch> lk(_mutex);
+        bool clientsShutDown = false;
+        while (_activeRangeQueries > 0) {
+            _rangeQueryFinished.wait_for(lk, Seconds(1).toSystemDuration());
+            bool stop = _stopRangeQueries;
+            if (!stop) {
+                lk.unlock();
+                stop = mustExit();
+                lk.lock();
+            }
+            if (stop && !clientsShutDown) {
+                _stopRangeQueries = true;
+                _documentsInserted.notify_all();
+                for (auto client : _rangeClients) {
+                    if (client) {
+                        client->shutdownAndDisallowReconnect();
+                    }
+                }
+                clientsShutDown = true;
+            }
+        }
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    // The query stage is retried on transient errors, resuming each unfinished range after the
+    // last document it received.
+    uassertStatusOK(firstError);
+}
+
+void CollectionCloner::runRangeQuery(size_t streamIndex, DBClientConnection* client) {
+    BSONObj min;
+    BSONObj max;
+    BSONObj resumeAfter;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        const auto& stream = _stats.streams[streamIndex];
+        resumeAfter = stream.lastId;
+        min = resumeAfter.isEmpty() ? stream.min : resumeAfter;
+        max = stream.max;
+    }
+
+    Query query = QUERY("query" << BSONObj() << "$readOnce" << true);
+    query.hint(BSON("_id" << 1));
+    if (!min.isEmpty()) {
+        query.minKey(min);
+    }
+    if (!max.isEmpty()) {
+        query.maxKey(max);
+    }
+
+    // Unlike the single query, these cursors are allowed to time out: a range query resumes
+    // after its last document, so losing the cursor costs no more than a network error does.
+    client->query(
+        [&](DBClientCursorBatchIterator& iter) {
+            handleNextRangeBatch(streamIndex, iter, &resumeAfter);
+        },
+        _sourceDbAndUuid,
+        query,
+        nullptr /* fieldsToReturn */,
+        QueryOption_SlaveOk | (collectionClonerUsesExhaust ? QueryOption_Exhaust : 0),
+        _collectionClonerBatchSize);
+
+    stdx::lock_guard<Latch> lk(_mutex);
+    _stats.streams[streamIndex].done = true;
+    _rangeCursorIds[streamIndex] = -1;
+}
+
+void CollectionCloner::handleNextRangeBatch(size_t streamIndex,
+                                            DBClientCursorBatchIterator& iter,
+                                            BSONObj* resumeAfter) {
+    checkInitialSyncNotFailed();
+
+    bool scheduleInsert;
     {
-        stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
-        if (!getSharedData()->getInitialSyncStatus(lk).isOK()) {
-            std::string message = str::stream()
-                << "Collection cloning cancelled due to initial sync failure: "
-                << getSharedData()->getInitialSyncStatus(lk).toString();
-            log() << message;
-            uasserted(ErrorCodes::CallbackCanceled, message);
+        stdx::unique_lock<Latch> lk(_mutex);
+        while (!_stopRangeQueries &&
+               _documentsToInsertBytes >= kMaxBufferedBytesForRangeQueries) {
+            _documentsInserted.wait_for(lk, Seconds(1).toSystemDuration());
+            lk.unlock();
+            checkInitialSyncNotFailed();
+            lk.lock();
         }
+        uassert(ErrorCodes::CallbackCanceled,
+                "Collection cloning cancelled because another range query failed",
+                !_stopRangeQueries);
+
+        // Stored so that a retry can kill the cursor if this query fails before it is exhausted.
+        _rangeCursorIds[streamIndex] = iter.getCursorId();
+        auto& stream = _stats.streams[streamIndex];
+        ++stream.receivedBatches;
+        ++_stats.receivedBatches;
+        // A new insert must be scheduled unless one is already waiting for these documents.
+        scheduleInsert = _documentsToInsert.empty();
+        BSONObj lastDoc;
+        while (iter.moreInCurrentBatch()) {
+            auto doc = iter.nextSafe();
+            // A resumed query starts at, and so returns again, the last document received.
+            if (!resumeAfter->isEmpty()) {
+                bool received = doc["_id"].woCompare(resumeAfter->firstElement(), false) == 0;
+                *resumeAfter = BSONObj();
+                if (received) {
+                    continue;
+                }
+            }
+            ++stream.documentsFetched;
+            _documentsToInsertBytes += doc.objsize();
+            lastDoc = doc;
+            _documentsToInsert.emplace_back(std::move(doc));
+        }
+        if (!lastDoc.isEmpty()) {
+            stream.lastId = lastDoc["_id"].wrap();
+        }
+        scheduleInsert = scheduleInsert && !_documentsToInsert.empty();
     }
 
+    if (scheduleInsert) {
+        uassertStatusOK(
+            _scheduleDbWorkFn([=](const executor::TaskExecutor::CallbackArgs& cbd) {
+                insertDocumentsCallback(cbd);
+            }).getStatus().withContext(str::stream() << "Error cloning collection '"
+                                                     << _sourceNss.ns() << "'"));
+    }
+
+    hangAfterHandlingBatchResponseIfNeeded();
+}
+
+void CollectionCloner::checkInitialSyncNotFailed() {
+    stdx::lock_guard<InitialSyncSharedData> lk(*getSharedData());
+    if (!getSharedData()->getInitialSyncStatus(lk).isOK()) {
+        std::string message = str::stream()
+            << "Collection cloning cancelled due to initial sync failure: "
+            << getSharedData()->getInitialSyncStatus(lk).toString();
+        log() << message;
+        uasserted(ErrorCodes::CallbackCanceled, message);
+    }
+}
+
+void CollectionCloner::handleNextBatch(DBClientCursorBatchIterator& iter) {
+    checkInitialSyncNotFailed();
+
     // If this is 'true', it means that something happened to our remote cursor for a reason other
     // than the collection being dropped, all while we were running a non-resumable (4.2) clone.
     // We must abort initial sync in that case.
@@ -311,6 +588,10 @@ void CollectionCloner::handleNextBatch(DBClientCursorBatchIterator& iter) {
         _resumeToken = iter.getPostBatchResumeToken();
     }
 
+    hangAfterHandlingBatchResponseIfNeeded();
+}
+
+void CollectionCloner::hangAfterHandlingBatchResponseIfNeeded() {
     initialSyncHangCollectionClonerAfterHandlingBatchResponse.executeIf(
         [&](const BSONObj&) {
             while (MONGO_unlikely(
@@ -333,21 +614,26 @@ void CollectionCloner::insertDocumentsCallback(const executor::TaskExecutor::Cal
     uassertStatusOK(cbd.status);
 
     {
-        stdx::lock_guard<Latch> lk(_mutex);
+        // The insert must be done within _insertMutex, because CollectionBulkLoader is not
+        // thread safe.  _mutex is released first so that range queries can keep buffering
+        // documents while these are inserted.
+        stdx::lock_guard<Latch> insertLk(_insertMutex);
         std::vector<BSONObj> docs;
-        if (_documentsToInsert.size() == 0) {
-            warning() << "insertDocumentsCallback, but no documents to insert for ns:"
-                      << _sourceNss;
-            return;
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (_documentsToInsert.size() == 0) {
+                warning() << "insertDocumentsCallback, but no documents to insert for ns:"
+                          << _sourceNss;
+                return;
+            }
+            _documentsToInsert.swap(docs);
+            _documentsToInsertBytes = 0;
+            _documentsInserted.notify_all();
+            _stats.documentsCopied += docs.size();
+            ++_stats.fetchedBatches;
+            _progressMeter.hit(int(docs.size()));
         }
-        _documentsToInsert.swap(docs);
-        _stats.documentsCopied += docs.size();
-        ++_stats.fetchedBatches;
-        _progressMeter.hit(int(docs.size()));
         invariant(_collLoader);
-
-        // The insert must be done within the lock, because CollectionBulkLoader is not
-        // thread safe.
         uassertStatusOK(_collLoader->insertDocuments(docs.cbegin(), docs.cend()));
     }
 
@@ -376,17 +662,35 @@ void CollectionCloner::waitForDatabaseWorkToComplete() {
 }
 
 void CollectionCloner::killOldQueryCursor() {
+    std::vector<long long> ids;
+    if (_remoteCursorId != -1) {
+        ids.push_back(_remoteCursorId);
+    }
+    {
+        // The connections of the range queries are gone, so their cursors are killed over ours.
+        stdx::lock_guard<Latch> lk(_mutex);
+        for (auto& id : _rangeCursorIds) {
+            if (id != -1) {
+                ids.push_back(id);
+            }
+            id = -1;
+        }
+    }
+
     // No cursor stored. Do nothing.
-    if (_remoteCursorId == -1) {
+    if (ids.empty()) {
         return;
     }
 
     BSONObj infoObj;
     auto nss = _sourceNss;
-    auto id = _remoteCursorId;
 
-    auto cmdObj = BSON("killCursors" << nss.coll() << "cursors" << BSON_ARRAY(id));
-    LOG(1) << "Attempting to kill old remote cursor with id: " << id;
+    BSONArrayBuilder idsBuilder;
+    for (auto id : ids) {
+        idsBuilder.append(id);
+    }
+    auto cmdObj = BSON("killCursors" << nss.coll() << "cursors" << idsBuilder.arr());
+    LOG(1) << "Attempting to kill old remote cursors with ids: " << cmdObj["cursors"];
     try {
         getClient()->runCommand(nss.db().toString(), cmdObj, infoObj);
     } catch (...) {
@@ -442,6 +746,15 @@ void CollectionCloner::Stats::append(BSONObjBuilder* builder) const {
         }
     }
     builder->appendNumber("receivedBatches", receivedBatches);
+    if (!streams.empty()) {
+        BSONArrayBuilder streamsBuilder(builder->subarrayStart("streams"));
+        for (auto&& stream : streams) {
+            BSONObjBuilder streamBuilder(streamsBuilder.subobjStart());
+            streamBuilder.appendNumber("documentsFetched", stream.documentsFetched);
+            streamBuilder.appendNumber("receivedBatches", stream.receivedBatches);
+            streamBuilder.append("done", stream.done);
+        }
+    }
 }
 
 }  // namespace repl
@@ -29,11 +29,13 @@
 
 #pragma once
 
+#include <functional>
 #include <memory>
 #include <vector>
 
 #include "mongo/db/repl/base_cloner.h"
 #include "mongo/db/repl/task_runner.h"
+#include "mongo/stdx/condition_variable.h"
 #include "mongo/util/progress_meter.h"
 
 namespace mongo {
@@ -59,6 +61,18 @@ public:
         size_t fetchedBatches{0};  // This is actually inserted batches.
         size_t receivedBatches{0};
 
+        // One entry per concurrent query when the collection is split into _id ranges; empty
+        // when the collection is copied by a single query.
+        struct StreamStats {
+            BSONObj min;     // Inclusive lower bound, as {_id: <value>}; empty for the first range.
+            BSONObj max;     // Exclusive upper bound, as {_id: <value>}; empty for the last range.
+            BSONObj lastId;  // The last document received, as {_id: <value>}; used to resume.
+            size_t documentsFetched{0};
+            size_t receivedBatches{0};
+            bool done{false};
+        };
+        std::vector<StreamStats> streams;
+
         std::string toString() const;
         BSONObj toBSON() const;
         void append(BSONObjBuilder* builder) const;
@@ -72,6 +86,12 @@ public:
     using ScheduleDbWorkFn = unique_function<StatusWith<executor::TaskExecutor::CallbackHandle>(
         executor::TaskExecutor::CallbackFn)>;
 
+    /**
+     * Type of function to create the additional connections to the sync source used when the
+     * collection is copied by several concurrent queries.
+     */
+    using CreateClientFn = std::function<std::unique_ptr<DBClientConnection>()>;
+
     CollectionCloner(const NamespaceString& ns,
                      const CollectionOptions& collectionOptions,
                      InitialSyncSharedData* sharedData,
@@ -117,6 +137,15 @@ public:
         _scheduleDbWorkFn = std::move(scheduleDbWorkFn);
     }
 
+    /**
+     * Overrides how the connections for concurrent range queries are created.
+     *
+     * For testing only.
+     */
+    void setCreateClientFn_forTest(CreateClientFn createClientFn) {
+        _createClientFn = std::move(createClientFn);
+    }
+
 protected:
     ClonerStages getStages() final;
 
@@ -191,6 +220,13 @@ private:
      */
     AfterStageBehavior createCollectionStage();
 
+    /**
+     * Stage function that decides whether the collection is copied by several concurrent queries
+     * and, if so, splits it into _id ranges using the collStats and splitVector commands on the
+     * source.  Any failure other than a transient one falls back to a single query.
+     */
+    AfterStageBehavior partitionStage();
+
     /**
      * Stage function that executes a query to retrieve all documents in the collection.  For each
      * batch returned by the upstream node, handleNextBatch will be called with the data.  This
@@ -219,8 +255,39 @@ private:
     void runQuery();
 
     /**
-     * Attempts to clean up the cursor on the upstream node. This is called any time we
-     * receive a transient error during the query stage.
+     * Copies every _id range not yet finished by a query of its own, each on a separate thread
+     * and connection, resuming after the last document received for the range.  Throws the first
+     * error any range encountered once all of them have stopped.
+     */
+    void runRangeQueries();
+
+    /**
+     * Runs the query for the _id range 'streamIndex' over 'client'.
+     */
+    void runRangeQuery(size_t streamIndex, DBClientConnection* client);
+
+    /**
+     * Like handleNextBatch, for a batch of the query over the _id range 'streamIndex'.  Skips the
+     * document whose _id is 'resumeAfter' if it starts the batch, then clears 'resumeAfter'.
+     */
+    void handleNextRangeBatch(size_t streamIndex,
+                              DBClientCursorBatchIterator& iter,
+                              BSONObj* resumeAfter);
+
+    /**
+     * Throws if initial sync has failed in the meantime.
+     */
+    void checkInitialSyncNotFailed();
+
+    /**
+     * Blocks while the initialSyncHangCollectionClonerAfterHandlingBatchResponse fail point is
+     * enabled for this collection.
+     */
+    void hangAfterHandlingBatchResponseIfNeeded();
+
+    /**
+     * Attempts to clean up the cursor on the upstream node, and those of any range queries. This
+     * is called any time we receive a transient error during the query stage.
      */
     void killOldQueryCursor();
 
@@ -253,16 +320,37 @@ private:
     CollectionClonerStage _countStage;             // (R)
     CollectionClonerStage _listIndexesStage;       // (R)
     CollectionClonerStage _createCollectionStage;  // (R)
+    CollectionClonerStage _partitionStage;         // (R)
     CollectionClonerQueryStage _queryStage;        // (R)
 
     ProgressMeter _progressMeter;                       // (X) progress meter for this instance.
     std::vector<BSONObj> _indexSpecs;                   // (X) Except for _id_
     BSONObj _idIndexSpec;                               // (X)
-    std::unique_ptr<CollectionBulkLoader> _collLoader;  // (X)
+    std::unique_ptr<CollectionBulkLoader> _collLoader;  // (X) Inserts under _insertMutex.
+    // Serializes inserts into _collLoader.  Acquired before _mutex.
+    Mutex _insertMutex = MONGO_MAKE_LATCH("CollectionCloner::_insertMutex");  // (S)
     //  Function for scheduling database work using the executor.
     ScheduleDbWorkFn _scheduleDbWorkFn;  // (R)
+    // Function for creating the connections used by concurrent range queries.
+    CreateClientFn _createClientFn;  // (R)
     // Documents read from source to insert.
     std::vector<BSONObj> _documentsToInsert;  // (M)
+    // Total size of _documentsToInsert.  Range queries wait while this is too large.
+    size_t _documentsToInsertBytes = 0;  // (M)
+    // Notified when _documentsToInsert has been handed to the bulk loader.
+    stdx::condition_variable _documentsInserted;  // (S)
+    // Set when a range query fails, so that the other range queries stop too.
+    bool _stopRangeQueries = false;  // (M)
+    // The cursorIds of the range queries' remote cursors, indexed like _stats.streams; -1 when a
+    // range has no cursor left to kill.
+    std::vector<long long> _rangeCursorIds;  // (M)
+    // The connections of the running range queries, indexed like _stats.streams, so that they
+    // can be shut down from the thread waiting for the queries; nullptr for the others.
+    std::vector<DBClientConnection*> _rangeClients;  // (M)
+    // Number of range query threads which have not yet finished.
+    size_t _activeRangeQueries = 0;  // (M)
+    // Notified when a range query thread finishes.
+    stdx::condition_variable _rangeQueryFinished;  // (S)
     Stats _stats;                             // (M)
     // Putting _dbWorkTaskRunner last ensures anything the database work threads depend on,
     // like _documentsToInsert, is destroyed after those threads exit.
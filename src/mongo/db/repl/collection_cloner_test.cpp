@@ -29,17 +29,21 @@
 
 #include "mongo/platform/basic.h"
 
+#include <algorithm>
 #include <vector>
 
 #include "mongo/bson/bsonmisc.h"
 #include "mongo/db/repl/cloner_test_fixture.h"
 #include "mongo/db/repl/collection_cloner.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/storage_interface.h"
 #include "mongo/db/repl/storage_interface_mock.h"
 #include "mongo/db/service_context_test_fixture.h"
 #include "mongo/dbtests/mock/mock_dbclient_connection.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/concurrency/thread_pool.h"
+#include "mongo/util/scopeguard.h"
 
 namespace mongo {
 namespace repl {
@@ -54,6 +58,46 @@ public:
     }
 };
 
+// A connection for range query tests that, the first time it is asked for the range starting at
+// 'failingMin', delivers one batch of it and then fails as if the sync source went away.
+class FailingRangeQueryConnection final : public MockDBClientConnection {
+public:
+    FailingRangeQueryConnection(MockRemoteDBServer* remoteServer,
+                                BSONObj failingMin,
+                                AtomicWord<bool>* failed)
+        : MockDBClientConnection(remoteServer), _failingMin(failingMin), _failed(failed) {}
+
+    using MockDBClientConnection::query;
+
+    unsigned long long query(std::function<void(DBClientCursorBatchIterator&)> f,
+                             const NamespaceStringOrUUID& nsOrUuid,
+                             Query query,
+                             const BSONObj* fieldsToReturn,
+                             int queryOptions,
+                             int batchSize) override {
+        auto min = query.obj["$min"];
+        if (!min.isABSONObj() || min.Obj().woCompare(_failingMin) != 0 || _failed->swap(true)) {
+            return MockDBClientConnection::query(
+                f, nsOrUuid, query, fieldsToReturn, queryOptions, batchSize);
+        }
+        int batches = 0;
+        return MockDBClientConnection::query(
+            [&](DBClientCursorBatchIterator& iter) {
+                uassert(ErrorCodes::HostUnreachable, "Range query failed for test", batches++ < 1);
+                f(iter);
+            },
+            nsOrUuid,
+            query,
+            fieldsToReturn,
+            queryOptions,
+            batchSize);
+    }
+
+private:
+    const BSONObj _failingMin;
+    AtomicWord<bool>* const _failed;
+};
+
 class CollectionClonerTest : public ClonerTestFixture {
 public:
     CollectionClonerTest() {}
@@ -97,6 +141,63 @@ protected:
                                                   _dbWorkThreadPool.get());
     }
 
+    /**
+     * Sets up a collection of 'numDocs' documents with _ids 0 to numDocs - 1, which the sync
+     * source splits into four ranges of equal size, and records the _id of every document the
+     * cloner inserts in _insertedIds.
+     */
+    void setUpRangeQueries(int numDocs) {
+        _mockServer->setCommandReply("count", createCountResponse(numDocs));
+        _mockServer->setCommandReply("listIndexes",
+                                     createCursorResponse(_nss.ns(), BSON_ARRAY(_idIndexSpec)));
+        _mockServer->setCommandReply(
+            "collStats", BSON("ok" << 1 << "size" << 4 * collectionClonerMinBytesPerStream.load()));
+        _mockServer->setCommandReply("splitVector",
+                                     BSON("ok" << 1 << "splitKeys"
+                                               << BSON_ARRAY(BSON("_id" << numDocs / 4)
+                                                             << BSON("_id" << numDocs / 2)
+                                                             << BSON("_id" << 3 * numDocs / 4))));
+        _mockServer->setCommandReply("killCursors", fromjson("{ok:1}"));
+        for (int i = 0; i < numDocs; ++i) {
+            _mockServer->insert(_nss.ns(), BSON("_id" << i));
+        }
+
+        _storageInterface.createCollectionForBulkFn =
+            [this](const NamespaceString& nss,
+                   const CollectionOptions& options,
+                   const BSONObj idIndexSpec,
+                   const std::vector<BSONObj>& nonIdIndexSpecs)
+            -> StatusWith<std::unique_ptr<CollectionBulkLoader>> {
+            auto localLoader = std::make_unique<CollectionBulkLoaderMock>(_collectionStats);
+            Status result = localLoader->init(nonIdIndexSpecs);
+            if (!result.isOK())
+                return result;
+
+            // Inserts are serialized on the database work thread.
+            localLoader->insertDocsFn = [this](const std::vector<BSONObj>::const_iterator begin,
+                                               const std::vector<BSONObj>::const_iterator end) {
+                for (auto it = begin; it != end; ++it) {
+                    _insertedIds.push_back((*it)["_id"].numberInt());
+                }
+                return Status::OK();
+            };
+            _loader = localLoader.get();
+
+            return std::unique_ptr<CollectionBulkLoader>(std::move(localLoader));
+        };
+    }
+
+    /**
+     * Asserts that every document set up by setUpRangeQueries() was inserted exactly once.
+     */
+    void assertEveryIdInsertedOnce(int numDocs) {
+        std::sort(_insertedIds.begin(), _insertedIds.end());
+        ASSERT_EQUALS(static_cast<size_t>(numDocs), _insertedIds.size());
+        for (int i = 0; i < numDocs; ++i) {
+            ASSERT_EQUALS(i, _insertedIds[i]);
+        }
+    }
+
     ProgressMeter& getProgressMeter(CollectionCloner* cloner) {
         return cloner->_progressMeter;
     }
@@ -110,6 +211,7 @@ protected:
     }
 
     std::shared_ptr<CollectionMockStats> _collectionStats;  // Used by the _loader.
+    std::vector<int> _insertedIds;  // Used by the _loader set up by setUpRangeQueries().
     StorageInterfaceMock::CreateCollectionForBulkFn _standardCreateCollectionFn;
     CollectionBulkLoaderMock* _loader = nullptr;  // Owned by CollectionCloner.
     CollectionOptions _options;
@@ -285,6 +387,148 @@ TEST_F(CollectionClonerTest, BeginCollectionFailed) {
     ASSERT_EQUALS(ErrorCodes::OperationFailed, cloner->run());
 }
 
+TEST_F(CollectionClonerTest, PartitionStageSplitsLargeCollectionIntoIdRanges) {
+    auto oldParallelism = collectionClonerParallelism.load();
+    collectionClonerParallelism.store(4);
+    ON_BLOCK_EXIT([&] { collectionClonerParallelism.store(oldParallelism); });
+
+    auto cloner = makeCollectionCloner();
+    cloner->setStopAfterStage_forTest("partition");
+    _mockServer->setCommandReply("count", createCountResponse(1000));
+    _mockServer->setCommandReply("listIndexes",
+                                 createCursorResponse(_nss.ns(), BSON_ARRAY(_idIndexSpec)));
+    _mockServer->setCommandReply(
+        "collStats", BSON("ok" << 1 << "size" << 4 * collectionClonerMinBytesPerStream.load()));
+    _mockServer->setCommandReply(
+        "splitVector",
+        BSON("ok" << 1 << "splitKeys"
+                  << BSON_ARRAY(BSON("_id" << 250) << BSON("_id" << 500) << BSON("_id" << 750))));
+    ASSERT_OK(cloner->run());
+
+    auto stats = cloner->getStats();
+    ASSERT_EQUALS(4u, stats.streams.size());
+    ASSERT_BSONOBJ_EQ(BSONObj(), stats.streams[0].min);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 250), stats.streams[0].max);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 250), stats.streams[1].min);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 500), stats.streams[1].max);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 750), stats.streams[3].min);
+    ASSERT_BSONOBJ_EQ(BSONObj(), stats.streams[3].max);
+    ASSERT_EQUALS(4, stats.toBSON()["streams"].Array().size());
+}
+
+TEST_F(CollectionClonerTest, PartitionStageUsesSingleQueryForSmallCollection) {
+    auto oldParallelism = collectionClonerParallelism.load();
+    collectionClonerParallelism.store(4);
+    ON_BLOCK_EXIT([&] { collectionClonerParallelism.store(oldParallelism); });
+
+    auto cloner = makeCollectionCloner();
+    cloner->setStopAfterStage_forTest("partition");
+    _mockServer->setCommandReply("count", createCountResponse(10));
+    _mockServer->setCommandReply("listIndexes",
+                                 createCursorResponse(_nss.ns(), BSON_ARRAY(_idIndexSpec)));
+    _mockServer->setCommandReply(
+        "collStats", BSON("ok" << 1 << "size" << collectionClonerMinBytesPerStream.load()));
+    ASSERT_OK(cloner->run());
+
+    auto stats = cloner->getStats();
+    ASSERT_TRUE(stats.streams.empty());
+    ASSERT_FALSE(stats.toBSON().hasField("streams"));
+}
+
+TEST_F(CollectionClonerTest, RangeQueriesCopyEachRangeOnItsOwnConnection) {
+    auto oldParallelism = collectionClonerParallelism.load();
+    collectionClonerParallelism.store(4);
+    ON_BLOCK_EXIT([&] { collectionClonerParallelism.store(oldParallelism); });
+
+    setUpRangeQueries(100);
+    auto cloner = makeCollectionCloner();
+    cloner->setBatchSize_forTest(5);
+    AtomicWord<int> clientsCreated{0};
+    cloner->setCreateClientFn_forTest([&] {
+        clientsCreated.fetchAndAdd(1);
+        return std::unique_ptr<DBClientConnection>(
+            std::make_unique<MockDBClientConnection>(_mockServer.get()));
+    });
+    ASSERT_OK(cloner->run());
+
+    ASSERT_EQUALS(4, clientsCreated.load());
+    ASSERT_TRUE(_collectionStats->commitCalled);
+    assertEveryIdInsertedOnce(100);
+    auto stats = cloner->getStats();
+    ASSERT_EQUALS(100u, stats.documentsCopied);
+    ASSERT_EQUALS(4u, stats.streams.size());
+    for (auto&& stream : stats.streams) {
+        ASSERT_TRUE(stream.done);
+        ASSERT_EQUALS(25u, stream.documentsFetched);
+        ASSERT_EQUALS(5u, stream.receivedBatches);
+    }
+}
+
+TEST_F(CollectionClonerTest, RangeQueryFailsMidRangeAndResumesAfterLastDocument) {
+    auto oldParallelism = collectionClonerParallelism.load();
+    collectionClonerParallelism.store(4);
+    ON_BLOCK_EXIT([&] { collectionClonerParallelism.store(oldParallelism); });
+
+    setUpRangeQueries(100);
+    auto cloner = makeCollectionCloner();
+    cloner->setBatchSize_forTest(5);
+    AtomicWord<bool> failed{false};
+    cloner->setCreateClientFn_forTest([&] {
+        return std::unique_ptr<DBClientConnection>(std::make_unique<FailingRangeQueryConnection>(
+            _mockServer.get(), BSON("_id" << 25), &failed));
+    });
+    ASSERT_OK(cloner->run());
+
+    // The second range failed after its first batch, and was retried after _id 29 rather than
+    // from its start. The ranges stopped by the failure resumed the same way.
+    ASSERT_TRUE(failed.load());
+    ASSERT_TRUE(_collectionStats->commitCalled);
+    assertEveryIdInsertedOnce(100);
+    auto stats = cloner->getStats();
+    ASSERT_EQUALS(100u, stats.documentsCopied);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 49), stats.streams[1].lastId);
+    for (auto&& stream : stats.streams) {
+        ASSERT_TRUE(stream.done);
+        ASSERT_EQUALS(25u, stream.documentsFetched);
+    }
+}
+
+TEST_F(CollectionClonerTest, RangeQueriesHangAfterHandlingBatchResponse) {
+    auto oldParallelism = collectionClonerParallelism.load();
+    collectionClonerParallelism.store(4);
+    ON_BLOCK_EXIT([&] { collectionClonerParallelism.store(oldParallelism); });
+
+    setUpRangeQueries(100);
+    auto cloner = makeCollectionCloner();
+    cloner->setBatchSize_forTest(5);
+    cloner->setCreateClientFn_forTest([&] {
+        return std::unique_ptr<DBClientConnection>(
+            std::make_unique<MockDBClientConnection>(_mockServer.get()));
+    });
+    auto afterBatchFailpoint =
+        globalFailPointRegistry().find("initialSyncHangCollectionClonerAfterHandlingBatchResponse");
+    auto timesEnteredAfterBatch = afterBatchFailpoint->setMode(FailPoint::alwaysOn, 0);
+
+    stdx::thread clonerThread([&] {
+        Client::initThread("ClonerRunner");
+        ASSERT_OK(cloner->run());
+    });
+
+    // Every range stops after handling its first batch.
+    afterBatchFailpoint->waitForTimesEntered(timesEnteredAfterBatch + 4);
+    auto stats = cloner->getStats();
+    ASSERT_EQUALS(4u, stats.streams.size());
+    for (auto&& stream : stats.streams) {
+        ASSERT_EQUALS(1u, stream.receivedBatches);
+    }
+
+    afterBatchFailpoint->setMode(FailPoint::off, 0);
+    clonerThread.join();
+
+    ASSERT_TRUE(_collectionStats->commitCalled);
+    assertEveryIdInsertedOnce(100);
+}
+
 TEST_F(CollectionClonerTest, InsertDocumentsSingleBatch) {
     // Set up data for preliminary stages
     _mockServer->setCommandReply("count", createCountResponse(2));
@@ -0,0 +1,320 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kReplicationInitialSync
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <boost/optional.hpp>
+#include <fstream>
+#include <vector>
+
+#include "mongo/bson/util/bson_extract.h"
+#include "mongo/db/client.h"
+#include "mongo/db/repl/file_copy_initial_syncer.h"
+#include "mongo/db/repl/repl_set_command.h"
+#include "mongo/db/service_context.h"
+#include "mongo/db/storage/backup_cursor_hooks.h"
+#include "mongo/db/storage/storage_engine.h"
+#include "mongo/db/storage/storage_options.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/log.h"
+#include "mongo/util/periodic_runner.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/str.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+namespace fs = boost::filesystem;
+
+// How long a backup opened for file copy initial sync may go without being read from before it
+// is closed. This bounds how long a syncing node that went away pins the backup's checkpoint and
+// oplog on this node.
+const Minutes kIdleBackupTimeout{5};
+
+// How often a periodic job looks for an idle backup to close.
+const Minutes kIdleBackupCheckInterval{1};
+
+/**
+ * The backup, if any, that a node doing file copy initial sync from this node is copying. The
+ * storage engine supports only one backup at a time.
+ */
+struct FileCopyBackupState {
+    struct OpenBackup {
+        UUID backupId;
+        // Keyed by file name relative to the dbpath.
+        StorageEngine::BackupInformation files;
+        Date_t lastUsed;
+    };
+
+    Mutex mutex = MONGO_MAKE_LATCH("FileCopyBackupState::mutex");
+    boost::optional<OpenBackup> backup;
+
+    // Set while a backup is being opened, outside of 'mutex', so that no other can open at once.
+    bool opening = false;
+
+    // Closes the backup once it has been idle for kIdleBackupTimeout. Started with the first
+    // backup.
+    boost::optional<PeriodicJobAnchor> idleBackupReaper;
+};
+
+const auto getFileCopyBackupState = ServiceContext::declareDecoration<FileCopyBackupState>();
+
+/**
+ * Closes the open backup if it has not been read from for kIdleBackupTimeout. Returns false if a
+ * backup is open and still in use.
+ */
+bool closeIdleBackup(OperationContext* opCtx, WithLock, FileCopyBackupState* state) {
+    if (!state->backup) {
+        return true;
+    }
+
+    auto serviceContext = opCtx->getServiceContext();
+    const auto now = serviceContext->getFastClockSource()->now();
+    if (now - state->backup->lastUsed < kIdleBackupTimeout) {
+        return false;
+    }
+
+    log() << "Closing backup " << state->backup->backupId
+          << " for file copy initial sync, which was last read from at "
+          << state->backup->lastUsed;
+    serviceContext->getStorageEngine()->endNonBlockingBackup(opCtx);
+    state->backup = boost::none;
+    return true;
+}
+
+/**
+ * Starts the periodic job which closes idle backups, unless it is already running.
+ */
+void startIdleBackupReaper(ServiceContext* serviceContext, WithLock, FileCopyBackupState* state) {
+    auto periodicRunner = serviceContext->getPeriodicRunner();
+    if (state->idleBackupReaper || !periodicRunner) {
+        return;
+    }
+
+    PeriodicRunner::PeriodicJob job(
+        "closeIdleFileCopyBackup",
+        [state](Client* client) {
+            auto opCtx = client->makeOperationContext();
+            stdx::lock_guard<Latch> lk(state->mutex);
+            closeIdleBackup(opCtx.get(), lk, state);
+        },
+        kIdleBackupCheckInterval);
+    state->idleBackupReaper.emplace(periodicRunner->makeJob(std::move(job)));
+    state->idleBackupReaper->start();
+}
+
+UUID extractBackupId(const BSONObj& cmdObj) {
+    return uassertStatusOK(UUID::parse(cmdObj["backupId"]));
+}
+
+/**
+ * Opens a backup of this node's data files and returns its id, checkpoint timestamp and files.
+ */
+class CmdFileCopyInitialSyncOpenBackup : public ReplSetCommand {
+public:
+    CmdFileCopyInitialSyncOpenBackup()
+        : ReplSetCommand(FileCopyInitialSyncer::kOpenBackupCommandName.rawData()) {}
+
+    std::string help() const override {
+        return "Internal command used by file copy initial sync to open a backup of this node's "
+               "data files.";
+    }
+
+    bool run(OperationContext* opCtx,
+             const std::string&,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        auto serviceContext = opCtx->getServiceContext();
+        auto storageEngine = serviceContext->getStorageEngine();
+        auto& state = getFileCopyBackupState(serviceContext);
+
+        {
+            stdx::lock_guard<Latch> lk(state.mutex);
+            uassert(ErrorCodes::ConflictingOperationInProgress,
+                    "Another node is already copying a backup of this node's data files",
+                    !state.opening && closeIdleBackup(opCtx, lk, &state));
+            state.opening = true;
+        }
+        auto openingGuard = makeGuard([&] {
+            stdx::lock_guard<Latch> lk(state.mutex);
+            state.opening = false;
+        });
+
+        auto backupCursorHooks = BackupCursorHooks::get(serviceContext);
+        uassert(ErrorCodes::ConflictingOperationInProgress,
+                "A backup cursor is already open on this node",
+                !backupCursorHooks->enabled() || !backupCursorHooks->isBackupCursorOpen());
+
+        // The backup pins the last checkpoint taken before it opens. Holding the checkpoint lock
+        // until the timestamp is read after opening it keeps another checkpoint from completing in
+        // between, so the timestamp reported is that of the checkpoint the backup holds. Waiting
+        // for it can take as long as a checkpoint does, so 'state.mutex' is not held meanwhile.
+        boost::optional<Timestamp> checkpointTimestamp;
+        StorageEngine::BackupInformation files;
+        {
+            auto checkpointLock = storageEngine->getCheckpointLock(opCtx);
+            files = uassertStatusOK(
+                storageEngine->beginNonBlockingBackup(opCtx, StorageEngine::BackupOptions()));
+            checkpointTimestamp = storageEngine->getLastStableRecoveryTimestamp();
+        }
+        auto endBackupGuard = makeGuard([&] { storageEngine->endNonBlockingBackup(opCtx); });
+
+        FileCopyBackupState::OpenBackup backup{
+            UUID::gen(), {}, serviceContext->getFastClockSource()->now()};
+        BSONArrayBuilder filesBuilder;
+        const fs::path dbpath(storageGlobalParams.dbpath);
+        for (auto&& [path, file] : files) {
+            auto filename = fs::path(path).lexically_relative(dbpath).generic_string();
+            filesBuilder.append(BSON("filename" << filename << "fileSize"
+                                                << static_cast<long long>(file.fileSize)));
+            backup.files.emplace(std::move(filename), file);
+        }
+
+        log() << "Opened backup " << backup.backupId << " of " << backup.files.size()
+              << " files for file copy initial sync";
+        backup.backupId.appendToBuilder(&result, "backupId");
+        result.append("checkpointTimestamp", checkpointTimestamp.value_or(Timestamp()));
+        result.append("files", filesBuilder.arr());
+
+        stdx::lock_guard<Latch> lk(state.mutex);
+        state.backup = std::move(backup);
+        endBackupGuard.dismiss();
+        startIdleBackupReaper(serviceContext, lk, &state);
+        return true;
+    }
+} cmdFileCopyInitialSyncOpenBackup;
+
+/**
+ * Returns up to 'length' bytes of a file of the open backup, starting at 'offset'.
+ */
+class CmdFileCopyInitialSyncReadFile : public ReplSetCommand {
+public:
+    CmdFileCopyInitialSyncReadFile()
+        : ReplSetCommand(FileCopyInitialSyncer::kReadFileCommandName.rawData()) {}
+
+    std::string help() const override {
+        return "Internal command used by file copy initial sync to read a file of the backup "
+               "opened by " +
+            FileCopyInitialSyncer::kOpenBackupCommandName.toString() + ".";
+    }
+
+    bool run(OperationContext* opCtx,
+             const std::string&,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        auto serviceContext = opCtx->getServiceContext();
+        auto& state = getFileCopyBackupState(serviceContext);
+        const auto backupId = extractBackupId(cmdObj);
+        std::string filename;
+        uassertStatusOK(bsonExtractStringField(cmdObj, "filename", &filename));
+        long long offset;
+        uassertStatusOK(bsonExtractIntegerField(cmdObj, "offset", &offset));
+        long long length;
+        uassertStatusOK(bsonExtractIntegerField(cmdObj, "length", &length));
+
+        // Only files of the open backup may be read, which also keeps reads within the dbpath.
+        long long fileSize;
+        {
+            stdx::lock_guard<Latch> lk(state.mutex);
+            uassert(ErrorCodes::NoSuchKey,
+                    str::stream() << "Backup " << backupId << " is not open",
+                    state.backup && state.backup->backupId == backupId);
+            auto it = state.backup->files.find(filename);
+            uassert(ErrorCodes::NoSuchKey,
+                    str::stream() << filename << " is not part of backup " << backupId,
+                    it != state.backup->files.end());
+            fileSize = it->second.fileSize;
+            state.backup->lastUsed = serviceContext->getFastClockSource()->now();
+        }
+        uassert(ErrorCodes::BadValue,
+                str::stream() << "Invalid range of " << length << " bytes at offset " << offset
+                              << " for " << filename << " of size " << fileSize,
+                offset >= 0 && offset <= fileSize && length > 0);
+        length = std::min({length, FileCopyInitialSyncer::kMaxChunkBytes, fileSize - offset});
+
+        const auto path = fs::path(storageGlobalParams.dbpath) / filename;
+        std::ifstream in(path.string(), std::ios::binary);
+        uassert(ErrorCodes::FileOpenFailed,
+                str::stream() << "Failed to open " << path.string(),
+                in.is_open());
+        std::vector<char> buffer(length);
+        in.seekg(offset);
+        in.read(buffer.data(), length);
+        uassert(ErrorCodes::FileStreamFailed,
+                str::stream() << "Failed to read " << length << " bytes at offset " << offset
+                              << " of " << path.string(),
+                in.gcount() == length);
+
+        result.appendBinData("data", length, BinDataGeneral, buffer.data());
+        return true;
+    }
+} cmdFileCopyInitialSyncReadFile;
+
+/**
+ * Closes the backup opened by CmdFileCopyInitialSyncOpenBackup. Closing a backup that is not
+ * open succeeds.
+ */
+class CmdFileCopyInitialSyncCloseBackup : public ReplSetCommand {
+public:
+    CmdFileCopyInitialSyncCloseBackup()
+        : ReplSetCommand(FileCopyInitialSyncer::kCloseBackupCommandName.rawData()) {}
+
+    std::string help() const override {
+        return "Internal command used by file copy initial sync to close the backup opened by " +
+            FileCopyInitialSyncer::kOpenBackupCommandName.toString() + ".";
+    }
+
+    bool run(OperationContext* opCtx,
+             const std::string&,
+             const BSONObj& cmdObj,
+             BSONObjBuilder& result) override {
+        auto serviceContext = opCtx->getServiceContext();
+        auto& state = getFileCopyBackupState(serviceContext);
+        const auto backupId = extractBackupId(cmdObj);
+
+        stdx::lock_guard<Latch> lk(state.mutex);
+        if (state.backup && state.backup->backupId == backupId) {
+            serviceContext->getStorageEngine()->endNonBlockingBackup(opCtx);
+            state.backup = boost::none;
+            log() << "Closed backup " << backupId << " for file copy initial sync";
+        }
+        return true;
+    }
+} cmdFileCopyInitialSyncCloseBackup;
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -0,0 +1,299 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kReplicationInitialSync
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/repl/file_copy_initial_syncer.h"
+
+#include <algorithm>
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <vector>
+
+#include "mongo/db/repl/replication_auth.h"
+#include "mongo/db/storage/storage_file_util.h"
+#include "mongo/rpc/get_status_from_command_result.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/str.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+namespace fs = boost::filesystem;
+
+// The file WiredTiger looks for to decide whether a directory holds a database.
+const std::string kWiredTigerMetadataFileName = "WiredTiger";
+
+/**
+ * Returns true for the entries a dbpath may contain before the storage engine is initialized
+ * without holding any data.
+ */
+bool isEntryAllowedInEmptyDbpath(const fs::path& name) {
+    return name == "mongod.lock" || name == "diagnostic.data" ||
+        name == FileCopyInitialSyncer::kDownloadDirName.toString();
+}
+
+/**
+ * Returns a backup file name reported by the sync source as a path, after checking that it stays
+ * within the directory it is downloaded into.
+ */
+fs::path checkBackupFileName(const std::string& filename) {
+    fs::path path(filename);
+    bool valid = !filename.empty() && path.is_relative() && !path.has_root_path();
+    for (auto&& component : path) {
+        valid = valid && component != ".." && component != ".";
+    }
+    uassert(ErrorCodes::BadValue,
+            str::stream() << "Sync source reported an invalid backup file name: " << filename,
+            valid);
+    return path;
+}
+
+/**
+ * Runs 'cmdObj' against the admin database of the sync source and throws if it fails.
+ */
+BSONObj runAdminCommand(DBClientConnection* client, const BSONObj& cmdObj) {
+    BSONObj reply;
+    client->runCommand("admin", cmdObj, reply);
+    uassertStatusOK(getStatusFromCommandResult(reply));
+    return reply;
+}
+
+}  // namespace
+
+FileCopyInitialSyncer::FileCopyInitialSyncer(HostAndPort source, std::string dbpath)
+    : _source(std::move(source)),
+      _dbpath(std::move(dbpath)),
+      _createClientFn([this] {
+          auto client = std::make_unique<DBClientConnection>();
+          uassertStatusOK(client->connect(_source, StringData()));
+          uassertStatusOK(replAuthenticate(client.get())
+                              .withContext(str::stream()
+                                           << "Failed to authenticate to " << _source));
+          return client;
+      }) {}
+
+Status FileCopyInitialSyncer::run(int maxAttempts) {
+    const fs::path dbpath(_dbpath);
+    try {
+        if (fs::exists(dbpath / kInstallMarkerFileName.toString())) {
+            _removeInterruptedInstall();
+        }
+        if (fs::exists(dbpath / kWiredTigerMetadataFileName)) {
+            log() << "Skipping file copy initial sync from " << _source << " because " << _dbpath
+                  << " already holds data files";
+            return Status::OK();
+        }
+        if (fs::exists(dbpath)) {
+            for (auto&& entry : fs::directory_iterator(dbpath)) {
+                if (!isEntryAllowedInEmptyDbpath(entry.path().filename())) {
+                    return {ErrorCodes::IllegalOperation,
+                            str::stream()
+                                << "Cannot copy data files from " << _source << " into "
+                                << _dbpath << ", which is not empty; found "
+                                << entry.path().string() << ". Empty the dbpath and restart."};
+                }
+            }
+        }
+    } catch (const DBException& e) {
+        return e.toStatus();
+    } catch (const fs::filesystem_error& e) {
+        return {ErrorCodes::InvalidPath, e.what()};
+    }
+
+    Status status = Status::OK();
+    for (int attempt = 1; attempt <= maxAttempts; ++attempt) {
+        log() << "Starting file copy initial sync from " << _source << ", attempt " << attempt
+              << " of " << maxAttempts;
+        try {
+            _downloadBackup();
+            _installDownloadedFiles();
+            return Status::OK();
+        } catch (const DBException& e) {
+            status = e.toStatus();
+        } catch (const fs::filesystem_error& e) {
+            status = {ErrorCodes::FileStreamFailed, e.what()};
+        }
+        error() << "File copy initial sync attempt " << attempt << " of " << maxAttempts
+                << " failed: " << redact(status);
+    }
+    return status.withContext(str::stream() << "File copy initial sync from " << _source
+                                            << " failed after " << maxAttempts << " attempts");
+}
+
+void FileCopyInitialSyncer::_downloadBackup() {
+    const fs::path downloadDir = fs::path(_dbpath) / kDownloadDirName.toString();
+    fs::remove_all(downloadDir);
+    fs::create_directories(downloadDir);
+
+    auto client = _createClientFn();
+    auto backup = runAdminCommand(client.get(), BSON(kOpenBackupCommandName << 1));
+    auto backupId = uassertStatusOK(UUID::parse(backup["backupId"]));
+    ON_BLOCK_EXIT([&] {
+        // The sync source also closes backups that stop being read from, so failing to close
+        // this one only delays that.
+        try {
+            runAdminCommand(client.get(),
+                            BSON(kCloseBackupCommandName << 1 << "backupId" << backupId));
+        } catch (const DBException& e) {
+            warning() << "Failed to close backup " << backupId << " on " << _source << ": "
+                      << redact(e.toStatus());
+        }
+    });
+
+    auto files = backup["files"].Array();
+    log() << "Opened backup " << backupId << " of " << files.size() << " files on " << _source
+          << " at checkpoint " << backup["checkpointTimestamp"].timestamp();
+
+    long long totalBytes = 0;
+    for (auto&& fileElem : files) {
+        const auto filename = fileElem["filename"].String();
+        const long long fileSize = fileElem["fileSize"].safeNumberLong();
+        const auto path = downloadDir / checkBackupFileName(filename);
+        fs::create_directories(path.parent_path());
+
+        std::ofstream out(path.string(), std::ios::binary | std::ios::trunc);
+        uassert(ErrorCodes::FileOpenFailed,
+                str::stream() << "Failed to open " << path.string() << " for writing",
+                out.is_open());
+
+        long long offset = 0;
+        while (offset < fileSize) {
+            auto chunk = runAdminCommand(
+                client.get(),
+                BSON(kReadFileCommandName << 1 << "backupId" << backupId << "filename" << filename
+                                          << "offset" << offset << "length"
+                                          << std::min(fileSize - offset, kMaxChunkBytes)));
+            int length = 0;
+            const char* data = chunk["data"].binData(length);
+            uassert(ErrorCodes::FileStreamFailed,
+                    str::stream() << "Sync source returned no data for " << filename
+                                  << " at offset " << offset << " of " << fileSize,
+                    length > 0);
+            out.write(data, length);
+            offset += length;
+        }
+        out.close();
+        uassert(ErrorCodes::FileStreamFailed,
+                str::stream() << "Failed to write " << path.string(),
+                !out.fail());
+
+        LOG(1) << "Copied " << filename << " (" << fileSize << " bytes) from " << _source;
+        totalBytes += fileSize;
+    }
+
+    log() << "Copied " << files.size() << " files (" << totalBytes << " bytes) from " << _source
+          << "; replication recovery will apply the oplog from checkpoint "
+          << backup["checkpointTimestamp"].timestamp();
+}
+
+void FileCopyInitialSyncer::_installDownloadedFiles() {
+    const fs::path dbpath(_dbpath);
+    const fs::path downloadDir = dbpath / kDownloadDirName.toString();
+
+    // Once the WiredTiger metadata file is in place the dbpath counts as holding data, so it is
+    // moved last.
+    std::vector<fs::path> files;
+    for (auto&& entry : fs::recursive_directory_iterator(downloadDir)) {
+        if (fs::is_regular_file(entry.path())) {
+            files.push_back(entry.path().lexically_relative(downloadDir));
+        }
+    }
+    std::stable_partition(files.begin(), files.end(), [](const fs::path& file) {
+        return file != kWiredTigerMetadataFileName;
+    });
+
+    // If the node stops before all files are in place, the next startup finds the marker and
+    // removes them, instead of starting from a partial copy or refusing the non-empty dbpath.
+    const fs::path marker = dbpath / kInstallMarkerFileName.toString();
+    {
+        std::ofstream out(marker.string(), std::ios::trunc);
+        for (auto&& file : files) {
+            out << file.generic_string() << '\n';
+        }
+        out.close();
+        uassert(ErrorCodes::FileStreamFailed,
+                str::stream() << "Failed to write " << marker.string(),
+                !out.fail());
+    }
+    uassertStatusOK(fsyncFile(marker));
+    uassertStatusOK(fsyncParentDirectory(marker));
+
+    for (auto&& file : files) {
+        fs::create_directories((dbpath / file).parent_path());
+        uassertStatusOK(fsyncRename(downloadDir / file, dbpath / file));
+    }
+    fs::remove_all(downloadDir);
+
+    fs::remove(marker);
+    uassertStatusOK(fsyncParentDirectory(marker));
+}
+
+void FileCopyInitialSyncer::_removeInterruptedInstall() {
+    const fs::path dbpath(_dbpath);
+    const fs::path marker = dbpath / kInstallMarkerFileName.toString();
+    warning() << "A file copy initial sync was interrupted while moving files into " << _dbpath
+              << "; removing them before copying from " << _source << " again";
+
+    std::ifstream in(marker.string());
+    std::string filename;
+    while (std::getline(in, filename)) {
+        if (filename.empty()) {
+            continue;
+        }
+        const auto file = checkBackupFileName(filename);
+        fs::remove(dbpath / file);
+        // Only the download created subdirectories, so remove them once they are empty.
+        for (auto dir = file.parent_path(); !dir.empty(); dir = dir.parent_path()) {
+            if (!fs::exists(dbpath / dir) || !fs::is_empty(dbpath / dir)) {
+                break;
+            }
+            fs::remove(dbpath / dir);
+        }
+    }
+    uassert(ErrorCodes::FileStreamFailed,
+            str::stream() << "Failed to read " << marker.string(),
+            in.eof());
+    in.close();
+    fs::remove_all(dbpath / kDownloadDirName.toString());
+
+    // The files must be gone before the marker is, or a crash here would leave them behind.
+    uassertStatusOK(fsyncParentDirectory(marker));
+    fs::remove(marker);
+    uassertStatusOK(fsyncParentDirectory(marker));
+}
+
+}  // namespace repl
+}  // namespace mongo
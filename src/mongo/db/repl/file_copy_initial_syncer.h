@@ -0,0 +1,121 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <string>
+
+#include "mongo/base/status.h"
+#include "mongo/base/string_data.h"
+#include "mongo/client/dbclient_connection.h"
+#include "mongo/util/net/hostandport.h"
+
+namespace mongo {
+namespace repl {
+
+/**
+ * Seeds an empty dbpath with a copy of the sync source's data files, as an alternative to the
+ * logical initial sync done by the InitialSyncer.
+ *
+ * This runs at startup, before the storage engine opens the dbpath. It opens a backup on the sync
+ * source with the commands named below, downloads every file of the backup over one connection
+ * and moves them into the dbpath once all have been copied. The storage engine then starts from
+ * the backup's checkpoint and replication recovery applies the copied oplog from the checkpoint
+ * timestamp, after which the node catches up from its sync source like any other secondary.
+ */
+class FileCopyInitialSyncer {
+    FileCopyInitialSyncer(const FileCopyInitialSyncer&) = delete;
+    FileCopyInitialSyncer& operator=(const FileCopyInitialSyncer&) = delete;
+
+public:
+    // Internal commands the sync source runs on behalf of this class.
+    static constexpr StringData kOpenBackupCommandName = "_fileCopyInitialSyncOpenBackup"_sd;
+    static constexpr StringData kReadFileCommandName = "_fileCopyInitialSyncReadFile"_sd;
+    static constexpr StringData kCloseBackupCommandName = "_fileCopyInitialSyncCloseBackup"_sd;
+
+    // The largest chunk of a file returned by a single kReadFileCommandName.
+    static constexpr long long kMaxChunkBytes = 8 * 1024 * 1024;
+
+    // The directory under the dbpath that files are downloaded into.
+    static constexpr StringData kDownloadDirName = "_fileCopyInitialSync.tmp"_sd;
+
+    // The file in the dbpath that lists the files being moved into it. It only exists while they
+    // are moved, so finding it at startup means the files in the dbpath are an incomplete copy.
+    static constexpr StringData kInstallMarkerFileName = "_fileCopyInitialSync.installing"_sd;
+
+    using CreateClientFn = std::function<std::unique_ptr<DBClientConnection>()>;
+
+    FileCopyInitialSyncer(HostAndPort source, std::string dbpath);
+
+    /**
+     * Copies the sync source's data files into the dbpath, making up to 'maxAttempts' attempts.
+     *
+     * Files left by a copy that was interrupted while they were moved into the dbpath are removed
+     * first. Returns OK without contacting the sync source if the dbpath already holds data files,
+     * and IllegalOperation if it holds anything else that the copy could conflict with.
+     */
+    Status run(int maxAttempts);
+
+    /**
+     * Overrides how the connection to the sync source is created.
+     *
+     * For testing only.
+     */
+    void setCreateClientFn_forTest(CreateClientFn createClientFn) {
+        _createClientFn = std::move(createClientFn);
+    }
+
+private:
+    /**
+     * Makes a single attempt at downloading every file of a backup into the download directory.
+     * Throws on failure.
+     */
+    void _downloadBackup();
+
+    /**
+     * Moves the downloaded files into the dbpath, the WiredTiger metadata file last, and removes
+     * the download directory. The files are listed in the install marker file while they move.
+     */
+    void _installDownloadedFiles();
+
+    /**
+     * Removes the files listed in the install marker file, and the directories created for them,
+     * from the dbpath, and then the download directory and the marker itself.
+     */
+    void _removeInterruptedInstall();
+
+    const HostAndPort _source;
+    const std::string _dbpath;
+    CreateClientFn _createClientFn;
+};
+
+}  // namespace repl
+}  // namespace mongo
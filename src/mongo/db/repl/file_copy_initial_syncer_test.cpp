@@ -0,0 +1,183 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <boost/filesystem.hpp>
+#include <fstream>
+#include <sstream>
+
+#include "mongo/db/repl/file_copy_initial_syncer.h"
+#include "mongo/db/service_context_test_fixture.h"
+#include "mongo/dbtests/mock/mock_dbclient_connection.h"
+#include "mongo/dbtests/mock/mock_remote_db_server.h"
+#include "mongo/unittest/temp_dir.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/uuid.h"
+
+namespace mongo {
+namespace repl {
+namespace {
+
+namespace fs = boost::filesystem;
+
+class FileCopyInitialSyncerTest : public ServiceContextTest {
+protected:
+    void setUp() override {
+        ServiceContextTest::setUp();
+        _mockServer = std::make_unique<MockRemoteDBServer>(_source.toString());
+        _mockServer->setCommandReply(FileCopyInitialSyncer::kCloseBackupCommandName.toString(),
+                                     BSON("ok" << 1));
+    }
+
+    std::unique_ptr<FileCopyInitialSyncer> makeSyncer() {
+        auto syncer = std::make_unique<FileCopyInitialSyncer>(_source, _dbpath.path());
+        syncer->setCreateClientFn_forTest([this] {
+            return std::unique_ptr<DBClientConnection>(
+                new MockDBClientConnection(_mockServer.get()));
+        });
+        return syncer;
+    }
+
+    void setOpenBackupReply(const BSONArray& files) {
+        BSONObjBuilder reply;
+        reply.append("ok", 1);
+        UUID::gen().appendToBuilder(&reply, "backupId");
+        reply.append("checkpointTimestamp", Timestamp(10, 1));
+        reply.append("files", files);
+        _mockServer->setCommandReply(FileCopyInitialSyncer::kOpenBackupCommandName.toString(),
+                                     reply.obj());
+    }
+
+    static BSONObj makeChunkReply(StringData data) {
+        return BSON("ok" << 1 << "data"
+                         << BSONBinData(data.rawData(), data.size(), BinDataGeneral));
+    }
+
+    std::string readFile(const std::string& relativePath) {
+        std::ifstream in((fs::path(_dbpath.path()) / relativePath).string(), std::ios::binary);
+        std::stringstream contents;
+        contents << in.rdbuf();
+        return contents.str();
+    }
+
+    const HostAndPort _source{"localhost", 12345};
+    unittest::TempDir _dbpath{"file_copy_initial_syncer_test"};
+    std::unique_ptr<MockRemoteDBServer> _mockServer;
+};
+
+TEST_F(FileCopyInitialSyncerTest, CopiesBackupFilesIntoDbpath) {
+    setOpenBackupReply(BSON_ARRAY(BSON("filename"
+                                       << "WiredTiger"
+                                       << "fileSize" << 6)
+                                  << BSON("filename"
+                                          << "journal/WiredTigerLog.0000000001"
+                                          << "fileSize" << 3)));
+    _mockServer->setCommandReply(
+        FileCopyInitialSyncer::kReadFileCommandName.toString(),
+        std::vector<StatusWith<BSONObj>>{
+            makeChunkReply("abc"), makeChunkReply("def"), makeChunkReply("ghi")});
+
+    ASSERT_OK(makeSyncer()->run(1));
+
+    ASSERT_EQ("abcdef", readFile("WiredTiger"));
+    ASSERT_EQ("ghi", readFile("journal/WiredTigerLog.0000000001"));
+    ASSERT_FALSE(fs::exists(fs::path(_dbpath.path()) /
+                            FileCopyInitialSyncer::kDownloadDirName.toString()));
+    ASSERT_FALSE(fs::exists(fs::path(_dbpath.path()) /
+                            FileCopyInitialSyncer::kInstallMarkerFileName.toString()));
+}
+
+TEST_F(FileCopyInitialSyncerTest, RetriesFailedAttempt) {
+    setOpenBackupReply(BSON_ARRAY(BSON("filename"
+                                       << "WiredTiger"
+                                       << "fileSize" << 3)));
+    _mockServer->setCommandReply(
+        FileCopyInitialSyncer::kReadFileCommandName.toString(),
+        std::vector<StatusWith<BSONObj>>{
+            BSON("ok" << 0 << "code" << ErrorCodes::HostUnreachable << "errmsg"
+                      << "injected failure"),
+            makeChunkReply("abc")});
+
+    ASSERT_OK(makeSyncer()->run(2));
+    ASSERT_EQ("abc", readFile("WiredTiger"));
+}
+
+TEST_F(FileCopyInitialSyncerTest, SkipsCopyWhenDbpathHoldsData) {
+    std::ofstream(fs::path(_dbpath.path()) / "WiredTiger") << "existing";
+
+    ASSERT_OK(makeSyncer()->run(1));
+    ASSERT_EQ(0U, _mockServer->getCmdCount());
+    ASSERT_EQ("existing", readFile("WiredTiger"));
+}
+
+TEST_F(FileCopyInitialSyncerTest, FailsWhenDbpathIsNotEmpty) {
+    std::ofstream(fs::path(_dbpath.path()) / "collection-0-1.wt") << "existing";
+
+    ASSERT_EQ(ErrorCodes::IllegalOperation, makeSyncer()->run(1));
+    ASSERT_EQ(0U, _mockServer->getCmdCount());
+}
+
+TEST_F(FileCopyInitialSyncerTest, RemovesInterruptedInstallAndCopiesAgain) {
+    // A previous copy stopped after moving some of its files, the WiredTiger metadata file among
+    // them, into the dbpath.
+    const fs::path dbpath(_dbpath.path());
+    fs::create_directories(dbpath / "journal");
+    std::ofstream(dbpath / "WiredTiger") << "stale";
+    std::ofstream(dbpath / "collection-0-1.wt") << "stale";
+    std::ofstream(dbpath / "journal/WiredTigerLog.0000000001") << "stale";
+    std::ofstream(dbpath / FileCopyInitialSyncer::kInstallMarkerFileName.toString())
+        << "collection-0-1.wt\njournal/WiredTigerLog.0000000001\nWiredTiger\n";
+
+    setOpenBackupReply(BSON_ARRAY(BSON("filename"
+                                       << "WiredTiger"
+                                       << "fileSize" << 3)));
+    _mockServer->setCommandReply(FileCopyInitialSyncer::kReadFileCommandName.toString(),
+                                 makeChunkReply("abc"));
+
+    ASSERT_OK(makeSyncer()->run(1));
+
+    ASSERT_EQ("abc", readFile("WiredTiger"));
+    ASSERT_FALSE(fs::exists(dbpath / "collection-0-1.wt"));
+    ASSERT_FALSE(fs::exists(dbpath / "journal"));
+    ASSERT_FALSE(fs::exists(dbpath / FileCopyInitialSyncer::kInstallMarkerFileName.toString()));
+}
+
+TEST_F(FileCopyInitialSyncerTest, RejectsBackupFileNamesOutsideDbpath) {
+    setOpenBackupReply(BSON_ARRAY(BSON("filename"
+                                       << "../WiredTiger"
+                                       << "fileSize" << 3)));
+
+    ASSERT_EQ(ErrorCodes::BadValue, makeSyncer()->run(1));
+    ASSERT_FALSE(fs::exists(fs::path(_dbpath.path()) / "WiredTiger"));
+}
+
+}  // namespace
+}  // namespace repl
+}  // namespace mongo
@@ -43,9 +43,11 @@
 #include "mongo/db/logical_session_id.h"
 #include "mongo/db/repl/apply_ops.h"
 #include "mongo/db/repl/insert_group.h"
+#include "mongo/db/repl/repl_server_parameters_gen.h"
 #include "mongo/db/repl/transaction_oplog_application.h"
 #include "mongo/db/stats/timer_stats.h"
 #include "mongo/platform/basic.h"
+#include "mongo/platform/mutex.h"
 #include "mongo/util/fail_point.h"
 #include "mongo/util/log.h"
 #include "third_party/murmurhash3/MurmurHash3.h"
@@ -57,6 +59,7 @@ namespace {
 MONGO_FAIL_POINT_DEFINE(pauseBatchApplicationBeforeCompletion);
 MONGO_FAIL_POINT_DEFINE(pauseBatchApplicationAfterWritingOplogEntries);
 MONGO_FAIL_POINT_DEFINE(hangAfterRecordingOpApplicationStartTime);
+MONGO_FAIL_POINT_DEFINE(hangAfterWritingPipelinedBatchToOplog);
 
 // The oplog entries applied
 Counter64 opsAppliedStats;
@@ -70,6 +73,23 @@ ServerStatusMetricField<Counter64> displayOplogApplicationBatchSize("repl.apply.
 TimerStats applyBatchStats;
 ServerStatusMetricField<TimerStats> displayOpBatchesApplied("repl.apply.batches", &applyBatchStats);
 
+// How the operations of each batch were spread over the writer threads. The operations in the
+// largest partition of a batch must be applied one after another, so the ratio of 'scheduledOps' to
+// 'criticalPathOps' is the average number of writer threads a batch could keep busy.
+Counter64 scheduledOpsStats;
+ServerStatusMetricField<Counter64> displayScheduledOps("repl.apply.scheduledOps",
+                                                       &scheduledOpsStats);
+Counter64 criticalPathOpsStats;
+ServerStatusMetricField<Counter64> displayCriticalPathOps("repl.apply.criticalPathOps",
+                                                          &criticalPathOpsStats);
+Counter64 partitionsStats;
+ServerStatusMetricField<Counter64> displayPartitions("repl.apply.partitions", &partitionsStats);
+
+// Batches whose oplog entries were written while the previous batch was being applied.
+Counter64 pipelinedBatchesStats;
+ServerStatusMetricField<Counter64> displayPipelinedBatches("repl.apply.pipelinedBatches",
+                                                           &pipelinedBatchesStats);
+
 NamespaceString parseUUIDOrNs(OperationContext* opCtx, const OplogEntry& oplogEntry) {
     auto optionalUuid = oplogEntry.getUuid();
     if (!optionalUuid) {
@@ -275,6 +295,108 @@ void stableSortByNamespace(std::vector<const OplogEntry*>* oplogEntryPointers) {
     std::stable_sort(oplogEntryPointers->begin(), oplogEntryPointers->end(), nssComparator);
 }
 
+/**
+ * Hands out the partitions that fillWriterVectors() split a batch into to the writer threads.
+ * Operations in different partitions never write the same document (or, for capped collections
+ * and storage engines without document-level locking, the same collection), so partitions can be
+ * applied in any order and in parallel, as long as each is applied in order.
+ *
+ * The largest partitions are handed out first, so that the one that takes longest to apply starts
+ * right away and the others are shared among the remaining writers. Small partitions are handed
+ * out several at a time, so that a writer can still group their inserts.
+ *
+ * With no more partitions than writers (replWriterPartitionsPerThread is 1), the partitions are
+ * neither sorted nor packed: each is handed out on its own, in order, and each writer applies
+ * exactly one of them, as before partitions were shared.
+ */
+class WriterPartitionQueue {
+public:
+    WriterPartitionQueue(std::vector<std::vector<const OplogEntry*>>* partitions,
+                         size_t numWriters) {
+        for (auto&& partition : *partitions) {
+            if (partition.empty()) {
+                continue;
+            }
+            _partitions.push_back(&partition);
+            _numOps += partition.size();
+        }
+        if (partitions->size() <= numWriters) {
+            _onePerWriter = true;
+            return;
+        }
+        std::stable_sort(_partitions.begin(), _partitions.end(), [](auto&& l, auto&& r) {
+            return l->size() > r->size();
+        });
+
+        // Leave a few claims per writer, so that writers that finish early have work to take.
+        const size_t kClaimsPerWriter = 4;
+        _opsPerClaim = std::max<size_t>(1, _numOps / (numWriters * kClaimsPerWriter));
+    }
+
+    /**
+     * Appends the operations of the next partitions to 'ops'. Returns false when there are none
+     * left or a writer has failed.
+     */
+    bool claim(std::vector<const OplogEntry*>* ops) {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (_failed || _next == _partitions.size()) {
+            return false;
+        }
+        do {
+            const auto& partition = *_partitions[_next++];
+            ops->insert(ops->end(), partition.begin(), partition.end());
+        } while (!_onePerWriter && _next < _partitions.size() &&
+                 ops->size() + _partitions[_next]->size() <= _opsPerClaim);
+        return true;
+    }
+
+    /**
+     * Stops handing out partitions, as the batch will fail anyway.
+     */
+    void fail() {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _failed = true;
+    }
+
+    /**
+     * Returns true if each writer should apply only the single partition it claims first.
+     */
+    bool onePerWriter() const {
+        return _onePerWriter;
+    }
+
+    size_t numPartitions() const {
+        return _partitions.size();
+    }
+
+    size_t numOps() const {
+        return _numOps;
+    }
+
+    /**
+     * Returns the number of operations in the largest partition, which no number of writers can
+     * apply any faster than one after another.
+     */
+    size_t criticalPathOps() const {
+        size_t ops = 0;
+        for (auto&& partition : _partitions) {
+            ops = std::max(ops, partition->size());
+        }
+        return ops;
+    }
+
+private:
+    // Non-empty partitions, largest first unless _onePerWriter.
+    std::vector<const std::vector<const OplogEntry*>*> _partitions;
+    size_t _numOps = 0;
+    size_t _opsPerClaim = 1;
+    bool _onePerWriter = false;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("WriterPartitionQueue::_mutex");
+    size_t _next = 0;
+    bool _failed = false;
+};
+
 }  // namespace
 
 
@@ -416,6 +538,11 @@ void OplogApplierImpl::_run(OplogBuffer* oplogBuffer) {
             ? new ApplyBatchFinalizerForJournal(_replCoord)
             : new ApplyBatchFinalizer(_replCoord)};
 
+    // In pipelined mode, the batch after the one being applied, whose oplog entries have already
+    // been written. Any left when this returns are in the oplog, but unapplied, so startup
+    // recovery applies them.
+    boost::optional<OplogBatch> nextBatch;
+
     while (true) {  // Exits on message from OplogBatcher.
         // Use a new operation context each iteration, as otherwise we may appear to use a single
         // collection name to refer to collections with different UUIDs.
@@ -438,8 +565,12 @@ void OplogApplierImpl::_run(OplogBuffer* oplogBuffer) {
         _replCoord->finishRecoveryIfEligible(&opCtx);
 
         // Blocks up to a second waiting for a batch to be ready to apply. If one doesn't become
-        // ready in time, we'll loop again so we can do the above checks periodically.
-        OplogBatch ops = _oplogBatcher->getNextBatch(Seconds(1));
+        // ready in time, we'll loop again so we can do the above checks periodically. A batch whose
+        // oplog entries were written while the last one was being applied goes first.
+        const bool oplogEntriesWritten = bool(nextBatch);
+        OplogBatch ops =
+            nextBatch ? std::move(*nextBatch) : _oplogBatcher->getNextBatch(Seconds(1));
+        nextBatch.reset();
         if (ops.empty()) {
             if (ops.mustShutdown()) {
                 // Shut down and exit oplog application loop.
@@ -481,7 +612,11 @@ void OplogApplierImpl::_run(OplogBuffer* oplogBuffer) {
 
         // Apply the operations in this batch. '_applyOplogBatch' returns the optime of the
         // last op that was applied, which should be the last optime in the batch.
-        auto swLastOpTimeAppliedInBatch = _applyOplogBatch(&opCtx, ops.releaseBatch());
+        auto swLastOpTimeAppliedInBatch =
+            _applyOplogBatchImpl(&opCtx,
+                                 ops.releaseBatch(),
+                                 oplogEntriesWritten,
+                                 replPipelinedBatchApplication.load() ? &nextBatch : nullptr);
         if (swLastOpTimeAppliedInBatch.getStatus().code() == ErrorCodes::InterruptedAtShutdown) {
             // If an operation was interrupted at shutdown, fail the batch without advancing
             // appliedThrough as if this were an unclean shutdown. This ensures the stable timestamp
@@ -526,6 +661,27 @@ void OplogApplierImpl::_run(OplogBuffer* oplogBuffer) {
 }
 
 
+// Writes 'ops' from 'begin' up to 'end' to the oplog.
+void writeToOplog(OperationContext* opCtx,
+                  StorageInterface* storageInterface,
+                  const std::vector<OplogEntry>& ops,
+                  size_t begin,
+                  size_t end) {
+    UnreplicatedWritesBlock uwb(opCtx);
+
+    std::vector<InsertStatement> docs;
+    docs.reserve(end - begin);
+    for (size_t i = begin; i < end; i++) {
+        // Add as unowned BSON to avoid unnecessary ref-count bumps.
+        // 'ops' will outlive 'docs' so the BSON lifetime will be guaranteed.
+        docs.emplace_back(InsertStatement{
+            ops[i].getRaw(), ops[i].getOpTime().getTimestamp(), ops[i].getOpTime().getTerm()});
+    }
+
+    fassert(40141,
+            storageInterface->insertDocuments(opCtx, NamespaceString::kRsOplogNamespace, docs));
+}
+
 // Schedules the writes to the oplog for 'ops' into threadPool. The caller must guarantee that
 // 'ops' stays valid until all scheduled work in the thread pool completes.
 void scheduleWritesToOplog(OperationContext* opCtx,
@@ -545,23 +701,10 @@ void scheduleWritesToOplog(OperationContext* opCtx,
             // safe to exclude any writes from Flow Control.
             opCtx->setShouldParticipateInFlowControl(false);
 
-            UnreplicatedWritesBlock uwb(opCtx.get());
             ShouldNotConflictWithSecondaryBatchApplicationBlock shouldNotConflictBlock(
                 opCtx->lockState());
 
-            std::vector<InsertStatement> docs;
-            docs.reserve(end - begin);
-            for (size_t i = begin; i < end; i++) {
-                // Add as unowned BSON to avoid unnecessary ref-count bumps.
-                // 'ops' will outlive 'docs' so the BSON lifetime will be guaranteed.
-                docs.emplace_back(InsertStatement{ops[i].getRaw(),
-                                                  ops[i].getOpTime().getTimestamp(),
-                                                  ops[i].getOpTime().getTerm()});
-            }
-
-            fassert(40141,
-                    storageInterface->insertDocuments(
-                        opCtx.get(), NamespaceString::kRsOplogNamespace, docs));
+            writeToOplog(opCtx.get(), storageInterface, ops, begin, end);
         };
     };
 
@@ -595,6 +738,13 @@ void scheduleWritesToOplog(OperationContext* opCtx,
 
 StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
                                                       std::vector<OplogEntry> ops) {
+    return _applyOplogBatchImpl(opCtx, std::move(ops), false, nullptr);
+}
+
+StatusWith<OpTime> OplogApplierImpl::_applyOplogBatchImpl(OperationContext* opCtx,
+                                                          std::vector<OplogEntry> ops,
+                                                          bool oplogEntriesWritten,
+                                                          boost::optional<OplogBatch>* nextBatch) {
     invariant(!ops.empty());
 
     LOG(2) << "replication batch size is " << ops.size();
@@ -623,7 +773,7 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
         ON_BLOCK_EXIT([&] { _writerPool->waitForIdle(); });
 
         // Write batch of ops into oplog.
-        if (!getOptions().skipWritesToOplog) {
+        if (!getOptions().skipWritesToOplog && !oplogEntriesWritten) {
             _consistencyMarkers->setOplogTruncateAfterPoint(
                 opCtx, _replCoord->getMyLastAppliedOpTime().getTimestamp());
             scheduleWritesToOplog(opCtx, _storageInterface, _writerPool, ops);
@@ -638,8 +788,11 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
         //   and create a pseudo oplog.
         std::vector<std::vector<OplogEntry>> derivedOps;
 
+        // Split the batch into several times as many partitions as there are writers, for the
+        // writers to share out as they go.
+        const size_t numWriters = _writerPool->getStats().numThreads;
         std::vector<std::vector<const OplogEntry*>> writerVectors(
-            _writerPool->getStats().numThreads);
+            numWriters * static_cast<size_t>(replWriterPartitionsPerThread.load()));
         fillWriterVectors(opCtx, &ops, &writerVectors, &derivedOps);
 
         // Wait for writes to finish before applying ops.
@@ -660,34 +813,60 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
         }
 
         {
-            std::vector<Status> statusVector(_writerPool->getStats().numThreads, Status::OK());
-
-            // Doles out all the work to the writer pool threads. writerVectors is not modified,
-            // but  applyOplogBatchPerWorker will modify the vectors that it contains.
-            invariant(writerVectors.size() == statusVector.size());
-            for (size_t i = 0; i < writerVectors.size(); i++) {
-                if (writerVectors[i].empty())
-                    continue;
-
+            WriterPartitionQueue partitionQueue(&writerVectors, numWriters);
+            scheduledOpsStats.increment(partitionQueue.numOps());
+            criticalPathOpsStats.increment(partitionQueue.criticalPathOps());
+            partitionsStats.increment(partitionQueue.numPartitions());
+            LOG(2) << "applying " << partitionQueue.numOps() << " operations in "
+                   << partitionQueue.numPartitions() << " partitions, the largest of which has "
+                   << partitionQueue.criticalPathOps() << " operations";
+
+            // Doles out all the work to the writer pool threads. Each writer applies the
+            // partitions it claims with applyOplogBatchPerWorker, which modifies the vector it is
+            // given, but not writerVectors.
+            std::vector<Status> statusVector(numWriters, Status::OK());
+            const size_t numTasks = std::min(numWriters, partitionQueue.numPartitions());
+            for (size_t i = 0; i < numTasks; i++) {
                 _writerPool->schedule(
                     [this,
-                     &writer = writerVectors.at(i),
+                     &partitionQueue,
                      &status = statusVector.at(i),
                      &multikeyVector = multikeyVector.at(i)](auto scheduleStatus) {
                         invariant(scheduleStatus);
 
-                        auto opCtx = cc().makeOperationContext();
-
-                        // This code path is only executed on secondaries and initial syncing nodes,
-                        // so it is safe to exclude any writes from Flow Control.
-                        opCtx->setShouldParticipateInFlowControl(false);
-
-                        status = opCtx->runWithoutInterruptionExceptAtGlobalShutdown([&] {
-                            return applyOplogBatchPerWorker(opCtx.get(), &writer, &multikeyVector);
-                        });
+                        std::vector<const OplogEntry*> writer;
+                        while (partitionQueue.claim(&writer)) {
+                            auto opCtx = cc().makeOperationContext();
+
+                            // This code path is only executed on secondaries and initial syncing
+                            // nodes, so it is safe to exclude any writes from Flow Control.
+                            opCtx->setShouldParticipateInFlowControl(false);
+
+                            WorkerMultikeyPathInfo multikeyPathInfo;
+                            status = opCtx->runWithoutInterruptionExceptAtGlobalShutdown([&] {
+                                return applyOplogBatchPerWorker(
+                                    opCtx.get(), &writer, &multikeyPathInfo);
+                            });
+                            if (!status.isOK()) {
+                                partitionQueue.fail();
+                                return;
+                            }
+                            multikeyVector.insert(multikeyVector.end(),
+                                                  multikeyPathInfo.begin(),
+                                                  multikeyPathInfo.end());
+                            if (partitionQueue.onePerWriter()) {
+                                // There is one task per partition, so the others are taken.
+                                return;
+                            }
+                            writer.clear();
+                        }
                     });
             }
 
+            if (nextBatch && !getOptions().skipWritesToOplog) {
+                _writeNextBatchToOplog(opCtx, ops.back().getOpTime(), nextBatch);
+            }
+
             _writerPool->waitForIdle();
 
             // If any of the statuses is not ok, return error.
@@ -751,6 +930,41 @@ StatusWith<OpTime> OplogApplierImpl::_applyOplogBatch(OperationContext* opCtx,
     return ops.back().getOpTime();
 }
 
+void OplogApplierImpl::_writeNextBatchToOplog(OperationContext* opCtx,
+                                              const OpTime& lastOpTimeInBatch,
+                                              boost::optional<OplogBatch>* nextBatch) {
+    *nextBatch = _oplogBatcher->tryGetNextNonEmptyBatch();
+    if (!*nextBatch) {
+        return;
+    }
+
+    // Leave a batch that goes back in time for _run() to refuse, without writing it.
+    const auto& batch = (*nextBatch)->getBatch();
+    if (batch.front().getOpTime() <= lastOpTimeInBatch) {
+        return;
+    }
+
+    // All of the entries of the batch being applied are in the oplog, so if this write is
+    // interrupted by a crash, startup recovery truncates the oplog after them, as it would if the
+    // next batch's entries were written once the batch being applied was done.
+    _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, lastOpTimeInBatch.getTimestamp());
+    writeToOplog(opCtx, _storageInterface, batch, 0, batch.size());
+
+    // Use this fail point to crash the node while the oplog truncate-after point still covers the
+    // next batch's entries.
+    if (MONGO_unlikely(hangAfterWritingPipelinedBatchToOplog.shouldFail())) {
+        log() << "hangAfterWritingPipelinedBatchToOplog fail point enabled. Oplog truncate-after "
+                 "point: "
+              << lastOpTimeInBatch.getTimestamp().toBSON()
+              << ". Blocking until fail point is disabled.";
+        hangAfterWritingPipelinedBatchToOplog.pauseWhileSet(opCtx);
+    }
+
+    _consistencyMarkers->setOplogTruncateAfterPoint(opCtx, Timestamp());
+
+    pipelinedBatchesStats.increment();
+}
+
 /**
  * ops - This only modifies the isForCappedCollection field on each op. It does not alter the ops
  *      vector in any other way.
@@ -995,6 +1209,7 @@ Status OplogApplierImpl::applyOplogBatchPerWorker(OperationContext* opCtx,
     // ShouldNotConflictWithSecondaryBatchApplicationBlock will touch the locker that has been
     // destroyed by unstash in its destructor. Thus we set the flag explicitly.
     opCtx->lockState()->setShouldConflictWithSecondaryBatchApplication(false);
+    opCtx->lockState()->setTicketPriority(TicketHolder::Priority::kReplication);
 
     // Explicitly start future read transactions without a timestamp.
     opCtx->recoveryUnit()->setTimestampReadSource(RecoveryUnit::ReadSource::kNoTimestamp);
@@ -98,6 +98,27 @@ private:
      */
     StatusWith<OpTime> _applyOplogBatch(OperationContext* opCtx, std::vector<OplogEntry> ops);
 
+    /**
+     * Implements _applyOplogBatch(). If 'oplogEntriesWritten' is true, the batch's entries are
+     * already in the oplog and are not written again.
+     *
+     * If 'nextBatch' is not null, then while the writer threads apply 'ops', this thread takes the
+     * next batch from the OplogBatcher, if one is ready, writes its entries to the oplog and
+     * returns it in 'nextBatch', to be applied next with 'oplogEntriesWritten' set.
+     */
+    StatusWith<OpTime> _applyOplogBatchImpl(OperationContext* opCtx,
+                                            std::vector<OplogEntry> ops,
+                                            bool oplogEntriesWritten,
+                                            boost::optional<OplogBatch>* nextBatch);
+
+    /**
+     * Takes the next batch from the OplogBatcher, if one is ready, into 'nextBatch' and writes its
+     * entries to the oplog, while the batch ending at 'lastOpTimeInBatch' is being applied.
+     */
+    void _writeNextBatchToOplog(OperationContext* opCtx,
+                                const OpTime& lastOpTimeInBatch,
+                                boost::optional<OplogBatch>* nextBatch);
+
     void _deriveOpsAndFillWriterVectors(OperationContext* opCtx,
                                         std::vector<OplogEntry>* ops,
                                         std::vector<std::vector<const OplogEntry*>>* writerVectors,
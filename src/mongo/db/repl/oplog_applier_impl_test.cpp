@@ -383,6 +383,82 @@ TEST_F(OplogApplierImplTest,
                                                      createOplogCollectionOptions()));
 }
 
+/**
+ * Test only subclass of OplogApplierImpl that does not apply oplog entries, but records the ops
+ * each call to applyOplogBatchPerWorker was given.
+ */
+class RecordWriterBatchesApplier : public OplogApplierImpl {
+public:
+    using OplogApplierImpl::OplogApplierImpl;
+
+    Status applyOplogBatchPerWorker(OperationContext* opCtx,
+                                    std::vector<const OplogEntry*>* ops,
+                                    WorkerMultikeyPathInfo* workerMultikeyPathInfo) override {
+        stdx::lock_guard<Latch> lk(mutex);
+        writerBatches.emplace_back();
+        for (auto&& opPtr : *ops) {
+            writerBatches.back().push_back(*opPtr);
+        }
+        return Status::OK();
+    }
+
+    Mutex mutex = MONGO_MAKE_LATCH("RecordWriterBatchesApplier::mutex");
+    std::vector<std::vector<OplogEntry>> writerBatches;
+};
+
+TEST_F(OplogApplierImplTest, MultiApplySharesPartitionsAmongWritersAndKeepsDocumentOrder) {
+    NamespaceString nss("test." + _agent.getSuiteName() + "_" + _agent.getTestName());
+    createCollection(_opCtx.get(), nss, {});
+
+    // Half of the batch updates a single document, and must be applied in order by one writer.
+    // The inserts of other documents are shared out among the other writers.
+    std::vector<OplogEntry> ops;
+    for (int i = 1; i <= 200; ++i) {
+        OpTime opTime(Timestamp(Seconds(1), i), 1LL);
+        if (i % 2) {
+            ops.push_back(makeUpdateDocumentOplogEntry(
+                opTime, nss, BSON("_id" << 0), BSON("$set" << BSON("x" << i))));
+        } else {
+            ops.push_back(makeInsertDocumentOplogEntry(opTime, nss, BSON("_id" << i)));
+        }
+    }
+
+    auto writerPool = makeReplWriterPool(4);
+    NoopOplogApplierObserver observer;
+    RecordWriterBatchesApplier oplogApplier(
+        nullptr,  // executor
+        nullptr,  // oplogBuffer
+        &observer,
+        ReplicationCoordinator::get(_opCtx.get()),
+        getConsistencyMarkers(),
+        getStorageInterface(),
+        repl::OplogApplier::Options(repl::OplogApplication::Mode::kSecondary),
+        writerPool.get());
+    ASSERT_EQUALS(ops.back().getOpTime(),
+                  unittest::assertGet(oplogApplier.applyOplogBatch(_opCtx.get(), ops)));
+
+    size_t numApplied = 0;
+    size_t numWriterBatchesWithUpdates = 0;
+    for (const auto& writerBatch : oplogApplier.writerBatches) {
+        numApplied += writerBatch.size();
+        std::vector<Timestamp> updateTimestamps;
+        for (const auto& op : writerBatch) {
+            if (op.getOpType() == OpTypeEnum::kUpdate) {
+                updateTimestamps.push_back(op.getTimestamp());
+            }
+        }
+        if (updateTimestamps.empty()) {
+            continue;
+        }
+        ++numWriterBatchesWithUpdates;
+        ASSERT_EQUALS(100U, updateTimestamps.size());
+        ASSERT_TRUE(std::is_sorted(updateTimestamps.begin(), updateTimestamps.end()));
+    }
+    ASSERT_EQUALS(ops.size(), numApplied);
+    ASSERT_EQUALS(1U, numWriterBatchesWithUpdates);
+    ASSERT_GT(oplogApplier.writerBatches.size(), 1U);
+}
+
 TEST_F(OplogApplierImplTest,
        OplogApplicationThreadFuncUsesApplyOplogEntryOrGroupedInsertsToApplyOperation) {
     NamespaceString nss("local." + _agent.getSuiteName() + "_" + _agent.getTestName());
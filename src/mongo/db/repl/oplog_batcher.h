@@ -151,6 +151,13 @@ public:
      */
     OplogBatch getNextBatch(Seconds maxWaitTime);
 
+    /**
+     * Returns the next batch if one is ready and holds oplog entries, without waiting. Empty
+     * batches, including those that signal shutdown or the end of draining, are left for
+     * getNextBatch().
+     */
+    boost::optional<OplogBatch> tryGetNextNonEmptyBatch();
+
     /**
      * Starts up a thread to continuously pull from the OplogBuffer into the OplogBatcher's oplog
      * batch.
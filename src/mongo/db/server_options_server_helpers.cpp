@@ -289,14 +289,22 @@ Status storeServerOptions(const moe::Environment& params) {
 
     if (params.count("net.transportLayer")) {
         serverGlobalParams.transportLayer = params["net.transportLayer"].as<std::string>();
+#ifdef MONGO_CONFIG_IO_URING
+        if (serverGlobalParams.transportLayer != "asio" &&
+            serverGlobalParams.transportLayer != "iouring") {
+            return {ErrorCodes::BadValue,
+                    "Unsupported value for transportLayer. Must be \"asio\" or \"iouring\""};
+        }
+#else
         if (serverGlobalParams.transportLayer != "asio") {
             return {ErrorCodes::BadValue, "Unsupported value for transportLayer. Must be \"asio\""};
         }
+#endif
     }
 
     if (params.count("net.serviceExecutor")) {
         auto value = params["net.serviceExecutor"].as<std::string>();
-        const auto valid = {"synchronous"_sd, "adaptive"_sd};
+        const auto valid = {"synchronous"_sd, "adaptive"_sd, "threadPerCore"_sd};
         if (std::find(valid.begin(), valid.end(), value) == valid.end()) {
             return {ErrorCodes::BadValue, "Unsupported value for serviceExecutor"};
         }
@@ -305,6 +313,12 @@ Status storeServerOptions(const moe::Environment& params) {
         serverGlobalParams.serviceExecutor = "synchronous";
     }
 
+    if (serverGlobalParams.transportLayer == "iouring" &&
+        serverGlobalParams.serviceExecutor != "synchronous") {
+        return {ErrorCodes::BadValue,
+                "The \"iouring\" transportLayer requires the \"synchronous\" serviceExecutor"};
+    }
+
     if (params.count("security.transitionToAuth")) {
         serverGlobalParams.transitionToAuth = params["security.transitionToAuth"].as<bool>();
     }
@@ -444,6 +458,14 @@ Status storeServerOptions(const moe::Environment& params) {
         }
     }
 
+    if (params.count("net.compression.zstdDictionaries")) {
+        const auto ret = storeMessageCompressionDictionaryOptions(
+            params["net.compression.zstdDictionaries"].as<string>());
+        if (!ret.isOK()) {
+            return ret;
+        }
+    }
+
     return Status::OK();
 }
 
@@ -1143,7 +1143,8 @@ void curOpCommandSetup(OperationContext* opCtx, const OpMsgRequest& request) {
 DbResponse receivedCommands(OperationContext* opCtx,
                             const Message& message,
                             const ServiceEntryPointCommon::Hooks& behaviors) {
-    auto replyBuilder = rpc::makeReplyBuilder(rpc::protocolForMessage(message));
+    auto replyBuilder =
+        rpc::makeReplyBuilder(rpc::protocolForMessage(message), opCtx->releaseReplyBuffer());
     OpMsgRequest request;
     [&] {
         try {  // Parse.
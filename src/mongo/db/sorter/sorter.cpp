@@ -524,7 +524,7 @@ public:
     NoLimitSorter(const SortOptions& opts,
                   const Comparator& comp,
                   const Settings& settings = Settings())
-        : _comp(comp), _settings(settings), _opts(opts), _memUsed(0) {
+        : _comp(comp), _settings(settings), _opts(opts) {
         verify(_opts.limit == 0);
         if (_opts.extSortAllowed) {
             _fileName = _opts.tempDir + "/" + nextFileName();
@@ -544,10 +544,10 @@ public:
 
         _data.emplace_back(key.getOwned(), val.getOwned());
 
-        _memUsed += key.memUsageForSorter();
-        _memUsed += val.memUsageForSorter();
+        this->_memUsed += key.memUsageForSorter();
+        this->_memUsed += val.memUsageForSorter();
 
-        if (_memUsed > _opts.maxMemoryUsageBytes)
+        if (this->_memUsed > _opts.maxMemoryUsageBytes)
             spill();
     }
 
@@ -615,8 +615,9 @@ private:
         _nextSortedFileWriterOffset = writer.getFileEndOffset();
 
         _iters.push_back(std::shared_ptr<Iterator>(iteratorPtr));
+        ++this->_numSpills;
 
-        _memUsed = 0;
+        this->_memUsed = 0;
     }
 
     const Comparator _comp;
@@ -625,7 +626,6 @@ private:
     std::string _fileName;
     std::streampos _nextSortedFileWriterOffset = 0;
     bool _done = false;
-    size_t _memUsed;
     std::deque<Data> _data;                         // the "current" data
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
 };
@@ -686,7 +686,6 @@ public:
         : _comp(comp),
           _settings(settings),
           _opts(opts),
-          _memUsed(0),
           _haveCutoff(false),
           _worstCount(0),
           _medianCount(0) {
@@ -726,13 +725,13 @@ public:
 
             _data.emplace_back(contender.first.getOwned(), contender.second.getOwned());
 
-            _memUsed += key.memUsageForSorter();
-            _memUsed += val.memUsageForSorter();
+            this->_memUsed += key.memUsageForSorter();
+            this->_memUsed += val.memUsageForSorter();
 
             if (_data.size() == _opts.limit)
                 std::make_heap(_data.begin(), _data.end(), less);
 
-            if (_memUsed > _opts.maxMemoryUsageBytes)
+            if (this->_memUsed > _opts.maxMemoryUsageBytes)
                 spill();
 
             return;
@@ -743,19 +742,19 @@ public:
         if (!less(contender, _data.front()))
             return;  // not good enough
 
-        // Remove the old worst pair and insert the contender, adjusting _memUsed
+        // Remove the old worst pair and insert the contender, adjusting memory usage
 
-        _memUsed += key.memUsageForSorter();
-        _memUsed += val.memUsageForSorter();
+        this->_memUsed += key.memUsageForSorter();
+        this->_memUsed += val.memUsageForSorter();
 
-        _memUsed -= _data.front().first.memUsageForSorter();
-        _memUsed -= _data.front().second.memUsageForSorter();
+        this->_memUsed -= _data.front().first.memUsageForSorter();
+        this->_memUsed -= _data.front().second.memUsageForSorter();
 
         std::pop_heap(_data.begin(), _data.end(), less);
         _data.back() = {contender.first.getOwned(), contender.second.getOwned()};
         std::push_heap(_data.begin(), _data.end(), less);
 
-        if (_memUsed > _opts.maxMemoryUsageBytes)
+        if (this->_memUsed > _opts.maxMemoryUsageBytes)
             spill();
     }
 
@@ -909,8 +908,9 @@ private:
         Iterator* iteratorPtr = writer.done();
         _nextSortedFileWriterOffset = writer.getFileEndOffset();
         _iters.push_back(std::shared_ptr<Iterator>(iteratorPtr));
+        ++this->_numSpills;
 
-        _memUsed = 0;
+        this->_memUsed = 0;
     }
 
     const Comparator _comp;
@@ -919,7 +919,6 @@ private:
     std::string _fileName;
     std::streampos _nextSortedFileWriterOffset = 0;
     bool _done = false;
-    size_t _memUsed;
     std::vector<Data> _data;  // the "current" data. Organized as max-heap if size == limit.
     std::vector<std::shared_ptr<Iterator>> _iters;  // data that has already been spilled
 
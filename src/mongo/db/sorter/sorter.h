@@ -233,10 +233,27 @@ public:
         return _usedDisk;
     }
 
+    /**
+     * Number of times the sorter has written the data it held in memory to disk.
+     */
+    size_t numSpills() const {
+        return _numSpills;
+    }
+
+    /**
+     * Approximate number of bytes of data the sorter holds in memory, not counting what it has
+     * spilled.
+     */
+    size_t memUsed() const {
+        return _memUsed;
+    }
+
 protected:
     Sorter() {}  // can only be constructed as a base
 
     bool _usedDisk{false};  // Keeps track of whether the sorter used disk or not
+    size_t _numSpills{0};
+    size_t _memUsed{0};
 };
 
 /**
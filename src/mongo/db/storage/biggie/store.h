@@ -29,6 +29,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <array>
 #include <boost/optional.hpp>
 #include <cstring>
@@ -190,26 +191,17 @@ public:
                 context.pop_back();
 
                 // Check the children right of the node that the iterator was at already. This way,
-                // there will be no backtracking in the traversal.
-                for (auto iter = oldKey + 1 + node->_children.begin();
-                     iter != node->_children.end();
-                     ++iter) {
-
-                    // If the node has a child, then the sub-tree must have a node with data that
-                    // has not yet been visited.
-                    if (*iter != nullptr) {
-
-                        // If the current node has data, return it and exit. If not, continue
-                        // following the nodes to find the next one with data. It is necessary to go
-                        // to the left-most node in this sub-tree.
-                        if ((*iter)->_data) {
-                            _current = iter->get();
-                            return;
-                        }
-                        _current = iter->get();
+                // there will be no backtracking in the traversal. If the node has such a child,
+                // then the sub-tree must have a node with data that has not yet been visited.
+                if (Node* child = node->_children.firstFrom(oldKey + 1)) {
+
+                    // If the current node has data, return it and exit. If not, continue following
+                    // the nodes to find the next one with data. It is necessary to go to the
+                    // left-most node in this sub-tree.
+                    _current = child;
+                    if (!child->_data)
                         _traverseLeftSubtree();
-                        return;
-                    }
+                    return;
                 }
             }
             return;
@@ -220,12 +212,7 @@ public:
             // '_current' is root. However, it cannot return the root, and hence at least 1
             // iteration of the while loop is required.
             do {
-                for (auto child : _current->_children) {
-                    if (child != nullptr) {
-                        _current = child.get();
-                        break;
-                    }
-                }
+                _current = _current->_children.firstFrom(0);
             } while (!_current->_data);
         }
 
@@ -399,14 +386,12 @@ public:
 
                 // After moving up in the tree, continue searching for neighboring nodes to see if
                 // they have data, moving from right to left.
-                for (int i = oldKey - 1; i >= 0; i--) {
-                    if (node->_children[i] != nullptr) {
-                        // If there is a sub-tree found, it must have data, therefore it's necessary
-                        // to traverse to the right most node.
-                        _current = node->_children[i].get();
-                        _traverseRightSubtree();
-                        return;
-                    }
+                if (Node* child = node->_children.lastBefore(oldKey)) {
+                    // If there is a sub-tree found, it must have data, therefore it's necessary
+                    // to traverse to the right most node.
+                    _current = child;
+                    _traverseRightSubtree();
+                    return;
                 }
 
                 // If there were no sub-trees that contained data, and the 'current' node has data,
@@ -421,15 +406,9 @@ public:
         void _traverseRightSubtree() {
             // This function traverses the given tree to the right most leaf of the subtree where
             // 'current' is the root.
-            do {
-                for (auto iter = _current->_children.rbegin(); iter != _current->_children.rend();
-                     ++iter) {
-                    if (*iter != nullptr) {
-                        _current = iter->get();
-                        break;
-                    }
-                }
-            } while (!_current->isLeaf());
+            while (!_current->isLeaf()) {
+                _current = _current->_children.lastBefore(256);
+            }
         }
 
         void updateTreeView(bool stopIfMultipleCursors = false) {
@@ -559,7 +538,7 @@ public:
         size_t depth = prev->_depth + prev->_trieKey.size();
         while (depth < key.size()) {
             uint8_t c = static_cast<uint8_t>(charKey[depth]);
-            node = prev->_children[c].get();
+            node = prev->_children.get(c).get();
             if (node == nullptr) {
                 return false;
             }
@@ -570,7 +549,7 @@ public:
                 return false;
             }
 
-            isUniquelyOwned = isUniquelyOwned && prev->_children[c].use_count() == 1;
+            isUniquelyOwned = isUniquelyOwned && prev->_children.get(c).use_count() == 1;
             context.push_back(std::make_pair(node, isUniquelyOwned));
             depth = node->_depth + node->_trieKey.size();
             prev = node;
@@ -610,15 +589,15 @@ public:
 
             uint8_t childFirstChar = child->_trieKey.front();
             if (!isUniquelyOwned) {
-                parent->_children[childFirstChar] = std::make_shared<Node>(*child);
-                child = parent->_children[childFirstChar].get();
+                parent->_children.set(childFirstChar, std::make_shared<Node>(*child));
+                child = parent->_children.get(childFirstChar).get();
             }
 
             parent = child;
         }
 
         // Handle the deleted node, as it is a leaf.
-        parent->_children[deleted->_trieKey.front()] = nullptr;
+        parent->_children.set(deleted->_trieKey.front(), nullptr);
 
         // 'parent' may only have one child, in which case we need to evaluate whether or not
         // this node is redundant.
@@ -688,10 +667,11 @@ public:
             if (idx != UINT8_MAX)
                 context.push_back(std::make_pair(node, idx + 1));
 
-            if (!node->_children[idx])
+            Node* child = node->_children.get(idx).get();
+            if (!child)
                 break;
 
-            node = node->_children[idx].get();
+            node = child;
             size_t mismatchIdx =
                 _comparePrefix(node->_trieKey, charKey + depth, key.size() - depth);
 
@@ -734,18 +714,14 @@ public:
             std::tie(node, idx) = context.back();
             context.pop_back();
 
-            for (auto iter = idx + node->_children.begin(); iter != node->_children.end(); ++iter) {
-                if (!(*iter))
-                    continue;
-
+            if (Node* child = node->_children.firstFrom(idx)) {
                 // There exists a node with a key larger than the one given.
-                node = iter->get();
+                node = child;
                 if (node->_data)
                     return const_iterator(_root, node);
 
                 // Need to search this node's children for the next largest node.
                 context.push_back(std::make_pair(node, 0));
-                break;
             }
 
             if (node->_trieKey.empty() && context.empty()) {
@@ -782,7 +758,321 @@ public:
         return _walkTree(_root.get(), 0);
     }
 
+    /**
+     * Layouts of the children of a node, named for the most children each can hold.
+     */
+    enum class NodeType : uint8_t { kNode4, kNode16, kNode48, kNode256 };
+
+    /**
+     * Memory used by the nodes of this tree, not counting the keys and values they hold.
+     * 'fixedLayoutBytes' is what the same nodes would use if each had a slot for all 256 children.
+     */
+    struct NodeMemoryStats {
+        size_type numNodes = 0;
+        std::array<size_type, 4> numNodesByType{};  // Indexed by NodeType.
+        size_type bytes = 0;
+        size_type fixedLayoutBytes = 0;
+    };
+
+    NodeMemoryStats memory_stats_for_test() const {
+        NodeMemoryStats stats;
+        _addMemoryStats(_root.get(), &stats);
+        return stats;
+    }
+
 private:
+    /**
+     * The children of a Node, keyed by the first byte of their trie key. As in an adaptive radix
+     * tree, the layout follows the number of children: up to 4 or 16 children are kept in sorted
+     * parallel arrays of keys and pointers, up to 48 in a pointer array reached through a
+     * 256-entry index, and beyond that in a direct array of 256 pointers. Leaves own no storage.
+     *
+     * The layout grows and shrinks in place, so a Node keeps its address when children are added
+     * or removed, and copying a Node copies its children in their current layout.
+     */
+    class Children {
+    public:
+        NodeType type() const {
+            return _type;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        bool empty() const {
+            return _size == 0;
+        }
+
+        /**
+         * Returns the child for 'key', or a null pointer if there is none.
+         */
+        const std::shared_ptr<Node>& get(uint8_t key) const {
+            const std::shared_ptr<Node>* slot = _find(key);
+            return slot ? *slot : _nullChild();
+        }
+
+        /**
+         * Sets the child for 'key', replacing any existing one. A null 'child' removes it.
+         */
+        void set(uint8_t key, std::shared_ptr<Node> child) {
+            if (!child) {
+                _erase(key);
+                return;
+            }
+
+            if (auto slot = const_cast<std::shared_ptr<Node>*>(_find(key)); slot && *slot) {
+                *slot = std::move(child);
+                return;
+            }
+
+            if (_size == _ptrs.size()) {
+                // Leaves start out as a Node4 once they get their first child.
+                _relayout(_ptrs.empty() ? NodeType::kNode4
+                                        : static_cast<NodeType>(static_cast<int>(_type) + 1));
+            }
+            _insert(key, std::move(child));
+        }
+
+        /**
+         * Returns the smallest key at least 'from' which has a child, or 256 if there is none.
+         */
+        unsigned nextKey(unsigned from) const {
+            switch (_type) {
+                case NodeType::kNode4:
+                case NodeType::kNode16:
+                    for (size_t i = 0; i < _size; ++i) {
+                        if (_keys[i] >= from)
+                            return _keys[i];
+                    }
+                    return 256;
+                case NodeType::kNode48:
+                    for (unsigned key = from; key < 256; ++key) {
+                        if (_keys[key])
+                            return key;
+                    }
+                    return 256;
+                case NodeType::kNode256:
+                    for (unsigned key = from; key < 256; ++key) {
+                        if (_ptrs[key])
+                            return key;
+                    }
+                    return 256;
+            }
+            MONGO_UNREACHABLE;
+        }
+
+        /**
+         * Returns the largest key less than 'before' which has a child, or -1 if there is none.
+         */
+        int prevKey(int before) const {
+            switch (_type) {
+                case NodeType::kNode4:
+                case NodeType::kNode16:
+                    for (int i = static_cast<int>(_size) - 1; i >= 0; --i) {
+                        if (_keys[i] < before)
+                            return _keys[i];
+                    }
+                    return -1;
+                case NodeType::kNode48:
+                    for (int key = std::min(before, 256) - 1; key >= 0; --key) {
+                        if (_keys[key])
+                            return key;
+                    }
+                    return -1;
+                case NodeType::kNode256:
+                    for (int key = std::min(before, 256) - 1; key >= 0; --key) {
+                        if (_ptrs[key])
+                            return key;
+                    }
+                    return -1;
+            }
+            MONGO_UNREACHABLE;
+        }
+
+        /**
+         * Returns the child with the smallest key at least 'from', or nullptr.
+         */
+        Node* firstFrom(unsigned from) const {
+            unsigned key = nextKey(from);
+            return key < 256 ? get(key).get() : nullptr;
+        }
+
+        /**
+         * Returns the child with the largest key less than 'before', or nullptr.
+         */
+        Node* lastBefore(int before) const {
+            int key = prevKey(before);
+            return key >= 0 ? get(key).get() : nullptr;
+        }
+
+        /**
+         * Calls 'func' with each child in key order.
+         */
+        template <typename Func>
+        void forEach(Func&& func) const {
+            for (unsigned key = nextKey(0); key < 256; key = nextKey(key + 1)) {
+                func(get(key));
+            }
+        }
+
+        /**
+         * Returns the number of bytes of child storage allocated outside of this object.
+         */
+        size_t storageBytes() const {
+            return _keys.capacity() + _ptrs.capacity() * sizeof(std::shared_ptr<Node>);
+        }
+
+    private:
+        static const std::shared_ptr<Node>& _nullChild() {
+            static const std::shared_ptr<Node> nullChild;
+            return nullChild;
+        }
+
+        /**
+         * Returns the slot holding the child for 'key', or nullptr if there is no such slot. In a
+         * kNode256 the slot exists but may be empty.
+         */
+        const std::shared_ptr<Node>* _find(uint8_t key) const {
+            switch (_type) {
+                case NodeType::kNode4:
+                case NodeType::kNode16:
+                    for (size_t i = 0; i < _size && _keys[i] <= key; ++i) {
+                        if (_keys[i] == key)
+                            return &_ptrs[i];
+                    }
+                    return nullptr;
+                case NodeType::kNode48:
+                    return _keys[key] ? &_ptrs[_keys[key] - 1] : nullptr;
+                case NodeType::kNode256:
+                    return &_ptrs[key];
+            }
+            MONGO_UNREACHABLE;
+        }
+
+        /**
+         * Adds a child for 'key', which must not have one, assuming there is room for it.
+         */
+        void _insert(uint8_t key, std::shared_ptr<Node> child) {
+            switch (_type) {
+                case NodeType::kNode4:
+                case NodeType::kNode16: {
+                    size_t pos = _size;
+                    for (; pos > 0 && _keys[pos - 1] > key; --pos) {
+                        _keys[pos] = _keys[pos - 1];
+                        _ptrs[pos] = std::move(_ptrs[pos - 1]);
+                    }
+                    _keys[pos] = key;
+                    _ptrs[pos] = std::move(child);
+                    break;
+                }
+                case NodeType::kNode48: {
+                    size_t slot = 0;
+                    while (_ptrs[slot])
+                        ++slot;
+                    _keys[key] = slot + 1;
+                    _ptrs[slot] = std::move(child);
+                    break;
+                }
+                case NodeType::kNode256:
+                    _ptrs[key] = std::move(child);
+                    break;
+            }
+            ++_size;
+        }
+
+        void _erase(uint8_t key) {
+            switch (_type) {
+                case NodeType::kNode4:
+                case NodeType::kNode16: {
+                    size_t pos = 0;
+                    while (pos < _size && _keys[pos] != key)
+                        ++pos;
+                    if (pos == _size)
+                        return;
+                    for (; pos + 1 < _size; ++pos) {
+                        _keys[pos] = _keys[pos + 1];
+                        _ptrs[pos] = std::move(_ptrs[pos + 1]);
+                    }
+                    _ptrs[pos].reset();
+                    break;
+                }
+                case NodeType::kNode48:
+                    if (!_keys[key])
+                        return;
+                    _ptrs[_keys[key] - 1].reset();
+                    _keys[key] = 0;
+                    break;
+                case NodeType::kNode256:
+                    if (!_ptrs[key])
+                        return;
+                    _ptrs[key].reset();
+                    break;
+            }
+            --_size;
+
+            // Shrink once well below the capacity of the next smaller layout, so that a node
+            // hovering around a boundary does not change layout on every insert and erase.
+            if (_size == 0) {
+                _keys = std::vector<uint8_t>();
+                _ptrs = std::vector<std::shared_ptr<Node>>();
+                _type = NodeType::kNode4;
+            } else if (_type == NodeType::kNode16 && _size <= 3) {
+                _relayout(NodeType::kNode4);
+            } else if (_type == NodeType::kNode48 && _size <= 12) {
+                _relayout(NodeType::kNode16);
+            } else if (_type == NodeType::kNode256 && _size <= 40) {
+                _relayout(NodeType::kNode48);
+            }
+        }
+
+        /**
+         * Moves the children into a new layout of type 'type', which must have room for them.
+         */
+        void _relayout(NodeType type) {
+            std::vector<std::pair<uint8_t, std::shared_ptr<Node>>> children;
+            children.reserve(_size);
+            for (unsigned key = nextKey(0); key < 256; key = nextKey(key + 1)) {
+                children.emplace_back(key, get(key));
+            }
+
+            _type = type;
+            _size = 0;
+            switch (type) {
+                case NodeType::kNode4:
+                    _keys = std::vector<uint8_t>(4);
+                    _ptrs = std::vector<std::shared_ptr<Node>>(4);
+                    break;
+                case NodeType::kNode16:
+                    _keys = std::vector<uint8_t>(16);
+                    _ptrs = std::vector<std::shared_ptr<Node>>(16);
+                    break;
+                case NodeType::kNode48:
+                    _keys = std::vector<uint8_t>(256);
+                    _ptrs = std::vector<std::shared_ptr<Node>>(48);
+                    break;
+                case NodeType::kNode256:
+                    _keys = std::vector<uint8_t>();
+                    _ptrs = std::vector<std::shared_ptr<Node>>(256);
+                    break;
+            }
+
+            for (auto&& child : children) {
+                _insert(child.first, std::move(child.second));
+            }
+        }
+
+        NodeType _type = NodeType::kNode4;
+        uint16_t _size = 0;
+
+        // Sorted keys for kNode4 and kNode16. For kNode48, 1 + the slot in '_ptrs' of each key's
+        // child, or 0 if the key has none. Unused for kNode256.
+        std::vector<uint8_t> _keys;
+
+        // The child pointers, whose size is the capacity of the layout.
+        std::vector<std::shared_ptr<Node>> _ptrs;
+    };
+
     class Node {
         friend class RadixStore;
 
@@ -822,18 +1112,14 @@ private:
         }
 
         bool isLeaf() const {
-            for (auto child : _children) {
-                if (child != nullptr)
-                    return false;
-            }
-            return true;
+            return _children.empty();
         }
 
     protected:
         unsigned int _depth = 0;
         std::vector<uint8_t> _trieKey;
         boost::optional<value_type> _data;
-        std::array<std::shared_ptr<Node>, 256> _children;
+        Children _children;
     };
 
     /**
@@ -910,14 +1196,24 @@ private:
         }
         ret.push_back('\n');
 
-        for (auto child : node->_children) {
-            if (child != nullptr) {
-                ret.append(_walkTree(child.get(), depth + 1));
-            }
-        }
+        node->_children.forEach([&](const std::shared_ptr<Node>& child) {
+            ret.append(_walkTree(child.get(), depth + 1));
+        });
         return ret;
     }
 
+    void _addMemoryStats(const Node* node, NodeMemoryStats* stats) const {
+        const size_type nodeBytes = sizeof(Node) + node->_trieKey.capacity();
+        stats->numNodes++;
+        stats->numNodesByType[static_cast<size_t>(node->_children.type())]++;
+        stats->bytes += nodeBytes + node->_children.storageBytes();
+        stats->fixedLayoutBytes +=
+            nodeBytes - sizeof(Children) + sizeof(std::array<std::shared_ptr<Node>, 256>);
+
+        node->_children.forEach(
+            [&](const std::shared_ptr<Node>& child) { _addMemoryStats(child.get(), stats); });
+    }
+
     Node* _findNode(const Key& key) const {
         const char* charKey = key.data();
 
@@ -938,7 +1234,7 @@ private:
 
         depth = _root->_depth + _root->_trieKey.size();
         uint8_t childFirstChar = static_cast<uint8_t>(charKey[depth]);
-        auto node = _root->_children[childFirstChar];
+        Node* node = _root->_children.get(childFirstChar).get();
 
         while (node != nullptr) {
 
@@ -949,13 +1245,13 @@ private:
             if (mismatchIdx != node->_trieKey.size()) {
                 return nullptr;
             } else if (mismatchIdx == key.size() - depth && node->_data) {
-                return node.get();
+                return node;
             }
 
             depth = node->_depth + node->_trieKey.size();
 
             childFirstChar = static_cast<uint8_t>(charKey[depth]);
-            node = node->_children[childFirstChar];
+            node = node->_children.get(childFirstChar).get();
         }
 
         return nullptr;
@@ -1007,12 +1303,12 @@ private:
         _makeRootUnique();
 
         Node* prev = _root.get();
-        std::shared_ptr<Node> node = prev->_children[childFirstChar];
+        std::shared_ptr<Node> node = prev->_children.get(childFirstChar);
         while (node != nullptr) {
             if (node.use_count() - 1 > 1) {
                 // Copy node on a modifying operation when it isn't owned uniquely.
                 node = std::make_shared<Node>(*node);
-                prev->_children[childFirstChar] = node;
+                prev->_children.set(childFirstChar, node);
             }
 
             // 'node' is uniquely owned at this point, so we are free to modify it.
@@ -1045,7 +1341,7 @@ private:
 
                 // Change the current node's trieKey and make a child of the new node.
                 newKey = _makeKey(node->_trieKey, mismatchIdx, node->_trieKey.size() - mismatchIdx);
-                newNode->_children[newKey.front()] = node;
+                newNode->_children.set(newKey.front(), node);
 
                 node->_trieKey = newKey;
                 node->_depth = newNode->_depth + newNode->_trieKey.size();
@@ -1077,7 +1373,7 @@ private:
             childFirstChar = static_cast<uint8_t>(charKey[depth]);
 
             prev = node.get();
-            node = node->_children[childFirstChar];
+            node = node->_children.get(childFirstChar);
         }
 
         // Add a completely new child to a node. The new key at this depth does not
@@ -1125,7 +1421,7 @@ private:
         if (value) {
             newNode->_data.emplace(value->first, value->second);
         }
-        node->_children[key.front()] = newNode;
+        node->_children.set(key.front(), newNode);
         return newNode.get();
     }
 
@@ -1146,7 +1442,7 @@ private:
 
         while (depth < key.size()) {
             uint8_t c = static_cast<uint8_t>(charKey[depth]);
-            node = node->_children[c].get();
+            node = node->_children.get(c).get();
             context.push_back(node);
             depth = node->_depth + node->_trieKey.size();
         }
@@ -1181,16 +1477,10 @@ private:
         }
 
         // Determine if this node has only one child.
-        std::shared_ptr<Node> onlyChild = nullptr;
-
-        for (size_t i = 0; i < node->_children.size(); ++i) {
-            if (node->_children[i] != nullptr) {
-                if (onlyChild != nullptr) {
-                    return;
-                }
-                onlyChild = node->_children[i];
-            }
+        if (node->_children.size() != 1) {
+            return;
         }
+        std::shared_ptr<Node> onlyChild = node->_children.get(node->_children.nextKey(0));
 
         // Append the child's key onto the parent.
         for (char item : onlyChild->_trieKey) {
@@ -1213,7 +1503,7 @@ private:
         context[0] = replaceNode;
 
         for (size_t node = 1; node < context.size(); node++) {
-            replaceNode = replaceNode->_children[trieKeyIndex[node - 1]].get();
+            replaceNode = replaceNode->_children.get(trieKeyIndex[node - 1]).get();
             context[node] = replaceNode;
         }
     }
@@ -1238,13 +1528,13 @@ private:
         for (size_t idx = 1; idx < context.size(); idx++) {
             node = context[idx];
 
-            if (prev->_children[node->_trieKey.front()].use_count() > 1) {
+            if (prev->_children.get(node->_trieKey.front()).use_count() > 1) {
                 std::shared_ptr<Node> nodeCopy = std::make_shared<Node>(*node);
-                prev->_children[nodeCopy->_trieKey.front()] = nodeCopy;
+                prev->_children.set(nodeCopy->_trieKey.front(), nodeCopy);
                 context[idx] = nodeCopy.get();
                 prev = nodeCopy.get();
             } else {
-                prev = prev->_children[node->_trieKey.front()].get();
+                prev = prev->_children.get(node->_trieKey.front()).get();
             }
         }
 
@@ -1355,13 +1645,20 @@ private:
         if (!current->_trieKey.empty())
             trieKeyIndex.push_back(current->_trieKey.at(0));
 
-        for (size_t key = 0; key < 256; ++key) {
+        for (unsigned key = 0; key < 256; ++key) {
             // Since _makeBranchUnique may make changes to the pointer addresses in recursive calls.
             current = context.back();
 
-            Node* node = current->_children[key].get();
-            Node* baseNode = base->_children[key].get();
-            Node* otherNode = other->_children[key].get();
+            // Skip ahead to the next key for which any of the three trees has a branch.
+            key = std::min({current->_children.nextKey(key),
+                            base->_children.nextKey(key),
+                            other->_children.nextKey(key)});
+            if (key == 256)
+                break;
+
+            Node* node = current->_children.get(key).get();
+            Node* baseNode = base->_children.get(key).get();
+            Node* otherNode = other->_children.get(key).get();
 
             if (!node && !baseNode && !otherNode)
                 continue;
@@ -1379,7 +1676,7 @@ private:
                     // modifications that go on in _makeBranchUnique.
                     _rebuildContext(context, trieKeyIndex);
 
-                    current->_children[key] = other->_children[key];
+                    current->_children.set(key, other->_children.get(key));
                 } else if (!otherNode || (baseNode && baseNode != otherNode)) {
                     // Either the master tree and working tree remove the same branch, or the master
                     // tree updated the branch while the working tree removed the branch, resulting
@@ -1392,12 +1689,12 @@ private:
 
                     current = _makeBranchUnique(context);
                     _rebuildContext(context, trieKeyIndex);
-                    current->_children[key] = nullptr;
+                    current->_children.set(key, nullptr);
                 } else if (baseNode && otherNode && baseNode == node) {
                     // If base and current point to the same node, then master changed.
                     current = _makeBranchUnique(context);
                     _rebuildContext(context, trieKeyIndex);
-                    current->_children[key] = other->_children[key];
+                    current->_children.set(key, other->_children.get(key));
                 }
             } else if (baseNode && otherNode && baseNode != otherNode) {
                 // If all three are unique and leaf nodes, then it is a merge conflict.
@@ -1440,12 +1737,7 @@ private:
             if (node->_children.empty())
                 return nullptr;
 
-            for (auto child : node->_children) {
-                if (child != nullptr) {
-                    node = child.get();
-                    break;
-                }
-            }
+            node = node->_children.firstFrom(0);
         }
         return node;
     }
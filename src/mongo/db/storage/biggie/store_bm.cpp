@@ -0,0 +1,131 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <algorithm>
+#include <benchmark/benchmark.h>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "mongo/db/storage/biggie/store.h"
+
+namespace mongo {
+namespace biggie {
+namespace {
+
+/**
+ * Returns 'num' distinct keys shaped like the record ids the biggie record store uses: a common
+ * prefix followed by a big-endian integer, so that the tree has the long shared paths and dense
+ * low levels of a real collection.
+ */
+std::vector<std::string> makeKeys(int64_t num) {
+    std::vector<std::string> keys;
+    keys.reserve(num);
+    for (int64_t i = 0; i < num; ++i) {
+        std::string key = "collection-1-";
+        for (int shift = 56; shift >= 0; shift -= 8) {
+            key.push_back(static_cast<char>((i * 7919) >> shift));
+        }
+        keys.push_back(std::move(key));
+    }
+    return keys;
+}
+
+StringStore makeStore(const std::vector<std::string>& keys) {
+    StringStore store;
+    for (auto&& key : keys) {
+        store.insert(StringStore::value_type(key, "value"));
+    }
+    return store;
+}
+
+/**
+ * Reports the memory used by the nodes of 'store', and what the nodes would use if each had a
+ * slot for every possible child as they did before nodes had adaptive layouts.
+ */
+void reportMemory(benchmark::State& state, const StringStore& store) {
+    auto stats = store.memory_stats_for_test();
+    state.counters["bytesPerKey"] = static_cast<double>(stats.bytes) / store.size();
+    state.counters["fixedLayoutBytesPerKey"] =
+        static_cast<double>(stats.fixedLayoutBytes) / store.size();
+    state.counters["nodesPerKey"] = static_cast<double>(stats.numNodes) / store.size();
+}
+
+void BM_RadixStoreInsert(benchmark::State& state) {
+    auto keys = makeKeys(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(makeStore(keys));
+    }
+    state.SetItemsProcessed(state.iterations() * keys.size());
+    reportMemory(state, makeStore(keys));
+}
+
+void BM_RadixStoreFind(benchmark::State& state) {
+    auto keys = makeKeys(state.range(0));
+    auto store = makeStore(keys);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(34862));
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(store.find(keys[i]));
+        if (++i == keys.size())
+            i = 0;
+    }
+    state.SetItemsProcessed(state.iterations());
+    reportMemory(state, store);
+}
+
+void BM_RadixStoreRangeScan(benchmark::State& state) {
+    constexpr int kScanLength = 100;
+    auto keys = makeKeys(state.range(0));
+    auto store = makeStore(keys);
+    std::shuffle(keys.begin(), keys.end(), std::mt19937(34862));
+
+    size_t i = 0;
+    for (auto _ : state) {
+        auto it = store.lower_bound(keys[i]);
+        for (int n = 0; n < kScanLength && it != store.end(); ++n, ++it) {
+            benchmark::DoNotOptimize(it->second);
+        }
+        if (++i == keys.size())
+            i = 0;
+    }
+    state.SetItemsProcessed(state.iterations() * kScanLength);
+    reportMemory(state, store);
+}
+
+BENCHMARK(BM_RadixStoreInsert)->Range(1 << 10, 1 << 18);
+BENCHMARK(BM_RadixStoreFind)->Range(1 << 10, 1 << 18);
+BENCHMARK(BM_RadixStoreRangeScan)->Range(1 << 10, 1 << 18);
+
+}  // namespace
+}  // namespace biggie
+}  // namespace mongo
@@ -2492,5 +2492,70 @@ TEST_F(RadixStoreTest, LowerBoundEndpoint) {
     ASSERT_TRUE(it == thisStore.end());
 }
 
+TEST_F(RadixStoreTest, NodeLayoutGrowsAndShrinksWithChildren) {
+    using NodeType = StringStore::NodeType;
+    auto rootNodeType = [](const StringStore& store) {
+        // Every key is a single byte, so the root is the only node with children.
+        auto stats = store.memory_stats_for_test();
+        for (size_t type = 0; type < stats.numNodesByType.size(); type++) {
+            if (type != static_cast<size_t>(NodeType::kNode4)) {
+                ASSERT_LTE(stats.numNodesByType[type], 1UL);
+                if (stats.numNodesByType[type] == 1)
+                    return static_cast<NodeType>(type);
+            }
+        }
+        return NodeType::kNode4;
+    };
+    auto key = [](int i) { return std::string(1, static_cast<char>(i * 5)); };
+
+    for (int i = 1; i <= 50; i++) {
+        thisStore.insert(value_type(key(i), std::to_string(i)));
+        if (i == 10) {
+            otherStore = thisStore;
+        }
+
+        NodeType expected = i <= 4 ? NodeType::kNode4
+                                   : i <= 16 ? NodeType::kNode16
+                                             : i <= 48 ? NodeType::kNode48 : NodeType::kNode256;
+        ASSERT(rootNodeType(thisStore) == expected);
+        for (int j = 1; j <= i; j++) {
+            ASSERT_EQ(thisStore.find(key(j))->second, std::to_string(j));
+        }
+    }
+
+    // Growing the shared root copied it, leaving the snapshot with its own Node16.
+    ASSERT_EQ(otherStore.size(), StringStore::size_type(10));
+    ASSERT(rootNodeType(otherStore) == NodeType::kNode16);
+    ASSERT_TRUE(otherStore.find(key(11)) == otherStore.end());
+
+    for (int i = 50; i > 0; i--) {
+        ASSERT_TRUE(thisStore.erase(key(i)));
+        const int size = i - 1;
+        NodeType expected = size > 40 ? NodeType::kNode256
+                                      : size > 12 ? NodeType::kNode48
+                                                  : size > 3 ? NodeType::kNode16 : NodeType::kNode4;
+        ASSERT(rootNodeType(thisStore) == expected);
+        ASSERT_TRUE(thisStore.find(key(i)) == thisStore.end());
+        if (size > 0) {
+            ASSERT_EQ(thisStore.rbegin()->first, key(size));
+        }
+    }
+    ASSERT_TRUE(thisStore.empty());
+}
+
+TEST_F(RadixStoreTest, NodeMemoryIsProportionalToChildren) {
+    for (int i = 0; i < 1000; i++) {
+        thisStore.insert(value_type("key" + std::to_string(i), "value"));
+    }
+
+    auto stats = thisStore.memory_stats_for_test();
+    ASSERT_GT(stats.numNodes, 1000UL);
+
+    // Most nodes are leaves, which own no child storage, and no node needs all 256 child slots.
+    ASSERT_LT(stats.bytes * 10, stats.fixedLayoutBytes);
+    ASSERT_EQ(stats.numNodesByType[static_cast<size_t>(StringStore::NodeType::kNode256)],
+              0UL);
+}
+
 }  // namespace biggie
 }  // namespace mongo
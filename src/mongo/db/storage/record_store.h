@@ -37,6 +37,7 @@
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/record_id.h"
 #include "mongo/db/storage/record_data.h"
+#include "mongo/util/string_map.h"
 
 namespace mongo {
 
@@ -109,6 +110,17 @@ public:
      */
     virtual boost::optional<Record> next() = 0;
 
+    /**
+     * Asks the cursor to return only the top-level fields named in 'fields' from each record it
+     * returns after this call, as an owned BSONObj, keeping every occurrence of a repeated field
+     * in its original order. An empty set asks for whole records again.
+     *
+     * This is only a hint: cursors which can't do better than copying the record anyway may keep
+     * returning whole records, so callers must still apply their own projection. It must only be
+     * used on record stores whose records are BSON documents.
+     */
+    virtual void setProjectedFields(StringSet fields) {}
+
     //
     // Saving and restoring state
     //
@@ -171,6 +183,17 @@ public:
      */
     virtual boost::optional<Record> seekExact(const RecordId& id) = 0;
 
+    /**
+     * Positions a forward cursor so that the following call to next() returns the first record
+     * whose RecordId is greater than or equal to 'start'.
+     *
+     * Returns false, leaving the cursor where it was, if the cursor can't seek this way. Callers
+     * must then skip records before 'start' themselves.
+     */
+    virtual bool positionAt(const RecordId& start) {
+        return false;
+    }
+
     /**
      * Prepares for state changes in underlying data without necessarily saving the current
      * state.
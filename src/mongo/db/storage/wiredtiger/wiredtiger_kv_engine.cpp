@@ -83,6 +83,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_recovery_unit.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_session_cache.h"
 #include "mongo/db/storage/wiredtiger/wiredtiger_size_storer.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_controller.h"
 #include "mongo/platform/atomic_word.h"
 #include "mongo/util/background.h"
 #include "mongo/util/concurrency/idle_thread_block.h"
@@ -550,6 +551,26 @@ private:
 namespace {
 TicketHolder openWriteTransaction(128);
 TicketHolder openReadTransaction(128);
+WiredTigerTicketController ticketController(&openReadTransaction, &openWriteTransaction);
+
+/**
+ * Returns true when the cache is at the points where WiredTiger's default eviction settings make
+ * application threads help with eviction: 95% full, or 20% dirty.
+ */
+bool isCacheUnderEvictionPressure(WT_CONNECTION* conn) {
+    WiredTigerSession session(conn);
+    const auto getStat = [&](int key) {
+        return uassertStatusOK(WiredTigerUtil::getStatisticsValue(
+            session.getSession(), "statistics:", "statistics=(fast)", key));
+    };
+
+    const auto maxBytes = getStat(WT_STAT_CONN_CACHE_BYTES_MAX);
+    if (maxBytes <= 0)
+        return false;
+
+    return getStat(WT_STAT_CONN_CACHE_BYTES_INUSE) >= maxBytes / 100 * 95 ||
+        getStat(WT_STAT_CONN_CACHE_BYTES_DIRTY) >= maxBytes / 100 * 20;
+}
 }  // namespace
 
 OpenWriteTransactionParam::OpenWriteTransactionParam(StringData name, ServerParameterType spt)
@@ -840,6 +861,33 @@ WiredTigerKVEngine::WiredTigerKVEngine(const std::string& canonicalName,
 
     Locker::setGlobalThrottling(&openReadTransaction, &openWriteTransaction);
 
+    auto periodicRunner =
+        hasGlobalServiceContext() ? getGlobalServiceContext()->getPeriodicRunner() : nullptr;
+    if (!_readOnly && periodicRunner) {
+        ticketController.resetBaseline(Date_t::now());
+
+        PeriodicRunner::PeriodicJob job(
+            "WiredTigerTicketAdjustment",
+            [this](Client* client) {
+                const auto now = Date_t::now();
+                if (!gWiredTigerTicketAdjustmentEnabled.load()) {
+                    ticketController.resetBaseline(now);
+                    return;
+                }
+
+                try {
+                    ticketController.adjust(now, isCacheUnderEvictionPressure(_conn));
+                } catch (const DBException& ex) {
+                    warning() << "Failed to adjust the ticket pool sizes"
+                              << causedBy(ex.toStatus());
+                }
+            },
+            Milliseconds(gWiredTigerTicketAdjustmentPeriodMillis));
+
+        _ticketAdjustmentJob.emplace(periodicRunner->makeJob(std::move(job)));
+        _ticketAdjustmentJob->start();
+    }
+
     _runTimeConfigParam.reset(new WiredTigerEngineRuntimeConfigParameter(
         "wiredTigerEngineRuntimeConfig", ServerParameterType::kRuntimeOnly));
     _runTimeConfigParam->_data.second = this;
@@ -880,6 +928,7 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
         bbb.append("out", openWriteTransaction.used());
         bbb.append("available", openWriteTransaction.available());
         bbb.append("totalTickets", openWriteTransaction.outof());
+        openWriteTransaction.appendStats(&bbb);
         bbb.done();
     }
     {
@@ -887,6 +936,12 @@ void WiredTigerKVEngine::appendGlobalStats(BSONObjBuilder& b) {
         bbb.append("out", openReadTransaction.used());
         bbb.append("available", openReadTransaction.available());
         bbb.append("totalTickets", openReadTransaction.outof());
+        openReadTransaction.appendStats(&bbb);
+        bbb.done();
+    }
+    {
+        BSONObjBuilder bbb(bb.subobjStart("adjustment"));
+        ticketController.appendStats(&bbb);
         bbb.done();
     }
     bb.done();
@@ -956,6 +1011,10 @@ void WiredTigerKVEngine::_openWiredTiger(const std::string& path, const std::str
 
 void WiredTigerKVEngine::cleanShutdown() {
     log() << "WiredTigerKVEngine shutting down";
+    if (_ticketAdjustmentJob) {
+        _ticketAdjustmentJob->stop();
+        _ticketAdjustmentJob.reset();
+    }
     if (!_readOnly)
         syncSizeInfo(true);
     if (!_conn) {
@@ -47,6 +47,7 @@
 #include "mongo/db/storage/wiredtiger/wiredtiger_util.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/util/elapsed_tracker.h"
+#include "mongo/util/periodic_runner.h"
 
 namespace mongo {
 
@@ -497,5 +498,9 @@ private:
 
     std::unique_ptr<WiredTigerEngineRuntimeConfigParameter> _runTimeConfigParam;
     std::unique_ptr<WiredTigerMaxCacheOverflowSizeGBParameter> _maxCacheOverflowParam;
+
+    // Periodically resizes the read and write ticket pools while wiredTigerTicketAdjustmentEnabled
+    // is set. Not started for read-only engines or when there is no PeriodicRunner.
+    boost::optional<PeriodicJobAnchor> _ticketAdjustmentJob;
 };
 }  // namespace mongo
@@ -1978,11 +1978,8 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::next() {
         throw WriteConflictException();
     }
 
-    WT_ITEM value;
-    invariantWTOK(c->get_value(c, &value));
-
     _lastReturnedId = id;
-    return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
+    return {{id, currentRecordData(c)}};
 }
 
 boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordId& id) {
@@ -2004,12 +2001,73 @@ boost::optional<Record> WiredTigerRecordStoreCursorBase::seekExact(const RecordI
     }
     invariantWTOK(seekRet);
 
+    _lastReturnedId = id;
+    _eof = false;
+    return {{id, currentRecordData(c)}};
+}
+
+bool WiredTigerRecordStoreCursorBase::positionAt(const RecordId& start) {
+    invariant(_hasRestored);
+    if (!_forward || _oplogVisibleTs) {
+        return false;
+    }
+
+    _skipNextAdvance = false;
+    _eof = false;
+
+    // Pretend we just returned the record before 'start', so that a save() and restore() before
+    // the next call to next() come back to the same place.
+    _lastReturnedId = RecordId(start.repr() - 1);
+
+    WT_CURSOR* c = _cursor->get();
+    setKey(c, start);
+    int cmp;
+    int ret = wiredTigerPrepareConflictRetry(_opCtx, [&] { return c->search_near(c, &cmp); });
+    if (ret == WT_NOTFOUND) {
+        _eof = true;
+        return true;
+    }
+    invariantWTOK(ret);
+
+    // search_near() lands on 'start' or one of its neighbours. Return it from next() unless it
+    // is before 'start', in which case next() advances past it as usual.
+    if (cmp >= 0) {
+        RecordId id;
+        if (hasWrongPrefix(c, &id)) {
+            _eof = true;
+            return true;
+        }
+        _skipNextAdvance = true;
+    }
+    return true;
+}
+
+void WiredTigerRecordStoreCursorBase::setProjectedFields(StringSet fields) {
+    _projectedFields = std::move(fields);
+}
+
+RecordData WiredTigerRecordStoreCursorBase::currentRecordData(WT_CURSOR* c) const {
     WT_ITEM value;
     invariantWTOK(c->get_value(c, &value));
 
-    _lastReturnedId = id;
-    _eof = false;
-    return {{id, {static_cast<const char*>(value.data), static_cast<int>(value.size)}}};
+    if (_projectedFields.empty()) {
+        return {static_cast<const char*>(value.data), static_cast<int>(value.size)};
+    }
+
+    // Copy only the wanted elements out of WiredTiger's buffer. Stored documents may repeat a
+    // top-level field name, so every occurrence is kept, in order, and the caller's projection
+    // sees the same fields it would in the whole document.
+    BufBuilder buf;
+    BSONObjBuilder bob(buf);
+    for (auto&& elem : BSONObj(static_cast<const char*>(value.data))) {
+        if (_projectedFields.count(elem.fieldNameStringData())) {
+            bob.append(elem);
+        }
+    }
+    bob.doneFast();
+
+    const int size = buf.len();
+    return {buf.release(), size};
 }
 
 
@@ -444,6 +444,10 @@ public:
 
     boost::optional<Record> seekExact(const RecordId& id);
 
+    bool positionAt(const RecordId& start);
+
+    void setProjectedFields(StringSet fields);
+
     void save();
 
     void saveUnpositioned();
@@ -485,6 +489,16 @@ protected:
 private:
     bool isVisible(const RecordId& id);
 
+    /**
+     * Returns the record at which the cursor is positioned, trimmed to '_projectedFields' if
+     * there are any. Whole records point into WiredTiger's buffer and are only valid until the
+     * cursor moves; trimmed ones are built directly from that buffer and owned.
+     */
+    RecordData currentRecordData(WT_CURSOR* c) const;
+
+    // If not empty, the only top-level fields returned from each record.
+    StringSet _projectedFields;
+
     /**
      * This value is used for visibility calculations on what oplog entries can be returned to a
      * client. This value *must* be initialized/updated *before* a WiredTiger snapshot is
@@ -260,6 +260,112 @@ TEST(WiredTigerRecordStoreTest, CappedCursorRollover) {
     ASSERT(!cursor->next());
 }
 
+TEST(WiredTigerRecordStoreTest, CursorReturnsOnlyProjectedFields) {
+    unique_ptr<RecordStoreHarnessHelper> harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+
+    const BSONObj doc = BSON("_id" << 1 << "a" << 2 << "b" << BSON("c" << 3) << "d" << 4);
+    RecordId id;
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        auto res = rs->insertRecord(opCtx.get(), doc.objdata(), doc.objsize(), Timestamp());
+        ASSERT_OK(res.getStatus());
+        id = res.getValue();
+        uow.commit();
+    }
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    auto cursor = rs->getCursor(opCtx.get());
+    cursor->setProjectedFields({"b", "_id", "missing"});
+
+    auto record = cursor->next();
+    ASSERT(record);
+    ASSERT(record->data.isOwned());
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1 << "b" << BSON("c" << 3)), record->data.toBson());
+
+    record = cursor->seekExact(id);
+    ASSERT(record);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1 << "b" << BSON("c" << 3)), record->data.toBson());
+
+    // An empty set asks for whole records again.
+    cursor->setProjectedFields({});
+    record = cursor->seekExact(id);
+    ASSERT(record);
+    ASSERT_BSONOBJ_EQ(doc, record->data.toBson());
+}
+
+TEST(WiredTigerRecordStoreTest, CursorPositionAtSeeksToFirstRecordAtOrAfterStart) {
+    unique_ptr<RecordStoreHarnessHelper> harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+
+    std::vector<RecordId> ids;
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        for (int i = 0; i < 5; ++i) {
+            WriteUnitOfWork uow(opCtx.get());
+            const BSONObj doc = BSON("i" << i);
+            auto res = rs->insertRecord(opCtx.get(), doc.objdata(), doc.objsize(), Timestamp());
+            ASSERT_OK(res.getStatus());
+            ids.push_back(res.getValue());
+            uow.commit();
+        }
+    }
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    auto cursor = rs->getCursor(opCtx.get());
+
+    // Positioning on an existing record returns that record next.
+    ASSERT(cursor->positionAt(ids[2]));
+    auto record = cursor->next();
+    ASSERT(record);
+    ASSERT_EQ(ids[2], record->id);
+
+    // The position survives a save and restore before the next call to next().
+    ASSERT(cursor->positionAt(ids[3]));
+    cursor->save();
+    ASSERT(cursor->restore());
+    record = cursor->next();
+    ASSERT(record);
+    ASSERT_EQ(ids[3], record->id);
+    record = cursor->next();
+    ASSERT(record);
+    ASSERT_EQ(ids[4], record->id);
+
+    // Positioning past the last record leaves the cursor at EOF.
+    ASSERT(cursor->positionAt(RecordId(ids[4].repr() + 1)));
+    ASSERT(!cursor->next());
+
+    // Positioning before the first record returns the first record.
+    ASSERT(cursor->positionAt(RecordId(ids[0].repr() - 1)));
+    record = cursor->next();
+    ASSERT(record);
+    ASSERT_EQ(ids[0], record->id);
+}
+
+TEST(WiredTigerRecordStoreTest, CursorReturnsEveryOccurrenceOfDuplicateProjectedField) {
+    unique_ptr<RecordStoreHarnessHelper> harnessHelper(newRecordStoreHarnessHelper());
+    unique_ptr<RecordStore> rs(harnessHelper->newNonCappedRecordStore());
+
+    // BSONObjBuilder does not check for duplicate field names, and neither does the record store.
+    const BSONObj doc = BSON("_id" << 1 << "a" << 2 << "b" << 3 << "a" << 4);
+    {
+        ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+        WriteUnitOfWork uow(opCtx.get());
+        ASSERT_OK(
+            rs->insertRecord(opCtx.get(), doc.objdata(), doc.objsize(), Timestamp()).getStatus());
+        uow.commit();
+    }
+
+    ServiceContext::UniqueOperationContext opCtx(harnessHelper->newOperationContext());
+    auto cursor = rs->getCursor(opCtx.get());
+    cursor->setProjectedFields({"_id", "a"});
+
+    auto record = cursor->next();
+    ASSERT(record);
+    ASSERT_BSONOBJ_EQ(BSON("_id" << 1 << "a" << 2 << "a" << 4), record->data.toBson());
+}
+
 RecordId _oplogOrderInsertOplog(OperationContext* opCtx,
                                 const unique_ptr<RecordStore>& rs,
                                 int inc) {
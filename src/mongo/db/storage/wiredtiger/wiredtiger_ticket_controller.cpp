@@ -0,0 +1,150 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kStorage
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_controller.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/storage/wiredtiger/wiredtiger_parameters_gen.h"
+#include "mongo/util/log.h"
+
+namespace mongo {
+namespace {
+
+// A step which grew a pool is undone if throughput over the following period falls below this
+// fraction of what it was before
+const double kThroughputDropRatio = 0.9;
+
+}  // namespace
+
+WiredTigerTicketController::WiredTigerTicketController(TicketHolder* readTickets,
+                                                       TicketHolder* writeTickets) {
+    _pools.emplace_back("read", readTickets);
+    _pools.emplace_back("write", writeTickets);
+}
+
+void WiredTigerTicketController::adjust(Date_t now, bool cacheUnderPressure) {
+    stdx::lock_guard<Latch> lk(_mutex);
+
+    const auto elapsed = now - _lastSample;
+    _lastSample = now;
+    if (elapsed <= Milliseconds(0))
+        return;
+
+    for (auto& pool : _pools) {
+        _adjustPool(lk, &pool, elapsed, cacheUnderPressure);
+    }
+}
+
+void WiredTigerTicketController::resetBaseline(Date_t now) {
+    stdx::lock_guard<Latch> lk(_mutex);
+
+    _lastSample = now;
+    for (auto& pool : _pools) {
+        pool.lastStats = pool.holder->getStats();
+        pool.lastThroughput = 0;
+        pool.lastChange = 0;
+    }
+}
+
+void WiredTigerTicketController::_adjustPool(WithLock,
+                                             Pool* pool,
+                                             Milliseconds elapsed,
+                                             bool cacheUnderPressure) {
+    const auto stats = pool->holder->getStats();
+    const auto admitted = stats.admissions - pool->lastStats.admissions;
+    const double throughput = admitted * 1000.0 / durationCount<Milliseconds>(elapsed);
+    pool->lastStats = stats;
+
+    const int minTickets = gWiredTigerTicketAdjustmentMinTickets.load();
+    const int maxTickets = std::max(minTickets, gWiredTigerTicketAdjustmentMaxTickets.load());
+    const int size = pool->holder->outof();
+
+    int newSize = size;
+    StringData reason;
+    if (cacheUnderPressure) {
+        newSize = size - size / 4;
+        reason = "cachePressure"_sd;
+    } else if (pool->lastChange > 0 && throughput < pool->lastThroughput * kThroughputDropRatio) {
+        newSize = size - pool->lastChange;
+        reason = "throughputDropped"_sd;
+    } else if (stats.queued > 0 || pool->holder->used() >= size) {
+        newSize = size + gWiredTigerTicketAdjustmentStep.load();
+        reason = "saturated"_sd;
+    }
+    newSize = std::max(minTickets, std::min(maxTickets, newSize));
+
+    pool->lastThroughput = throughput;
+    pool->lastChange = 0;
+    if (newSize == size)
+        return;
+
+    const auto status = pool->holder->resize(newSize);
+    if (!status.isOK()) {
+        warning() << "Failed to resize the " << pool->name << " ticket pool from " << size
+                  << " to " << newSize << causedBy(status);
+        return;
+    }
+
+    LOG(1) << "Resized the " << pool->name << " ticket pool from " << size << " to " << newSize
+           << " (" << reason << ", " << throughput << " admissions/s)";
+
+    pool->lastChange = newSize - size;
+    if (newSize > size) {
+        pool->increases++;
+    } else {
+        pool->decreases++;
+    }
+    pool->lastDecision = Decision{_lastSample, size, newSize, reason.toString()};
+}
+
+void WiredTigerTicketController::appendStats(BSONObjBuilder* b) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+
+    b->append("enabled", gWiredTigerTicketAdjustmentEnabled.load());
+    for (const auto& pool : _pools) {
+        BSONObjBuilder poolBuilder(b->subobjStart(pool.name));
+        poolBuilder.append("increases", pool.increases);
+        poolBuilder.append("decreases", pool.decreases);
+        if (pool.lastDecision) {
+            BSONObjBuilder decisionBuilder(poolBuilder.subobjStart("lastDecision"));
+            decisionBuilder.append("at", pool.lastDecision->when);
+            decisionBuilder.append("from", pool.lastDecision->from);
+            decisionBuilder.append("to", pool.lastDecision->to);
+            decisionBuilder.append("reason", pool.lastDecision->reason);
+            decisionBuilder.doneFast();
+        }
+        poolBuilder.doneFast();
+    }
+}
+
+}  // namespace mongo
@@ -0,0 +1,109 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <string>
+#include <vector>
+
+#include "mongo/platform/mutex.h"
+#include "mongo/util/concurrency/ticketholder.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+
+class BSONObjBuilder;
+
+/**
+ * Resizes the storage engine's ticket pools at runtime, in place of hand tuning
+ * wiredTigerConcurrentReadTransactions and wiredTigerConcurrentWriteTransactions.
+ *
+ * Each call to adjust() looks at what every pool did since the previous call and moves its size
+ * with an additive-increase, multiplicative-decrease policy:
+ *  - under cache pressure the pool is cut by a quarter, since more concurrency only adds to the
+ *    eviction work;
+ *  - if the previous step grew the pool and throughput fell, that step is undone;
+ *  - if operations queued for tickets or every ticket was in use, the pool grows by a step.
+ * Sizes stay within the wiredTigerTicketAdjustment{Min,Max}Tickets bounds.
+ */
+class WiredTigerTicketController {
+    WiredTigerTicketController(const WiredTigerTicketController&) = delete;
+    WiredTigerTicketController& operator=(const WiredTigerTicketController&) = delete;
+
+public:
+    WiredTigerTicketController(TicketHolder* readTickets, TicketHolder* writeTickets);
+
+    /**
+     * Samples the ticket pools and resizes them as described above.
+     */
+    void adjust(Date_t now, bool cacheUnderPressure);
+
+    /**
+     * Samples the ticket pools without resizing them, so that the next adjust() only considers
+     * what happens from now on.
+     */
+    void resetBaseline(Date_t now);
+
+    /**
+     * Appends the number of adjustments made to each pool and the most recent decision.
+     */
+    void appendStats(BSONObjBuilder* b) const;
+
+private:
+    struct Decision {
+        Date_t when;
+        int from = 0;
+        int to = 0;
+        std::string reason;
+    };
+
+    struct Pool {
+        Pool(std::string name, TicketHolder* holder) : name(std::move(name)), holder(holder) {}
+
+        std::string name;
+        TicketHolder* holder;
+
+        TicketHolder::Stats lastStats;
+        double lastThroughput = 0;
+        int lastChange = 0;
+
+        long long increases = 0;
+        long long decreases = 0;
+        boost::optional<Decision> lastDecision;
+    };
+
+    void _adjustPool(WithLock, Pool* pool, Milliseconds elapsed, bool cacheUnderPressure);
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("WiredTigerTicketController::_mutex");
+    std::vector<Pool> _pools;
+    Date_t _lastSample;
+};
+
+}  // namespace mongo
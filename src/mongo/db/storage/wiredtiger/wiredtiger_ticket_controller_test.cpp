@@ -0,0 +1,111 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/db/storage/wiredtiger/wiredtiger_ticket_controller.h"
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/unittest/unittest.h"
+
+namespace mongo {
+namespace {
+
+TEST(WiredTigerTicketControllerTest, GrowsSaturatedPoolAndShrinksUnderCachePressure) {
+    TicketHolder readTickets(32);
+    TicketHolder writeTickets(32);
+    WiredTigerTicketController controller(&readTickets, &writeTickets);
+
+    auto now = Date_t::now();
+    controller.resetBaseline(now);
+
+    // Every write ticket is in use, while reads are idle
+    for (int i = 0; i < 32; ++i) {
+        ASSERT(writeTickets.tryAcquire());
+    }
+
+    now += Seconds(1);
+    controller.adjust(now, false);
+    ASSERT_EQ(readTickets.outof(), 32);
+    ASSERT_EQ(writeTickets.outof(), 40);
+
+    for (int i = 0; i < 32; ++i) {
+        writeTickets.release();
+    }
+
+    now += Seconds(1);
+    controller.adjust(now, true);
+    ASSERT_EQ(readTickets.outof(), 24);
+    ASSERT_EQ(writeTickets.outof(), 30);
+
+    BSONObjBuilder b;
+    controller.appendStats(&b);
+    const auto stats = b.obj();
+    ASSERT_EQ(stats["write"]["increases"].numberLong(), 1);
+    ASSERT_EQ(stats["write"]["decreases"].numberLong(), 1);
+    ASSERT_EQ(stats["write"]["lastDecision"]["reason"].str(), "cachePressure");
+    ASSERT_EQ(stats["read"]["lastDecision"]["to"].numberInt(), 24);
+}
+
+TEST(WiredTigerTicketControllerTest, UndoesGrowthWhichLowersThroughput) {
+    TicketHolder readTickets(32);
+    TicketHolder writeTickets(32);
+    WiredTigerTicketController controller(&readTickets, &writeTickets);
+
+    auto now = Date_t::now();
+    controller.resetBaseline(now);
+
+    const auto admit = [&](int n) {
+        for (int i = 0; i < n; ++i) {
+            writeTickets.waitForTicket();
+            writeTickets.release();
+        }
+    };
+
+    // Saturate the pool while admitting 100 operations, which grows it by a step
+    admit(100);
+    for (int i = 0; i < 32; ++i) {
+        ASSERT(writeTickets.tryAcquire());
+    }
+    now += Seconds(1);
+    controller.adjust(now, false);
+    ASSERT_EQ(writeTickets.outof(), 40);
+    for (int i = 0; i < 32; ++i) {
+        writeTickets.release();
+    }
+
+    // Throughput then halves, so the step is taken back
+    admit(50);
+    now += Seconds(1);
+    controller.adjust(now, false);
+    ASSERT_EQ(writeTickets.outof(), 32);
+}
+
+}  // namespace
+}  // namespace mongo
@@ -128,6 +128,28 @@ std::unique_ptr<mongo::DBClientCursor> MockDBClientConnection::query(
                                                      queryOptions,
                                                      batchSize));
 
+        // A simple mock implementation of an index bounded query, where we only keep the documents
+        // whose field named in $min or $max lies in [$min, $max). Documents are not sorted, so the
+        // bounds only select a contiguous range if they were inserted in index order.
+        auto minElem = query.obj["$min"];
+        auto maxElem = query.obj["$max"];
+        if (minElem.isABSONObj() || maxElem.isABSONObj()) {
+            auto min = minElem.isABSONObj() ? minElem.Obj().firstElement() : BSONElement();
+            auto max = maxElem.isABSONObj() ? maxElem.Obj().firstElement() : BSONElement();
+            BSONArrayBuilder builder;
+            for (auto&& elem : result) {
+                auto doc = elem.Obj();
+                if (!min.eoo() && doc[min.fieldNameStringData()].woCompare(min, false) < 0) {
+                    continue;
+                }
+                if (!max.eoo() && doc[max.fieldNameStringData()].woCompare(max, false) >= 0) {
+                    continue;
+                }
+                builder.append(doc);
+            }
+            result = BSONArray(builder.obj());
+        }
+
         BSONArray resultsInCursor;
 
         // A simple mock implementation of a resumable query, where we skip the first 'n' fields
@@ -428,6 +428,45 @@ TEST_F(QueryStageCachedPlan, EntriesAreNotDeactivatedWhenInactiveEntriesDisabled
     ASSERT_EQ(cache->get(*shapeCq).state, PlanCache::CacheEntryState::kPresentActive);
 }
 
+TEST_F(QueryStageCachedPlan, EvictsDriftedEntryWhenTrialPeriodHitsEOF) {
+    internalQueryCacheRuntimeDriftMinExecutions.store(1);
+    ON_BLOCK_EXIT([] { internalQueryCacheRuntimeDriftMinExecutions.store(20); });
+
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    Collection* collection = ctx.getCollection();
+    ASSERT(collection);
+
+    // Create an active cache entry whose winning plan found no results in a single work cycle.
+    const auto cq =
+        canonicalQueryFromFilterObj(opCtx(), nss, fromjson("{a: {$gte: 11}, b: {$gte: 11}}"));
+    PlanCache* cache = CollectionQueryInfo::get(collection).getPlanCache();
+    forceReplanning(collection, cq.get());
+    forceReplanning(collection, cq.get());
+    ASSERT_EQ(cache->get(*cq).state, PlanCache::CacheEntryState::kPresentActive);
+
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(&_opCtx, collection, cq.get(), &plannerParams);
+
+    // The cached plan now takes far more work cycles per result than during its trial period, but
+    // not so many that the trial period replans, so the plan reaches EOF within the trial.
+    const size_t decisionWorks = 50;
+    auto mockChild = std::make_unique<QueuedDataStage>(&_opCtx, &_ws);
+    for (size_t i = 0; i < 100; i++) {
+        mockChild->pushBack(PlanStage::NEED_TIME);
+    }
+    CachedPlanStage cachedPlanStage(
+        &_opCtx, collection, &_ws, cq.get(), plannerParams, decisionWorks, std::move(mockChild));
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD,
+                                _opCtx.getServiceContext()->getFastClockSource());
+    ASSERT_OK(cachedPlanStage.pickBestPlan(&yieldPolicy));
+    ASSERT_EQ(cache->get(*cq).state, PlanCache::CacheEntryState::kPresentActive);
+
+    // Finding out that the execution is over reports it to the plan cache, which evicts the entry.
+    ASSERT_TRUE(cachedPlanStage.isEOF());
+    ASSERT_EQ(cache->get(*cq).state, PlanCache::CacheEntryState::kNotPresent);
+}
+
 TEST_F(QueryStageCachedPlan, ThrowsOnYieldRecoveryWhenIndexIsDroppedBeforePlanSelection) {
     // Create an index which we will drop later on.
     BSONObj keyPattern = BSON("c" << 1);
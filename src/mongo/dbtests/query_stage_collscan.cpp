@@ -42,15 +42,19 @@
 #include "mongo/db/db_raii.h"
 #include "mongo/db/dbdirectclient.h"
 #include "mongo/db/exec/collection_scan.h"
+#include "mongo/db/exec/limit.h"
 #include "mongo/db/exec/plan_stage.h"
+#include "mongo/db/exec/skip.h"
 #include "mongo/db/json.h"
 #include "mongo/db/matcher/expression_parser.h"
 #include "mongo/db/namespace_string.h"
 #include "mongo/db/query/plan_executor.h"
+#include "mongo/db/query/query_knobs_gen.h"
 #include "mongo/db/storage/record_store.h"
 #include "mongo/dbtests/dbtests.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/fail_point.h"
+#include "mongo/util/scopeguard.h"
 
 namespace query_stage_collection_scan {
 
@@ -179,6 +183,112 @@ TEST_F(QueryStageCollectionScanTest, QueryStageCollscanBasicBackwardWithMatch) {
     ASSERT_EQUALS(25, countResults(CollectionScanParams::BACKWARD, obj));
 }
 
+// Batches of a filtered scan under SKIP and LIMIT return the same documents, in the same order,
+// with the same stats, as working the plan one result at a time.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanBatchesMatchWork) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    const boost::intrusive_ptr<ExpressionContext> expCtx(new ExpressionContext(&_opCtx, nullptr));
+    auto statusWithMatcher =
+        MatchExpressionParser::parse(BSON("foo" << BSON("$mod" << BSON_ARRAY(3 << 0))), expCtx);
+    ASSERT_OK(statusWithMatcher.getStatus());
+    auto filterExpr = std::move(statusWithMatcher.getValue());
+
+    auto makePlan = [&](WorkingSet* ws) {
+        CollectionScanParams params;
+        params.direction = CollectionScanParams::FORWARD;
+        params.tailable = false;
+        auto scan =
+            std::make_unique<CollectionScan>(&_opCtx, collection, params, ws, filterExpr.get());
+        auto skip = std::make_unique<SkipStage>(&_opCtx, 2, ws, std::move(scan));
+        return std::make_unique<LimitStage>(&_opCtx, 10, ws, std::move(skip));
+    };
+
+    WorkingSet unbatchedWs;
+    auto unbatched = makePlan(&unbatchedWs);
+    ASSERT_TRUE(unbatched->producesNativeBatches());
+    vector<int> expected;
+    for (WorkingSetID id; !unbatched->isEOF();) {
+        if (PlanStage::ADVANCED == unbatched->work(&id)) {
+            expected.push_back(unbatchedWs.get(id)->doc.value()["foo"].getInt());
+        }
+    }
+
+    WorkingSet batchedWs;
+    auto batched = makePlan(&batchedWs);
+    vector<int> actual;
+    for (WorkingSetID id; !batched->isEOF();) {
+        vector<WorkingSetID> batch;
+        if (PlanStage::ADVANCED == batched->workBatch(&batchedWs, 4, &batch, &id)) {
+            ASSERT_LTE(batch.size(), 4U);
+            for (auto&& batchedId : batch) {
+                WorkingSetMember* member = batchedWs.get(batchedId);
+                ASSERT_TRUE(member->doc.value().isOwned());
+                actual.push_back(member->doc.value()["foo"].getInt());
+            }
+        } else {
+            ASSERT_TRUE(batch.empty());
+        }
+    }
+
+    ASSERT_EQ(10U, expected.size());
+    ASSERT(expected == actual);
+
+    auto unbatchedStats = unbatched->getStats();
+    auto batchedStats = batched->getStats();
+    ASSERT_EQ(unbatchedStats->common.advanced, batchedStats->common.advanced);
+    auto unbatchedScanStats = static_cast<const CollectionScanStats*>(
+        unbatchedStats->children[0]->children[0]->specific.get());
+    auto batchedScanStats = static_cast<const CollectionScanStats*>(
+        batchedStats->children[0]->children[0]->specific.get());
+    ASSERT_GTE(batchedScanStats->docsTested, unbatchedScanStats->docsTested);
+    ASSERT_LTE(batchedScanStats->docsTested, unbatchedScanStats->docsTested + 4);
+}
+
+// Saving the executor part way through a batch keeps the rest of that batch, and the plan carries
+// on after it without skipping or repeating a record.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanSaveStateMidBatch) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    vector<RecordId> recordIds;
+    getRecordIds(collection, CollectionScanParams::FORWARD, &recordIds);
+
+    const auto oldBatchSize = internalQueryExecBatchSize.load();
+    internalQueryExecBatchSize.store(8);
+    ON_BLOCK_EXIT([&] { internalQueryExecBatchSize.store(oldBatchSize); });
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.tailable = false;
+
+    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<PlanStage> ps =
+        std::make_unique<CollectionScan>(&_opCtx, collection, params, ws.get(), nullptr);
+    auto statusWithPlanExecutor = PlanExecutor::make(
+        &_opCtx, std::move(ws), std::move(ps), collection, PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    size_t count = 0;
+    PlanExecutor::ExecState state;
+    RecordId recordId;
+    for (BSONObj obj; PlanExecutor::ADVANCED == (state = exec->getNext(&obj, &recordId));) {
+        ASSERT_EQUALS(recordIds[count], recordId);
+        ASSERT_EQUALS(static_cast<int>(count), obj["foo"].numberInt());
+        ++count;
+
+        // Save and restore at a different point of each batch.
+        if (count % 3 == 0) {
+            exec->saveState();
+            exec->restoreState();
+        }
+    }
+    ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+    ASSERT_EQUALS(static_cast<size_t>(numObj()), count);
+}
+
 // Get objects in the order we inserted them.
 TEST_F(QueryStageCollectionScanTest, QueryStageCollscanObjectsInOrderForward) {
     AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
@@ -425,4 +535,40 @@ TEST_F(QueryStageCollectionScanTest, QueryTestCollscanResumeAfterRecordIdSeekFai
     ASSERT_EQUALS(PlanStage::FAILURE, ps->work(&id));
 }
 
+// Verify that a scan bounded by minRecord and maxRecord returns exactly the records in that
+// inclusive range, in order.
+TEST_F(QueryStageCollectionScanTest, QueryStageCollscanRecordIdRange) {
+    AutoGetCollectionForReadCommand ctx(&_opCtx, nss);
+    auto collection = ctx.getCollection();
+
+    vector<RecordId> recordIds;
+    getRecordIds(collection, CollectionScanParams::FORWARD, &recordIds);
+
+    const size_t first = 10;
+    const size_t last = 20;
+
+    CollectionScanParams params;
+    params.direction = CollectionScanParams::FORWARD;
+    params.minRecord = recordIds[first];
+    params.maxRecord = recordIds[last];
+
+    unique_ptr<WorkingSet> ws = std::make_unique<WorkingSet>();
+    unique_ptr<PlanStage> ps =
+        std::make_unique<CollectionScan>(&_opCtx, collection, params, ws.get(), nullptr);
+    auto statusWithPlanExecutor = PlanExecutor::make(
+        &_opCtx, std::move(ws), std::move(ps), collection, PlanExecutor::NO_YIELD);
+    ASSERT_OK(statusWithPlanExecutor.getStatus());
+    auto exec = std::move(statusWithPlanExecutor.getValue());
+
+    size_t count = 0;
+    PlanExecutor::ExecState state;
+    RecordId recordId;
+    for (BSONObj obj; PlanExecutor::ADVANCED == (state = exec->getNext(&obj, &recordId));) {
+        ASSERT_EQUALS(recordIds[first + count], recordId);
+        ++count;
+    }
+    ASSERT_EQUALS(PlanExecutor::IS_EOF, state);
+    ASSERT_EQUALS(last - first + 1, count);
+}
+
 }  // namespace query_stage_collection_scan
@@ -444,6 +444,105 @@ TEST_F(QueryStageMultiPlanTest, MPSBackupPlan) {
     internalQueryForceIntersectionPlans.store(forceIxisectOldValue);
 }
 
+// The candidates can be raced on worker threads, after which the winner runs from the start.
+TEST_F(QueryStageMultiPlanTest, MPSParallelTrialPicksBestPlan) {
+    const int N = 5000;
+    for (int i = 0; i < N; ++i) {
+        insert(BSON("foo" << (i % 10) << "bar" << i));
+    }
+
+    addIndex(BSON("foo" << 1));
+    addIndex(BSON("bar" << 1));
+
+    const int parallelismOldValue = internalQueryPlanEvaluationParallelism.load();
+    internalQueryPlanEvaluationParallelism.store(2);
+    ON_BLOCK_EXIT([&] { internalQueryPlanEvaluationParallelism.store(parallelismOldValue); });
+
+    AutoGetCollectionForReadCommand ctx(_opCtx.get(), nss);
+    Collection* collection = ctx.getCollection();
+
+    // Every document matches the predicate on 'bar', so the index on 'foo' is ten times as
+    // productive.
+    auto cq = makeCanonicalQuery(_opCtx.get(), nss, fromjson("{foo: 7, bar: {$gte: 0}}"));
+
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(_opCtx.get(), collection, cq.get(), &plannerParams);
+    auto statusWithSolutions = QueryPlanner::plan(*cq, plannerParams);
+    ASSERT_OK(statusWithSolutions.getStatus());
+    auto solutions = std::move(statusWithSolutions.getValue());
+    ASSERT_GTE(solutions.size(), 2U);
+
+    auto ws = std::make_unique<WorkingSet>();
+    auto mps = std::make_unique<MultiPlanStage>(_opCtx.get(), collection, cq.get());
+    for (size_t i = 0; i < solutions.size(); ++i) {
+        auto root = StageBuilder::build(_opCtx.get(), collection, *cq, *solutions[i], ws.get());
+        mps->addPlan(std::move(solutions[i]), std::move(root), ws.get());
+    }
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD, _clock);
+    ASSERT_OK(mps->pickBestPlan(&yieldPolicy));
+    ASSERT(mps->bestPlanChosen());
+    ASSERT(static_cast<const MultiPlanStats*>(mps->getSpecificStats())->ranParallelTrial);
+    ASSERT(QueryPlannerTestLib::solutionMatches(
+        "{fetch: {filter: {bar: {$gte: 0}}, node: {ixscan: {pattern: {foo: 1}}}}}",
+        mps->bestSolution()->root.get()));
+
+    // The plan cache entry is ranked from the stats gathered by the workers.
+    auto entry = assertGet(CollectionQueryInfo::get(collection).getPlanCache()->getEntry(*cq));
+    ASSERT_GT(entry->decision->stats[0]->common.works, 0U);
+
+    // The winner was not worked during the trial, so it still returns every matching document.
+    auto exec = assertGet(PlanExecutor::make(
+        std::move(cq), std::move(ws), std::move(mps), collection, PlanExecutor::NO_YIELD));
+    size_t numResults = 0;
+    BSONObj obj;
+    while (PlanExecutor::ADVANCED == exec->getNext(&obj, nullptr)) {
+        ASSERT_EQUALS(obj["foo"].numberInt(), 7);
+        ++numResults;
+    }
+    ASSERT_EQUALS(numResults, static_cast<size_t>(N / 10));
+}
+
+// A candidate which sorts is built against the query's own ExpressionContext, so it is only ever
+// worked on the owning thread.
+TEST_F(QueryStageMultiPlanTest, MPSSortingCandidatesTrialSerially) {
+    for (int i = 0; i < 100; ++i) {
+        insert(BSON("a" << (i % 10) << "b" << i));
+    }
+
+    addIndex(BSON("a" << 1));
+    addIndex(BSON("b" << 1));
+
+    const int parallelismOldValue = internalQueryPlanEvaluationParallelism.load();
+    internalQueryPlanEvaluationParallelism.store(2);
+    ON_BLOCK_EXIT([&] { internalQueryPlanEvaluationParallelism.store(parallelismOldValue); });
+
+    AutoGetCollectionForReadCommand ctx(_opCtx.get(), nss);
+    Collection* collection = ctx.getCollection();
+
+    auto qr = std::make_unique<QueryRequest>(nss);
+    qr->setFilter(BSON("a" << 1 << "b" << BSON("$gte" << 0)));
+    qr->setSort(BSON("b" << -1));
+    auto cq = assertGet(CanonicalQuery::canonicalize(opCtx(), std::move(qr)));
+
+    QueryPlannerParams plannerParams;
+    fillOutPlannerParams(_opCtx.get(), collection, cq.get(), &plannerParams);
+    auto solutions = assertGet(QueryPlanner::plan(*cq, plannerParams));
+    ASSERT_GTE(solutions.size(), 2U);
+
+    auto ws = std::make_unique<WorkingSet>();
+    auto mps = std::make_unique<MultiPlanStage>(_opCtx.get(), collection, cq.get());
+    for (size_t i = 0; i < solutions.size(); ++i) {
+        auto root = StageBuilder::build(_opCtx.get(), collection, *cq, *solutions[i], ws.get());
+        mps->addPlan(std::move(solutions[i]), std::move(root), ws.get());
+    }
+
+    PlanYieldPolicy yieldPolicy(PlanExecutor::NO_YIELD, _clock);
+    ASSERT_OK(mps->pickBestPlan(&yieldPolicy));
+    ASSERT(mps->bestPlanChosen());
+    ASSERT_FALSE(static_cast<const MultiPlanStats*>(mps->getSpecificStats())->ranParallelTrial);
+}
+
 /**
  * Allocates a new WorkingSetMember with data 'dataObj' in 'ws', and adds the WorkingSetMember
  * to 'qds'.
@@ -82,9 +82,12 @@ OpMsgRequest opMsgRequestFromAnyProtocol(const Message& unownedMessage) {
     }
 }
 
-std::unique_ptr<ReplyBuilderInterface> makeReplyBuilder(Protocol protocol) {
+std::unique_ptr<ReplyBuilderInterface> makeReplyBuilder(Protocol protocol, SharedBuffer buffer) {
     switch (protocol) {
         case Protocol::kOpMsg:
+            if (buffer) {
+                return std::make_unique<OpMsgReplyBuilder>(std::move(buffer));
+            }
             return std::make_unique<OpMsgReplyBuilder>();
         case Protocol::kOpQuery:
             return std::make_unique<LegacyReplyBuilder>();
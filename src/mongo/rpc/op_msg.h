@@ -203,6 +203,15 @@ public:
         skipHeaderAndFlags();
     }
 
+    /**
+     * Builds the message in 'buffer', which must not be shared, rather than in a newly allocated
+     * one. Lets a caller that sends a stream of similar messages reuse one buffer for all of them.
+     */
+    explicit OpMsgBuilder(SharedBuffer buffer) : _buf(0) {
+        _buf.useSharedBuffer(std::move(buffer));
+        skipHeaderAndFlags();
+    }
+
     /**
      * See the documentation for DocSequenceBuilder below.
      */
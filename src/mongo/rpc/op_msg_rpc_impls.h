@@ -53,6 +53,9 @@ private:
 
 class OpMsgReplyBuilder final : public rpc::ReplyBuilderInterface {
 public:
+    OpMsgReplyBuilder() = default;
+    explicit OpMsgReplyBuilder(SharedBuffer buffer) : _builder(std::move(buffer)) {}
+
     ReplyBuilderInterface& setRawCommandReply(const BSONObj& reply) override {
         _builder.beginBody().appendElements(reply);
         return *this;
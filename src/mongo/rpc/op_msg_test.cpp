@@ -825,6 +825,28 @@ TEST(OpMsgSerializer, BodyAndInPlaceSequenceInPlaceWithReset) {
                    });
 }
 
+TEST(OpMsgSerializer, BodyInSuppliedBuffer) {
+    // Build one message, then build the next one in the buffer it was sent from.
+    OpMsgBuilder first;
+    first.beginBody().append("ping", 1);
+    auto buffer = first.finish().sharedBuffer();
+    const auto capacity = buffer.capacity();
+    const auto data = buffer.get();
+
+    OpMsgBuilder second(std::move(buffer));
+    second.beginBody().append("ping", 2);
+    auto msg = second.finish();
+    ASSERT_EQ(msg.sharedBuffer().get(), data);
+    ASSERT_EQ(msg.sharedBuffer().capacity(), capacity);
+
+    testSerializer(msg,
+                   OpMsgBytes{
+                       kNoFlags,  //
+                       kBodySection,
+                       fromjson("{ping: 2}"),
+                   });
+}
+
 TEST(OpMsgSerializer, ReplaceFlagsWorks) {
     {
         auto msg = OpMsgBytes{~0u}.done();
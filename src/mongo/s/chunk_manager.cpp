@@ -70,6 +70,37 @@ std::string extractKeyStringInternal(const BSONObj& shardKeyValue, Ordering orde
 
 }  // namespace
 
+ChunkMap::ChunkMap(std::vector<std::string> maxKeyStrings, ChunkVector chunks)
+    : _maxKeyStrings(std::move(maxKeyStrings)), _chunks(std::move(chunks)) {
+    invariant(_maxKeyStrings.size() == _chunks.size());
+
+    // Clusters rarely have more than a few hundred shards, so a linear probe over the shards seen
+    // so far beats hashing their names for every chunk
+    _shardOrdinals.reserve(_chunks.size());
+    for (const auto& chunk : _chunks) {
+        const auto& shardId = chunk->getShardIdAt(boost::none);
+        if (_shardIds.empty() || _shardIds[_shardOrdinals.back()] != shardId) {
+            auto it = std::find(_shardIds.begin(), _shardIds.end(), shardId);
+            if (it == _shardIds.end()) {
+                it = _shardIds.insert(_shardIds.end(), shardId);
+            }
+            _shardOrdinals.push_back(it - _shardIds.begin());
+        } else {
+            _shardOrdinals.push_back(_shardOrdinals.back());
+        }
+    }
+}
+
+ChunkMap::const_iterator ChunkMap::upperBound(const std::string& keyString) const {
+    const auto it = std::upper_bound(_maxKeyStrings.begin(), _maxKeyStrings.end(), keyString);
+    return _chunks.begin() + (it - _maxKeyStrings.begin());
+}
+
+ChunkMap::const_iterator ChunkMap::lowerBound(const std::string& keyString) const {
+    const auto it = std::lower_bound(_maxKeyStrings.begin(), _maxKeyStrings.end(), keyString);
+    return _chunks.begin() + (it - _maxKeyStrings.begin());
+}
+
 ShardVersionTargetingInfo::ShardVersionTargetingInfo(const OID& epoch)
     : shardVersion(0, 0, epoch) {}
 
@@ -78,7 +109,7 @@ RoutingTableHistory::RoutingTableHistory(NamespaceString nss,
                                          KeyPattern shardKeyPattern,
                                          std::unique_ptr<CollatorInterface> defaultCollator,
                                          bool unique,
-                                         ChunkInfoMap chunkMap,
+                                         ChunkMap chunkMap,
                                          ChunkVersion collectionVersion)
     : _sequenceNumber(nextCMSequenceNumber.addAndFetch(1)),
       _nss(std::move(nss)),
@@ -116,26 +147,26 @@ Chunk ChunkManager::findIntersectingChunk(const BSONObj& shardKey, const BSONObj
         }
     }
 
-    const auto it = _rt->getChunkMap().upper_bound(_rt->_extractKeyString(shardKey));
+    const auto it = _rt->getChunkMap().upperBound(_rt->_extractKeyString(shardKey));
     uassert(ErrorCodes::ShardKeyNotFound,
             str::stream() << "Cannot target single shard using key " << shardKey
                           << " for namespace " << getns(),
-            it != _rt->getChunkMap().end() && it->second->containsKey(shardKey));
+            it != _rt->getChunkMap().end() && (*it)->containsKey(shardKey));
 
-    return Chunk(*(it->second), _clusterTime);
+    return Chunk(**it, _clusterTime);
 }
 
 bool ChunkManager::keyBelongsToShard(const BSONObj& shardKey, const ShardId& shardId) const {
     if (shardKey.isEmpty())
         return false;
 
-    const auto it = _rt->getChunkMap().upper_bound(_rt->_extractKeyString(shardKey));
+    const auto it = _rt->getChunkMap().upperBound(_rt->_extractKeyString(shardKey));
     if (it == _rt->getChunkMap().end())
         return false;
 
-    invariant(it->second->containsKey(shardKey));
+    invariant((*it)->containsKey(shardKey));
 
-    return it->second->getShardIdAt(_clusterTime) == shardId;
+    return (*it)->getShardIdAt(_clusterTime) == shardId;
 }
 
 void ChunkManager::getShardIdsForQuery(OperationContext* opCtx,
@@ -199,7 +230,7 @@ void ChunkManager::getShardIdsForQuery(OperationContext* opCtx,
     // For now, we satisfy that assumption by adding a shard with no matches rather than returning
     // an empty set of shards.
     if (shardIds->empty()) {
-        shardIds->insert(_rt->getChunkMap().begin()->second->getShardIdAt(_clusterTime));
+        shardIds->insert((*_rt->getChunkMap().begin())->getShardIdAt(_clusterTime));
     }
 }
 
@@ -207,8 +238,31 @@ void ChunkManager::getShardIdsForRange(const BSONObj& min,
                                        const BSONObj& max,
                                        std::set<ShardId>* shardIds) const {
     const auto bounds = _rt->overlappingRanges(min, max, true);
+
+    if (!_clusterTime) {
+        // Targeting the latest placement, so deduplicate on the shard ordinals kept alongside the
+        // chunks. This way each owning shard costs one set insertion, rather than one for every
+        // chunk in the range.
+        const auto& chunkMap = _rt->getChunkMap();
+        const auto& shardIdTable = chunkMap.getShardIds();
+        std::vector<char> seen(shardIdTable.size(), 0);
+        for (auto it = bounds.first; it != bounds.second; ++it) {
+            const auto ordinal = chunkMap.shardOrdinalAt(it);
+            if (seen[ordinal])
+                continue;
+
+            seen[ordinal] = 1;
+            shardIds->insert(shardIdTable[ordinal]);
+
+            if (shardIds->size() == _rt->_shardVersions.size()) {
+                break;
+            }
+        }
+        return;
+    }
+
     for (auto it = bounds.first; it != bounds.second; ++it) {
-        shardIds->insert(it->second->getShardIdAt(_clusterTime));
+        shardIds->insert((*it)->getShardIdAt(_clusterTime));
 
         // No need to iterate through the rest of the ranges, because we already know we need to use
         // all shards.
@@ -220,8 +274,8 @@ void ChunkManager::getShardIdsForRange(const BSONObj& min,
 
 bool ChunkManager::rangeOverlapsShard(const ChunkRange& range, const ShardId& shardId) const {
     const auto bounds = _rt->overlappingRanges(range.getMin(), range.getMax(), false);
-    const auto it = std::find_if(bounds.first, bounds.second, [this, &shardId](const auto& scr) {
-        return scr.second->getShardIdAt(_clusterTime) == shardId;
+    const auto it = std::find_if(bounds.first, bounds.second, [this, &shardId](const auto& chunk) {
+        return chunk->getShardIdAt(_clusterTime) == shardId;
     });
 
     return it != bounds.second;
@@ -229,10 +283,10 @@ bool ChunkManager::rangeOverlapsShard(const ChunkRange& range, const ShardId& sh
 
 ChunkManager::ConstRangeOfChunks ChunkManager::getNextChunkOnShard(const BSONObj& shardKey,
                                                                    const ShardId& shardId) const {
-    for (auto it = _rt->getChunkMap().upper_bound(_rt->_extractKeyString(shardKey));
+    for (auto it = _rt->getChunkMap().upperBound(_rt->_extractKeyString(shardKey));
          it != _rt->getChunkMap().end();
          ++it) {
-        const auto& chunk = it->second;
+        const auto& chunk = *it;
         if (chunk->getShardIdAt(_clusterTime) == shardId) {
             const auto begin = it;
             const auto end = ++it;
@@ -254,15 +308,15 @@ int RoutingTableHistory::getNShardsOwningChunks() const {
     return _shardVersions.size();
 }
 
-std::pair<ChunkInfoMap::const_iterator, ChunkInfoMap::const_iterator>
+std::pair<ChunkMap::const_iterator, ChunkMap::const_iterator>
 RoutingTableHistory::overlappingRanges(const BSONObj& min,
                                        const BSONObj& max,
                                        bool isMaxInclusive) const {
 
-    const auto itMin = _chunkMap.upper_bound(_extractKeyString(min));
+    const auto itMin = _chunkMap.upperBound(_extractKeyString(min));
     const auto itMax = [this, &max, isMaxInclusive]() {
-        auto it = isMaxInclusive ? _chunkMap.upper_bound(_extractKeyString(max))
-                                 : _chunkMap.lower_bound(_extractKeyString(max));
+        auto it = isMaxInclusive ? _chunkMap.upperBound(_extractKeyString(max))
+                                 : _chunkMap.lowerBound(_extractKeyString(max));
         return it == _chunkMap.end() ? it : ++it;
     }();
 
@@ -422,7 +476,7 @@ std::string RoutingTableHistory::toString() const {
 
     sb << "Chunks:\n";
     for (const auto& chunk : _chunkMap) {
-        sb << "\t" << chunk.second->toString() << '\n';
+        sb << "\t" << chunk->toString() << '\n';
     }
 
     sb << "Shard versions:\n";
@@ -437,13 +491,13 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
     const OID& epoch = _collectionVersion.epoch();
 
     ShardVersionMap shardVersions;
-    ChunkInfoMap::const_iterator current = _chunkMap.cbegin();
+    ChunkMap::const_iterator current = _chunkMap.cbegin();
 
     boost::optional<BSONObj> firstMin = boost::none;
     boost::optional<BSONObj> lastMax = boost::none;
 
     while (current != _chunkMap.cend()) {
-        const auto& firstChunkInRange = current->second;
+        const auto& firstChunkInRange = *current;
         const auto& currentRangeShardId = firstChunkInRange->getShardIdAt(boost::none);
 
         // Tracks the max shard version for the shard on which the current range will reside
@@ -458,9 +512,7 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
             std::find_if(current,
                          _chunkMap.cend(),
                          [&currentRangeShardId,
-                          &maxShardVersion](const ChunkInfoMap::value_type& chunkMapEntry) {
-                             const auto& currentChunk = chunkMapEntry.second;
-
+                          &maxShardVersion](const std::shared_ptr<ChunkInfo>& currentChunk) {
                              if (currentChunk->getShardIdAt(boost::none) != currentRangeShardId)
                                  return true;
 
@@ -473,7 +525,7 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
         const auto rangeLast = std::prev(current);
 
         const auto& rangeMin = firstChunkInRange->getMin();
-        const auto& rangeMax = rangeLast->second->getMax();
+        const auto& rangeMax = (*rangeLast)->getMax();
 
         // Check the continuity of the chunks map
         if (lastMax && !SimpleBSONObjComparator::kInstance.evaluate(*lastMax == rangeMin)) {
@@ -481,14 +533,18 @@ ShardVersionMap RoutingTableHistory::_constructShardVersionMap() const {
                 uasserted(ErrorCodes::ConflictingOperationInProgress,
                           str::stream()
                               << "Gap exists in the routing table between chunks "
-                              << _chunkMap.at(_extractKeyString(*lastMax))->getRange().toString()
-                              << " and " << rangeLast->second->getRange().toString());
+                              << (*_chunkMap.lowerBound(_extractKeyString(*lastMax)))
+                                     ->getRange()
+                                     .toString()
+                              << " and " << (*rangeLast)->getRange().toString());
             else
                 uasserted(ErrorCodes::ConflictingOperationInProgress,
                           str::stream()
                               << "Overlap exists in the routing table between chunks "
-                              << _chunkMap.at(_extractKeyString(*lastMax))->getRange().toString()
-                              << " and " << rangeLast->second->getRange().toString());
+                              << (*_chunkMap.lowerBound(_extractKeyString(*lastMax)))
+                                     ->getRange()
+                                     .toString()
+                              << " and " << (*rangeLast)->getRange().toString());
         }
 
         if (!firstMin)
@@ -539,7 +595,18 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
     const std::vector<ChunkType>& changedChunks) {
 
     const auto startingCollectionVersion = getVersion();
-    auto chunkMap = _chunkMap;
+
+    // The changed chunks are applied to a small ordered overlay, into which only the entries of the
+    // current routing table that they touch get copied. The overlay is then merged with the
+    // untouched entries in a single pass, so a refresh costs a linear copy of the flat table plus
+    // logarithmic work per changed chunk, instead of shifting the whole table for every change.
+    std::map<std::string, std::shared_ptr<ChunkInfo>> overlay;
+    std::vector<char> inOverlay(_chunkMap.size(), 0);
+
+    const auto copyToOverlay = [&](size_t index) {
+        inOverlay[index] = 1;
+        overlay.emplace(_chunkMap.maxKeyStringAt(index), _chunkMap.chunkAt(index));
+    };
 
     ChunkVersion collectionVersion = startingCollectionVersion;
     for (const auto& chunk : changedChunks) {
@@ -559,27 +626,50 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
         const auto chunkMinKeyString = _extractKeyString(chunk.getMin());
         const auto chunkMaxKeyString = _extractKeyString(chunk.getMax());
 
+        // Bring into the overlay every entry of the current table with a max key in (min, max],
+        // plus the first one past max which has not been erased by an earlier change. With those
+        // present, the lookups below observe exactly what they would in a full copy of the table.
+        if (!_chunkMap.empty()) {
+            auto index = size_t(_chunkMap.upperBound(chunkMinKeyString) - _chunkMap.begin());
+            const auto highIndex =
+                size_t(_chunkMap.upperBound(chunkMaxKeyString) - _chunkMap.begin());
+
+            for (; index < highIndex; ++index) {
+                if (!inOverlay[index])
+                    copyToOverlay(index);
+            }
+
+            for (; index < _chunkMap.size(); ++index) {
+                if (!inOverlay[index]) {
+                    copyToOverlay(index);
+                    break;
+                }
+                if (overlay.count(_chunkMap.maxKeyStringAt(index)))
+                    break;
+            }
+        }
+
         // Returns the first chunk with a max key that is > min - implies that the chunk overlaps
         // min
-        const auto low = chunkMap.upper_bound(chunkMinKeyString);
+        const auto low = overlay.upper_bound(chunkMinKeyString);
 
         // Returns the first chunk with a max key that is > max - implies that the next chunk cannot
         // not overlap max
-        const auto high = chunkMap.upper_bound(chunkMaxKeyString);
+        const auto high = overlay.upper_bound(chunkMaxKeyString);
 
         // If we are in the middle of splitting a chunk, for the first few
         // chunks inserted, low == high, because both lookups will point to the
         // same chunk (the one being split). If we're inserting the last chunk
         // for the current chunk being split, low will point to the chunk that
         // we're splitting, and high will point to the next chunk past the one
-        // we're splitting (which could be chunkMap.end()). In this case,
+        // we're splitting (which could be overlay.end()). In this case,
         // std::distance(low, high) == 1. Lastly, this does not apply during
         // the creation of the original routing table, in which case the map is
         // empty and the first chunk that is inserted will find that low ==
-        // high, but low == chunkMap.end(), and we aren't doing a split in that
+        // high, but low == overlay.end(), and we aren't doing a split in that
         // case.
         auto foundSingleChunk =
-            ((low == high || std::distance(low, high) == 1) && low != chunkMap.end());
+            ((low == high || std::distance(low, high) == 1) && low != overlay.end());
 
         auto newChunk = std::make_shared<ChunkInfo>(chunk);
         if (foundSingleChunk) {
@@ -590,10 +680,10 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
         }
 
         // Erase all chunks from the map, which overlap the chunk we got from the persistent store
-        chunkMap.erase(low, high);
+        overlay.erase(low, high);
 
         // Insert only the chunk itself
-        chunkMap.insert(std::make_pair(chunkMaxKeyString, newChunk));
+        overlay.insert(std::make_pair(chunkMaxKeyString, newChunk));
     }
 
     // If at least one diff was applied, the metadata is correct, but it might not have changed so
@@ -608,13 +698,40 @@ std::shared_ptr<RoutingTableHistory> RoutingTableHistory::makeUpdated(
         return shared_from_this();
     }
 
+    // Every entry of the current table which some change could have affected is in the overlay, so
+    // the remaining ones are carried over as they are
+    std::vector<std::string> maxKeyStrings;
+    ChunkMap::ChunkVector chunks;
+    maxKeyStrings.reserve(_chunkMap.size() + overlay.size());
+    chunks.reserve(_chunkMap.size() + overlay.size());
+
+    auto overlayIt = overlay.begin();
+    for (size_t index = 0; index < _chunkMap.size(); ++index) {
+        if (inOverlay[index])
+            continue;
+
+        const auto& maxKeyString = _chunkMap.maxKeyStringAt(index);
+        for (; overlayIt != overlay.end() && overlayIt->first < maxKeyString; ++overlayIt) {
+            maxKeyStrings.push_back(overlayIt->first);
+            chunks.push_back(std::move(overlayIt->second));
+        }
+
+        maxKeyStrings.push_back(maxKeyString);
+        chunks.push_back(_chunkMap.chunkAt(index));
+    }
+
+    for (; overlayIt != overlay.end(); ++overlayIt) {
+        maxKeyStrings.push_back(overlayIt->first);
+        chunks.push_back(std::move(overlayIt->second));
+    }
+
     return std::shared_ptr<RoutingTableHistory>(
         new RoutingTableHistory(_nss,
                                 _uuid,
                                 KeyPattern(getShardKeyPattern().getKeyPattern()),
                                 CollatorInterface::cloneCollator(getDefaultCollator()),
                                 isUnique(),
-                                std::move(chunkMap),
+                                ChunkMap(std::move(maxKeyStrings), std::move(chunks)),
                                 collectionVersion));
 }
 
@@ -49,8 +49,92 @@ struct QuerySolutionNode;
 class OperationContext;
 class ChunkManager;
 
-// Ordered map from the max for each chunk to an entry describing the chunk
-using ChunkInfoMap = std::map<std::string, std::shared_ptr<ChunkInfo>>;
+/**
+ * Flat, ordered map from the max for each chunk to an entry describing the chunk.
+ *
+ * The chunks are kept in a contiguous array sorted by max key and the KeyString encodings of those
+ * max keys in a parallel array, so that targeting a key is a binary search over contiguous memory
+ * rather than a walk over the nodes of a tree. Alongside them, each chunk carries the ordinal of
+ * its current owner in a compact table of the distinct shards owning chunks, which lets callers
+ * that only need the set of shards for a range deduplicate without comparing ShardIds.
+ */
+class ChunkMap {
+public:
+    using ChunkVector = std::vector<std::shared_ptr<ChunkInfo>>;
+    using const_iterator = ChunkVector::const_iterator;
+
+    ChunkMap() = default;
+
+    /**
+     * Both vectors must be of the same length and sorted in ascending order of the chunks' max
+     * keys, with "maxKeyStrings[i]" being the KeyString encoding of "chunks[i]->getMax()".
+     */
+    ChunkMap(std::vector<std::string> maxKeyStrings, ChunkVector chunks);
+
+    const_iterator begin() const {
+        return _chunks.begin();
+    }
+
+    const_iterator end() const {
+        return _chunks.end();
+    }
+
+    const_iterator cbegin() const {
+        return _chunks.cbegin();
+    }
+
+    const_iterator cend() const {
+        return _chunks.cend();
+    }
+
+    size_t size() const {
+        return _chunks.size();
+    }
+
+    bool empty() const {
+        return _chunks.empty();
+    }
+
+    const std::shared_ptr<ChunkInfo>& chunkAt(size_t index) const {
+        return _chunks[index];
+    }
+
+    const std::string& maxKeyStringAt(size_t index) const {
+        return _maxKeyStrings[index];
+    }
+
+    /**
+     * Returns the first chunk whose max key sorts after "keyString", which is the chunk containing
+     * the key if one exists.
+     */
+    const_iterator upperBound(const std::string& keyString) const;
+
+    /**
+     * Returns the first chunk whose max key does not sort before "keyString".
+     */
+    const_iterator lowerBound(const std::string& keyString) const;
+
+    /**
+     * Returns the index into getShardIds() of the shard which currently owns the chunk at "it".
+     */
+    size_t shardOrdinalAt(const_iterator it) const {
+        return _shardOrdinals[it - _chunks.begin()];
+    }
+
+    /**
+     * Returns the distinct shards which currently own chunks, in order of first appearance.
+     */
+    const std::vector<ShardId>& getShardIds() const {
+        return _shardIds;
+    }
+
+private:
+    std::vector<std::string> _maxKeyStrings;
+    ChunkVector _chunks;
+
+    std::vector<uint32_t> _shardOrdinals;
+    std::vector<ShardId> _shardIds;
+};
 
 struct ShardVersionTargetingInfo {
     // Indicates whether the shard is stale and thus needs a catalog cache refresh. Is false by
@@ -146,7 +230,7 @@ public:
 
     ChunkVersion getVersion(const ShardId& shardId) const;
 
-    const ChunkInfoMap& getChunkMap() const {
+    const ChunkMap& getChunkMap() const {
         return _chunkMap;
     }
 
@@ -175,7 +259,7 @@ public:
         return _uuid;
     }
 
-    std::pair<ChunkInfoMap::const_iterator, ChunkInfoMap::const_iterator> overlappingRanges(
+    std::pair<ChunkMap::const_iterator, ChunkMap::const_iterator> overlappingRanges(
         const BSONObj& min, const BSONObj& max, bool isMaxInclusive) const;
 
 
@@ -185,7 +269,7 @@ private:
                         KeyPattern shardKeyPattern,
                         std::unique_ptr<CollatorInterface> defaultCollator,
                         bool unique,
-                        ChunkInfoMap chunkMap,
+                        ChunkMap chunkMap,
                         ChunkVersion collectionVersion);
 
     /**
@@ -216,9 +300,9 @@ private:
     // Whether the sharding key is unique
     const bool _unique;
 
-    // Map from the max for each chunk to an entry describing the chunk. The union of all chunks'
-    // ranges must cover the complete space from [MinKey, MaxKey).
-    const ChunkInfoMap _chunkMap;
+    // Flat map from the max for each chunk to an entry describing the chunk. The union of all
+    // chunks' ranges must cover the complete space from [MinKey, MaxKey).
+    const ChunkMap _chunkMap;
 
     // Max version across all chunks
     const ChunkVersion _collectionVersion;
@@ -240,7 +324,7 @@ public:
     class ConstChunkIterator {
     public:
         ConstChunkIterator() = default;
-        explicit ConstChunkIterator(ChunkInfoMap::const_iterator iter,
+        explicit ConstChunkIterator(ChunkMap::const_iterator iter,
                                     boost::optional<Timestamp> clusterTime)
             : _iter{std::move(iter)}, _clusterTime{std::move(clusterTime)} {}
 
@@ -258,11 +342,11 @@ public:
             return !(*this == other);
         }
         const Chunk operator*() const {
-            return Chunk{*_iter->second, _clusterTime};
+            return Chunk{**_iter, _clusterTime};
         }
 
     private:
-        ChunkInfoMap::const_iterator _iter;
+        ChunkMap::const_iterator _iter;
         boost::optional<Timestamp> _clusterTime;
     };
 
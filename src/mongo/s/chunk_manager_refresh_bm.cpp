@@ -122,7 +122,48 @@ void BM_IncrementalRefreshOfPessimalBalancedDistribution(benchmark::State& state
     }
 }
 
-BENCHMARK(BM_IncrementalRefreshOfPessimalBalancedDistribution)->Args({2, 50000});
+BENCHMARK(BM_IncrementalRefreshOfPessimalBalancedDistribution)
+    ->Args({2, 50000})
+    ->Args({2, 500000});
+
+void BM_IncrementalRefreshWithManySplits(benchmark::State& state) {
+    const int nShards = state.range(0);
+    const int nChunks = state.range(1);
+    const int nSplits = state.range(2);
+    auto cm = makeChunkManagerWithOptimalBalancedDistribution(nShards, nChunks);
+
+    auto postSplitVersion = cm->getChunkManager()->getVersion();
+    const auto collName = NamespaceString(cm->getChunkManager()->getns());
+
+    // Split chunks spread evenly across the key space in half, which is what a refresh following a
+    // round of auto-splitting observes
+    std::vector<ChunkType> newChunks;
+    const int stride = std::max(1, (nChunks - 2) / nSplits);
+    for (int i = 1; i + 1 < nChunks && int(newChunks.size()) < 2 * nSplits; i += stride) {
+        const auto range = getRangeForChunk(i, nChunks);
+        const auto splitPoint = BSON("_id" << (i - 1) * 100 + 50);
+        const auto shardId = optimalShardSelector(i, nShards, nChunks);
+
+        postSplitVersion.incMinor();
+        newChunks.emplace_back(
+            collName, ChunkRange(range.getMin(), splitPoint), postSplitVersion, shardId);
+        postSplitVersion.incMinor();
+        newChunks.emplace_back(
+            collName, ChunkRange(splitPoint, range.getMax()), postSplitVersion, shardId);
+    }
+
+    for (auto keepRunning : state) {
+        benchmark::DoNotOptimize(runIncrementalUpdate(*cm, newChunks));
+    }
+
+    state.SetItemsProcessed(state.iterations() * newChunks.size());
+}
+
+BENCHMARK(BM_IncrementalRefreshWithManySplits)
+    ->Args({10, 50000, 10})
+    ->Args({10, 50000, 1000})
+    ->Args({10, 500000, 10})
+    ->Args({10, 500000, 10000});
 
 template <typename ShardSelectorFn>
 auto BM_FullBuildOfChunkManager(benchmark::State& state, ShardSelectorFn selectShard) {
@@ -348,6 +389,7 @@ MONGO_INITIALIZER(RegisterBenchmarks)(InitializerContext* context) {
             ->Args({10, 50000})
             ->Args({100, 50000})
             ->Args({1000, 50000})
+            ->Args({10, 500000})
             ->Args({2, 2});
     }
 
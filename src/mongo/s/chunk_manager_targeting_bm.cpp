@@ -0,0 +1,138 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+
+#include "mongo/platform/random.h"
+#include "mongo/s/chunk_manager.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace {
+
+const int kMaxPerfThreads = 64;
+const int kNumShards = 100;
+const int kNumChunks = 500000;
+const int kNumDocs = 1 << 16;
+
+/**
+ * Builds a routing table of kNumChunks chunks spread round-robin across kNumShards shards, which is
+ * shared by every benchmark and thread so that concurrent targeting reads the same table, as it
+ * does on a busy mongos.
+ */
+class ChunkManagerTargetingTest : public benchmark::Fixture {
+public:
+    struct RoutingTable {
+        RoutingTable() {
+            const auto collEpoch = OID::gen();
+            const auto collName = NamespaceString("test.foo");
+
+            std::vector<ChunkType> chunks;
+            chunks.reserve(kNumChunks);
+            for (int i = 0; i < kNumChunks; ++i) {
+                const auto min = i == 0 ? BSON("_id" << MINKEY) : BSON("_id" << (i - 1) * 100);
+                const auto max =
+                    i + 1 == kNumChunks ? BSON("_id" << MAXKEY) : BSON("_id" << i * 100);
+                chunks.emplace_back(collName,
+                                    ChunkRange(min, max),
+                                    ChunkVersion{uint32_t(i + 1), 0, collEpoch},
+                                    ShardId(str::stream() << "shard" << (i % kNumShards)));
+            }
+
+            auto rt = RoutingTableHistory::makeNew(collName,
+                                                   UUID::gen(),
+                                                   KeyPattern(BSON("_id" << 1)),
+                                                   nullptr,
+                                                   true,
+                                                   collEpoch,
+                                                   chunks);
+            chunkManager = std::make_shared<ChunkManager>(std::move(rt), boost::none);
+
+            PseudoRandom rand(12345);
+            docs.reserve(kNumDocs);
+            for (int i = 0; i < kNumDocs; ++i) {
+                docs.push_back(BSON("_id" << rand.nextInt64(int64_t(kNumChunks) * 100) << "x"
+                                          << "payload"));
+            }
+        }
+
+        std::shared_ptr<ChunkManager> chunkManager;
+        std::vector<BSONObj> docs;
+    };
+
+    static RoutingTable& getRoutingTable() {
+        static RoutingTable routingTable;
+        return routingTable;
+    }
+};
+
+/**
+ * Targets single documents the way an insert is routed: extract the shard key and find the chunk
+ * which owns it.
+ */
+BENCHMARK_DEFINE_F(ChunkManagerTargetingTest, BM_TargetInsert)(benchmark::State& state) {
+    auto& rt = getRoutingTable();
+    const auto& shardKeyPattern = rt.chunkManager->getShardKeyPattern();
+    size_t i = state.thread_index * (kNumDocs / kMaxPerfThreads);
+
+    for (auto keepRunning : state) {
+        const auto& doc = rt.docs[i++ % kNumDocs];
+        benchmark::DoNotOptimize(rt.chunkManager->findIntersectingChunkWithSimpleCollation(
+            shardKeyPattern.extractShardKeyFromDoc(doc)));
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+/**
+ * Targets ranges spanning a few hundred chunks, as a multi-update or multi-delete with a range
+ * predicate on the shard key does.
+ */
+BENCHMARK_DEFINE_F(ChunkManagerTargetingTest, BM_TargetRange)(benchmark::State& state) {
+    auto& rt = getRoutingTable();
+    size_t i = state.thread_index * (kNumDocs / kMaxPerfThreads);
+
+    for (auto keepRunning : state) {
+        const auto min = rt.docs[i++ % kNumDocs]["_id"].numberLong();
+        std::set<ShardId> shardIds;
+        rt.chunkManager->getShardIdsForRange(
+            BSON("_id" << min), BSON("_id" << min + 25000), &shardIds);
+        benchmark::DoNotOptimize(shardIds);
+    }
+
+    state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_REGISTER_F(ChunkManagerTargetingTest, BM_TargetInsert)->ThreadRange(1, kMaxPerfThreads);
+BENCHMARK_REGISTER_F(ChunkManagerTargetingTest, BM_TargetRange)->ThreadRange(1, kMaxPerfThreads);
+
+}  // namespace
+}  // namespace mongo
@@ -93,9 +93,7 @@ std::set<ChunkInfo*> getChunksInRange(std::shared_ptr<RoutingTableHistory> rt,
     std::transform(chunksFromSplitIter.first,
                    chunksFromSplitIter.second,
                    std::inserter(chunksFromSplit, chunksFromSplit.begin()),
-                   [](const std::pair<std::string, std::shared_ptr<ChunkInfo>>& pair) {
-                       return pair.second.get();
-                   });
+                   [](const std::shared_ptr<ChunkInfo>& chunkInfo) { return chunkInfo.get(); });
     return chunksFromSplit;
 }
 
@@ -108,7 +106,7 @@ std::shared_ptr<ChunkInfo> getChunkToSplit(std::shared_ptr<RoutingTableHistory>
     invariant(std::distance(chunkToSplitIter.first, chunkToSplitIter.second) <= 1);
     invariant(chunkToSplitIter.first != rt->getChunkMap().end());
 
-    return (*chunkToSplitIter.first).second;
+    return *chunkToSplitIter.first;
 }
 
 /**
@@ -136,8 +134,7 @@ void assertCorrectBytesWritten(std::shared_ptr<RoutingTableHistory> rt,
     auto chunksFromSplit = getChunksInRange(rt, minSplitBoundary, maxSplitBoundary);
     ASSERT_EQ(chunksFromSplit.size(), expectedNumChunksFromSplit);
 
-    for (auto kv : rt->getChunkMap()) {
-        auto chunkInfo = kv.second;
+    for (const auto& chunkInfo : rt->getChunkMap()) {
         auto writesTracker = chunkInfo->getWritesTracker();
         auto bytesWritten = writesTracker->getBytesWritten();
         if (chunksFromSplit.count(chunkInfo.get()) > 0) {
@@ -170,8 +167,7 @@ public:
 
         ASSERT_EQ(_rt->getChunkMap().size(), 1ull);
         // Should only be one
-        for (auto kv : _rt->getChunkMap()) {
-            auto chunkInfo = kv.second;
+        for (const auto& chunkInfo : _rt->getChunkMap()) {
             auto writesTracker = chunkInfo->getWritesTracker();
             writesTracker->addBytesWritten(_bytesInOriginalChunk);
         }
@@ -234,8 +230,7 @@ TEST_F(RoutingTableHistoryTest, SplittingOnlyChunkCopiesBytesWrittenToAllSubchun
     auto rt = splitChunk(getInitialRoutingTable(), newChunkBoundaryPoints);
 
     ASSERT_EQ(rt->getChunkMap().size(), 3ull);
-    for (auto kv : rt->getChunkMap()) {
-        auto chunkInfo = kv.second;
+    for (const auto& chunkInfo : rt->getChunkMap()) {
         auto writesTracker = chunkInfo->getWritesTracker();
         auto bytesWritten = writesTracker->getBytesWritten();
         ASSERT_EQ(bytesWritten, getBytesInOriginalChunk());
@@ -315,6 +315,14 @@ Status storeMongoShellOptions(const moe::Environment& params,
         }
     }
 
+    if (params.count("net.compression.zstdDictionaries")) {
+        const auto ret = storeMessageCompressionDictionaryOptions(
+            params["net.compression.zstdDictionaries"].as<string>());
+        if (!ret.isOK()) {
+            return ret;
+        }
+    }
+
     if (params.count("setShellParameter")) {
         auto ssp = params["setShellParameter"].as<std::map<std::string, std::string>>();
         auto map = ServerParameterSet::getGlobal()->getMap();
@@ -0,0 +1,281 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/io_uring.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "mongo/util/assert_util.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+int sysIoUringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+int sysIoUringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags) {
+    return static_cast<int>(
+        ::syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, nullptr, 0));
+}
+
+int sysIoUringRegister(int fd, unsigned opcode, void* arg, unsigned nrArgs) {
+    return static_cast<int>(::syscall(__NR_io_uring_register, fd, opcode, arg, nrArgs));
+}
+
+Status errnoStatus(StringData what, int err) {
+    return Status(ErrorCodes::InternalError,
+                  str::stream() << what << " failed: " << errnoWithDescription(err));
+}
+
+void* mapRing(int fd, size_t bytes, off_t offset) {
+    return ::mmap(
+        nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, offset);
+}
+
+template <typename T>
+T* ringField(void* base, uint32_t offset) {
+    return reinterpret_cast<T*>(static_cast<char*>(base) + offset);
+}
+
+}  // namespace
+
+StatusWith<std::unique_ptr<IoUring>> IoUring::make(unsigned entries) {
+    std::unique_ptr<IoUring> ring(new IoUring());
+    auto status = ring->_setup(entries);
+    if (!status.isOK()) {
+        return status;
+    }
+    return {std::move(ring)};
+}
+
+Status IoUring::_setup(unsigned entries) {
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_CLAMP | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = entries * 4;
+
+    _ringFd = sysIoUringSetup(entries, &params);
+    if (_ringFd < 0 && errno == EINVAL) {
+        // IORING_SETUP_COOP_TASKRUN is only an optimization; older kernels reject it.
+        params.flags &= ~IORING_SETUP_COOP_TASKRUN;
+        _ringFd = sysIoUringSetup(entries, &params);
+    }
+    if (_ringFd < 0) {
+        return errnoStatus("io_uring_setup", errno);
+    }
+
+    _sqRingBytes = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    _cqRingBytes = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    const bool singleMmap = params.features & IORING_FEAT_SINGLE_MMAP;
+    if (singleMmap) {
+        _sqRingBytes = _cqRingBytes = std::max(_sqRingBytes, _cqRingBytes);
+    }
+
+    _sqRingPtr = mapRing(_ringFd, _sqRingBytes, IORING_OFF_SQ_RING);
+    if (_sqRingPtr == MAP_FAILED) {
+        _sqRingPtr = nullptr;
+        return errnoStatus("mmap of io_uring submission queue", errno);
+    }
+
+    if (singleMmap) {
+        _cqRingPtr = _sqRingPtr;
+    } else {
+        _cqRingPtr = mapRing(_ringFd, _cqRingBytes, IORING_OFF_CQ_RING);
+        if (_cqRingPtr == MAP_FAILED) {
+            _cqRingPtr = nullptr;
+            return errnoStatus("mmap of io_uring completion queue", errno);
+        }
+    }
+
+    _sqesBytes = params.sq_entries * sizeof(io_uring_sqe);
+    _sqesPtr = mapRing(_ringFd, _sqesBytes, IORING_OFF_SQES);
+    if (_sqesPtr == MAP_FAILED) {
+        _sqesPtr = nullptr;
+        return errnoStatus("mmap of io_uring submission entries", errno);
+    }
+
+    _sq.head = ringField<unsigned>(_sqRingPtr, params.sq_off.head);
+    _sq.tail = ringField<unsigned>(_sqRingPtr, params.sq_off.tail);
+    _sq.ringMask = ringField<unsigned>(_sqRingPtr, params.sq_off.ring_mask);
+    _sq.ringEntries = ringField<unsigned>(_sqRingPtr, params.sq_off.ring_entries);
+    _sq.array = ringField<unsigned>(_sqRingPtr, params.sq_off.array);
+    _sq.sqes = static_cast<io_uring_sqe*>(_sqesPtr);
+    _sq.localTail = *_sq.tail;
+
+    _cq.head = ringField<unsigned>(_cqRingPtr, params.cq_off.head);
+    _cq.tail = ringField<unsigned>(_cqRingPtr, params.cq_off.tail);
+    _cq.ringMask = ringField<unsigned>(_cqRingPtr, params.cq_off.ring_mask);
+    _cq.cqes = ringField<io_uring_cqe>(_cqRingPtr, params.cq_off.cqes);
+
+    return Status::OK();
+}
+
+IoUring::~IoUring() {
+    // Closing the ring cancels every outstanding operation, after which the kernel no longer
+    // references the provided buffers, so those are released last.
+    if (_ringFd >= 0) {
+        ::close(_ringFd);
+    }
+    if (_sqesPtr) {
+        ::munmap(_sqesPtr, _sqesBytes);
+    }
+    if (_cqRingPtr && _cqRingPtr != _sqRingPtr) {
+        ::munmap(_cqRingPtr, _cqRingBytes);
+    }
+    if (_sqRingPtr) {
+        ::munmap(_sqRingPtr, _sqRingBytes);
+    }
+    if (_buffers.ring) {
+        ::munmap(_buffers.ring, _buffers.ringBytes);
+    }
+    if (_buffers.data) {
+        ::munmap(_buffers.data, _buffers.size * _buffers.count);
+    }
+}
+
+io_uring_sqe* IoUring::getSqe() {
+    auto tryGet = [&]() -> io_uring_sqe* {
+        const unsigned head = __atomic_load_n(_sq.head, __ATOMIC_ACQUIRE);
+        if (_sq.localTail - head >= *_sq.ringEntries) {
+            return nullptr;
+        }
+        auto sqe = &_sq.sqes[_sq.localTail & *_sq.ringMask];
+        ++_sq.localTail;
+        memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    };
+
+    if (auto sqe = tryGet()) {
+        return sqe;
+    }
+
+    if (!submitAndWait(0).isOK()) {
+        return nullptr;
+    }
+    return tryGet();
+}
+
+Status IoUring::submitAndWait(unsigned waitFor) {
+    // Publish every entry prepared since the last submission. The kernel's head tells us how many
+    // of the published entries it has yet to consume, which also covers any that a previous call
+    // left behind.
+    const unsigned mask = *_sq.ringMask;
+    for (unsigned idx = *_sq.tail; idx != _sq.localTail; ++idx) {
+        _sq.array[idx & mask] = idx & mask;
+    }
+    __atomic_store_n(_sq.tail, _sq.localTail, __ATOMIC_RELEASE);
+
+    unsigned toSubmit = _sq.localTail - __atomic_load_n(_sq.head, __ATOMIC_ACQUIRE);
+    const unsigned flags = waitFor ? IORING_ENTER_GETEVENTS : 0;
+    while (toSubmit || waitFor) {
+        const int ret = sysIoUringEnter(_ringFd, toSubmit, waitFor, flags);
+        if (ret >= 0) {
+            return Status::OK();
+        }
+        if (errno == EINTR) {
+            if (!waitFor) {
+                continue;
+            }
+            return Status::OK();
+        }
+        if (errno == EAGAIN || errno == EBUSY) {
+            // The completion queue is backed up. The caller needs to reap before we can submit
+            // more, so only wait when asked to.
+            return Status::OK();
+        }
+        return errnoStatus("io_uring_enter", errno);
+    }
+    return Status::OK();
+}
+
+Status IoUring::registerBufferRing(uint16_t groupId, unsigned count, size_t size) {
+    invariant(!_buffers.ring);
+    invariant(count > 0 && count <= (1u << 15) && (count & (count - 1)) == 0);
+    invariant(size > 0);
+
+    const size_t pageSize = ::sysconf(_SC_PAGESIZE);
+    _buffers.ringBytes = (count * sizeof(io_uring_buf) + pageSize - 1) & ~(pageSize - 1);
+    void* ringMem = ::mmap(
+        nullptr, _buffers.ringBytes, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (ringMem == MAP_FAILED) {
+        return errnoStatus("mmap of io_uring buffer ring", errno);
+    }
+    _buffers.ring = static_cast<io_uring_buf*>(ringMem);
+
+    void* dataMem =
+        ::mmap(nullptr, size * count, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0);
+    if (dataMem == MAP_FAILED) {
+        return errnoStatus("mmap of io_uring buffers", errno);
+    }
+    _buffers.data = static_cast<char*>(dataMem);
+    _buffers.size = size;
+    _buffers.count = count;
+    _buffers.groupId = groupId;
+
+    io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = reinterpret_cast<uint64_t>(_buffers.ring);
+    reg.ring_entries = count;
+    reg.bgid = groupId;
+    if (sysIoUringRegister(_ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) {
+        return errnoStatus("io_uring_register(IORING_REGISTER_PBUF_RING)", errno);
+    }
+
+    for (unsigned i = 0; i < count; ++i) {
+        auto& buf = _buffers.ring[i];
+        buf.addr = reinterpret_cast<uint64_t>(bufferData(i));
+        buf.len = size;
+        buf.bid = i;
+    }
+    __atomic_store_n(&_buffers.ring[0].resv, uint16_t(count), __ATOMIC_RELEASE);
+
+    return Status::OK();
+}
+
+void IoUring::recycleBuffer(uint16_t bufferId) {
+    uint16_t* tail = &_buffers.ring[0].resv;
+    auto& buf = _buffers.ring[*tail & (_buffers.count - 1)];
+    buf.addr = reinterpret_cast<uint64_t>(bufferData(bufferId));
+    buf.len = _buffers.size;
+    buf.bid = bufferId;
+    __atomic_store_n(tail, uint16_t(*tail + 1), __ATOMIC_RELEASE);
+}
+
+}  // namespace transport
+}  // namespace mongo
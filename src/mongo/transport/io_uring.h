@@ -0,0 +1,166 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <memory>
+
+#include "mongo/base/status_with.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * A minimal wrapper around a Linux io_uring instance that talks to the kernel directly through
+ * the io_uring_setup/io_uring_enter/io_uring_register system calls.
+ *
+ * The submission and completion queues are mapped into our address space, so preparing
+ * operations with getSqe() and consuming their results with reapCompletions() costs no system
+ * calls at all; a single submitAndWait() hands every prepared operation to the kernel and waits
+ * for results in one go.
+ *
+ * The ring may also own a "provided buffer ring": a group of fixed-size buffers shared with the
+ * kernel, from which operations submitted with IOSQE_BUFFER_SELECT (such as multishot recv) pick
+ * a buffer at completion time. The buffer id is reported in the completion flags and the buffer
+ * must be handed back with recycleBuffer() once its contents have been consumed.
+ *
+ * An IoUring is not thread-safe; it must only be driven by one thread at a time.
+ */
+class IoUring {
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+public:
+    /**
+     * Creates a ring with room for at least 'entries' submissions. The completion queue is sized
+     * to four times that, since multishot operations post many completions per submission.
+     */
+    static StatusWith<std::unique_ptr<IoUring>> make(unsigned entries);
+
+    ~IoUring();
+
+    /**
+     * Returns a zeroed submission queue entry to fill in. If the submission queue is full, the
+     * pending entries are submitted to make room first. Returns nullptr only if the kernel could
+     * not accept any of them.
+     */
+    io_uring_sqe* getSqe();
+
+    /**
+     * Submits every prepared entry and, if 'waitFor' is non-zero, blocks until at least that many
+     * completions are available. Interrupted waits return early without an error.
+     */
+    Status submitAndWait(unsigned waitFor);
+
+    /**
+     * Invokes 'cb' with every available completion queue entry, in order, then releases them
+     * back to the kernel. Returns the number of completions consumed.
+     */
+    template <typename Callback>
+    size_t reapCompletions(Callback&& cb) {
+        unsigned head = *_cq.head;
+        const unsigned tail = __atomic_load_n(_cq.tail, __ATOMIC_ACQUIRE);
+        const size_t count = tail - head;
+        for (; head != tail; ++head) {
+            cb(_cq.cqes[head & *_cq.ringMask]);
+        }
+        __atomic_store_n(_cq.head, tail, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    /**
+     * Registers 'count' buffers of 'size' bytes each with the kernel as buffer group 'groupId'.
+     * 'count' must be a power of two no larger than 32768. Only one group may be registered.
+     */
+    Status registerBufferRing(uint16_t groupId, unsigned count, size_t size);
+
+    const char* bufferData(uint16_t bufferId) const {
+        return _buffers.data + size_t(bufferId) * _buffers.size;
+    }
+
+    /**
+     * Returns a buffer previously selected by the kernel to the buffer group.
+     */
+    void recycleBuffer(uint16_t bufferId);
+
+    uint16_t bufferGroup() const {
+        return _buffers.groupId;
+    }
+
+private:
+    IoUring() = default;
+
+    Status _setup(unsigned entries);
+
+    int _ringFd = -1;
+
+    struct SubmissionQueue {
+        unsigned* head = nullptr;
+        unsigned* tail = nullptr;
+        unsigned* ringMask = nullptr;
+        unsigned* ringEntries = nullptr;
+        unsigned* array = nullptr;
+        io_uring_sqe* sqes = nullptr;
+
+        // Index of the next entry handed out by getSqe(); published to '*tail' on submission.
+        unsigned localTail = 0;
+    } _sq;
+
+    struct CompletionQueue {
+        unsigned* head = nullptr;
+        unsigned* tail = nullptr;
+        unsigned* ringMask = nullptr;
+        io_uring_cqe* cqes = nullptr;
+    } _cq;
+
+    struct ProvidedBuffers {
+        // The ring is addressed as a plain array of io_uring_buf rather than through
+        // io_uring_buf_ring, whose flexible array member is laid out differently by C++ compilers
+        // than by C ones. The kernel overlays the ring tail on the first entry's 'resv' field.
+        io_uring_buf* ring = nullptr;
+        size_t ringBytes = 0;
+        char* data = nullptr;
+        size_t size = 0;
+        unsigned count = 0;
+        uint16_t groupId = 0;
+    } _buffers;
+
+    void* _sqRingPtr = nullptr;
+    size_t _sqRingBytes = 0;
+    void* _cqRingPtr = nullptr;
+    size_t _cqRingBytes = 0;
+    void* _sqesPtr = nullptr;
+    size_t _sqesBytes = 0;
+};
+
+}  // namespace transport
+}  // namespace mongo
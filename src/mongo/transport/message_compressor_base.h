@@ -33,7 +33,9 @@
 #include "mongo/base/status_with.h"
 #include "mongo/base/string_data.h"
 #include "mongo/platform/atomic_word.h"
+#include "mongo/util/shared_buffer.h"
 
+#include <algorithm>
 #include <type_traits>
 
 namespace mongo {
@@ -82,6 +84,23 @@ public:
      */
     virtual StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) = 0;
 
+    /*
+     * Like compressData, but writes into 'output' starting at 'offset', growing 'output' as
+     * compressed data is produced rather than sizing it for getMaxCompressedSize() up front. For
+     * large, compressible messages this keeps the compressed copy close to its real size. 'output'
+     * must not be shared. Returns the number of bytes written after 'offset'.
+     *
+     * Compressors without an incremental API use this default, which sizes 'output' for the worst
+     * case and calls compressData.
+     */
+    virtual StatusWith<std::size_t> compressDataStreaming(ConstDataRange input,
+                                                          SharedBuffer* output,
+                                                          std::size_t offset) {
+        output->realloc(offset + getMaxCompressedSize(input.length()));
+        return compressData(input,
+                            DataRange(output->get() + offset, output->get() + output->capacity()));
+    }
+
     /*
      * This method decompresses the data in the input ConstDataRange into the output DataRange.
      * It returns the number of bytes actually decompressed into the output range, or an error
@@ -126,6 +145,27 @@ protected:
         : _id{static_cast<MessageCompressorId>(id)},
           _name{getMessageCompressorName(id).toString()} {}
 
+    /*
+     * Called by sub-classes from compressDataStreaming when 'output' has no room left after
+     * 'offset'. Starts with an eighth of the input (a typical compression ratio for BSON) and
+     * doubles from there, never past getMaxCompressedSize. Returns the space now available after
+     * 'offset', which is unchanged once the worst case is reached.
+     */
+    std::size_t growStreamingOutput(SharedBuffer* output,
+                                    std::size_t offset,
+                                    std::size_t inputSize) {
+        const std::size_t kMinStreamingOutput = 64 * 1024;
+        const std::size_t current = output->capacity() > offset ? output->capacity() - offset : 0;
+        const std::size_t wanted =
+            current ? current * 2 : std::max(inputSize / 8, kMinStreamingOutput);
+        const std::size_t grown =
+            std::max(current, std::min(wanted, getMaxCompressedSize(inputSize)));
+        if (grown != current) {
+            output->realloc(offset + grown);
+        }
+        return grown;
+    }
+
     /*
      * Called by sub-classes to bump their bytesIn/bytesOut counters for compression
      */
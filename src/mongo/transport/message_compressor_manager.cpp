@@ -39,6 +39,7 @@
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/rpc/message.h"
 #include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/message_compressor_zstd.h"
 #include "mongo/transport/session.h"
 #include "mongo/util/log.h"
 
@@ -74,6 +75,17 @@ struct CompressionHeader {
 
 const transport::Session::Decoration<MessageCompressorManager> getForSession =
     transport::Session::declareDecoration<MessageCompressorManager>();
+
+constexpr auto kZstdDictionariesFieldName = "zstdDictionaries"_sd;
+constexpr auto kZstdDictionaryFieldName = "zstdDictionary"_sd;
+
+ZstdMessageCompressor* getZstdCompressor(MessageCompressorBase* compressor) {
+    if (!compressor ||
+        compressor->getId() != static_cast<MessageCompressorId>(MessageCompressor::kZstd)) {
+        return nullptr;
+    }
+    return static_cast<ZstdMessageCompressor*>(compressor);
+}
 }  // namespace
 
 MessageCompressorManager::MessageCompressorManager()
@@ -98,8 +110,8 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
     LOG(3) << "Compressing message with " << compressor->getName();
 
     auto inputHeader = msg.header();
-    size_t bufferSize = compressor->getMaxCompressedSize(msg.dataSize()) +
-        CompressionHeader::size() + MsgData::MsgDataHeaderSize;
+    const size_t headerSize = CompressionHeader::size() + MsgData::MsgDataHeaderSize;
+    size_t bufferSize = compressor->getMaxCompressedSize(msg.dataSize()) + headerSize;
 
     CompressionHeader compressionHeader(
         inputHeader.getNetworkOp(), inputHeader.dataLen(), compressor->getId());
@@ -110,7 +122,11 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
         return {msg};
     }
 
-    auto outputMessageBuffer = SharedBuffer::allocate(bufferSize);
+    // Large messages start out with room for just the headers and the compressor grows the buffer
+    // as it goes.
+    const bool streaming =
+        static_cast<size_t>(msg.dataSize()) >= kStreamingCompressionThresholdBytes;
+    auto outputMessageBuffer = SharedBuffer::allocate(streaming ? headerSize : bufferSize);
 
     MsgData::View outMessage(outputMessageBuffer.get());
     outMessage.setId(inputHeader.getId());
@@ -118,17 +134,34 @@ StatusWith<Message> MessageCompressorManager::compressMessage(
     outMessage.setOperation(dbCompressed);
     outMessage.setLen(bufferSize);
 
-    DataRangeCursor output(outMessage.data(), outMessage.data() + outMessage.dataLen());
+    DataRangeCursor output(outMessage.data(),
+                           outputMessageBuffer.get() + outputMessageBuffer.capacity());
     compressionHeader.serialize(&output);
     ConstDataRange input(inputHeader.data(), inputHeader.data() + inputHeader.dataLen());
 
-    auto sws = compressor->compressData(input, output);
+    auto zstd = getZstdCompressor(compressor);
+    auto dictionary = zstd ? _zstdDictionary.get() : nullptr;
+    auto sws = [&]() -> StatusWith<std::size_t> {
+        if (streaming) {
+            return dictionary ? zstd->compressDataStreamingWithDictionary(
+                                    input, &outputMessageBuffer, headerSize, dictionary)
+                              : compressor->compressDataStreaming(
+                                    input, &outputMessageBuffer, headerSize);
+        }
+        return dictionary ? zstd->compressDataWithDictionary(input, output, dictionary)
+                          : compressor->compressData(input, output);
+    }();
 
     if (!sws.isOK())
         return sws.getStatus();
 
-    auto realCompressedSize = sws.getValue();
-    outMessage.setLen(realCompressedSize + CompressionHeader::size() + MsgData::MsgDataHeaderSize);
+    auto compressedMessageSize = sws.getValue() + headerSize;
+    if (streaming) {
+        // Hand back whatever the last growth step over-reserved, since the message may sit in a
+        // send queue for a while.
+        outputMessageBuffer.realloc(compressedMessageSize);
+    }
+    MsgData::View(outputMessageBuffer.get()).setLen(compressedMessageSize);
 
     return {Message(outputMessageBuffer)};
 }
@@ -195,6 +228,7 @@ void MessageCompressorManager::clientBegin(BSONObjBuilder* output) {
 
     // We're about to update the compressor list with the negotiation result from the server.
     _negotiated.clear();
+    _zstdDictionary.reset();
 
     auto& compressorList = _registry->getCompressorNames();
     if (compressorList.size() == 0)
@@ -206,6 +240,21 @@ void MessageCompressorManager::clientBegin(BSONObjBuilder* output) {
         sub.append(e);
     }
     sub.doneFast();
+
+    auto zstd = getZstdCompressor(
+        _registry->getCompressor(static_cast<MessageCompressorId>(MessageCompressor::kZstd)));
+    if (!zstd)
+        return;
+    auto dictionaryIds = zstd->getDictionaryIds();
+    if (dictionaryIds.empty())
+        return;
+
+    BSONArrayBuilder dictionaries(output->subarrayStart(kZstdDictionariesFieldName));
+    for (auto id : dictionaryIds) {
+        LOG(3) << "Offering zstd dictionary " << id << " to server";
+        dictionaries.append(static_cast<long long>(id));
+    }
+    dictionaries.doneFast();
 }
 
 void MessageCompressorManager::clientFinish(const BSONObj& input) {
@@ -231,6 +280,14 @@ void MessageCompressorManager::clientFinish(const BSONObj& input) {
         LOG(3) << "Adding compressor " << ret->getName();
         _negotiated.push_back(ret);
     }
+
+    auto dictionaryElem = input.getField(kZstdDictionaryFieldName);
+    if (dictionaryElem.isNumber()) {
+        _zstdDictionary = _findZstdDictionary(dictionaryElem.safeNumberLong());
+        if (_zstdDictionary) {
+            LOG(3) << "Using zstd dictionary " << _zstdDictionary->getId();
+        }
+    }
 }
 
 void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuilder* output) {
@@ -249,6 +306,10 @@ void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuil
                 sub.append(algo->getName());
             }
             sub.doneFast();
+            if (_zstdDictionary) {
+                output->append(kZstdDictionaryFieldName,
+                               static_cast<long long>(_zstdDictionary->getId()));
+            }
         } else {
             LOG(3) << "Compression negotiation not requested by client";
         }
@@ -258,6 +319,7 @@ void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuil
     // If compression has already been negotiated, then this is a renegotiation, so we should
     // reset the state of the manager.
     _negotiated.clear();
+    _zstdDictionary.reset();
 
     // First we go through all the compressor names that the client has requested support for
     BSONObj theirObj = elem.Obj();
@@ -290,7 +352,35 @@ void MessageCompressorManager::serverNegotiate(const BSONObj& input, BSONObjBuil
         sub.doneFast();
     } else {
         LOG(3) << "Could not agree on compressor to use";
+        return;
+    }
+
+    // Use the first dictionary the client offered that we have too.
+    auto dictionariesElem = input.getField(kZstdDictionariesFieldName);
+    if (dictionariesElem.type() != Array)
+        return;
+    for (const auto& elem : dictionariesElem.Obj()) {
+        if (!elem.isNumber())
+            continue;
+        if ((_zstdDictionary = _findZstdDictionary(elem.safeNumberLong()))) {
+            LOG(3) << "Agreed on zstd dictionary " << _zstdDictionary->getId();
+            output->append(kZstdDictionaryFieldName,
+                           static_cast<long long>(_zstdDictionary->getId()));
+            return;
+        }
+    }
+    LOG(3) << "Could not agree on zstd dictionary to use";
+}
+
+std::shared_ptr<ZstdDictionary> MessageCompressorManager::_findZstdDictionary(long long id) const {
+    for (auto compressor : _negotiated) {
+        if (auto zstd = getZstdCompressor(compressor)) {
+            if (id <= 0 || id > std::numeric_limits<uint32_t>::max())
+                return nullptr;
+            return zstd->getDictionary(static_cast<uint32_t>(id));
+        }
     }
+    return nullptr;
 }
 
 MessageCompressorManager& MessageCompressorManager::forSession(
@@ -33,6 +33,7 @@
 #include "mongo/transport/message_compressor_base.h"
 #include "mongo/transport/session.h"
 
+#include <memory>
 #include <vector>
 
 namespace mongo {
@@ -41,12 +42,15 @@ class BSONObj;
 class BSONObjBuilder;
 class Message;
 class MessageCompressorRegistry;
+class ZstdDictionary;
 
 class MessageCompressorManager {
     MessageCompressorManager(const MessageCompressorManager&) = delete;
     MessageCompressorManager& operator=(const MessageCompressorManager&) = delete;
 
 public:
+    static constexpr std::size_t kStreamingCompressionThresholdBytes = 1024 * 1024;
+
     /*
      * Default constructor. Uses the global MessageCompressorRegistry.
      */
@@ -65,6 +69,9 @@ public:
      * Called by a client constructing an isMaster request. This function will append the result
      * of _registry->getCompressorNames() to the BSONObjBuilder as a BSON array. If no compressors
      * are configured, it won't append anything.
+     *
+     * If zstd is offered and has dictionaries loaded, their IDs are appended as the
+     * "zstdDictionaries" array, in order of preference.
      */
     void clientBegin(BSONObjBuilder* output);
 
@@ -75,6 +82,9 @@ public:
      * This looks for a BSON array called "compression" with the server's list of
      * requested algorithms. The first algorithm in that array will be used in subsequent calls
      * to compressMessage.
+     *
+     * If the server also picked a zstd dictionary ("zstdDictionary"), zstd compression on this
+     * connection uses it.
      */
     void clientFinish(const BSONObj& input);
 
@@ -87,6 +97,9 @@ public:
      *
      * If no compressors are configured that match those requested by the client, then it will
      * not append anything to the BSONObjBuilder output.
+     *
+     * If zstd was negotiated, the first of the client's "zstdDictionaries" that this process also
+     * has is used for zstd compression on this connection and echoed back as "zstdDictionary".
      */
     void serverNegotiate(const BSONObj& input, BSONObjBuilder* output);
 
@@ -100,6 +113,11 @@ public:
      * it will return a ref-count bumped copy of the input message.
      *
      * If an error occurs in the compressor, it will return a Status error.
+     *
+     * Messages of at least kStreamingCompressionThresholdBytes (typically large command replies
+     * and getMore batches) are compressed into a buffer that grows with the compressed output,
+     * rather than one sized for the compressor's worst case, so that compressing a large reply
+     * does not briefly need twice its size.
      */
     StatusWith<Message> compressMessage(const Message& msg,
                                         const MessageCompressorId* compressorId = nullptr);
@@ -127,8 +145,16 @@ public:
     static MessageCompressorManager& forSession(const transport::SessionHandle& session);
 
 private:
+    /*
+     * Returns the zstd dictionary with the given ID if zstd was negotiated and has it loaded.
+     */
+    std::shared_ptr<ZstdDictionary> _findZstdDictionary(long long id) const;
+
     std::vector<MessageCompressorBase*> _negotiated;
     MessageCompressorRegistry* _registry;
+
+    // The zstd dictionary negotiated for this connection, if any.
+    std::shared_ptr<ZstdDictionary> _zstdDictionary;
 };
 
 }  // namespace mongo
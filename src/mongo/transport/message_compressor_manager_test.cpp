@@ -36,7 +36,9 @@
 #include <vector>
 
 #include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/rpc/message.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/transport/message_compressor_manager.h"
 #include "mongo/transport/message_compressor_noop.h"
 #include "mongo/transport/message_compressor_registry.h"
@@ -404,5 +406,248 @@ TEST(MessageCompressorManager, RuntMessage) {
     ASSERT_NOT_OK(status);
 }
 
+/**
+ * Builds a message whose body is a small document with the same shape as the ones used to train
+ * makeTestDictionary(), like a reply to a point read.
+ */
+Message buildPointReadReply(int i) {
+    const auto doc = BSON("_id" << i << "name" << ("customer" + std::to_string(i * 7)) << "status"
+                                << "active"
+                                << "address"
+                                << BSON("city"
+                                        << "Springfield"
+                                        << "postalCode" << std::to_string(10000 + i)));
+    const auto bufferSize = MsgData::MsgDataHeaderSize + doc.objsize();
+    auto buf = SharedBuffer::allocate(bufferSize);
+    MsgData::View view(buf.get());
+    view.setId(i);
+    view.setResponseToMsgId(0);
+    view.setOperation(dbMsg);
+    view.setLen(bufferSize);
+    memcpy(view.data(), doc.objdata(), doc.objsize());
+    return Message{buf};
+}
+
+std::shared_ptr<ZstdDictionary> makeTestDictionary() {
+    std::vector<Message> messages;
+    std::vector<ConstDataRange> samples;
+    for (int i = 0; i < 1000; ++i) {
+        messages.push_back(buildPointReadReply(i));
+        const auto view = messages.back().singleData();
+        samples.emplace_back(view.data(), view.dataLen());
+    }
+    return assertOk(ZstdDictionary::train("test", samples, 16 * 1024));
+}
+
+MessageCompressorRegistry buildZstdRegistry(std::vector<std::shared_ptr<ZstdDictionary>> dicts) {
+    auto compressor = std::make_unique<ZstdMessageCompressor>();
+    for (auto&& dict : dicts) {
+        ASSERT_OK(compressor->addDictionary(dict));
+    }
+
+    MessageCompressorRegistry registry;
+    registry.setSupportedCompressors({compressor->getName()});
+    registry.registerImplementation(std::move(compressor));
+    ASSERT_OK(registry.finalizeSupportedCompressors());
+    return registry;
+}
+
+void negotiate(MessageCompressorManager* client, MessageCompressorManager* server) {
+    BSONObjBuilder clientOutput;
+    client->clientBegin(&clientOutput);
+    BSONObjBuilder serverOutput;
+    server->serverNegotiate(clientOutput.done(), &serverOutput);
+    client->clientFinish(serverOutput.done());
+}
+
+TEST(ZstdMessageCompressor, NegotiatesSharedDictionary) {
+    const auto dict = makeTestDictionary();
+    auto clientRegistry = buildZstdRegistry({dict});
+    auto serverRegistry = buildZstdRegistry({dict});
+
+    MessageCompressorManager client(&clientRegistry);
+    BSONObjBuilder clientOutput;
+    client.clientBegin(&clientOutput);
+    const auto clientObj = clientOutput.done();
+    ASSERT_BSONOBJ_EQ(clientObj["zstdDictionaries"].Obj(),
+                      BSON_ARRAY(static_cast<long long>(dict->getId())));
+
+    MessageCompressorManager server(&serverRegistry);
+    BSONObjBuilder serverOutput;
+    server.serverNegotiate(clientObj, &serverOutput);
+    const auto serverObj = serverOutput.done();
+    checkNegotiationResult(serverObj, {"zstd"});
+    ASSERT_EQ(serverObj["zstdDictionary"].numberLong(), dict->getId());
+    client.clientFinish(serverObj);
+
+    // Replies go out compressed against the dictionary, come back intact, and are much smaller
+    // than with plain zstd.
+    MessageCompressorManager plain(&serverRegistry);
+    auto original = buildPointReadReply(5000);
+    auto compressed = assertOk(server.compressMessage(original));
+    auto compressedPlain = assertOk(plain.compressMessage(original));
+    ASSERT_LT(compressed.size(), compressedPlain.size());
+
+    auto decompressed = assertOk(client.decompressMessage(compressed));
+    ASSERT_EQ(decompressed.size(), original.size());
+    ASSERT_EQ(memcmp(decompressed.buf(), original.buf(), original.size()), 0);
+
+    // Requests use the dictionary too.
+    decompressed = assertOk(server.decompressMessage(assertOk(client.compressMessage(original))));
+    ASSERT_EQ(memcmp(decompressed.buf(), original.buf(), original.size()), 0);
+
+    BSONObjBuilder stats;
+    dict->appendStats(&stats);
+    const auto statsObj = stats.obj();
+    ASSERT_EQ(statsObj["compressor"]["bytesIn"].numberLong(), 2 * original.dataSize());
+    ASSERT_EQ(statsObj["decompressor"]["bytesOut"].numberLong(), 2 * original.dataSize());
+}
+
+// Connections on many threads at once share the pooled zstd contexts, including when there are more
+// of them than the pool keeps.
+TEST(ZstdMessageCompressor, ConcurrentDictionaryCompression) {
+    const auto dict = makeTestDictionary();
+    auto clientRegistry = buildZstdRegistry({dict});
+    auto serverRegistry = buildZstdRegistry({dict});
+
+    AtomicWord<long long> bytesIn{0};
+    std::vector<stdx::thread> threads;
+    for (int t = 0; t < 32; ++t) {
+        threads.emplace_back([&, t] {
+            MessageCompressorManager client(&clientRegistry);
+            MessageCompressorManager server(&serverRegistry);
+            negotiate(&client, &server);
+            for (int i = 0; i < 100; ++i) {
+                auto original = buildPointReadReply(t * 100 + i);
+                bytesIn.fetchAndAdd(original.dataSize());
+                auto decompressed = assertOk(
+                    client.decompressMessage(assertOk(server.compressMessage(original))));
+                ASSERT_EQ(decompressed.size(), original.size());
+                ASSERT_EQ(memcmp(decompressed.buf(), original.buf(), original.size()), 0);
+            }
+        });
+    }
+    for (auto&& thread : threads) {
+        thread.join();
+    }
+
+    BSONObjBuilder stats;
+    dict->appendStats(&stats);
+    ASSERT_EQ(stats.obj()["compressor"]["bytesIn"].numberLong(), bytesIn.load());
+}
+
+TEST(ZstdMessageCompressor, NoSharedDictionary) {
+    auto clientRegistry = buildZstdRegistry({makeTestDictionary()});
+    auto serverRegistry = buildZstdRegistry({});
+
+    MessageCompressorManager client(&clientRegistry);
+    MessageCompressorManager server(&serverRegistry);
+    BSONObjBuilder clientOutput;
+    client.clientBegin(&clientOutput);
+    BSONObjBuilder serverOutput;
+    server.serverNegotiate(clientOutput.done(), &serverOutput);
+    const auto serverObj = serverOutput.done();
+    checkNegotiationResult(serverObj, {"zstd"});
+    ASSERT_TRUE(serverObj["zstdDictionary"].eoo());
+    client.clientFinish(serverObj);
+
+    // Compression still works, just without a dictionary.
+    auto original = buildPointReadReply(1);
+    auto decompressed =
+        assertOk(server.decompressMessage(assertOk(client.compressMessage(original))));
+    ASSERT_EQ(memcmp(decompressed.buf(), original.buf(), original.size()), 0);
+}
+
+TEST(ZstdMessageCompressor, UnknownDictionaryFailsToDecompress) {
+    auto senderRegistry = buildZstdRegistry({makeTestDictionary()});
+    auto receiverRegistry = buildZstdRegistry({});
+    MessageCompressorManager sender(&senderRegistry);
+    MessageCompressorManager peer(&senderRegistry);
+    negotiate(&sender, &peer);
+
+    auto compressed = assertOk(sender.compressMessage(buildPointReadReply(1)));
+    MessageCompressorManager receiver(&receiverRegistry);
+    ASSERT_NOT_OK(receiver.decompressMessage(compressed).getStatus());
+}
+
+/**
+ * Builds a message the size of a full getMore batch, large enough to take the streaming
+ * compression path.
+ */
+Message buildLargeBatchReply() {
+    BufBuilder body;
+    for (int i = 0; body.len() < 4 * 1024 * 1024; ++i) {
+        const auto doc = buildPointReadReply(i);
+        body.appendBuf(doc.singleData().data(), doc.singleData().dataLen());
+    }
+    ASSERT_GTE(static_cast<size_t>(body.len()),
+               MessageCompressorManager::kStreamingCompressionThresholdBytes);
+
+    const auto bufferSize = MsgData::MsgDataHeaderSize + body.len();
+    auto buf = SharedBuffer::allocate(bufferSize);
+    MsgData::View view(buf.get());
+    view.setId(1);
+    view.setResponseToMsgId(0);
+    view.setOperation(dbMsg);
+    view.setLen(bufferSize);
+    memcpy(view.data(), body.buf(), body.len());
+    return Message{buf};
+}
+
+TEST(MessageCompressorManager, StreamingFidelity) {
+    const auto original = buildLargeBatchReply();
+    checkFidelity(original, std::make_unique<NoopMessageCompressor>());
+    checkFidelity(original, std::make_unique<SnappyMessageCompressor>());
+    checkFidelity(original, std::make_unique<ZlibMessageCompressor>());
+    checkFidelity(original, std::make_unique<ZstdMessageCompressor>());
+}
+
+TEST(MessageCompressorManager, StreamingCompressionOnlyAllocatesWhatItUses) {
+    const auto original = buildLargeBatchReply();
+    auto checkCompressor = [&](std::unique_ptr<MessageCompressorBase> compressor) {
+        const auto maxCompressedSize = compressor->getMaxCompressedSize(original.dataSize());
+        MessageCompressorRegistry registry;
+        registry.setSupportedCompressors({compressor->getName()});
+        registry.registerImplementation(std::move(compressor));
+        ASSERT_OK(registry.finalizeSupportedCompressors());
+        MessageCompressorManager client(&registry);
+        MessageCompressorManager server(&registry);
+        negotiate(&client, &server);
+
+        auto compressed = assertOk(server.compressMessage(original));
+        ASSERT_EQ(compressed.capacity(), static_cast<size_t>(compressed.size()));
+        ASSERT_LT(compressed.capacity(), maxCompressedSize / 4);
+
+        auto decompressed = assertOk(client.decompressMessage(compressed));
+        ASSERT_EQ(decompressed.size(), original.size());
+        ASSERT_EQ(memcmp(decompressed.buf(), original.buf(), original.size()), 0);
+    };
+    checkCompressor(std::make_unique<ZlibMessageCompressor>());
+    checkCompressor(std::make_unique<ZstdMessageCompressor>());
+}
+
+TEST(ZstdMessageCompressor, StreamingCompressionUsesDictionary) {
+    const auto dict = makeTestDictionary();
+    auto registry = buildZstdRegistry({dict});
+    MessageCompressorManager client(&registry);
+    MessageCompressorManager server(&registry);
+    negotiate(&client, &server);
+
+    const auto original = buildLargeBatchReply();
+    auto compressed = assertOk(server.compressMessage(original));
+    auto decompressed = assertOk(client.decompressMessage(compressed));
+    ASSERT_EQ(decompressed.size(), original.size());
+    ASSERT_EQ(memcmp(decompressed.buf(), original.buf(), original.size()), 0);
+
+    BSONObjBuilder stats;
+    dict->appendStats(&stats);
+    ASSERT_EQ(stats.obj()["compressor"]["bytesIn"].numberLong(), original.dataSize());
+}
+
+TEST(ZstdMessageCompressor, RejectsUntrainedDictionary) {
+    const std::string raw = "not a dictionary";
+    ASSERT_NOT_OK(ZstdDictionary::make("raw", ConstDataRange(raw.data(), raw.size())).getStatus());
+}
+
 }  // namespace
 }  // namespace mongo
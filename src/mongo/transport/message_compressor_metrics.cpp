@@ -31,6 +31,7 @@
 
 #include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/transport/message_compressor_registry.h"
+#include "mongo/transport/message_compressor_zstd.h"
 
 namespace mongo {
 namespace {
@@ -59,6 +60,15 @@ void appendMessageCompressionStats(BSONObjBuilder* b) {
         decompressorSection << kBytesIn << compressor->getDecompressorBytesIn() << kBytesOut
                             << compressor->getDecompressorBytesOut();
         decompressorSection.doneFast();
+
+        if (compressor->getId() == static_cast<MessageCompressorId>(MessageCompressor::kZstd)) {
+            auto zstd = static_cast<ZstdMessageCompressor*>(compressor);
+            if (!zstd->getDictionaryIds().empty()) {
+                BSONObjBuilder dictionariesSection(base.subobjStart("dictionaries"));
+                zstd->appendDictionaryStats(&dictionariesSection);
+                dictionariesSection.doneFast();
+            }
+        }
         base.doneFast();
     }
     compressionSection.doneFast();
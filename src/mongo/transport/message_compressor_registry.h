@@ -119,5 +119,11 @@ private:
 };
 
 Status storeMessageCompressionOptions(const std::string& compressors);
+
+/*
+ * Loads the zstd dictionaries in the comma-separated list of files. They are handed to the zstd
+ * compressor when it registers itself.
+ */
+Status storeMessageCompressionDictionaryOptions(const std::string& zstdDictionaryFiles);
 void appendMessageCompressionStats(BSONObjBuilder* b);
 }  // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/base/init.h"
 #include "mongo/transport/message_compressor_registry.h"
 #include "mongo/transport/message_compressor_zlib.h"
+#include "mongo/util/scopeguard.h"
 
 #include <zlib.h>
 
@@ -63,6 +64,44 @@ StatusWith<std::size_t> ZlibMessageCompressor::compressData(ConstDataRange input
     return {outLength};
 }
 
+StatusWith<std::size_t> ZlibMessageCompressor::compressDataStreaming(ConstDataRange input,
+                                                                     SharedBuffer* output,
+                                                                     std::size_t offset) {
+    z_stream stream{};
+    if (::deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+        return Status{ErrorCodes::BadValue, "Could not compress input"};
+    }
+    ON_BLOCK_EXIT([&] { ::deflateEnd(&stream); });
+
+    // Messages are capped well below 4GB, so the whole input fits in 'avail_in'.
+    stream.next_in = const_cast<Bytef*>(reinterpret_cast<const Bytef*>(input.data()));
+    stream.avail_in = input.length();
+
+    std::size_t space = output->capacity() - offset;
+    int ret = Z_OK;
+    while (ret == Z_OK || ret == Z_BUF_ERROR) {
+        if (stream.total_out == space) {
+            const auto grown = growStreamingOutput(output, offset, input.length());
+            if (grown == space) {
+                return Status{ErrorCodes::BadValue,
+                              "Could not compress input: output exceeded the maximum size"};
+            }
+            space = grown;
+        }
+
+        // The output buffer may have moved when it grew.
+        stream.next_out = reinterpret_cast<Bytef*>(output->get() + offset + stream.total_out);
+        stream.avail_out = space - stream.total_out;
+        ret = ::deflate(&stream, Z_FINISH);
+    }
+
+    if (ret != Z_STREAM_END) {
+        return Status{ErrorCodes::BadValue, "Could not compress input"};
+    }
+    counterHitCompress(input.length(), stream.total_out);
+    return {stream.total_out};
+}
+
 StatusWith<std::size_t> ZlibMessageCompressor::decompressData(ConstDataRange input,
                                                               DataRange output) {
     uLongf length = output.length();
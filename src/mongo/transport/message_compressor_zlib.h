@@ -38,6 +38,10 @@ public:
 
     StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) override;
 
+    StatusWith<std::size_t> compressDataStreaming(ConstDataRange input,
+                                                  SharedBuffer* output,
+                                                  std::size_t offset) override;
+
     StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) override;
 };
 
@@ -31,15 +31,187 @@
 
 #include "mongo/platform/basic.h"
 
+#include <fstream>
+#include <iterator>
 #include <memory>
 
+#include <boost/algorithm/string/classification.hpp>
+#include <boost/algorithm/string/split.hpp>
+#include <zdict.h>
 #include <zstd.h>
 
 #include "mongo/base/init.h"
+#include "mongo/bson/bsonobjbuilder.h"
 #include "mongo/transport/message_compressor_registry.h"
 #include "mongo/transport/message_compressor_zstd.h"
+#include "mongo/util/log.h"
+#include "mongo/util/timer.h"
 
 namespace mongo {
+namespace {
+
+// Dictionaries loaded while storing startup options, which happens before the compressor is
+// registered.
+std::vector<std::shared_ptr<ZstdDictionary>> dictionariesFromOptions;
+
+// Creating zstd contexts is expensive, so idle ones are kept for dictionary (de)compression and
+// shared by every connection. The pool keeps at most kMaxIdleContexts of each kind, and lets go of
+// any context whose buffers have grown past kMaxIdleContextBytes on an unusually large message.
+constexpr size_t kMaxIdleContexts = 16;
+constexpr size_t kMaxIdleContextBytes = 1024 * 1024;
+
+template <typename Context>
+class ZstdContextPool {
+public:
+    using CreateFn = Context* (*)();
+    using FreeFn = size_t (*)(Context*);
+    using SizeofFn = size_t (*)(const Context*);
+
+    struct Release {
+        void operator()(Context* context) const {
+            pool->_release(context);
+        }
+
+        ZstdContextPool* pool;
+    };
+
+    // Hands the context back to the pool when it goes out of scope. Null if creating a context
+    // failed.
+    using Handle = std::unique_ptr<Context, Release>;
+
+    ZstdContextPool(CreateFn create, FreeFn free, SizeofFn sizeOf)
+        : _create(create), _free(free), _sizeOf(sizeOf) {}
+
+    Handle acquire() {
+        stdx::unique_lock<Latch> lk(_mutex);
+        if (!_idle.empty()) {
+            auto context = _idle.back();
+            _idle.pop_back();
+            return Handle(context, Release{this});
+        }
+        lk.unlock();
+        return Handle(_create(), Release{this});
+    }
+
+private:
+    void _release(Context* context) {
+        if (_sizeOf(context) <= kMaxIdleContextBytes) {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (_idle.size() < kMaxIdleContexts) {
+                _idle.push_back(context);
+                return;
+            }
+        }
+        _free(context);
+    }
+
+    const CreateFn _create;
+    const FreeFn _free;
+    const SizeofFn _sizeOf;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("ZstdContextPool::_mutex");
+    std::vector<Context*> _idle;
+};
+
+// The pools are never destroyed, as connections may still be compressing during shutdown.
+ZstdContextPool<ZSTD_CCtx>& compressionContexts() {
+    static auto pool =
+        new ZstdContextPool<ZSTD_CCtx>(ZSTD_createCCtx, ZSTD_freeCCtx, ZSTD_sizeof_CCtx);
+    return *pool;
+}
+
+ZstdContextPool<ZSTD_DCtx>& decompressionContexts() {
+    static auto pool =
+        new ZstdContextPool<ZSTD_DCtx>(ZSTD_createDCtx, ZSTD_freeDCtx, ZSTD_sizeof_DCtx);
+    return *pool;
+}
+
+}  // namespace
+
+ZstdDictionary::ZstdDictionary(std::string source,
+                               uint32_t id,
+                               ZSTD_CDict_s* cdict,
+                               ZSTD_DDict_s* ddict)
+    : _source(std::move(source)), _id(id), _cdict(cdict), _ddict(ddict) {}
+
+ZstdDictionary::~ZstdDictionary() {
+    ZSTD_freeCDict(_cdict);
+    ZSTD_freeDDict(_ddict);
+}
+
+StatusWith<std::shared_ptr<ZstdDictionary>> ZstdDictionary::make(std::string source,
+                                                                 ConstDataRange data) {
+    const auto id = ZDICT_getDictID(data.data(), data.length());
+    if (id == 0) {
+        return Status{ErrorCodes::BadValue,
+                      str::stream() << "Not a trained zstd dictionary: " << source};
+    }
+
+    auto cdict = ZSTD_createCDict(data.data(), data.length(), ZSTD_CLEVEL_DEFAULT);
+    auto ddict = ZSTD_createDDict(data.data(), data.length());
+    if (!cdict || !ddict) {
+        ZSTD_freeCDict(cdict);
+        ZSTD_freeDDict(ddict);
+        return Status{ErrorCodes::BadValue,
+                      str::stream() << "Could not load zstd dictionary: " << source};
+    }
+
+    return std::shared_ptr<ZstdDictionary>(new ZstdDictionary(std::move(source), id, cdict, ddict));
+}
+
+StatusWith<std::shared_ptr<ZstdDictionary>> ZstdDictionary::load(const std::string& path) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        return Status{ErrorCodes::FileOpenFailed,
+                      str::stream() << "Could not open zstd dictionary file: " << path};
+    }
+    std::string contents{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()};
+    if (file.bad()) {
+        return Status{ErrorCodes::FileStreamFailed,
+                      str::stream() << "Could not read zstd dictionary file: " << path};
+    }
+    return make(path, ConstDataRange(contents.data(), contents.size()));
+}
+
+StatusWith<std::shared_ptr<ZstdDictionary>> ZstdDictionary::train(
+    std::string source, const std::vector<ConstDataRange>& samples, size_t maxSize) {
+    std::string sampleBuffer;
+    std::vector<size_t> sampleSizes;
+    sampleSizes.reserve(samples.size());
+    for (auto&& sample : samples) {
+        sampleBuffer.append(sample.data(), sample.length());
+        sampleSizes.push_back(sample.length());
+    }
+
+    std::string dictionary(maxSize, '\0');
+    size_t ret = ZDICT_trainFromBuffer(&dictionary[0],
+                                       dictionary.size(),
+                                       sampleBuffer.data(),
+                                       sampleSizes.data(),
+                                       sampleSizes.size());
+    if (ZDICT_isError(ret)) {
+        return Status{ErrorCodes::BadValue,
+                      str::stream() << "Could not train zstd dictionary: "
+                                    << ZDICT_getErrorName(ret)};
+    }
+    return make(std::move(source), ConstDataRange(dictionary.data(), ret));
+}
+
+void ZstdDictionary::appendStats(BSONObjBuilder* builder) const {
+    builder->append("source", _source);
+
+    BSONObjBuilder compressor(builder->subobjStart("compressor"));
+    compressor.append("bytesIn", _compressBytesIn.loadRelaxed());
+    compressor.append("bytesOut", _compressBytesOut.loadRelaxed());
+    compressor.append("micros", _compressMicros.loadRelaxed());
+    compressor.doneFast();
+
+    BSONObjBuilder decompressor(builder->subobjStart("decompressor"));
+    decompressor.append("bytesIn", _decompressBytesIn.loadRelaxed());
+    decompressor.append("bytesOut", _decompressBytesOut.loadRelaxed());
+    decompressor.append("micros", _decompressMicros.loadRelaxed());
+    decompressor.doneFast();
+}
 
 ZstdMessageCompressor::ZstdMessageCompressor() : MessageCompressorBase(MessageCompressor::kZstd) {}
 
@@ -63,8 +235,138 @@ StatusWith<std::size_t> ZstdMessageCompressor::compressData(ConstDataRange input
     return {ret};
 }
 
+StatusWith<std::size_t> ZstdMessageCompressor::compressDataWithDictionary(
+    ConstDataRange input, DataRange output, ZstdDictionary* dictionary) {
+    Timer timer;
+    auto cctx = compressionContexts().acquire();
+    if (!cctx) {
+        return Status{ErrorCodes::ExceededMemoryLimit,
+                      "Could not compress input: failed to create a zstd context"};
+    }
+    size_t ret = ZSTD_compress_usingCDict(cctx.get(),
+                                          const_cast<char*>(output.data()),
+                                          output.length(),
+                                          input.data(),
+                                          input.length(),
+                                          dictionary->_cdict);
+
+    if (ZSTD_isError(ret)) {
+        return Status{ErrorCodes::BadValue,
+                      str::stream() << "Could not compress input: " << ZSTD_getErrorName(ret)};
+    }
+    counterHitCompress(input.length(), ret);
+    dictionary->_compressBytesIn.addAndFetch(input.length());
+    dictionary->_compressBytesOut.addAndFetch(ret);
+    dictionary->_compressMicros.addAndFetch(timer.micros());
+    return {ret};
+}
+
+StatusWith<std::size_t> ZstdMessageCompressor::compressDataStreaming(ConstDataRange input,
+                                                                     SharedBuffer* output,
+                                                                     std::size_t offset) {
+    return _compressStreaming(input, output, offset, nullptr);
+}
+
+StatusWith<std::size_t> ZstdMessageCompressor::compressDataStreamingWithDictionary(
+    ConstDataRange input, SharedBuffer* output, std::size_t offset, ZstdDictionary* dictionary) {
+    return _compressStreaming(input, output, offset, dictionary);
+}
+
+StatusWith<std::size_t> ZstdMessageCompressor::_compressStreaming(ConstDataRange input,
+                                                                  SharedBuffer* output,
+                                                                  std::size_t offset,
+                                                                  ZstdDictionary* dictionary) {
+    Timer timer;
+    // Only messages of MessageCompressorManager::kStreamingCompressionThresholdBytes or more are
+    // compressed here, and a context's buffers grow to fit the largest message it has seen: about
+    // 2.5MB for a 1MB message and 3.5MB for a 16MB one. The pool would not keep such a context, so
+    // use one of our own. Creating it costs little next to compressing a megabyte.
+    std::unique_ptr<ZSTD_CCtx, decltype(&ZSTD_freeCCtx)> ownedCctx(ZSTD_createCCtx(),
+                                                                   &ZSTD_freeCCtx);
+    auto cctx = ownedCctx.get();
+    if (!cctx) {
+        return Status{ErrorCodes::ExceededMemoryLimit,
+                      "Could not compress input: failed to create a zstd context"};
+    }
+
+    size_t ret = dictionary
+        ? ZSTD_CCtx_refCDict(cctx, dictionary->_cdict)
+        : ZSTD_CCtx_setParameter(cctx, ZSTD_c_compressionLevel, ZSTD_CLEVEL_DEFAULT);
+    if (!ZSTD_isError(ret)) {
+        // Records the content size in the frame header, as ZSTD_compress does.
+        ret = ZSTD_CCtx_setPledgedSrcSize(cctx, input.length());
+    }
+
+    ZSTD_inBuffer in{input.data(), input.length(), 0};
+    std::size_t written = 0;
+    std::size_t space = output->capacity() - offset;
+    while (!ZSTD_isError(ret)) {
+        if (written == space) {
+            const auto grown = growStreamingOutput(output, offset, input.length());
+            if (grown == space) {
+                return Status{ErrorCodes::BadValue,
+                              "Could not compress input: output exceeded the maximum size"};
+            }
+            space = grown;
+        }
+
+        ZSTD_outBuffer out{output->get() + offset, space, written};
+        ret = ZSTD_compressStream2(cctx, &out, &in, ZSTD_e_end);
+        written = out.pos;
+        if (ret == 0) {
+            break;
+        }
+    }
+
+    if (ZSTD_isError(ret)) {
+        return Status{ErrorCodes::BadValue,
+                      str::stream() << "Could not compress input: " << ZSTD_getErrorName(ret)};
+    }
+    counterHitCompress(input.length(), written);
+    if (dictionary) {
+        dictionary->_compressBytesIn.addAndFetch(input.length());
+        dictionary->_compressBytesOut.addAndFetch(written);
+        dictionary->_compressMicros.addAndFetch(timer.micros());
+    }
+    return {written};
+}
+
 StatusWith<std::size_t> ZstdMessageCompressor::decompressData(ConstDataRange input,
                                                               DataRange output) {
+    const auto dictionaryId = ZSTD_getDictID_fromFrame(input.data(), input.length());
+    if (dictionaryId != 0) {
+        auto dictionary = getDictionary(dictionaryId);
+        if (!dictionary) {
+            return Status{ErrorCodes::BadValue,
+                          str::stream() << "Could not decompress message: unknown zstd dictionary "
+                                        << dictionaryId};
+        }
+
+        Timer timer;
+        auto dctx = decompressionContexts().acquire();
+        if (!dctx) {
+            return Status{ErrorCodes::ExceededMemoryLimit,
+                          "Could not decompress message: failed to create a zstd context"};
+        }
+        size_t ret = ZSTD_decompress_usingDDict(dctx.get(),
+                                                const_cast<char*>(output.data()),
+                                                output.length(),
+                                                input.data(),
+                                                input.length(),
+                                                dictionary->_ddict);
+        if (ZSTD_isError(ret)) {
+            return Status{ErrorCodes::BadValue,
+                          str::stream()
+                              << "Could not decompress message: " << ZSTD_getErrorName(ret)};
+        }
+
+        counterHitDecompress(input.length(), ret);
+        dictionary->_decompressBytesIn.addAndFetch(input.length());
+        dictionary->_decompressBytesOut.addAndFetch(ret);
+        dictionary->_decompressMicros.addAndFetch(timer.micros());
+        return {ret};
+    }
+
     size_t ret = ZSTD_decompress(
         const_cast<char*>(output.data()), output.length(), input.data(), input.length());
 
@@ -77,13 +379,82 @@ StatusWith<std::size_t> ZstdMessageCompressor::decompressData(ConstDataRange inp
     return {ret};
 }
 
+Status ZstdMessageCompressor::addDictionary(std::shared_ptr<ZstdDictionary> dictionary) {
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& existing : _dictionaries) {
+        if (existing->getId() == dictionary->getId()) {
+            return {ErrorCodes::BadValue,
+                    str::stream() << "zstd dictionaries " << existing->getSource() << " and "
+                                  << dictionary->getSource() << " have the same ID "
+                                  << dictionary->getId()};
+        }
+    }
+    _dictionaries.push_back(std::move(dictionary));
+    return Status::OK();
+}
+
+std::shared_ptr<ZstdDictionary> ZstdMessageCompressor::getDictionary(uint32_t id) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& dictionary : _dictionaries) {
+        if (dictionary->getId() == id) {
+            return dictionary;
+        }
+    }
+    return nullptr;
+}
+
+std::vector<uint32_t> ZstdMessageCompressor::getDictionaryIds() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    std::vector<uint32_t> ids;
+    for (auto&& dictionary : _dictionaries) {
+        ids.push_back(dictionary->getId());
+    }
+    return ids;
+}
+
+void ZstdMessageCompressor::appendDictionaryStats(BSONObjBuilder* builder) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+    for (auto&& dictionary : _dictionaries) {
+        BSONObjBuilder sub(builder->subobjStart(std::to_string(dictionary->getId())));
+        dictionary->appendStats(&sub);
+        sub.doneFast();
+    }
+}
+
+Status storeMessageCompressionDictionaryOptions(const std::string& zstdDictionaryFiles) {
+    std::vector<std::string> paths;
+    boost::algorithm::split(paths, zstdDictionaryFiles, boost::is_any_of(","));
+
+    for (auto&& path : paths) {
+        if (path.empty()) {
+            continue;
+        }
+        auto swDictionary = ZstdDictionary::load(path);
+        if (!swDictionary.isOK()) {
+            return swDictionary.getStatus();
+        }
+        dictionariesFromOptions.push_back(std::move(swDictionary.getValue()));
+    }
+    return Status::OK();
+}
 
 MONGO_INITIALIZER_GENERAL(ZstdMessageCompressorInit,
                           ("EndStartupOptionHandling"),
                           ("AllCompressorsRegistered"))
 (InitializerContext* context) {
+    auto compressor = std::make_unique<ZstdMessageCompressor>();
+    for (auto&& dictionary : dictionariesFromOptions) {
+        log() << "Loaded zstd network compression dictionary " << dictionary->getId() << " from "
+              << dictionary->getSource();
+        auto status = compressor->addDictionary(std::move(dictionary));
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+    dictionariesFromOptions.clear();
+
     auto& compressorRegistry = MessageCompressorRegistry::get();
-    compressorRegistry.registerImplementation(std::make_unique<ZstdMessageCompressor>());
+    compressorRegistry.registerImplementation(std::move(compressor));
     return Status::OK();
 }
 }  // namespace mongo
@@ -27,9 +27,89 @@
  *    it in the license file.
  */
 
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/platform/mutex.h"
 #include "mongo/transport/message_compressor_base.h"
 
+struct ZSTD_CDict_s;
+struct ZSTD_DDict_s;
+
 namespace mongo {
+
+class BSONObjBuilder;
+
+/*
+ * A trained zstd dictionary that both ends of a connection have loaded. Compressing small,
+ * similar messages (e.g. replies to point reads on one collection) against a dictionary trained on
+ * such messages does much better than compressing each one on its own.
+ *
+ * Dictionaries are identified by the ID zstd stores in them. zstd also writes that ID into the
+ * header of every frame compressed with the dictionary, which is how the receiving side knows
+ * which one to decompress with.
+ */
+class ZstdDictionary {
+    ZstdDictionary(const ZstdDictionary&) = delete;
+    ZstdDictionary& operator=(const ZstdDictionary&) = delete;
+
+public:
+    /*
+     * Loads a dictionary in the format produced by "zstd --train" or train(). 'source' describes
+     * where it came from, for diagnostics. Raw content dictionaries are rejected, as they carry no
+     * ID.
+     */
+    static StatusWith<std::shared_ptr<ZstdDictionary>> make(std::string source,
+                                                            ConstDataRange data);
+
+    /*
+     * Reads a dictionary from a file.
+     */
+    static StatusWith<std::shared_ptr<ZstdDictionary>> load(const std::string& path);
+
+    /*
+     * Trains a dictionary of at most 'maxSize' bytes from sample messages.
+     */
+    static StatusWith<std::shared_ptr<ZstdDictionary>> train(
+        std::string source, const std::vector<ConstDataRange>& samples, size_t maxSize);
+
+    ~ZstdDictionary();
+
+    uint32_t getId() const {
+        return _id;
+    }
+
+    const std::string& getSource() const {
+        return _source;
+    }
+
+    /*
+     * Appends the compression ratio and time spent (de)compressing with this dictionary.
+     */
+    void appendStats(BSONObjBuilder* builder) const;
+
+private:
+    friend class ZstdMessageCompressor;
+
+    ZstdDictionary(std::string source, uint32_t id, ZSTD_CDict_s* cdict, ZSTD_DDict_s* ddict);
+
+    const std::string _source;
+    const uint32_t _id;
+    ZSTD_CDict_s* const _cdict;
+    ZSTD_DDict_s* const _ddict;
+
+    AtomicWord<long long> _compressBytesIn;
+    AtomicWord<long long> _compressBytesOut;
+    AtomicWord<long long> _compressMicros;
+
+    AtomicWord<long long> _decompressBytesIn;
+    AtomicWord<long long> _decompressBytesOut;
+    AtomicWord<long long> _decompressMicros;
+};
+
 class ZstdMessageCompressor final : public MessageCompressorBase {
 public:
     ZstdMessageCompressor();
@@ -38,8 +118,64 @@ public:
 
     StatusWith<std::size_t> compressData(ConstDataRange input, DataRange output) override;
 
+    StatusWith<std::size_t> compressDataStreaming(ConstDataRange input,
+                                                  SharedBuffer* output,
+                                                  std::size_t offset) override;
+
+    /*
+     * Decompresses a zstd frame, using whichever of this compressor's dictionaries the frame was
+     * compressed with, if any.
+     */
     StatusWith<std::size_t> decompressData(ConstDataRange input, DataRange output) override;
-};
 
+    /*
+     * Like compressData, but compresses against 'dictionary', which the peer must also have.
+     */
+    StatusWith<std::size_t> compressDataWithDictionary(ConstDataRange input,
+                                                       DataRange output,
+                                                       ZstdDictionary* dictionary);
+
+    /*
+     * Like compressDataStreaming, but compresses against 'dictionary'.
+     */
+    StatusWith<std::size_t> compressDataStreamingWithDictionary(ConstDataRange input,
+                                                                SharedBuffer* output,
+                                                                std::size_t offset,
+                                                                ZstdDictionary* dictionary);
+
+    /*
+     * Makes a dictionary available for negotiation and decompression. Dictionaries are offered to
+     * peers in the order they were added. It is an error to add two dictionaries with the same ID.
+     */
+    Status addDictionary(std::shared_ptr<ZstdDictionary> dictionary);
+
+    /*
+     * Returns the dictionary with the given ID, or nullptr.
+     */
+    std::shared_ptr<ZstdDictionary> getDictionary(uint32_t id) const;
+
+    /*
+     * Returns the IDs of all dictionaries, in the order they were added.
+     */
+    std::vector<uint32_t> getDictionaryIds() const;
+
+    /*
+     * Appends ZstdDictionary::appendStats for each dictionary, keyed by dictionary ID.
+     */
+    void appendDictionaryStats(BSONObjBuilder* builder) const;
+
+private:
+    /*
+     * Feeds 'input' through this thread's compression context, growing 'output' whenever zstd
+     * fills it. 'dictionary' may be null.
+     */
+    StatusWith<std::size_t> _compressStreaming(ConstDataRange input,
+                                               SharedBuffer* output,
+                                               std::size_t offset,
+                                               ZstdDictionary* dictionary);
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("ZstdMessageCompressor::_mutex");
+    std::vector<std::shared_ptr<ZstdDictionary>> _dictionaries;
+};
 
 }  // namespace mongo
@@ -83,6 +83,31 @@ public:
      */
     virtual Status schedule(Task task, ScheduleFlags flags, ServiceExecutorTaskName taskName) = 0;
 
+    /*
+     * Identifies one of the worker threads of an executor that keeps work local to its threads.
+     * kAnyWorker expresses no preference.
+     */
+    using WorkerId = int;
+    static constexpr WorkerId kAnyWorker = -1;
+
+    /*
+     * Schedules a task like schedule(), preferring to run it on the given worker. Executors that
+     * don't keep work local to their threads ignore the preference.
+     */
+    virtual Status scheduleOnWorker(Task task,
+                                    ScheduleFlags flags,
+                                    ServiceExecutorTaskName taskName,
+                                    WorkerId worker) {
+        return schedule(std::move(task), flags, taskName);
+    }
+
+    /*
+     * Returns the worker that the calling thread belongs to, or kAnyWorker.
+     */
+    virtual WorkerId currentWorker() const {
+        return kAnyWorker;
+    }
+
     /*
      * Stops and joins the ServiceExecutor. Any outstanding tasks will not be executed, and any
      * associated callbacks waiting on I/O may get called with an error code.
@@ -0,0 +1,190 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#include "mongo/platform/basic.h"
+
+#include <benchmark/benchmark.h>
+#include <vector>
+
+#include "mongo/db/service_context.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/transport/service_executor_adaptive.h"
+#include "mongo/transport/service_executor_task_names.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
+#include "mongo/transport/transport_layer_asio.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+// Each simulated request touches 4KB of per-session state, roughly what the networking and
+// command dispatch paths touch for a small command, and each session runs this many requests.
+constexpr size_t kWorkingSetWords = 512;
+constexpr size_t kRequestsPerSession = 64;
+
+/**
+ * Drives a number of simulated sessions through an executor the way the ServiceStateMachine
+ * does: run a request on a worker, hand the "network I/O" to the reactor, then schedule the
+ * next request from the reactor's completion handler with a hint for the worker that ran the
+ * previous one.
+ */
+class SessionHarness {
+public:
+    SessionHarness(ServiceExecutor* executor, ReactorHandle reactor, size_t numSessions)
+        : _executor(executor), _reactor(std::move(reactor)), _sessions(numSessions) {
+        for (auto& session : _sessions) {
+            session.workingSet.resize(kWorkingSetWords, 1);
+        }
+    }
+
+    /**
+     * Runs every session to completion and returns the number of times a session's request
+     * ran on a different worker than its previous one.
+     */
+    int64_t runRound() {
+        _migrations.store(0);
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _outstanding = _sessions.size();
+        }
+
+        for (auto& session : _sessions) {
+            session.remaining = kRequestsPerSession;
+            session.lastWorker = ServiceExecutor::kAnyWorker;
+            invariant(_executor->schedule([this, s = &session] { _runRequest(s); },
+                                          ServiceExecutor::kEmptyFlags,
+                                          ServiceExecutorTaskName::kSSMStartSession));
+        }
+
+        stdx::unique_lock<Latch> lk(_mutex);
+        _cond.wait(lk, [&] { return _outstanding == 0; });
+        return _migrations.load();
+    }
+
+private:
+    struct Session {
+        std::vector<uint64_t> workingSet;
+        size_t remaining = 0;
+        ServiceExecutor::WorkerId lastWorker = ServiceExecutor::kAnyWorker;
+    };
+
+    void _runRequest(Session* session) {
+        const auto worker = _executor->currentWorker();
+        if (session->lastWorker != ServiceExecutor::kAnyWorker && session->lastWorker != worker) {
+            _migrations.fetchAndAdd(1);
+        }
+        session->lastWorker = worker;
+
+        uint64_t acc = 0;
+        for (auto& word : session->workingSet) {
+            word = word * 31 + acc;
+            acc += word;
+        }
+        benchmark::DoNotOptimize(acc);
+
+        if (--session->remaining == 0) {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (--_outstanding == 0) {
+                _cond.notify_all();
+            }
+            return;
+        }
+
+        _reactor->schedule([this, session](Status status) {
+            invariant(status);
+            invariant(_executor->scheduleOnWorker([this, session] { _runRequest(session); },
+                                                  ServiceExecutor::kMayRecurse,
+                                                  ServiceExecutorTaskName::kSSMProcessMessage,
+                                                  session->lastWorker));
+        });
+    }
+
+    ServiceExecutor* const _executor;
+    const ReactorHandle _reactor;
+    std::vector<Session> _sessions;
+
+    AtomicWord<int64_t> _migrations{0};
+    Mutex _mutex = MONGO_MAKE_LATCH("SessionHarness::_mutex");
+    stdx::condition_variable _cond;
+    size_t _outstanding = 0;
+};
+
+ReactorHandle makeReactor() {
+    // Only used as a reactor factory, and never torn down.
+    static auto tl = [] {
+        TransportLayerASIO::Options opts;
+        opts.mode = TransportLayerASIO::Options::kEgress;
+        return new TransportLayerASIO(opts, nullptr);
+    }();
+    return tl->getReactor(TransportLayer::kNewReactor);
+}
+
+ServiceContext* getServiceContext() {
+    if (!hasGlobalServiceContext()) {
+        setGlobalServiceContext(ServiceContext::make());
+    }
+    return getGlobalServiceContext();
+}
+
+template <typename Executor>
+void runSessions(benchmark::State& state) {
+    auto reactor = makeReactor();
+    Executor executor(getServiceContext(), reactor);
+    invariant(executor.start());
+
+    SessionHarness harness(&executor, reactor, state.range(0));
+    int64_t migrations = 0;
+    for (auto _ : state) {
+        migrations += harness.runRound();
+    }
+
+    invariant(executor.shutdown(Seconds{10}));
+
+    const auto requests = state.iterations() * state.range(0) * kRequestsPerSession;
+    state.SetItemsProcessed(requests);
+    state.counters["migrationRate"] = static_cast<double>(migrations) / requests;
+}
+
+void BM_AdaptiveExecutor(benchmark::State& state) {
+    runSessions<ServiceExecutorAdaptive>(state);
+}
+
+void BM_ThreadPerCoreExecutor(benchmark::State& state) {
+    runSessions<ServiceExecutorThreadPerCore>(state);
+}
+
+// The synchronous executor runs every session on its own dedicated thread, so it has no
+// equivalent of a shared reactor completing I/O for it and is left out of the comparison.
+BENCHMARK(BM_AdaptiveExecutor)->RangeMultiplier(4)->Range(16, 1024)->UseRealTime();
+BENCHMARK(BM_ThreadPerCoreExecutor)->RangeMultiplier(4)->Range(16, 1024)->UseRealTime();
+
+}  // namespace
+}  // namespace transport
+}  // namespace mongo
@@ -36,6 +36,7 @@
 #include "mongo/db/service_context.h"
 #include "mongo/transport/service_executor_adaptive.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
 #include "mongo/transport/service_executor_task_names.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/log.h"
@@ -176,6 +177,46 @@ protected:
     std::unique_ptr<ServiceExecutorSynchronous> executor;
 };
 
+class ServiceExecutorThreadPerCoreFixture : public unittest::Test {
+protected:
+    void setUp() override {
+        auto scOwned = ServiceContext::make();
+        setGlobalServiceContext(std::move(scOwned));
+
+        ServiceExecutorThreadPerCore::Options options;
+        options.numWorkers = 4;
+        // Long enough that idle workers don't go looking for work on their own during a test.
+        options.stuckThreadTimeout = Seconds{10};
+        makeExecutor(options);
+    }
+
+    void makeExecutor(ServiceExecutorThreadPerCore::Options options) {
+        executor = std::make_unique<ServiceExecutorThreadPerCore>(
+            getGlobalServiceContext(), std::make_shared<ASIOReactor>(), options);
+    }
+
+    Status startAndWaitForIdleWorkers() {
+        auto status = executor->start();
+        if (!status.isOK()) {
+            return status;
+        }
+        // Wait for every worker to park so that tasks go to the worker they are scheduled on.
+        const auto workers = stats()["workers"].numberInt();
+        while (stats()["idleWorkers"].numberInt() < workers) {
+            sleepFor(Milliseconds{1});
+        }
+        return Status::OK();
+    }
+
+    BSONObj stats() const {
+        BSONObjBuilder bob;
+        executor->appendStats(&bob);
+        return bob.obj();
+    }
+
+    std::unique_ptr<ServiceExecutorThreadPerCore> executor;
+};
+
 void scheduleBasicTask(ServiceExecutor* exec, bool expectSuccess) {
     stdx::condition_variable cond;
     auto mutex = MONGO_MAKE_LATCH();
@@ -217,6 +258,223 @@ TEST_F(ServiceExecutorSynchronousFixture, ScheduleFailsBeforeStartup) {
     scheduleBasicTask(executor.get(), false);
 }
 
+TEST_F(ServiceExecutorThreadPerCoreFixture, BasicTaskRuns) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    scheduleBasicTask(executor.get(), true);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, ScheduleFailsBeforeStartup) {
+    scheduleBasicTask(executor.get(), false);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, ContinuationsRunOnRequestedWorker) {
+    ASSERT_OK(startAndWaitForIdleWorkers());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    ASSERT_EQ(executor->currentWorker(), ServiceExecutor::kAnyWorker);
+
+    // Hop between workers the way a session's continuations would, with each step asking to
+    // resume on the worker that ran the previous one.
+    auto mutex = MONGO_MAKE_LATCH();
+    stdx::condition_variable cond;
+    std::vector<ServiceExecutor::WorkerId> ranOn;
+    std::function<void(ServiceExecutor::WorkerId)> step = [&](ServiceExecutor::WorkerId target) {
+        ASSERT_OK(executor->scheduleOnWorker(
+            [&, target] {
+                stdx::lock_guard<Latch> lk(mutex);
+                ranOn.push_back(executor->currentWorker());
+                if (ranOn.size() < 8) {
+                    step((target + 1) % 4);
+                }
+                cond.notify_all();
+            },
+            ServiceExecutor::kEmptyFlags,
+            ServiceExecutorTaskName::kSSMProcessMessage,
+            target));
+    };
+
+    stdx::unique_lock<Latch> lk(mutex);
+    step(2);
+    cond.wait(lk, [&] { return ranOn.size() == 8; });
+
+    for (size_t i = 0; i < ranOn.size(); ++i) {
+        ASSERT_EQ(ranOn[i], static_cast<ServiceExecutor::WorkerId>((2 + i) % 4));
+    }
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, RecursiveTasksRunInline) {
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    auto mutex = MONGO_MAKE_LATCH();
+    stdx::condition_variable cond;
+    bool ranInline = false;
+    bool done = false;
+    ASSERT_OK(executor->schedule(
+        [&] {
+            bool ran = false;
+            ASSERT_OK(executor->schedule([&] { ran = true; },
+                                         ServiceExecutor::kMayRecurse,
+                                         ServiceExecutorTaskName::kSSMProcessMessage));
+            stdx::lock_guard<Latch> lk(mutex);
+            ranInline = ran;
+            done = true;
+            cond.notify_all();
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMStartSession));
+
+    stdx::unique_lock<Latch> lk(mutex);
+    cond.wait(lk, [&] { return done; });
+    ASSERT_TRUE(ranInline);
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, IdleWorkersStealFromBusyWorker) {
+    ASSERT_OK(startAndWaitForIdleWorkers());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    auto mutex = MONGO_MAKE_LATCH();
+    stdx::condition_variable cond;
+    bool blockerStarted = false;
+    bool releaseBlocker = false;
+    std::vector<ServiceExecutor::WorkerId> ranOn;
+
+    ASSERT_OK(executor->scheduleOnWorker(
+        [&] {
+            stdx::unique_lock<Latch> lk(mutex);
+            blockerStarted = true;
+            cond.notify_all();
+            cond.wait(lk, [&] { return releaseBlocker; });
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMProcessMessage,
+        0));
+
+    {
+        stdx::unique_lock<Latch> lk(mutex);
+        cond.wait(lk, [&] { return blockerStarted; });
+    }
+
+    // Worker 0 is busy, so the tasks pinned to it get picked up by the idle workers.
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_OK(executor->scheduleOnWorker(
+            [&] {
+                stdx::lock_guard<Latch> lk(mutex);
+                ranOn.push_back(executor->currentWorker());
+                cond.notify_all();
+            },
+            ServiceExecutor::kEmptyFlags,
+            ServiceExecutorTaskName::kSSMProcessMessage,
+            0));
+    }
+
+    stdx::unique_lock<Latch> lk(mutex);
+    cond.wait(lk, [&] { return ranOn.size() == 3; });
+    for (auto worker : ranOn) {
+        ASSERT_NE(worker, 0);
+    }
+    ASSERT_EQ(stats()["totalStolen"].numberLong(), 3);
+
+    releaseBlocker = true;
+    cond.notify_all();
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, TaskQueuedAsWorkerGoesIdleIsStolen) {
+    ServiceExecutorThreadPerCore::Options options;
+    options.numWorkers = 2;
+    options.stuckThreadTimeout = Seconds{10};
+    makeExecutor(options);
+    ASSERT_OK(startAndWaitForIdleWorkers());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    auto mutex = MONGO_MAKE_LATCH();
+    stdx::condition_variable cond;
+    bool blockerStarted = false;
+    bool releaseBlocker = false;
+    int stolen = 0;
+
+    ASSERT_OK(executor->scheduleOnWorker(
+        [&] {
+            stdx::unique_lock<Latch> lk(mutex);
+            blockerStarted = true;
+            cond.notify_all();
+            cond.wait(lk, [&] { return releaseBlocker; });
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMProcessMessage,
+        0));
+    {
+        stdx::unique_lock<Latch> lk(mutex);
+        cond.wait(lk, [&] { return blockerStarted; });
+    }
+
+    // Race each task queued on the busy worker 0 against worker 1 finishing a task and going back
+    // to sleep. Worker 1 must always pick it up well before it would look for work on its own.
+    for (int i = 1; i <= 500; ++i) {
+        ASSERT_OK(executor->scheduleOnWorker([] {},
+                                             ServiceExecutor::kEmptyFlags,
+                                             ServiceExecutorTaskName::kSSMProcessMessage,
+                                             1));
+        ASSERT_OK(executor->scheduleOnWorker(
+            [&] {
+                stdx::lock_guard<Latch> lk(mutex);
+                ++stolen;
+                cond.notify_all();
+            },
+            ServiceExecutor::kEmptyFlags,
+            ServiceExecutorTaskName::kSSMProcessMessage,
+            0));
+
+        stdx::unique_lock<Latch> lk(mutex);
+        ASSERT_TRUE(cond.wait_for(lk, Seconds{5}.toSystemDuration(), [&] { return stolen == i; }));
+    }
+
+    stdx::lock_guard<Latch> lk(mutex);
+    releaseBlocker = true;
+    cond.notify_all();
+}
+
+TEST_F(ServiceExecutorThreadPerCoreFixture, StuckWorkersStartOverflowThread) {
+    ServiceExecutorThreadPerCore::Options options;
+    options.numWorkers = 1;
+    options.stuckThreadTimeout = Milliseconds{20};
+    makeExecutor(options);
+
+    ASSERT_OK(executor->start());
+    auto guard = makeGuard([this] { ASSERT_OK(executor->shutdown(kShutdownTime)); });
+
+    // The only worker blocks until a task queued behind it has run, which can only happen on an
+    // overflow thread.
+    auto mutex = MONGO_MAKE_LATCH();
+    stdx::condition_variable cond;
+    bool unblocked = false;
+    bool done = false;
+
+    ASSERT_OK(executor->schedule(
+        [&] {
+            ASSERT_OK(executor->schedule(
+                [&] {
+                    stdx::lock_guard<Latch> lk(mutex);
+                    unblocked = true;
+                    cond.notify_all();
+                },
+                ServiceExecutor::kEmptyFlags,
+                ServiceExecutorTaskName::kSSMProcessMessage));
+
+            stdx::unique_lock<Latch> lk(mutex);
+            cond.wait(lk, [&] { return unblocked; });
+            done = true;
+            cond.notify_all();
+        },
+        ServiceExecutor::kEmptyFlags,
+        ServiceExecutorTaskName::kSSMStartSession));
+
+    stdx::unique_lock<Latch> lk(mutex);
+    cond.wait(lk, [&] { return done; });
+    ASSERT_GTE(stats()["overflowThreadsStarted"].numberLong(), 1);
+}
 
 }  // namespace
 }  // namespace mongo
@@ -0,0 +1,471 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kExecutor
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/service_executor_thread_per_core.h"
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "mongo/transport/service_entry_point_utils.h"
+#include "mongo/transport/service_executor_gen.h"
+#include "mongo/util/concurrency/thread_name.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/processinfo.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+constexpr auto kThreadsRunning = "threadsRunning"_sd;
+constexpr auto kThreadsInUse = "threadsInUse"_sd;
+constexpr auto kIdleWorkers = "idleWorkers"_sd;
+constexpr auto kExecutorLabel = "executor"_sd;
+constexpr auto kExecutorName = "threadPerCore"_sd;
+constexpr auto kWorkers = "workers"_sd;
+constexpr auto kOverflowThreadsRunning = "overflowThreadsRunning"_sd;
+constexpr auto kOverflowThreadsStarted = "overflowThreadsStarted"_sd;
+constexpr auto kTotalQueued = "totalQueued"_sd;
+constexpr auto kTotalExecuted = "totalExecuted"_sd;
+constexpr auto kTotalStolen = "totalStolen"_sd;
+
+// How long the networking thread runs the reactor before checking whether it should exit.
+constexpr Milliseconds kReactorRunTime{1000};
+
+ServiceExecutorThreadPerCore::Options optionsFromServerParameters() {
+    ServiceExecutorThreadPerCore::Options options;
+    const auto workers = threadPerCoreServiceExecutorWorkers;
+    options.numWorkers = workers > 0 ? static_cast<size_t>(workers)
+                                     : static_cast<size_t>(ProcessInfo::getNumAvailableCores());
+    options.recursionLimit = threadPerCoreServiceExecutorRecursionLimit;
+    options.stuckThreadTimeout = Milliseconds{threadPerCoreServiceExecutorStuckThreadTimeoutMillis};
+    options.pinWorkers = threadPerCoreServiceExecutorPinWorkers;
+    return options;
+}
+
+#ifdef __linux__
+// Binds the calling thread to the 'n'th CPU (modulo their number) of the process' affinity mask.
+void pinToCpu(size_t n) {
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0 || CPU_COUNT(&allowed) == 0) {
+        return;
+    }
+
+    n %= CPU_COUNT(&allowed);
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed) && n-- == 0) {
+            cpu_set_t target;
+            CPU_ZERO(&target);
+            CPU_SET(cpu, &target);
+            if (int err = pthread_setaffinity_np(pthread_self(), sizeof(target), &target)) {
+                warning() << "Failed to pin service executor worker to CPU " << cpu << ": "
+                          << errnoWithDescription(err);
+            }
+            return;
+        }
+    }
+}
+#endif
+}  // namespace
+
+thread_local const ServiceExecutorThreadPerCore* ServiceExecutorThreadPerCore::_localExecutor =
+    nullptr;
+thread_local ServiceExecutorThreadPerCore::Worker* ServiceExecutorThreadPerCore::_localWorker =
+    nullptr;
+thread_local int ServiceExecutorThreadPerCore::_localRecursionDepth = 0;
+
+ServiceExecutorThreadPerCore::ServiceExecutorThreadPerCore(ServiceContext* ctx,
+                                                           ReactorHandle reactor)
+    : ServiceExecutorThreadPerCore(ctx, std::move(reactor), optionsFromServerParameters()) {}
+
+ServiceExecutorThreadPerCore::ServiceExecutorThreadPerCore(ServiceContext* ctx,
+                                                           ReactorHandle reactor,
+                                                           Options options)
+    : _reactorHandle(std::move(reactor)), _options(std::move(options)) {
+    invariant(_options.numWorkers > 0);
+    for (size_t i = 0; i < _options.numWorkers; ++i) {
+        _workers.push_back(std::make_unique<Worker>(static_cast<WorkerId>(i)));
+    }
+}
+
+ServiceExecutorThreadPerCore::~ServiceExecutorThreadPerCore() {
+    invariant(!_isRunning.load());
+}
+
+Status ServiceExecutorThreadPerCore::start() {
+    invariant(!_isRunning.load());
+    _isRunning.store(true);
+
+    for (auto& worker : _workers) {
+        auto status = _launchWorker([this, worker = worker.get()] { _workerRoutine(worker); });
+        if (!status.isOK()) {
+            return status;
+        }
+    }
+
+    _reactorThread = stdx::thread([this] { _reactorRoutine(); });
+    _controllerThread = stdx::thread([this] { _controllerRoutine(); });
+
+    return Status::OK();
+}
+
+Status ServiceExecutorThreadPerCore::shutdown(Milliseconds timeout) {
+    if (!_isRunning.load())
+        return Status::OK();
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        _isRunning.store(false);
+    }
+
+    _controllerCondition.notify_one();
+    _controllerThread.join();
+
+    _reactorHandle->stop();
+    _reactorThread.join();
+
+    for (auto& worker : _workers) {
+        stdx::lock_guard<Latch> lk(worker->mutex);
+        worker->cv.notify_one();
+    }
+
+    stdx::unique_lock<Latch> lk(_mutex);
+    bool result = _deathCondition.wait_for(
+        lk, timeout.toSystemDuration(), [&] { return _threadsRunning.load() == 0; });
+
+    return result
+        ? Status::OK()
+        : Status(ErrorCodes::Error::ExceededTimeLimit,
+                 "thread per core executor couldn't shutdown all worker threads within time "
+                 "limit.");
+}
+
+bool ServiceExecutorThreadPerCore::_onWorkerThread() const {
+    return _localExecutor == this;
+}
+
+ServiceExecutor::WorkerId ServiceExecutorThreadPerCore::currentWorker() const {
+    return (_onWorkerThread() && _localWorker) ? _localWorker->id : kAnyWorker;
+}
+
+Status ServiceExecutorThreadPerCore::schedule(Task task,
+                                              ScheduleFlags flags,
+                                              ServiceExecutorTaskName taskName) {
+    return scheduleOnWorker(std::move(task), flags, taskName, kAnyWorker);
+}
+
+Status ServiceExecutorThreadPerCore::scheduleOnWorker(Task task,
+                                                      ScheduleFlags flags,
+                                                      ServiceExecutorTaskName taskName,
+                                                      WorkerId workerId) {
+    if (!_isRunning.load()) {
+        return {ErrorCodes::ShutdownInProgress, "Executor is not running"};
+    }
+
+    _totalQueued.addAndFetch(1);
+
+    // Continue on this very thread if the caller allows it, as long as the stack stays bounded.
+    // This never happens on the reactor thread, which must stay free to complete network I/O.
+    if (_onWorkerThread() && (flags & kMayRecurse) &&
+        _localRecursionDepth < _options.recursionLimit) {
+        ++_localRecursionDepth;
+        const auto guard = makeGuard([] { --_localRecursionDepth; });
+        task();
+        _totalExecuted.addAndFetch(1);
+        return Status::OK();
+    }
+
+    Worker* target;
+    if (workerId >= 0 && static_cast<size_t>(workerId) < _workers.size()) {
+        target = _workers[workerId].get();
+    } else if (_onWorkerThread() && _localWorker) {
+        target = _localWorker;
+    } else {
+        target = _workers[_nextWorker.fetchAndAdd(1) % _workers.size()].get();
+    }
+
+    _enqueue(target, std::move(task));
+    return Status::OK();
+}
+
+void ServiceExecutorThreadPerCore::_enqueue(Worker* worker, Task task) {
+    _tasksQueued.addAndFetch(1);
+
+    stdx::unique_lock<Latch> lk(worker->mutex);
+    worker->tasks.push_back(std::move(task));
+    if (worker->sleeping) {
+        worker->sleeping = false;
+        lk.unlock();
+        worker->cv.notify_one();
+        return;
+    }
+    lk.unlock();
+
+    // The target worker is busy. Rather than leaving the task queued behind whatever it is
+    // running, let an idle worker (if any) steal it. A worker queueing work for itself is about
+    // to return to its queue, so that case is left alone.
+    if (_idleWorkers.load() > 0 && !(_onWorkerThread() && _localWorker == worker)) {
+        _wakeIdleWorker(worker);
+    }
+}
+
+void ServiceExecutorThreadPerCore::_wakeIdleWorker(const Worker* except) {
+    for (auto& worker : _workers) {
+        if (worker.get() == except) {
+            continue;
+        }
+        stdx::unique_lock<Latch> lk(worker->mutex);
+        if (worker->sleeping) {
+            worker->sleeping = false;
+            lk.unlock();
+            worker->cv.notify_one();
+            return;
+        }
+    }
+}
+
+ServiceExecutor::Task ServiceExecutorThreadPerCore::_steal(const Worker* thief) {
+    // Start with the worker after the thief so that thieves spread out over their victims.
+    const size_t start = thief ? static_cast<size_t>(thief->id) + 1 : 0;
+    for (size_t i = 0; i < _workers.size(); ++i) {
+        auto& victim = _workers[(start + i) % _workers.size()];
+        if (victim.get() == thief) {
+            continue;
+        }
+
+        stdx::lock_guard<Latch> lk(victim->mutex);
+        if (victim->running && !victim->tasks.empty()) {
+            // Take the oldest task; the victim keeps the ones it queued most recently, which are
+            // the likeliest to still be in its cache.
+            auto task = std::move(victim->tasks.front());
+            victim->tasks.pop_front();
+            victim->stolen.addAndFetch(1);
+            return task;
+        }
+    }
+    return nullptr;
+}
+
+void ServiceExecutorThreadPerCore::_runTask(Task& task) {
+    _tasksQueued.subtractAndFetch(1);
+    _threadsInUse.addAndFetch(1);
+    _localRecursionDepth = 1;
+    task();
+    _localRecursionDepth = 0;
+    _threadsInUse.subtractAndFetch(1);
+    _totalExecuted.addAndFetch(1);
+}
+
+void ServiceExecutorThreadPerCore::_workerRoutine(Worker* worker) {
+    {
+        std::string threadName = str::stream() << "worker-" << worker->id;
+        setThreadName(threadName);
+    }
+    _localExecutor = this;
+    _localWorker = worker;
+
+#ifdef __linux__
+    if (_options.pinWorkers) {
+        pinToCpu(worker->id);
+    }
+#endif
+
+    // A task stolen on the way to sleep, which is run on the next pass.
+    Task task;
+    while (_isRunning.loadRelaxed()) {
+        if (!task) {
+            stdx::lock_guard<Latch> lk(worker->mutex);
+            if (!worker->tasks.empty()) {
+                task = std::move(worker->tasks.front());
+                worker->tasks.pop_front();
+                worker->running = true;
+            }
+        }
+
+        if (!task) {
+            task = _steal(worker);
+            if (task) {
+                stdx::lock_guard<Latch> lk(worker->mutex);
+                worker->running = true;
+            }
+        }
+
+        if (task) {
+            _runTask(task);
+            task = nullptr;
+            worker->executed.addAndFetch(1);
+            stdx::lock_guard<Latch> lk(worker->mutex);
+            worker->running = false;
+            continue;
+        }
+
+        {
+            stdx::lock_guard<Latch> lk(worker->mutex);
+            if (!worker->tasks.empty() || !_isRunning.loadRelaxed()) {
+                continue;
+            }
+            worker->sleeping = true;
+            _idleWorkers.addAndFetch(1);
+        }
+
+        // A task queued on a busy worker after the steal above, but before we counted ourselves
+        // idle, woke nobody. Look again now that anything queued from here on will wake us. This
+        // can't be done under our own mutex, since another thief may hold its own while taking
+        // ours.
+        task = _steal(worker);
+
+        stdx::unique_lock<Latch> lk(worker->mutex);
+        if (task) {
+            worker->running = true;
+        } else {
+            // Wake up periodically to look for work that was queued on busy workers without
+            // anyone being told to steal it.
+            worker->cv.wait_for(lk, _options.stuckThreadTimeout.toSystemDuration(), [&] {
+                return !worker->sleeping || !_isRunning.loadRelaxed();
+            });
+        }
+        worker->sleeping = false;
+        _idleWorkers.subtractAndFetch(1);
+    }
+
+    _localExecutor = nullptr;
+    _localWorker = nullptr;
+}
+
+void ServiceExecutorThreadPerCore::_overflowWorkerRoutine() {
+    {
+        std::string threadName = str::stream() << "worker-overflow-"
+                                               << _overflowThreadsStarted.load();
+        setThreadName(threadName);
+    }
+    _localExecutor = this;
+
+    log() << "Started overflow database worker thread";
+    _overflowThreadsRunning.addAndFetch(1);
+
+    while (_isRunning.loadRelaxed()) {
+        auto task = _steal(nullptr);
+        if (!task) {
+            break;
+        }
+        _runTask(task);
+    }
+
+    _overflowThreadsRunning.subtractAndFetch(1);
+    _localExecutor = nullptr;
+}
+
+void ServiceExecutorThreadPerCore::_reactorRoutine() {
+    setThreadName("ServiceExecutorReactor");
+
+    while (_isRunning.load()) {
+        _reactorHandle->runFor(kReactorRunTime);
+    }
+}
+
+void ServiceExecutorThreadPerCore::_controllerRoutine() {
+    setThreadName("worker-controller");
+
+    auto lastExecuted = _totalExecuted.load();
+    stdx::unique_lock<Latch> lk(_mutex);
+    while (_isRunning.load()) {
+        _controllerCondition.wait_for(lk, _options.stuckThreadTimeout.toSystemDuration(), [&] {
+            return !_isRunning.load();
+        });
+        if (!_isRunning.load()) {
+            break;
+        }
+
+        // The executor is stuck if tasks are waiting, every thread is running one, and none of
+        // them finished since the last check: most likely they are all blocked on something.
+        const auto executed = _totalExecuted.load();
+        const bool stuck = _tasksQueued.load() > 0 &&
+            _threadsInUse.load() >= _threadsRunning.load() && executed == lastExecuted;
+        lastExecuted = executed;
+        if (!stuck) {
+            continue;
+        }
+
+        _overflowThreadsStarted.addAndFetch(1);
+        lk.unlock();
+        auto status = _launchWorker([this] { _overflowWorkerRoutine(); });
+        if (!status.isOK()) {
+            warning() << "Failed to launch overflow worker thread: " << status;
+        }
+        lk.lock();
+    }
+}
+
+Status ServiceExecutorThreadPerCore::_launchWorker(std::function<void()> routine) {
+    _threadsRunning.addAndFetch(1);
+    auto status = launchServiceWorkerThread([this, routine = std::move(routine)] {
+        ON_BLOCK_EXIT([this] { _workerExited(); });
+        routine();
+    });
+    if (!status.isOK()) {
+        _workerExited();
+    }
+    return status;
+}
+
+void ServiceExecutorThreadPerCore::_workerExited() {
+    stdx::lock_guard<Latch> lk(_mutex);
+    if (_threadsRunning.subtractAndFetch(1) == 0) {
+        _deathCondition.notify_all();
+    }
+}
+
+void ServiceExecutorThreadPerCore::appendStats(BSONObjBuilder* bob) const {
+    int64_t totalStolen = 0;
+    for (auto& worker : _workers) {
+        totalStolen += worker->stolen.load();
+    }
+
+    *bob << kExecutorLabel << kExecutorName                            //
+         << kWorkers << static_cast<int>(_workers.size())              //
+         << kThreadsRunning << _threadsRunning.load()                  //
+         << kThreadsInUse << _threadsInUse.load()                      //
+         << kIdleWorkers << _idleWorkers.load()                        //
+         << kOverflowThreadsRunning << _overflowThreadsRunning.load()  //
+         << kOverflowThreadsStarted << _overflowThreadsStarted.load()  //
+         << kTotalQueued << _totalQueued.load()                        //
+         << kTotalExecuted << _totalExecuted.load()                    //
+         << kTotalStolen << totalStolen;
+}
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,163 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <deque>
+#include <memory>
+#include <vector>
+
+#include "mongo/base/status.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/service_executor.h"
+#include "mongo/transport/service_executor_task_names.h"
+#include "mongo/transport/transport_layer.h"
+
+namespace mongo {
+namespace transport {
+
+/**
+ * A ServiceExecutor that runs one worker thread per core on top of asynchronous networking.
+ *
+ * Each worker owns a local deque of tasks. Tasks scheduled from a worker stay on that worker, and
+ * continuations scheduled from elsewhere (typically the networking reactor completing a read)
+ * are routed to the worker named by scheduleOnWorker(), which ServiceStateMachine sets to the one
+ * that processed the session's previous message. That keeps a client's state warm in one core's
+ * caches and avoids the context switches of a thread per connection. A worker that runs out of
+ * local work steals the oldest task queued on another worker before going to sleep.
+ *
+ * A dedicated thread runs the networking reactor. Because database operations may block, a
+ * controller thread watches for the case where every worker is busy, tasks are queued and no
+ * task has finished for stuckThreadTimeout; it then starts an overflow worker which only steals
+ * work and exits once it finds none.
+ */
+class ServiceExecutorThreadPerCore final : public ServiceExecutor {
+public:
+    struct Options {
+        size_t numWorkers = 1;
+        int recursionLimit = 8;
+        Milliseconds stuckThreadTimeout{250};
+        bool pinWorkers = false;  // bind worker N to the Nth CPU the process may run on
+    };
+
+    /**
+     * Configures the executor from the threadPerCoreServiceExecutor* server parameters.
+     */
+    ServiceExecutorThreadPerCore(ServiceContext* ctx, ReactorHandle reactor);
+    ServiceExecutorThreadPerCore(ServiceContext* ctx, ReactorHandle reactor, Options options);
+
+    ~ServiceExecutorThreadPerCore();
+
+    Status start() override;
+    Status shutdown(Milliseconds timeout) override;
+    Status schedule(Task task, ScheduleFlags flags, ServiceExecutorTaskName taskName) override;
+    Status scheduleOnWorker(Task task,
+                            ScheduleFlags flags,
+                            ServiceExecutorTaskName taskName,
+                            WorkerId worker) override;
+    WorkerId currentWorker() const override;
+
+    Mode transportMode() const override {
+        return Mode::kAsynchronous;
+    }
+
+    void appendStats(BSONObjBuilder* bob) const override;
+
+    size_t numWorkers() const {
+        return _workers.size();
+    }
+
+private:
+    struct Worker {
+        explicit Worker(WorkerId id) : id(id) {}
+
+        const WorkerId id;
+
+        Mutex mutex = MONGO_MAKE_LATCH("ServiceExecutorThreadPerCore::Worker::mutex");
+        stdx::condition_variable cv;
+        std::deque<Task> tasks;
+        bool sleeping = false;
+        // Set while the worker runs a task. Only tasks queued behind a running one get stolen; a
+        // worker that is merely waking up will get to its queue soon enough.
+        bool running = false;
+
+        AtomicWord<int64_t> executed{0};
+        AtomicWord<int64_t> stolen{0};
+    };
+
+    // Worker state for the calling thread. Overflow workers have '_localWorker' set to nullptr.
+    static thread_local const ServiceExecutorThreadPerCore* _localExecutor;
+    static thread_local Worker* _localWorker;
+    static thread_local int _localRecursionDepth;
+
+    void _workerRoutine(Worker* worker);
+    void _overflowWorkerRoutine();
+    void _reactorRoutine();
+    void _controllerRoutine();
+
+    bool _onWorkerThread() const;
+    void _enqueue(Worker* worker, Task task);
+    Task _steal(const Worker* thief);
+    void _wakeIdleWorker(const Worker* except);
+    void _runTask(Task& task);
+
+    Status _launchWorker(std::function<void()> routine);
+    void _workerExited();
+
+    ReactorHandle _reactorHandle;
+    const Options _options;
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+    AtomicWord<unsigned> _nextWorker{0};
+
+    AtomicWord<bool> _isRunning{false};
+
+    stdx::thread _reactorThread;
+    stdx::thread _controllerThread;
+
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("ServiceExecutorThreadPerCore::_mutex");
+    stdx::condition_variable _controllerCondition;
+    stdx::condition_variable _deathCondition;
+
+    AtomicWord<int> _threadsRunning{0};
+    AtomicWord<int> _threadsInUse{0};
+    AtomicWord<int> _overflowThreadsRunning{0};
+    AtomicWord<int> _idleWorkers{0};
+    AtomicWord<int64_t> _tasksQueued{0};
+
+    AtomicWord<int64_t> _totalQueued{0};
+    AtomicWord<int64_t> _totalExecuted{0};
+    AtomicWord<int64_t> _overflowThreadsStarted{0};
+};
+
+}  // namespace transport
+}  // namespace mongo
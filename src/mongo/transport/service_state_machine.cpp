@@ -428,6 +428,8 @@ void ServiceStateMachine::_sinkCallback(Status status) {
 void ServiceStateMachine::_processMessage(ThreadGuard guard) {
     invariant(!_inMessage.empty());
 
+    _lastWorker = _serviceExecutor->currentWorker();
+
     TrafficRecorder::get(_serviceContext)
         .observe(_sessionHandle, _serviceContext->getPreciseClockSource()->now(), _inMessage);
 
@@ -448,7 +450,16 @@ void ServiceStateMachine::_processMessage(ThreadGuard guard) {
     auto opCtx = Client::getCurrent()->makeOperationContext();
     if (_inExhaust) {
         opCtx->markKillOnClientDisconnect();
+
+        // Each batch would otherwise allocate, and for getMore reserve, a full batch's worth of
+        // memory. The previous batch's buffer is only free if the transport layer let go of it.
+        // Nothing else is carried over: every batch is still parsed, authorized and dispatched as
+        // a getMore of its own, which pins and unpins the cursor.
+        if (_exhaustReplyBuffer && !_exhaustReplyBuffer.isShared()) {
+            opCtx->setReplyBuffer(std::move(_exhaustReplyBuffer));
+        }
     }
+    _exhaustReplyBuffer = {};
 
     // The handleRequest is implemented in a subclass for mongod/mongos and actually all the
     // database work for this request.
@@ -484,6 +495,9 @@ void ServiceStateMachine::_processMessage(ThreadGuard guard) {
         // stream should continue.
         _inMessage = makeExhaustMessage(_inMessage, &dbresponse);
         _inExhaust = !_inMessage.empty();
+        if (_inExhaust) {
+            _exhaustReplyBuffer = toSink.sharedBuffer();
+        }
 
         networkCounter.hitLogicalOut(toSink.size());
 
@@ -561,6 +575,7 @@ void ServiceStateMachine::start(Ownership ownershipModel) {
 
 void ServiceStateMachine::setServiceExecutor(ServiceExecutor* executor) {
     _serviceExecutor = executor;
+    _lastWorker = ServiceExecutor::kAnyWorker;
 }
 
 void ServiceStateMachine::_scheduleNextWithGuard(ThreadGuard guard,
@@ -574,7 +589,8 @@ void ServiceStateMachine::_scheduleNextWithGuard(ThreadGuard guard,
         ssm->_runNextInGuard(std::move(guard));
     };
     guard.release();
-    Status status = _serviceExecutor->schedule(std::move(func), flags, taskName);
+    Status status =
+        _serviceExecutor->scheduleOnWorker(std::move(func), flags, taskName, _lastWorker);
     if (status.isOK()) {
         return;
     }
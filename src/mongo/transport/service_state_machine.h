@@ -234,6 +234,9 @@ private:
     ServiceContext* const _serviceContext;
     transport::ServiceExecutor* _serviceExecutor;
 
+    // The executor worker that processed the last message, where follow-up tasks are scheduled.
+    transport::ServiceExecutor::WorkerId _lastWorker = transport::ServiceExecutor::kAnyWorker;
+
     transport::SessionHandle _sessionHandle;
     const std::string _threadName;
     ServiceContext::UniqueClient _dbClient;
@@ -241,6 +244,8 @@ private:
     std::function<void()> _cleanupHook;
 
     bool _inExhaust = false;
+    // The buffer the last exhaust batch was built in, to build the next one in once it is sent.
+    SharedBuffer _exhaustReplyBuffer;
     boost::optional<MessageCompressorId> _compressorId;
     Message _inMessage;
 
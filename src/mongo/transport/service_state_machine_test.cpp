@@ -77,11 +77,20 @@ public:
         _ranHandler = true;
         ASSERT_TRUE(haveClient());
 
+        auto suppliedBuffer = opCtx->releaseReplyBuffer();
+        _suppliedBuffers.push_back(suppliedBuffer.get());
+
         // Build out a dummy OK response, if no custom response message was set. Otherwise, use the
-        // custom response message.
+        // custom response message, or a copy of it built the way receivedCommands builds replies.
         Message res;
         if (_responseMessage.empty()) {
             res = buildOpMsg(BSON("ok" << 1));
+        } else if (_buildResponseInSuppliedBuffer) {
+            auto builder = suppliedBuffer
+                ? std::make_unique<OpMsgBuilder>(std::move(suppliedBuffer))
+                : std::make_unique<OpMsgBuilder>();
+            builder->setBody(OpMsg::parse(_responseMessage).body);
+            res = builder->finish();
         } else {
             res = _responseMessage;
         }
@@ -131,9 +140,23 @@ public:
         return ret;
     }
 
+    void setBuildResponseInSuppliedBuffer() {
+        _buildResponseInSuppliedBuffer = true;
+    }
+
+    /**
+     * Returns the reply buffer each call to 'handleRequest' was handed, or nullptr for those that
+     * were handed none.
+     */
+    const std::vector<const char*>& suppliedBuffers() const {
+        return _suppliedBuffers;
+    }
+
 private:
     bool _uassertInHandler = false;
     bool _ranHandler = false;
+    bool _buildResponseInSuppliedBuffer = false;
+    std::vector<const char*> _suppliedBuffers;
 
     // A custom response message to return from 'handleRequest'.
     Message _responseMessage;
@@ -488,6 +511,93 @@ TEST_F(ServiceStateMachineFixture, TestGetMoreWithExhaust) {
     ASSERT_EQ(firstResponseId, msg.header().getResponseToMsgId());
 }
 
+TEST_F(ServiceStateMachineFixture, TestGetMoreWithExhaustReusesReplyBuffer) {
+    _sep->setBuildResponseInSuppliedBuffer();
+
+    const long long cursorId = 42;
+    const std::string nss = "test.coll";
+    BSONObj getMoreResBody =
+        BSON("ok" << 1 << "cursor"
+                  << BSON("id" << cursorId << "ns" << nss << "nextBatch"
+                               << BSON_ARRAY(BSON("_id" << 1))));
+    runSourceAndSinkTest(_tl,
+                         _sep,
+                         getMoreRequestWithExhaust(nss, cursorId, 1),
+                         buildOpMsg(getMoreResBody),
+                         State::Process,
+                         State::Process);
+
+    // The first batch is built in a new buffer. Once the transport layer has let go of it, every
+    // later batch is built in that same buffer.
+    auto msg = _tl->getLastSunk();
+    const char* replyBuffer = msg.buf();
+    ASSERT_BSONOBJ_EQ(getMoreResBody, OpMsg::parse(msg).body);
+    msg.reset();
+
+    const int numBatches = 3;
+    for (int i = 0; i < numBatches; ++i) {
+        _ssm->runNext();
+        ASSERT_EQ(_ssm->state(), State::Process);
+
+        msg = _tl->getLastSunk();
+        ASSERT_EQ(msg.buf(), replyBuffer);
+        ASSERT(OpMsg::isFlagSet(msg, OpMsg::kMoreToCome));
+        ASSERT_BSONOBJ_EQ(getMoreResBody, OpMsg::parse(msg).body);
+        msg.reset();
+    }
+
+    std::vector<const char*> expectedBuffers(numBatches + 1, replyBuffer);
+    expectedBuffers[0] = nullptr;
+    ASSERT(_sep->suppliedBuffers() == expectedBuffers);
+
+    // The buffer is dropped when the stream ends.
+    _sep->setResponseMessage(buildOpMsg(BSON(
+        "ok" << 1 << "cursor" << BSON("id" << 0 << "ns" << nss << "nextBatch" << BSONArray()))));
+    _ssm->runNext();
+    ASSERT_EQ(_ssm->state(), State::Source);
+    ASSERT_EQ(_sep->suppliedBuffers().back(), replyBuffer);
+    ASSERT(!OpMsg::isFlagSet(_tl->getLastSunk(), OpMsg::kMoreToCome));
+}
+
+TEST_F(ServiceStateMachineFixture, TestGetMoreWithExhaustNeverReusesSharedReplyBuffer) {
+    const long long cursorId = 42;
+    const std::string nss = "test.coll";
+    BSONObj getMoreResBody =
+        BSON("ok" << 1 << "cursor"
+                  << BSON("id" << cursorId << "ns" << nss << "nextBatch"
+                               << BSON_ARRAY(BSON("_id" << 1))));
+
+    // The ServiceEntryPoint replies with a message it keeps a reference to, so its buffer must
+    // not be handed to the next batch even once the transport layer has let go of it.
+    runSourceAndSinkTest(_tl,
+                         _sep,
+                         getMoreRequestWithExhaust(nss, cursorId, 1),
+                         buildOpMsg(getMoreResBody),
+                         State::Process,
+                         State::Process);
+    _tl->getLastSunk().reset();
+    _ssm->runNext();
+    ASSERT_EQ(_ssm->state(), State::Process);
+    ASSERT_EQ(_sep->suppliedBuffers().back(), nullptr);
+    ASSERT_BSONOBJ_EQ(getMoreResBody, OpMsg::parse(_tl->getLastSunk()).body);
+
+    // A reply the transport layer is still holding on to is not reused either.
+    _sep->setBuildResponseInSuppliedBuffer();
+    _ssm->runNext();
+    ASSERT_EQ(_ssm->state(), State::Process);
+    auto held = _tl->getLastSunk();
+
+    _ssm->runNext();
+    ASSERT_EQ(_ssm->state(), State::Process);
+    ASSERT_EQ(_sep->suppliedBuffers().back(), nullptr);
+    ASSERT_NE(_tl->getLastSunk().buf(), held.buf());
+    ASSERT_BSONOBJ_EQ(getMoreResBody, OpMsg::parse(held).body);
+
+    for (auto buffer : _sep->suppliedBuffers()) {
+        ASSERT_EQ(buffer, nullptr);
+    }
+}
+
 TEST_F(ServiceStateMachineFixture, TestThrowHandling) {
     _sep->setUassertInHandler();
 
@@ -0,0 +1,893 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kNetwork
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_io_uring.h"
+
+#include <deque>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <set>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+
+#include "mongo/config.h"
+#include "mongo/db/stats/counters.h"
+#include "mongo/rpc/message.h"
+#include "mongo/transport/io_uring.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/util/concurrency/with_lock.h"
+#include "mongo/util/errno_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/socket_utils.h"
+#include "mongo/util/net/ssl_options.h"
+#include "mongo/util/scopeguard.h"
+#include "mongo/util/str.h"
+
+namespace mongo {
+namespace transport {
+namespace {
+
+constexpr auto kHeaderSize = sizeof(MSGHEADER::Value);
+
+// The buffer group the multishot recvs select their buffers from.
+constexpr uint16_t kRecvBufferGroup = 0;
+
+constexpr int kOpKindShift = 56;
+constexpr uint64_t kOpPayloadMask = (uint64_t(1) << kOpKindShift) - 1;
+
+Status socketErrorToStatus(int err) {
+    switch (err) {
+        case ECONNRESET:
+            return {ErrorCodes::HostUnreachable, "Connection reset by peer"};
+        case ENETRESET:
+            return {ErrorCodes::HostUnreachable, "Connection reset by network"};
+        case EAGAIN:
+            return {ErrorCodes::NetworkTimeout, "Socket operation timed out"};
+        default:
+            return {ErrorCodes::SocketException, errnoWithDescription(err)};
+    }
+}
+
+SockAddr socketAddress(int fd, bool peer) {
+    sockaddr_storage storage;
+    socklen_t len = sizeof(storage);
+    auto addr = reinterpret_cast<sockaddr*>(&storage);
+    if ((peer ? ::getpeername(fd, addr, &len) : ::getsockname(fd, addr, &len)) != 0) {
+        uasserted(ErrorCodes::SocketException,
+                  str::stream() << "Unable to determine socket address: "
+                                << errnoWithDescription(errno));
+    }
+    return SockAddr(addr, len);
+}
+
+}  // namespace
+
+class TransportLayerIoUring::IoUringSession final : public Session {
+    IoUringSession(const IoUringSession&) = delete;
+    IoUringSession& operator=(const IoUringSession&) = delete;
+
+public:
+    // Whether the reactor has a multishot recv outstanding on the session's socket. Only touched
+    // by the reactor thread.
+    enum class RecvState { kArmed, kCancelling, kStopped };
+    RecvState recvState = RecvState::kArmed;
+
+    // May throw a DBException if the socket is disconnected while it is being configured, in
+    // which case the caller keeps ownership of 'fd'.
+    IoUringSession(TransportLayerIoUring* tl, int fd)
+        : _tl(tl), _localAddr(socketAddress(fd, false)), _remoteAddr(socketAddress(fd, true)) {
+        const int on = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+        ::setsockopt(fd, SOL_SOCKET, SO_KEEPALIVE, &on, sizeof(on));
+        setSocketKeepAliveParams(fd);
+
+        _local = HostAndPort(_localAddr.toString(true));
+        _remote = HostAndPort(_remoteAddr.toString(true));
+        _fd = fd;
+    }
+
+    ~IoUringSession() {
+        ::close(_fd);
+    }
+
+    int fd() const {
+        return _fd;
+    }
+
+    TransportLayer* getTransportLayer() const override {
+        return _tl;
+    }
+
+    const HostAndPort& remote() const override {
+        return _remote;
+    }
+
+    const HostAndPort& local() const override {
+        return _local;
+    }
+
+    const SockAddr& remoteAddr() const override {
+        return _remoteAddr;
+    }
+
+    const SockAddr& localAddr() const override {
+        return _localAddr;
+    }
+
+    void end() override {
+        // Shutting the socket down makes the reactor's recv complete, which is how it learns that
+        // it can forget about this session. The descriptor itself is closed on destruction.
+        if (_ended.swap(true)) {
+            return;
+        }
+        if (::shutdown(_fd, SHUT_RDWR) != 0 && errno != ENOTCONN) {
+            error() << "Error shutting down socket: " << errnoWithDescription(errno);
+        }
+
+        // A throttled session has no recv to complete, so have the reactor arm one.
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            if (!std::exchange(_throttled, false)) {
+                return;
+            }
+        }
+        _tl->_resumeRecv(_fd);
+    }
+
+    StatusWith<Message> sourceMessage() override {
+        stdx::unique_lock<Latch> lk(_mutex);
+        auto isReady = [&] { return !_messages.empty() || _closedStatus; };
+        if (_configuredTimeout) {
+            if (!_cv.wait_for(lk, _configuredTimeout->toSystemDuration(), isReady)) {
+                return Status(ErrorCodes::NetworkTimeout, "Socket operation timed out");
+            }
+        } else {
+            _cv.wait(lk, isReady);
+        }
+
+        if (_messages.empty()) {
+            return *_closedStatus;
+        }
+        bool resume = false;
+        auto message = _popMessage(lk, &resume);
+        lk.unlock();
+        if (resume) {
+            _tl->_resumeRecv(_fd);
+        }
+        return std::move(message);
+    }
+
+    Future<Message> asyncSourceMessage(const BatonHandle& baton = nullptr) override {
+        stdx::unique_lock<Latch> lk(_mutex);
+        if (!_messages.empty()) {
+            bool resume = false;
+            auto message = _popMessage(lk, &resume);
+            lk.unlock();
+            if (resume) {
+                _tl->_resumeRecv(_fd);
+            }
+            return Future<Message>::makeReady(std::move(message));
+        }
+        if (_closedStatus) {
+            return Future<Message>::makeReady(*_closedStatus);
+        }
+
+        invariant(!_pendingSource);
+        auto pf = makePromiseFuture<Message>();
+        _pendingSource = std::move(pf.promise);
+        return std::move(pf.future);
+    }
+
+    Status sinkMessage(Message message) override {
+        const char* data = message.buf();
+        size_t remaining = message.size();
+        while (remaining) {
+            const auto sent = ::send(_fd, data, remaining, MSG_NOSIGNAL);
+            if (sent >= 0) {
+                data += sent;
+                remaining -= sent;
+                continue;
+            }
+
+            if (errno == EINTR) {
+                continue;
+            } else if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                return socketErrorToStatus(errno);
+            }
+
+            auto status = _waitForWritable();
+            if (!status.isOK()) {
+                return status;
+            }
+        }
+
+        networkCounter.hitPhysicalOut(message.size());
+        return Status::OK();
+    }
+
+    Future<void> asyncSinkMessage(Message message, const BatonHandle& baton = nullptr) override {
+        return Future<void>::makeReady(sinkMessage(std::move(message)));
+    }
+
+    void cancelAsyncOperations(const BatonHandle& baton = nullptr) override {
+        LOG(3) << "Cancelling outstanding I/O operations on connection to " << _remote;
+        stdx::unique_lock<Latch> lk(_mutex);
+        if (auto promise = std::exchange(_pendingSource, boost::none)) {
+            lk.unlock();
+            promise->setError({ErrorCodes::CallbackCanceled, "Callback was canceled"});
+        }
+    }
+
+    void setTimeout(boost::optional<Milliseconds> timeout) override {
+        invariant(!timeout || timeout->count() > 0);
+        _configuredTimeout = timeout;
+    }
+
+    bool isConnected() override {
+        // The reactor observes EOF as soon as the kernel does, so there is no need to poll.
+        stdx::lock_guard<Latch> lk(_mutex);
+        return !_messages.empty() || !_closedStatus;
+    }
+
+    /**
+     * Called on the reactor thread with bytes received from the socket. Returns false if the
+     * stream does not carry valid wire protocol messages, after failing the session.
+     */
+    bool onData(const char* data, size_t len) {
+        if (_protocolError) {
+            return false;
+        }
+
+        while (len) {
+            if (!_partial) {
+                const auto n = std::min(len, kHeaderSize - _headerFilled);
+                memcpy(_header + _headerFilled, data, n);
+                _headerFilled += n;
+                data += n;
+                len -= n;
+                if (_headerFilled < kHeaderSize) {
+                    break;
+                }
+
+                _headerFilled = 0;
+                if (StringData(_header, 4) == "GET "_sd) {
+                    _sendHTTPResponse();
+                    _protocolError = true;
+                    onClosed({ErrorCodes::ProtocolError,
+                              "Client sent an HTTP request over a native MongoDB connection"});
+                    return false;
+                }
+
+                const auto msgLen = size_t(MSGHEADER::ConstView(_header).getMessageLength());
+                if (msgLen < kHeaderSize || msgLen > MaxMessageSizeBytes) {
+                    StringBuilder sb;
+                    sb << "recv(): message msgLen " << msgLen << " is invalid. "
+                       << "Min " << kHeaderSize << " Max: " << MaxMessageSizeBytes;
+                    const auto str = sb.str();
+                    LOG(0) << str;
+
+                    _protocolError = true;
+                    onClosed({ErrorCodes::ProtocolError, str});
+                    return false;
+                }
+
+                _partial = SharedBuffer::allocate(msgLen);
+                memcpy(_partial.get(), _header, kHeaderSize);
+                _partialLen = msgLen;
+                _partialFilled = kHeaderSize;
+            }
+
+            const auto n = std::min(len, _partialLen - _partialFilled);
+            memcpy(_partial.get() + _partialFilled, data, n);
+            _partialFilled += n;
+            data += n;
+            len -= n;
+
+            if (_partialFilled == _partialLen) {
+                networkCounter.hitPhysicalIn(_partialLen);
+                _deliver(Message(std::exchange(_partial, {})));
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Returns whether so many received messages are waiting to be sourced that the reactor should
+     * stop receiving more.
+     */
+    bool isThrottled() {
+        stdx::lock_guard<Latch> lk(_mutex);
+        return _throttled;
+    }
+
+    /**
+     * Called on the reactor thread once no more data will arrive. Messages that were already
+     * received are still handed out before 'status' is reported.
+     */
+    void onClosed(Status status) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        if (_closedStatus) {
+            return;
+        }
+        _closedStatus = std::move(status);
+        auto promise = std::exchange(_pendingSource, boost::none);
+        lk.unlock();
+
+        _cv.notify_all();
+        if (promise) {
+            promise->setError(*_closedStatus);
+        }
+    }
+
+private:
+    void _deliver(Message message) {
+        stdx::unique_lock<Latch> lk(_mutex);
+        if (auto promise = std::exchange(_pendingSource, boost::none)) {
+            lk.unlock();
+            promise->emplaceValue(std::move(message));
+            return;
+        }
+        _queuedBytes += message.size();
+        if (_queuedBytes >= _tl->_listenerOptions.maxQueuedBytesPerSession && !_ended.load()) {
+            _throttled = true;
+        }
+        _messages.push_back(std::move(message));
+        lk.unlock();
+        _cv.notify_one();
+    }
+
+    // Removes the oldest queued message. Sets 'resume' if that drained the queue far enough for
+    // the reactor to receive on the session again, which the caller must request once it has
+    // released _mutex.
+    Message _popMessage(WithLock, bool* resume) {
+        auto message = std::move(_messages.front());
+        _messages.pop_front();
+        _queuedBytes -= message.size();
+        if (_throttled && _queuedBytes <= _tl->_listenerOptions.maxQueuedBytesPerSession / 2) {
+            _throttled = false;
+            *resume = true;
+        }
+        return message;
+    }
+
+    Status _waitForWritable() {
+        pollfd pfd;
+        pfd.fd = _fd;
+        pfd.events = POLLOUT;
+        pfd.revents = 0;
+        const int timeoutMs = _configuredTimeout ? durationCount<Milliseconds>(*_configuredTimeout)
+                                                 : -1;
+        while (true) {
+            const int ret = ::poll(&pfd, 1, timeoutMs);
+            if (ret > 0) {
+                return Status::OK();
+            } else if (ret == 0) {
+                return {ErrorCodes::NetworkTimeout, "Socket operation timed out"};
+            } else if (errno != EINTR) {
+                return socketErrorToStatus(errno);
+            }
+        }
+    }
+
+    // Sends a plain-text response to a client that's trying to use HTTP over a native MongoDB
+    // port. Runs on the reactor thread, so this is a best effort that never blocks.
+    void _sendHTTPResponse() {
+        constexpr auto userMsg =
+            "It looks like you are trying to access MongoDB over HTTP"
+            " on the native driver port.\r\n"_sd;
+
+        static const std::string httpResp = str::stream() << "HTTP/1.0 200 OK\r\n"
+                                                             "Connection: close\r\n"
+                                                             "Content-Type: text/plain\r\n"
+                                                             "Content-Length: "
+                                                          << userMsg.size() << "\r\n\r\n"
+                                                          << userMsg;
+
+        if (::send(_fd, httpResp.data(), httpResp.size(), MSG_NOSIGNAL | MSG_DONTWAIT) < 0) {
+            LOG(1) << "Failed to send HTTP response to " << _remote << ": "
+                   << errnoWithDescription(errno);
+        }
+    }
+
+    TransportLayerIoUring* const _tl;
+    int _fd = -1;
+
+    SockAddr _localAddr;
+    SockAddr _remoteAddr;
+    HostAndPort _local;
+    HostAndPort _remote;
+
+    AtomicWord<bool> _ended{false};
+    boost::optional<Milliseconds> _configuredTimeout;
+
+    // Message reassembly state, only touched by the reactor thread.
+    char _header[kHeaderSize];
+    size_t _headerFilled = 0;
+    SharedBuffer _partial;
+    size_t _partialLen = 0;
+    size_t _partialFilled = 0;
+    bool _protocolError = false;
+
+    Mutex _mutex = MONGO_MAKE_LATCH("IoUringSession::_mutex");
+    stdx::condition_variable _cv;
+    std::deque<Message> _messages;
+    size_t _queuedBytes = 0;  // Total size of _messages.
+    bool _throttled = false;
+    boost::optional<Promise<Message>> _pendingSource;
+    boost::optional<Status> _closedStatus;
+};
+
+TransportLayerIoUring::Options::Options(const ServerGlobalParams* params)
+    : port(params->port),
+      ipList(params->bind_ips),
+      enableIPv6(params->enableIPv6),
+      listenBacklog(params->listenBacklog) {}
+
+TransportLayerIoUring::TransportLayerIoUring(const Options& opts, ServiceEntryPoint* sep)
+    : _sep(sep), _listenerOptions(opts) {}
+
+TransportLayerIoUring::~TransportLayerIoUring() {
+    shutdown();
+
+    for (auto& listener : _listeners) {
+        ::close(listener.fd);
+    }
+    if (_wakeupFd >= 0) {
+        ::close(_wakeupFd);
+    }
+}
+
+Status TransportLayerIoUring::checkKernelSupport() {
+    utsname name;
+    int major = 0;
+    int minor = 0;
+    if (::uname(&name) != 0 || sscanf(name.release, "%d.%d", &major, &minor) != 2) {
+        return {ErrorCodes::InternalError, "Unable to determine the running kernel version"};
+    }
+
+    // Multishot recv, the last feature we depend on, was added in Linux 6.0.
+    if (major < 6) {
+        return {ErrorCodes::IllegalOperation,
+                str::stream() << "The io_uring transport layer requires Linux 6.0 or newer, "
+                              << "but the running kernel is " << name.release};
+    }
+    return Status::OK();
+}
+
+StatusWith<SessionHandle> TransportLayerIoUring::connect(HostAndPort peer,
+                                                         ConnectSSLMode sslMode,
+                                                         Milliseconds timeout) {
+    return Status(ErrorCodes::IllegalOperation,
+                  "The io_uring transport layer does not support egress connections");
+}
+
+Future<SessionHandle> TransportLayerIoUring::asyncConnect(HostAndPort peer,
+                                                          ConnectSSLMode sslMode,
+                                                          const ReactorHandle& reactor,
+                                                          Milliseconds timeout) {
+    return Status(ErrorCodes::IllegalOperation,
+                  "The io_uring transport layer does not support egress connections");
+}
+
+ReactorHandle TransportLayerIoUring::getReactor(WhichReactor which) {
+    uasserted(ErrorCodes::IllegalOperation,
+              "The io_uring transport layer does not provide a networking reactor");
+}
+
+Status TransportLayerIoUring::setup() {
+    if (auto status = checkKernelSupport(); !status.isOK()) {
+        return status;
+    }
+
+#ifdef MONGO_CONFIG_SSL
+    if (getSSLGlobalParams().sslMode.load() != SSLParams::SSLMode_disabled) {
+        return {ErrorCodes::InvalidOptions, "The io_uring transport layer does not support TLS"};
+    }
+#endif
+
+    std::vector<std::string> listenAddrs = _listenerOptions.ipList;
+    if (listenAddrs.empty()) {
+        listenAddrs = {"127.0.0.1"};
+        if (_listenerOptions.enableIPv6) {
+            listenAddrs.emplace_back("::1");
+        }
+    }
+
+    _listenerPort = _listenerOptions.port;
+    const auto familyHint = _listenerOptions.enableIPv6 ? AF_UNSPEC : AF_INET;
+
+    // Self-deduplicating list of unique endpoint addresses.
+    std::set<SockAddr> endpoints;
+    for (auto& ip : listenAddrs) {
+        if (ip.empty()) {
+            warning() << "Skipping empty bind address";
+            continue;
+        }
+        if (ip.front() == '/') {
+            warning() << "The io_uring transport layer does not listen on UNIX domain sockets, "
+                      << "skipping " << ip;
+            continue;
+        }
+
+        auto addrs = SockAddr::createAll(ip, _listenerPort, familyHint);
+        if (addrs.empty()) {
+            warning() << "Found no addresses for " << ip;
+            continue;
+        }
+        endpoints.insert(addrs.begin(), addrs.end());
+    }
+
+    for (auto& addr : endpoints) {
+        if (addr.getType() == AF_INET6 && !_listenerOptions.enableIPv6) {
+            error() << "Specified ipv6 bind address, but ipv6 is disabled";
+            fassertFailedNoTrace(4956000);
+        }
+
+        const int fd = ::socket(addr.getType(), SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            return socketErrorToStatus(errno);
+        }
+        _listeners.push_back({addr, fd});
+
+        const int on = 1;
+        ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+        if (addr.getType() == AF_INET6) {
+            ::setsockopt(fd, IPPROTO_IPV6, IPV6_V6ONLY, &on, sizeof(on));
+        }
+
+        if (::bind(fd, addr.raw(), addr.addressSize) != 0) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Failed to bind to " << addr.toString() << ": "
+                                  << errnoWithDescription(errno)};
+        }
+
+        if (_listenerOptions.port == 0) {
+            if (_listenerPort != _listenerOptions.port) {
+                return Status(ErrorCodes::BadValue,
+                              "Port 0 (ephemeral port) is not allowed when"
+                              " listening on multiple IP interfaces");
+            }
+            _listenerPort = socketAddress(fd, false).getPort();
+        }
+    }
+
+    if (_listeners.empty()) {
+        return Status(ErrorCodes::SocketException, "No available addresses/ports to bind to");
+    }
+
+    auto swRing = IoUring::make(_listenerOptions.ringEntries);
+    if (!swRing.isOK()) {
+        return swRing.getStatus();
+    }
+    _ring = std::move(swRing.getValue());
+
+    if (auto status = _ring->registerBufferRing(kRecvBufferGroup,
+                                                _listenerOptions.recvBufferCount,
+                                                _listenerOptions.recvBufferSize);
+        !status.isOK()) {
+        return status;
+    }
+
+    _wakeupFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (_wakeupFd < 0) {
+        return socketErrorToStatus(errno);
+    }
+
+    return Status::OK();
+}
+
+Status TransportLayerIoUring::start() {
+    stdx::unique_lock<Latch> lk(_mutex);
+
+    // Make sure we haven't shutdown already
+    invariant(!_isShutdown);
+
+    const int backlog = _listenerOptions.listenBacklog > 0 ? _listenerOptions.listenBacklog
+                                                           : SOMAXCONN;
+    for (auto& listener : _listeners) {
+        if (::listen(listener.fd, backlog) != 0) {
+            return {ErrorCodes::SocketException,
+                    str::stream() << "Error listening for new connections on "
+                                  << listener.addr.toString() << ": "
+                                  << errnoWithDescription(errno)};
+        }
+    }
+
+    _reactorThread = stdx::thread([this] { _runReactor(); });
+    _reactorStateCV.wait(lk, [&] { return _isShutdown || _reactorRunning; });
+    return Status::OK();
+}
+
+void TransportLayerIoUring::shutdown() {
+    stdx::unique_lock<Latch> lk(_mutex);
+
+    if (std::exchange(_isShutdown, true)) {
+        // We were already stopped
+        return;
+    }
+
+    auto thread = std::exchange(_reactorThread, {});
+    if (!thread.joinable()) {
+        // If the reactor never started, then we can return now
+        return;
+    }
+
+    // Release the lock, interrupt the reactor and wait for its thread to die
+    lk.unlock();
+    _wakeReactor();
+    thread.join();
+}
+
+void TransportLayerIoUring::_resumeRecv(int fd) {
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (_isShutdown) {
+            return;
+        }
+        _sessionsToResume.push_back(fd);
+    }
+    _wakeReactor();
+}
+
+void TransportLayerIoUring::_wakeReactor() {
+    const uint64_t one = 1;
+    if (::write(_wakeupFd, &one, sizeof(one)) < 0 && errno != EAGAIN) {
+        warning() << "Failed to wake the io_uring reactor: " << errnoWithDescription(errno);
+    }
+}
+
+void TransportLayerIoUring::_armAccept(size_t listenerIdx) {
+    auto sqe = _ring->getSqe();
+    fassert(4956001, sqe);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = _listeners[listenerIdx].fd;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+    sqe->ioprio |= IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = (uint64_t(OpKind::kAccept) << kOpKindShift) | listenerIdx;
+}
+
+void TransportLayerIoUring::_armRecv(const IoUringSessionHandle& session) {
+    auto sqe = _ring->getSqe();
+    fassert(4956002, sqe);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = session->fd();
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = _ring->bufferGroup();
+    sqe->ioprio |= IORING_RECV_MULTISHOT;
+    sqe->user_data = (uint64_t(OpKind::kRecv) << kOpKindShift) | uint64_t(session->fd());
+    session->recvState = IoUringSession::RecvState::kArmed;
+}
+
+void TransportLayerIoUring::_cancelRecv(const IoUringSessionHandle& session) {
+    auto sqe = _ring->getSqe();
+    fassert(4956005, sqe);
+    sqe->opcode = IORING_OP_ASYNC_CANCEL;
+    sqe->fd = -1;
+    sqe->addr = (uint64_t(OpKind::kRecv) << kOpKindShift) | uint64_t(session->fd());
+    sqe->user_data = uint64_t(OpKind::kCancel) << kOpKindShift;
+    session->recvState = IoUringSession::RecvState::kCancelling;
+}
+
+void TransportLayerIoUring::_armWakeup() {
+    auto sqe = _ring->getSqe();
+    fassert(4956003, sqe);
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = _wakeupFd;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->user_data = uint64_t(OpKind::kWakeup) << kOpKindShift;
+}
+
+void TransportLayerIoUring::_runReactor() noexcept {
+    setThreadName("listener");
+
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        if (_isShutdown) {
+            return;
+        }
+
+        for (size_t i = 0; i < _listeners.size(); ++i) {
+            _armAccept(i);
+            log() << "Listening on " << _listeners[i].addr.getAddr();
+        }
+        _armWakeup();
+        log() << "waiting for connections on port " << _listenerPort << " (io_uring)";
+
+        _reactorRunning = true;
+    }
+    _reactorStateCV.notify_all();
+
+    ON_BLOCK_EXIT([&] {
+        {
+            stdx::lock_guard<Latch> lk(_mutex);
+            _reactorRunning = false;
+        }
+        _reactorStateCV.notify_all();
+    });
+
+    bool stopRequested = false;
+    while (!stopRequested) {
+        // Everything armed while processing the previous batch of completions goes to the kernel
+        // in this one call, which then sleeps until there is more work.
+        if (auto status = _ring->submitAndWait(1); !status.isOK()) {
+            severe() << "io_uring reactor failed: " << status;
+            fassertFailed(4956004);
+        }
+
+        _ring->reapCompletions([&](const io_uring_cqe& cqe) {
+            const auto payload = cqe.user_data & kOpPayloadMask;
+            switch (OpKind(cqe.user_data >> kOpKindShift)) {
+                case OpKind::kAccept:
+                    _onAccept(payload, cqe);
+                    break;
+                case OpKind::kRecv:
+                    _onRecv(static_cast<int>(payload), cqe);
+                    break;
+                case OpKind::kWakeup:
+                    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+                        _armWakeup();
+                    }
+                    _onWakeup();
+                    {
+                        stdx::lock_guard<Latch> lk(_mutex);
+                        stopRequested = _isShutdown;
+                    }
+                    break;
+                case OpKind::kCancel:
+                    // The recv being cancelled reports the outcome itself.
+                    break;
+            }
+        });
+    }
+
+    // Nothing will be received on the remaining sessions anymore, so fail them. Their sockets
+    // stay open until whoever owns the sessions lets go of them.
+    for (auto& [fd, session] : _sessions) {
+        session->onClosed(TransportLayer::ShutdownStatus);
+        session->end();
+    }
+    _sessions.clear();
+
+    for (auto& listener : _listeners) {
+        ::shutdown(listener.fd, SHUT_RDWR);
+    }
+}
+
+void TransportLayerIoUring::_onWakeup() {
+    uint64_t count;
+    if (::read(_wakeupFd, &count, sizeof(count)) < 0 && errno != EAGAIN) {
+        warning() << "Failed to reset the io_uring reactor wakeup: " << errnoWithDescription(errno);
+    }
+
+    std::vector<int> toResume;
+    {
+        stdx::lock_guard<Latch> lk(_mutex);
+        toResume.swap(_sessionsToResume);
+    }
+
+    for (int fd : toResume) {
+        // The session may have gone away, and its descriptor been reused, since it asked.
+        auto it = _sessions.find(fd);
+        if (it == _sessions.end()) {
+            continue;
+        }
+        auto& session = it->second;
+        if (session->recvState == IoUringSession::RecvState::kStopped && !session->isThrottled()) {
+            _armRecv(session);
+        }
+    }
+}
+
+void TransportLayerIoUring::_onAccept(size_t listenerIdx, const io_uring_cqe& cqe) {
+    if (!(cqe.flags & IORING_CQE_F_MORE)) {
+        _armAccept(listenerIdx);
+    }
+
+    if (cqe.res < 0) {
+        log() << "Error accepting new connection on " << _listeners[listenerIdx].addr << ": "
+              << errnoWithDescription(-cqe.res);
+        return;
+    }
+
+    const int fd = cqe.res;
+    IoUringSessionHandle session;
+    try {
+        session = std::make_shared<IoUringSession>(this, fd);
+    } catch (const DBException& e) {
+        warning() << "Error accepting new connection " << e;
+        ::close(fd);
+        return;
+    }
+
+    // Only start receiving once the session has an owner, so that a session which fails to
+    // start never has a recv in flight and is released right here.
+    try {
+        _sep->startSession(session);
+    } catch (const DBException& e) {
+        warning() << "Error accepting new connection " << e;
+        session->end();
+        return;
+    }
+
+    _sessions.emplace(fd, session);
+    _armRecv(session);
+}
+
+void TransportLayerIoUring::_onRecv(int fd, const io_uring_cqe& cqe) {
+    auto it = _sessions.find(fd);
+    invariant(it != _sessions.end());
+    auto& session = it->second;
+
+    if (cqe.res > 0) {
+        const auto bufferId = uint16_t(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        if (!session->onData(_ring->bufferData(bufferId), cqe.res)) {
+            // The recv completes once the socket is shut down, which releases the session.
+            session->end();
+        }
+        _ring->recycleBuffer(bufferId);
+    } else if (cqe.res == 0) {
+        session->onClosed({ErrorCodes::HostUnreachable, "Connection closed by peer"});
+    } else if (cqe.res != -ENOBUFS && cqe.res != -ECANCELED) {
+        session->onClosed(socketErrorToStatus(-cqe.res));
+    }
+
+    if (cqe.flags & IORING_CQE_F_MORE) {
+        // Stop receiving once the session has fallen too far behind; the data keeps arriving in
+        // this recv's completions until the kernel processes the cancellation.
+        if (session->recvState == IoUringSession::RecvState::kArmed && session->isThrottled()) {
+            _cancelRecv(session);
+        }
+        return;
+    }
+
+    // The kernel terminated the multishot recv. Either the connection is done, or it ran out of
+    // buffers (or completion queue space) or was cancelled, and the recv must be armed again
+    // unless the session is throttled. In that case the session asks for it to be re-armed once
+    // it has consumed enough of its queued messages.
+    if (cqe.res > 0 || cqe.res == -ENOBUFS || cqe.res == -ECANCELED) {
+        if (session->isThrottled()) {
+            session->recvState = IoUringSession::RecvState::kStopped;
+        } else {
+            _armRecv(session);
+        }
+    } else {
+        _sessions.erase(it);
+    }
+}
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,187 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mongo/base/status_with.h"
+#include "mongo/db/server_options.h"
+#include "mongo/platform/mutex.h"
+#include "mongo/rpc/message.h"
+#include "mongo/stdx/condition_variable.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/stdx/unordered_map.h"
+#include "mongo/transport/transport_layer.h"
+#include "mongo/util/net/sockaddr.h"
+
+struct io_uring_cqe;
+
+namespace mongo {
+
+class ServiceEntryPoint;
+
+namespace transport {
+
+class IoUring;
+
+/**
+ * An ingress-only TransportLayer built directly on Linux io_uring.
+ *
+ * A single reactor thread owns the ring. Each listening socket carries one multishot accept, and
+ * each accepted connection carries one multishot recv that draws from a ring of buffers shared
+ * with the kernel, so in the steady state no system call is made per connection or per message
+ * on the receive path: the reactor reaps a batch of completions, reassembles wire protocol
+ * messages from them, re-arms whatever the kernel terminated and submits all of that with a
+ * single io_uring_enter. Threads calling sourceMessage() simply wait for an assembled Message.
+ * A client pipelining faster than its session consumes has its recv cancelled once too many
+ * messages are queued, leaving the rest in the socket buffers until the session catches up.
+ *
+ * Replies are written directly by the thread calling sinkMessage(), which under the synchronous
+ * service executor is the one thread serving the session; routing them through the reactor would
+ * only add a wakeup.
+ *
+ * This layer neither connects to remote hosts nor supports TLS or UNIX domain sockets; egress
+ * networking stays with TransportLayerASIO.
+ */
+class TransportLayerIoUring final : public TransportLayer {
+    TransportLayerIoUring(const TransportLayerIoUring&) = delete;
+    TransportLayerIoUring& operator=(const TransportLayerIoUring&) = delete;
+
+public:
+    struct Options {
+        explicit Options(const ServerGlobalParams* params);
+        Options() = default;
+
+        int port = ServerGlobalParams::DefaultDBPort;  // port to bind to
+        std::vector<std::string> ipList;               // addresses to bind to
+        bool enableIPv6 = false;                       // whether to allow IPv6 sockets in ipList
+        int listenBacklog = 0;                         // backlog passed to listen()
+
+        unsigned ringEntries = 1024;      // submission queue size
+        unsigned recvBufferCount = 4096;  // number of buffers shared with the kernel
+        size_t recvBufferSize = 16 * 1024;
+
+        // Once this many bytes of received messages wait for a session to source them, the
+        // reactor stops receiving on its connection until half of them have been consumed.
+        size_t maxQueuedBytesPerSession = 4 * MaxMessageSizeBytes;
+    };
+
+    TransportLayerIoUring(const Options& opts, ServiceEntryPoint* sep);
+
+    ~TransportLayerIoUring() override;
+
+    /**
+     * Returns whether the running kernel supports everything this transport layer relies on
+     * (multishot accept and recv with provided buffer rings, i.e. Linux 6.0 or newer).
+     */
+    static Status checkKernelSupport();
+
+    StatusWith<SessionHandle> connect(HostAndPort peer,
+                                      ConnectSSLMode sslMode,
+                                      Milliseconds timeout) final;
+
+    Future<SessionHandle> asyncConnect(HostAndPort peer,
+                                       ConnectSSLMode sslMode,
+                                       const ReactorHandle& reactor,
+                                       Milliseconds timeout) final;
+
+    Status setup() final;
+
+    ReactorHandle getReactor(WhichReactor which) final;
+
+    Status start() final;
+
+    void shutdown() final;
+
+    int listenerPort() const {
+        return _listenerPort;
+    }
+
+private:
+    class IoUringSession;
+
+    using IoUringSessionHandle = std::shared_ptr<IoUringSession>;
+
+    // Tags stored in the top bits of each submission's user_data, identifying what completed.
+    enum class OpKind : uint64_t { kAccept = 1, kRecv = 2, kWakeup = 3, kCancel = 4 };
+
+    void _runReactor() noexcept;
+
+    void _armAccept(size_t listenerIdx);
+    void _armRecv(const IoUringSessionHandle& session);
+    void _armWakeup();
+    void _cancelRecv(const IoUringSessionHandle& session);
+
+    void _onAccept(size_t listenerIdx, const io_uring_cqe& cqe);
+    void _onRecv(int fd, const io_uring_cqe& cqe);
+
+    void _onWakeup();
+
+    // Asks the reactor to receive on the session using 'fd' again after it stopped doing so.
+    void _resumeRecv(int fd);
+
+    void _wakeReactor();
+
+    Mutex _mutex = MONGO_MAKE_LATCH("TransportLayerIoUring::_mutex");
+
+    std::unique_ptr<IoUring> _ring;
+
+    struct ListenSocket {
+        SockAddr addr;
+        int fd;
+    };
+    std::vector<ListenSocket> _listeners;
+
+    // Eventfd used to wake the reactor up for shutdown or to resume receiving on sessions.
+    int _wakeupFd = -1;
+
+    // File descriptors of the sessions whose recv the reactor should arm again.
+    std::vector<int> _sessionsToResume;
+
+    // Sessions the reactor receives on, keyed by file descriptor. Only touched by the reactor.
+    stdx::unordered_map<int, IoUringSessionHandle> _sessions;
+
+    stdx::thread _reactorThread;
+    stdx::condition_variable _reactorStateCV;
+    bool _reactorRunning = false;
+
+    ServiceEntryPoint* const _sep;
+
+    Options _listenerOptions;
+    // The real incoming port in case of _listenerOptions.port==0 (ephemeral).
+    int _listenerPort = 0;
+
+    bool _isShutdown = false;
+};
+
+}  // namespace transport
+}  // namespace mongo
@@ -0,0 +1,396 @@
+/**
+ *    Copyright (C) 2020-present MongoDB, Inc.
+ *
+ *    This program is free software: you can redistribute it and/or modify
+ *    it under the terms of the Server Side Public License, version 1,
+ *    as published by MongoDB, Inc.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    Server Side Public License for more details.
+ *
+ *    You should have received a copy of the Server Side Public License
+ *    along with this program. If not, see
+ *    <http://www.mongodb.com/licensing/server-side-public-license>.
+ *
+ *    As a special exception, the copyright holders give permission to link the
+ *    code of portions of this program with the OpenSSL library under certain
+ *    conditions as described in each individual source file and distribute
+ *    linked combinations including the program with the OpenSSL library. You
+ *    must comply with the Server Side Public License in all respects for
+ *    all of the code used other than as permitted herein. If you modify file(s)
+ *    with this exception, you may extend this exception to your version of the
+ *    file(s), but you are not obligated to do so. If you do not wish to do so,
+ *    delete this exception statement from your version. If you delete this
+ *    exception statement from all source files in the program, then also delete
+ *    it in the license file.
+ */
+
+#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
+
+#include "mongo/platform/basic.h"
+
+#include "mongo/transport/transport_layer_io_uring.h"
+
+#include <deque>
+
+#include "mongo/db/server_options.h"
+#include "mongo/platform/atomic_word.h"
+#include "mongo/rpc/op_msg.h"
+#include "mongo/stdx/thread.h"
+#include "mongo/transport/io_uring.h"
+#include "mongo/transport/service_entry_point.h"
+#include "mongo/unittest/unittest.h"
+#include "mongo/util/assert_util.h"
+#include "mongo/util/log.h"
+#include "mongo/util/net/sock.h"
+#include "mongo/util/time_support.h"
+
+namespace mongo {
+namespace {
+
+class ServiceEntryPointUtil : public ServiceEntryPoint {
+public:
+    void startSession(transport::SessionHandle session) override {
+        stdx::unique_lock<Latch> lk(_mutex);
+        _sessions.push_back(std::move(session));
+        log() << "started session";
+        _cv.notify_one();
+    }
+
+    void endAllSessions(transport::Session::TagMask tags) override {
+        log() << "end all sessions";
+        std::deque<transport::SessionHandle> old_sessions;
+        {
+            stdx::unique_lock<Latch> lock(_mutex);
+            old_sessions.swap(_sessions);
+        }
+        old_sessions.clear();
+    }
+
+    Status start() override {
+        return Status::OK();
+    }
+
+    bool shutdown(Milliseconds timeout) override {
+        return true;
+    }
+
+    void appendStats(BSONObjBuilder*) const override {}
+
+    size_t numOpenSessions() const override {
+        stdx::unique_lock<Latch> lock(_mutex);
+        return _sessions.size();
+    }
+
+    DbResponse handleRequest(OperationContext* opCtx, const Message& request) override {
+        MONGO_UNREACHABLE;
+    }
+
+    transport::SessionHandle waitForSession() {
+        stdx::unique_lock<Latch> lock(_mutex);
+        _cv.wait(lock, [&] { return !_sessions.empty(); });
+        auto session = std::move(_sessions.front());
+        _sessions.pop_front();
+        return session;
+    }
+
+private:
+    mutable Mutex _mutex = MONGO_MAKE_LATCH("::_mutex");
+    stdx::condition_variable _cv;
+    std::deque<transport::SessionHandle> _sessions;
+};
+
+// io_uring may be unavailable on the machine running the tests, either because the kernel is too
+// old or because it has been disabled (e.g. by a container's seccomp profile).
+bool ioUringAvailable() {
+    if (auto status = transport::TransportLayerIoUring::checkKernelSupport(); !status.isOK()) {
+        log() << "Skipping io_uring transport test: " << status;
+        return false;
+    }
+    if (auto swRing = transport::IoUring::make(8); !swRing.isOK()) {
+        log() << "Skipping io_uring transport test: " << swRing.getStatus();
+        return false;
+    }
+    return true;
+}
+
+std::unique_ptr<transport::TransportLayerIoUring> makeAndStartTL(
+    ServiceEntryPoint* sep,
+    size_t recvBufferSize = 16 * 1024,
+    size_t maxQueuedBytesPerSession = 4 * MaxMessageSizeBytes) {
+    transport::TransportLayerIoUring::Options opts;
+    opts.port = 0;
+    opts.recvBufferCount = 64;
+    opts.recvBufferSize = recvBufferSize;
+    opts.maxQueuedBytesPerSession = maxQueuedBytesPerSession;
+
+    auto tl = std::make_unique<transport::TransportLayerIoUring>(opts, sep);
+    ASSERT_OK(tl->setup());
+    ASSERT_OK(tl->start());
+    ASSERT_GT(tl->listenerPort(), 0);
+    log() << "TransportLayerIoUring.listenerPort() is " << tl->listenerPort();
+
+    return tl;
+}
+
+void connectTo(Socket& socket, int port) {
+    SockAddr sa{"localhost", port, AF_INET};
+    ASSERT(socket.connect(sa));
+}
+
+Message makeMessage(int32_t id, size_t payloadSize) {
+    OpMsgBuilder builder;
+    builder.setBody(BSON("ping" << 1 << "payload" << std::string(payloadSize, 'x')));
+    Message msg = builder.finish();
+    msg.header().setResponseToMsgId(0);
+    msg.header().setId(id);
+    return msg;
+}
+
+void assertSameMessage(const Message& actual, const Message& expected) {
+    ASSERT_EQ(actual.size(), expected.size());
+    ASSERT_EQ(memcmp(actual.buf(), expected.buf(), expected.size()), 0);
+}
+
+TEST(TransportLayerIoUring, PortZeroConnect) {
+    if (!ioUringAvailable()) {
+        return;
+    }
+
+    ServiceEntryPointUtil sepu;
+    auto tl = makeAndStartTL(&sepu);
+
+    Socket client;
+    connectTo(client, tl->listenerPort());
+    auto session = sepu.waitForSession();
+    ASSERT(session->isConnected());
+    ASSERT_EQ(session->getTransportLayer(), tl.get());
+
+    session.reset();
+    tl->shutdown();
+}
+
+TEST(TransportLayerIoUring, SourceAndSinkPipelinedMessages) {
+    if (!ioUringAvailable()) {
+        return;
+    }
+
+    // Use small receive buffers so that messages straddle several of them.
+    ServiceEntryPointUtil sepu;
+    auto tl = makeAndStartTL(&sepu, 256);
+
+    Socket client;
+    connectTo(client, tl->listenerPort());
+    auto session = sepu.waitForSession();
+
+    std::vector<Message> requests{makeMessage(1, 10), makeMessage(2, 8192), makeMessage(3, 0)};
+    std::string wire;
+    for (auto& request : requests) {
+        wire.append(request.buf(), request.size());
+    }
+    client.send(wire.data(), wire.size(), "pipelined requests");
+
+    for (auto& request : requests) {
+        auto swMessage = session->sourceMessage();
+        ASSERT_OK(swMessage.getStatus());
+        assertSameMessage(swMessage.getValue(), request);
+    }
+
+    auto reply = makeMessage(4, 100);
+    ASSERT_OK(session->sinkMessage(reply));
+    std::string received(reply.size(), '\0');
+    client.recv(&received[0], received.size());
+    ASSERT_EQ(received, std::string(reply.buf(), reply.size()));
+
+    session->end();
+    session.reset();
+    tl->shutdown();
+}
+
+TEST(TransportLayerIoUring, PipeliningPastQueueLimitAppliesBackpressure) {
+    if (!ioUringAvailable()) {
+        return;
+    }
+
+    // Far more data than the queue limit and the socket buffers of both ends can hold together.
+    constexpr size_t kMessageSize = 1024 * 1024;
+    constexpr int kNumMessages = 64;
+    ServiceEntryPointUtil sepu;
+    auto tl = makeAndStartTL(&sepu, 16 * 1024, 2 * kMessageSize);
+
+    Socket client;
+    connectTo(client, tl->listenerPort());
+    auto session = sepu.waitForSession();
+
+    std::vector<Message> requests;
+    for (int i = 0; i < kNumMessages; ++i) {
+        requests.push_back(makeMessage(i, kMessageSize));
+    }
+
+    AtomicWord<int> sent{0};
+    stdx::thread sender([&] {
+        for (auto& request : requests) {
+            client.send(request.buf(), request.size(), "pipelined request");
+            sent.addAndFetch(1);
+        }
+    });
+
+    // Nothing is sourced yet, so the reactor must stop receiving and leave the client blocked.
+    sleepmillis(500);
+    ASSERT_LT(sent.load(), kNumMessages);
+
+    // Consuming the queued messages resumes receiving, and nothing is lost or reordered.
+    for (auto& request : requests) {
+        auto swMessage = session->sourceMessage();
+        ASSERT_OK(swMessage.getStatus());
+        assertSameMessage(swMessage.getValue(), request);
+    }
+    sender.join();
+    ASSERT_EQ(sent.load(), kNumMessages);
+
+    session->end();
+    session.reset();
+    tl->shutdown();
+}
+
+TEST(TransportLayerIoUring, AsyncSourceMessage) {
+    if (!ioUringAvailable()) {
+        return;
+    }
+
+    ServiceEntryPointUtil sepu;
+    auto tl = makeAndStartTL(&sepu);
+
+    Socket client;
+    connectTo(client, tl->listenerPort());
+    auto session = sepu.waitForSession();
+
+    auto future = session->asyncSourceMessage();
+    ASSERT_FALSE(future.isReady());
+
+    auto request = makeMessage(1, 10);
+    client.send(request.buf(), request.size(), "request");
+    assertSameMessage(future.get(), request);
+
+    session.reset();
+    tl->shutdown();
+}
+
+TEST(TransportLayerIoUring, SourceMessageTimesOut) {
+    if (!ioUringAvailable()) {
+        return;
+    }
+
+    ServiceEntryPointUtil sepu;
+    auto tl = makeAndStartTL(&sepu);
+
+    Socket client;
+    connectTo(client, tl->listenerPort());
+    auto session = sepu.waitForSession();
+
+    session->setTimeout(Milliseconds{50});
+    ASSERT_EQ(session->sourceMessage().getStatus(), ErrorCodes::NetworkTimeout);
+
+    // Clearing the timeout makes the session wait for the message again.
+    session->setTimeout(boost::none);
+    auto request = makeMessage(1, 10);
+    client.send(request.buf(), request.size(), "request");
+    ASSERT_OK(session->sourceMessage().getStatus());
+
+    session.reset();
+    tl->shutdown();
+}
+
+TEST(TransportLayerIoUring, PeerCloseEndsSession) {
+    if (!ioUringAvailable()) {
+        return;
+    }
+
+    ServiceEntryPointUtil sepu;
+    auto tl = makeAndStartTL(&sepu);
+
+    Socket client;
+    connectTo(client, tl->listenerPort());
+    auto session = sepu.waitForSession();
+
+    // A message that was fully received before the peer went away is still handed out.
+    auto request = makeMessage(1, 10);
+    client.send(request.buf(), request.size(), "request");
+    client.close();
+
+    ASSERT_OK(session->sourceMessage().getStatus());
+    ASSERT_EQ(session->sourceMessage().getStatus(), ErrorCodes::HostUnreachable);
+    ASSERT_FALSE(session->isConnected());
+
+    session.reset();
+    tl->shutdown();
+}
+
+TEST(TransportLayerIoUring, InvalidMessageLengthIsRejected) {
+    if (!ioUringAvailable()) {
+        return;
+    }
+
+    ServiceEntryPointUtil sepu;
+    auto tl = makeAndStartTL(&sepu);
+
+    Socket client;
+    connectTo(client, tl->listenerPort());
+    auto session = sepu.waitForSession();
+
+    auto request = makeMessage(1, 10);
+    request.header().setLen(4);
+    client.send(request.buf(), request.size(), "request");
+
+    ASSERT_EQ(session->sourceMessage().getStatus(), ErrorCodes::ProtocolError);
+
+    session.reset();
+    tl->shutdown();
+}
+
+TEST(TransportLayerIoUring, HTTPRequestGetsHTTPResponse) {
+    if (!ioUringAvailable()) {
+        return;
+    }
+
+    ServiceEntryPointUtil sepu;
+    auto tl = makeAndStartTL(&sepu);
+
+    Socket client;
+    connectTo(client, tl->listenerPort());
+    auto session = sepu.waitForSession();
+
+    constexpr auto httpRequest = "GET / HTTP/1.1\r\nHost: localhost\r\n\r\n"_sd;
+    client.send(httpRequest.rawData(), httpRequest.size(), "HTTP request");
+
+    ASSERT_EQ(session->sourceMessage().getStatus(), ErrorCodes::ProtocolError);
+
+    char response[512];
+    const int received = client.unsafe_recv(response, sizeof(response));
+    ASSERT_GT(received, 0);
+    ASSERT_STRING_CONTAINS(std::string(response, received), "HTTP/1.0 200 OK");
+
+    session.reset();
+    tl->shutdown();
+}
+
+TEST(TransportLayerIoUring, ShutdownFailsOutstandingSessions) {
+    if (!ioUringAvailable()) {
+        return;
+    }
+
+    ServiceEntryPointUtil sepu;
+    auto tl = makeAndStartTL(&sepu);
+
+    Socket client;
+    connectTo(client, tl->listenerPort());
+    auto session = sepu.waitForSession();
+
+    tl->shutdown();
+    ASSERT_EQ(session->sourceMessage().getStatus(), ErrorCodes::ShutdownInProgress);
+}
+
+}  // namespace
+}  // namespace mongo
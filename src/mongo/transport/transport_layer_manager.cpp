@@ -36,12 +36,17 @@
 #include <memory>
 
 #include "mongo/base/status.h"
+#include "mongo/config.h"
 #include "mongo/db/server_options.h"
 #include "mongo/db/service_context.h"
 #include "mongo/transport/service_executor_adaptive.h"
 #include "mongo/transport/service_executor_synchronous.h"
+#include "mongo/transport/service_executor_thread_per_core.h"
 #include "mongo/transport/session.h"
 #include "mongo/transport/transport_layer_asio.h"
+#ifdef MONGO_CONFIG_IO_URING
+#include "mongo/transport/transport_layer_io_uring.h"
+#endif
 #include "mongo/util/net/ssl_types.h"
 #include "mongo/util/time_support.h"
 
@@ -133,8 +138,30 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
     std::unique_ptr<TransportLayer> transportLayer;
     auto sep = ctx->getServiceEntryPoint();
 
+#ifdef MONGO_CONFIG_IO_URING
+    if (config->transportLayer == "iouring") {
+        invariant(config->serviceExecutor == "synchronous");
+        ctx->setServiceExecutor(std::make_unique<ServiceExecutorSynchronous>(ctx));
+
+        // The io_uring transport layer only accepts connections, so an egress-only ASIO transport
+        // layer sits in front of it to serve connect() and getReactor().
+        transport::TransportLayerASIO::Options egressOpts(config);
+        egressOpts.mode = transport::TransportLayerASIO::Options::kEgress;
+        egressOpts.ipList.clear();
+
+        transport::TransportLayerIoUring::Options ingressOpts(config);
+
+        std::vector<std::unique_ptr<TransportLayer>> retVector;
+        retVector.emplace_back(
+            std::make_unique<transport::TransportLayerASIO>(egressOpts, nullptr));
+        retVector.emplace_back(
+            std::make_unique<transport::TransportLayerIoUring>(ingressOpts, sep));
+        return std::make_unique<TransportLayerManager>(std::move(retVector));
+    }
+#endif
+
     transport::TransportLayerASIO::Options opts(config);
-    if (config->serviceExecutor == "adaptive") {
+    if (config->serviceExecutor == "adaptive" || config->serviceExecutor == "threadPerCore") {
         opts.transportMode = transport::Mode::kAsynchronous;
     } else if (config->serviceExecutor == "synchronous") {
         opts.transportMode = transport::Mode::kSynchronous;
@@ -147,6 +174,10 @@ std::unique_ptr<TransportLayer> TransportLayerManager::createWithConfig(
     if (config->serviceExecutor == "adaptive") {
         auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
         ctx->setServiceExecutor(std::make_unique<ServiceExecutorAdaptive>(ctx, std::move(reactor)));
+    } else if (config->serviceExecutor == "threadPerCore") {
+        auto reactor = transportLayerASIO->getReactor(TransportLayer::kIngress);
+        ctx->setServiceExecutor(
+            std::make_unique<ServiceExecutorThreadPerCore>(ctx, std::move(reactor)));
     } else if (config->serviceExecutor == "synchronous") {
         ctx->setServiceExecutor(std::make_unique<ServiceExecutorSynchronous>(ctx));
     }
@@ -27,230 +27,209 @@
  *    it in the license file.
  */
 
-#define MONGO_LOG_DEFAULT_COMPONENT ::mongo::logger::LogComponent::kDefault
-
 #include "mongo/platform/basic.h"
 
 #include "mongo/util/concurrency/ticketholder.h"
 
-#include <iostream>
-
-#include "mongo/util/log.h"
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/db/operation_context.h"
+#include "mongo/platform/bits.h"
+#include "mongo/util/scopeguard.h"
 #include "mongo/util/str.h"
 
 namespace mongo {
-
-#if defined(__linux__)
 namespace {
 
-/**
- * Accepts an errno code, prints its error message, and exits.
- */
-void failWithErrno(int err) {
-    severe() << "error in Ticketholder: " << errnoWithDescription(err);
-    fassertFailed(28604);
-}
-
-/*
- * Checks the return value from a Linux semaphore function call, and fails with the set errno if the
- * call was unsucessful.
- */
-void check(int ret) {
-    if (ret == 0)
-        return;
-    failWithErrno(errno);
+const char* priorityName(TicketHolder::Priority priority) {
+    switch (priority) {
+        case TicketHolder::Priority::kReplication:
+            return "replication";
+        case TicketHolder::Priority::kInternal:
+            return "internal";
+        case TicketHolder::Priority::kUser:
+            return "user";
+    }
+    MONGO_UNREACHABLE;
 }
 
-/**
- * Takes a Date_t deadline and sets the appropriate values in a timespec structure.
- */
-void tsFromDate(const Date_t& deadline, struct timespec& ts) {
-    ts.tv_sec = deadline.toTimeT();
-    ts.tv_nsec = (deadline.toMillisSinceEpoch() % 1000) * 1'000'000;
-}
 }  // namespace
 
-TicketHolder::TicketHolder(int num) : _outof(num) {
-    check(sem_init(&_sem, 0, num));
-}
+TicketHolder::TicketHolder(int num) : _available(num), _outof(num) {}
 
-TicketHolder::~TicketHolder() {
-    check(sem_destroy(&_sem));
-}
+TicketHolder::~TicketHolder() = default;
 
 bool TicketHolder::tryAcquire() {
-    while (0 != sem_trywait(&_sem)) {
-        if (errno == EAGAIN)
-            return false;
-        if (errno != EINTR)
-            failWithErrno(errno);
-    }
-    return true;
-}
-
-void TicketHolder::waitForTicket(OperationContext* opCtx) {
-    waitForTicketUntil(opCtx, Date_t::max());
-}
+    stdx::lock_guard<Latch> lk(_mutex);
 
-bool TicketHolder::waitForTicketUntil(OperationContext* opCtx, Date_t until) {
-    const Milliseconds intervalMs(500);
-    struct timespec ts;
-
-    // To support interrupting ticket acquisition while still benefiting from semaphores, we do a
-    // timed wait on an interval to periodically check for interrupts.
-    // The wait period interval is the smaller of the default interval and the provided
-    // deadline.
-    Date_t deadline = std::min(until, Date_t::now() + intervalMs);
-    tsFromDate(deadline, ts);
-
-    while (0 != sem_timedwait(&_sem, &ts)) {
-        if (errno == ETIMEDOUT) {
-            // If we reached the deadline without being interrupted, we have completely timed out.
-            if (deadline == until)
-                return false;
-
-            deadline = std::min(until, Date_t::now() + intervalMs);
-            tsFromDate(deadline, ts);
-        } else if (errno != EINTR) {
-            failWithErrno(errno);
-        }
+    // Released tickets go straight to queued waiters, so a ticket being available implies that
+    // nobody is queued and taking it cannot jump the queue.
+    if (_available <= 0)
+        return false;
 
-        // To correctly handle errors from sem_timedwait, we should check for interrupts last.
-        // It is possible to unset 'errno' after a call to checkForInterrupt().
-        if (opCtx)
-            opCtx->checkForInterrupt();
-    }
+    _available--;
     return true;
 }
 
-void TicketHolder::release() {
-    check(sem_post(&_sem));
+void TicketHolder::waitForTicket(OperationContext* opCtx, Priority priority) {
+    invariant(waitForTicketUntil(opCtx, Date_t::max(), priority));
 }
 
-Status TicketHolder::resize(int newSize) {
-    stdx::lock_guard<Latch> lk(_resizeMutex);
-
-    if (newSize < 5)
-        return Status(ErrorCodes::BadValue,
-                      str::stream() << "Minimum value for semaphore is 5; given " << newSize);
-
-    if (newSize > SEM_VALUE_MAX)
-        return Status(ErrorCodes::BadValue,
-                      str::stream() << "Maximum value for semaphore is " << SEM_VALUE_MAX
-                                    << "; given " << newSize);
+bool TicketHolder::waitForTicketUntil(OperationContext* opCtx, Date_t until, Priority priority) {
+    stdx::unique_lock<Latch> lk(_mutex);
 
-    while (_outof.load() < newSize) {
-        release();
-        _outof.fetchAndAdd(1);
+    if (_available > 0) {
+        _available--;
+        _recordAdmissionInLock(lk, priority, Microseconds(0));
+        return true;
     }
 
-    while (_outof.load() > newSize) {
-        waitForTicket();
-        _outof.subtractAndFetch(1);
-    }
+    const auto start = Date_t::now();
+    if (until <= start)
+        return false;
 
-    invariant(_outof.load() == newSize);
-    return Status::OK();
-}
+    auto& queue = _queues[static_cast<size_t>(priority)];
+    Waiter waiter;
+    const auto it = queue.waiters.insert(queue.waiters.end(), &waiter);
+
+    // A waiter which gives up must leave the queue, or hand back the ticket if one was granted
+    // to it between the wakeup and reacquiring the mutex.
+    auto dequeueGuard = makeGuard([&] {
+        if (waiter.granted) {
+            _releaseInLock(lk);
+        } else {
+            queue.waiters.erase(it);
+        }
+    });
 
-int TicketHolder::available() const {
-    int val = 0;
-    check(sem_getvalue(&_sem, &val));
-    return val;
-}
+    const auto isGranted = [&waiter] { return waiter.granted; };
+    bool granted;
+    if (opCtx) {
+        granted = opCtx->waitForConditionOrInterruptUntil(waiter.cv, lk, until, isGranted);
+    } else if (until == Date_t::max()) {
+        waiter.cv.wait(lk, isGranted);
+        granted = true;
+    } else {
+        granted = waiter.cv.wait_until(lk, until.toSystemTimePoint(), isGranted);
+    }
 
-int TicketHolder::used() const {
-    return outof() - available();
-}
+    if (!granted)
+        return false;
 
-int TicketHolder::outof() const {
-    return _outof.load();
+    dequeueGuard.dismiss();
+    _recordAdmissionInLock(lk, priority, duration_cast<Microseconds>(Date_t::now() - start));
+    return true;
 }
 
-#else
-
-TicketHolder::TicketHolder(int num) : _outof(num), _num(num) {}
-
-TicketHolder::~TicketHolder() = default;
-
-bool TicketHolder::tryAcquire() {
+void TicketHolder::release() {
     stdx::lock_guard<Latch> lk(_mutex);
-    return _tryAcquire();
+    _releaseInLock(lk);
 }
 
-void TicketHolder::waitForTicket(OperationContext* opCtx) {
-    stdx::unique_lock<Latch> lk(_mutex);
-
-    if (opCtx) {
-        opCtx->waitForConditionOrInterrupt(_newTicket, lk, [this] { return _tryAcquire(); });
-    } else {
-        _newTicket.wait(lk, [this] { return _tryAcquire(); });
+void TicketHolder::_releaseInLock(WithLock) {
+    // A negative count means the holder was shrunk while the ticket was out, so retire it.
+    if (_available < 0) {
+        _available++;
+        return;
     }
-}
 
-bool TicketHolder::waitForTicketUntil(OperationContext* opCtx, Date_t until) {
-    stdx::unique_lock<Latch> lk(_mutex);
+    for (auto& queue : _queues) {
+        if (queue.waiters.empty())
+            continue;
 
-    if (opCtx) {
-        return opCtx->waitForConditionOrInterruptUntil(
-            _newTicket, lk, until, [this] { return _tryAcquire(); });
-    } else {
-        return _newTicket.wait_until(
-            lk, until.toSystemTimePoint(), [this] { return _tryAcquire(); });
+        auto waiter = queue.waiters.front();
+        queue.waiters.pop_front();
+        waiter->granted = true;
+        waiter->cv.notify_one();
+        return;
     }
+
+    _available++;
 }
 
-void TicketHolder::release() {
-    {
-        stdx::lock_guard<Latch> lk(_mutex);
-        _num++;
-    }
-    _newTicket.notify_one();
+void TicketHolder::_recordAdmissionInLock(WithLock, Priority priority, Microseconds waited) {
+    auto& queue = _queues[static_cast<size_t>(priority)];
+    queue.admissions++;
+    queue.totalWaitMicros += durationCount<Microseconds>(waited);
+
+    const auto micros = static_cast<uint64_t>(std::max<int64_t>(waited.count(), 0));
+    const size_t bucket = micros < 2 ? 0 : 63 - countLeadingZeros64(micros);
+    queue.waitHistogram[std::min(bucket, kNumWaitBuckets - 1)]++;
 }
 
 Status TicketHolder::resize(int newSize) {
+    if (newSize < 1)
+        return Status(ErrorCodes::BadValue,
+                      str::stream() << "Minimum value for tickets is 1; given " << newSize);
+
     stdx::lock_guard<Latch> lk(_mutex);
 
-    int used = _outof.load() - _num;
-    if (used > newSize) {
-        std::stringstream ss;
-        ss << "can't resize since we're using (" << used << ") "
-           << "more than newSize(" << newSize << ")";
+    const int delta = newSize - _outof.load();
+    _outof.store(newSize);
 
-        std::string errmsg = ss.str();
-        log() << errmsg;
-        return Status(ErrorCodes::BadValue, errmsg);
+    if (delta < 0) {
+        _available += delta;
+        return Status::OK();
     }
 
-    _outof.store(newSize);
-    _num = _outof.load() - used;
+    // Pay back any tickets still owed from an earlier shrink first, then hand out the rest as
+    // though they had just been released.
+    for (int i = 0; i < delta; ++i) {
+        _releaseInLock(lk);
+    }
 
-    // Potentially wasteful, but easier to see is correct
-    _newTicket.notify_all();
     return Status::OK();
 }
 
 int TicketHolder::available() const {
-    return _num;
+    stdx::lock_guard<Latch> lk(_mutex);
+    return std::max(_available, 0);
 }
 
 int TicketHolder::used() const {
-    return outof() - _num;
+    stdx::lock_guard<Latch> lk(_mutex);
+    return _outof.load() - _available;
 }
 
 int TicketHolder::outof() const {
     return _outof.load();
 }
 
-bool TicketHolder::_tryAcquire() {
-    if (_num <= 0) {
-        if (_num < 0) {
-            std::cerr << "DISASTER! in TicketHolder" << std::endl;
+TicketHolder::Stats TicketHolder::getStats() const {
+    stdx::lock_guard<Latch> lk(_mutex);
+
+    Stats stats;
+    for (const auto& queue : _queues) {
+        stats.queued += queue.waiters.size();
+        stats.admissions += queue.admissions;
+        stats.totalWaitMicros += queue.totalWaitMicros;
+    }
+    return stats;
+}
+
+void TicketHolder::appendStats(BSONObjBuilder* b) const {
+    stdx::lock_guard<Latch> lk(_mutex);
+
+    BSONObjBuilder queuesBuilder(b->subobjStart("queues"));
+    for (size_t i = 0; i < kNumPriorities; ++i) {
+        const auto& queue = _queues[i];
+        BSONObjBuilder queueBuilder(queuesBuilder.subobjStart(priorityName(Priority(i))));
+        queueBuilder.append("queued", static_cast<long long>(queue.waiters.size()));
+        queueBuilder.append("admitted", queue.admissions);
+        queueBuilder.append("totalWaitMicros", queue.totalWaitMicros);
+
+        BSONArrayBuilder histogramBuilder(queueBuilder.subarrayStart("waitHistogram"));
+        for (size_t bucket = 0; bucket < kNumWaitBuckets; ++bucket) {
+            if (queue.waitHistogram[bucket] == 0)
+                continue;
+            BSONObjBuilder entryBuilder(histogramBuilder.subobjStart());
+            entryBuilder.append("micros", bucket == 0 ? 0LL : 1LL << bucket);
+            entryBuilder.append("count", queue.waitHistogram[bucket]);
+            entryBuilder.doneFast();
         }
-        return false;
+        histogramBuilder.doneFast();
+        queueBuilder.doneFast();
     }
-    _num--;
-    return true;
+    queuesBuilder.doneFast();
 }
-#endif
+
 }  // namespace mongo
@@ -28,27 +28,52 @@
  */
 #pragma once
 
-#if defined(__linux__)
-#include <semaphore.h>
-#endif
+#include <array>
+#include <list>
 
-#include "mongo/db/operation_context.h"
+#include "mongo/base/status.h"
+#include "mongo/platform/atomic_word.h"
 #include "mongo/platform/mutex.h"
 #include "mongo/stdx/condition_variable.h"
 #include "mongo/util/concurrency/mutex.h"
+#include "mongo/util/concurrency/with_lock.h"
 #include "mongo/util/hierarchical_acquisition.h"
 #include "mongo/util/time_support.h"
 
 namespace mongo {
 
+class BSONObjBuilder;
+class OperationContext;
+
+/**
+ * Admission control queue which limits the number of operations that can hold a ticket at once.
+ *
+ * Waiters are admitted strictly in order of priority class and, within a class, in the order in
+ * which they started waiting. A released ticket is handed directly to the waiter at the head of the
+ * highest priority non-empty queue, so newly arriving operations cannot barge ahead of those which
+ * are already queued.
+ */
 class TicketHolder {
     TicketHolder(const TicketHolder&) = delete;
     TicketHolder& operator=(const TicketHolder&) = delete;
 
 public:
+    /**
+     * Priority classes for admission, from the most to the least preferred.
+     */
+    enum class Priority {
+        kReplication,  // Replication work, e.g. secondary oplog application
+        kInternal,     // Operations started by the server itself, or by other cluster members
+        kUser,         // Operations on behalf of user connections
+    };
+    static constexpr size_t kNumPriorities = 3;
+
     explicit TicketHolder(int num);
     ~TicketHolder();
 
+    /**
+     * Acquires a ticket without blocking if one is available and nobody is queued for it.
+     */
     bool tryAcquire();
 
     /**
@@ -56,7 +81,7 @@ public:
      * 'opCtx' is killed, throwing an AssertionException.
      * If 'opCtx' is not provided or equal to nullptr, the wait is not interruptible.
      */
-    void waitForTicket(OperationContext* opCtx);
+    void waitForTicket(OperationContext* opCtx, Priority priority = Priority::kUser);
     void waitForTicket() {
         waitForTicket(nullptr);
     }
@@ -68,12 +93,19 @@ public:
      * proceed.
      * If 'opCtx' is not provided or equal to nullptr, the wait is not interruptible.
      */
-    bool waitForTicketUntil(OperationContext* opCtx, Date_t until);
+    bool waitForTicketUntil(OperationContext* opCtx,
+                            Date_t until,
+                            Priority priority = Priority::kUser);
     bool waitForTicketUntil(Date_t until) {
         return waitForTicketUntil(nullptr, until);
     }
     void release();
 
+    /**
+     * Changes the total number of tickets. Growing hands the new tickets to queued waiters right
+     * away. Shrinking below the number of tickets in use does not wait: the excess is retired as
+     * the tickets are released.
+     */
     Status resize(int newSize);
 
     int available() const;
@@ -82,22 +114,52 @@ public:
 
     int outof() const;
 
+    /**
+     * Totals across all priority classes.
+     */
+    struct Stats {
+        int queued = 0;
+        long long admissions = 0;
+        long long totalWaitMicros = 0;
+    };
+    Stats getStats() const;
+
+    /**
+     * Appends the current queue depth, the number of admissions and a histogram of the time spent
+     * waiting for each priority class.
+     */
+    void appendStats(BSONObjBuilder* b) const;
+
 private:
-#if defined(__linux__)
-    mutable sem_t _sem;
+    // Histogram buckets have power of two lower bounds in microseconds: [0, 2), [2, 4), [4, 8) ...
+    static constexpr size_t kNumWaitBuckets = 32;
 
-    // You can read _outof without a lock, but have to hold _resizeMutex to change.
-    AtomicWord<int> _outof;
-    Mutex _resizeMutex =
-        MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "TicketHolder::_resizeMutex");
-#else
-    bool _tryAcquire();
+    struct Waiter {
+        stdx::condition_variable cv;
+        bool granted = false;
+    };
 
+    struct PriorityQueue {
+        std::list<Waiter*> waiters;
+        long long admissions = 0;
+        long long totalWaitMicros = 0;
+        std::array<long long, kNumWaitBuckets> waitHistogram{};
+    };
+
+    void _releaseInLock(WithLock);
+
+    void _recordAdmissionInLock(WithLock, Priority priority, Microseconds waited);
+
+    // Number of tickets which can be handed out. Goes negative if the holder is shrunk below the
+    // number of tickets in use, in which case releases retire tickets until it is back at zero.
+    int _available;
+
+    // You can read _outof without a lock, but have to hold _mutex to change.
     AtomicWord<int> _outof;
-    int _num;
-    Mutex _mutex = MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "TicketHolder::_mutex");
-    stdx::condition_variable _newTicket;
-#endif
+
+    mutable Mutex _mutex =
+        MONGO_MAKE_LATCH(HierarchicalAcquisitionLevel(0), "TicketHolder::_mutex");
+    std::array<PriorityQueue, kNumPriorities> _queues;
 };
 
 class ScopedTicket {
@@ -32,6 +32,10 @@
 
 #include "mongo/platform/basic.h"
 
+#include <vector>
+
+#include "mongo/bson/bsonobjbuilder.h"
+#include "mongo/stdx/thread.h"
 #include "mongo/unittest/unittest.h"
 #include "mongo/util/concurrency/ticketholder.h"
 
@@ -72,4 +76,79 @@ TEST(TicketholderTest, BasicTimeout) {
     holder.release();
     ASSERT_EQ(holder.used(), 0);
 }
+
+int numQueued(const TicketHolder& holder) {
+    BSONObjBuilder b;
+    holder.appendStats(&b);
+    int queued = 0;
+    for (auto&& queue : b.obj()["queues"].Obj()) {
+        queued += queue.Obj()["queued"].numberInt();
+    }
+    return queued;
+}
+
+TEST(TicketholderTest, AdmitsByPriorityThenArrivalOrder) {
+    TicketHolder holder(1);
+    ASSERT(holder.tryAcquire());
+
+    Mutex mutex = MONGO_MAKE_LATCH();
+    std::vector<int> admitted;
+
+    // Queue the waiters one at a time so that their arrival order is known
+    const std::vector<std::pair<int, TicketHolder::Priority>> waiters{
+        {0, TicketHolder::Priority::kUser},
+        {1, TicketHolder::Priority::kInternal},
+        {2, TicketHolder::Priority::kUser},
+        {3, TicketHolder::Priority::kReplication},
+    };
+    std::vector<stdx::thread> threads;
+    for (const auto& [id, priority] : waiters) {
+        threads.emplace_back([&, id = id, priority = priority] {
+            holder.waitForTicket(nullptr, priority);
+            {
+                stdx::lock_guard<Latch> lk(mutex);
+                admitted.push_back(id);
+            }
+            holder.release();
+        });
+
+        while (numQueued(holder) < int(threads.size())) {
+            sleepmillis(1);
+        }
+    }
+
+    // A queued ticket cannot be taken by a newcomer
+    ASSERT_FALSE(holder.tryAcquire());
+
+    holder.release();
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    ASSERT(admitted == (std::vector<int>{3, 1, 0, 2}));
+    ASSERT_EQ(holder.used(), 0);
+}
+
+TEST(TicketholderTest, ResizeDoesNotWaitForTicketsInUse) {
+    TicketHolder holder(3);
+    ASSERT(holder.tryAcquire());
+    ASSERT(holder.tryAcquire());
+
+    ASSERT_OK(holder.resize(1));
+    ASSERT_EQ(holder.outof(), 1);
+    ASSERT_EQ(holder.used(), 2);
+    ASSERT_EQ(holder.available(), 0);
+
+    // The first release retires the excess ticket rather than making it available
+    holder.release();
+    ASSERT_EQ(holder.available(), 0);
+    ASSERT_FALSE(holder.tryAcquire());
+
+    holder.release();
+    ASSERT_EQ(holder.available(), 1);
+
+    ASSERT_OK(holder.resize(4));
+    ASSERT_EQ(holder.available(), 4);
+    ASSERT_EQ(holder.used(), 0);
+}
 }  // namespace